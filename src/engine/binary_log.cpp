@@ -0,0 +1,227 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "binary_log.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/sink.h>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define ENGINE_HAS_MMAP 1
+#endif
+
+namespace engine {
+    binary_log_writer::binary_log_writer(const std::filesystem::path &path, const size_t initial_size) {
+        if (path.has_parent_path()) {
+            std::filesystem::create_directories(path.parent_path());
+        }
+
+#ifdef ENGINE_HAS_MMAP
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+#else
+        m_file = std::fopen(path.string().c_str(), "wb");
+        if (!m_file) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+#endif
+        _grow(std::max<size_t>(initial_size, sizeof(binary_log::file_header) + 1));
+
+        using period = std::chrono::steady_clock::period;
+
+        const auto unix_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        );
+        const binary_log::file_header header{
+            .magic                  = binary_log::magic,
+            .version                = binary_log::version,
+            .reserved               = 0,
+            .tick_numerator         = period::num,
+            .tick_denominator       = period::den,
+            .start_ticks            = _ticks(),
+            .start_unix_nanoseconds = static_cast<uint64_t>(unix_time.count()),
+        };
+
+        std::lock_guard lock(m_mutex);
+        std::byte      *out = _reserve(sizeof(header));
+        _put(out, header);
+    }
+
+    binary_log_writer::~binary_log_writer() {
+#ifdef ENGINE_HAS_MMAP
+        ::munmap(m_data, m_capacity);
+        ::ftruncate(m_fd, static_cast<off_t>(m_size));
+        ::close(m_fd);
+#else
+        std::fwrite(m_data, 1, m_size, m_file);
+        std::fclose(m_file);
+        delete[] m_data;
+#endif
+    }
+
+    void binary_log_writer::write_text(const name_id                   logger,
+                                       const spdlog::level::level_enum level,
+                                       const size_t                    thread_id,
+                                       const std::string_view          text) {
+        std::lock_guard lock(m_mutex);
+        _define(logger);
+
+        std::byte *out = _reserve(1 + 8 + 4 + 1 + 4 + 4 + text.size());
+        _put(out, binary_log::record_type::text);
+        _put(out, _ticks());
+        _put(out, logger.index());
+        _put(out, static_cast<uint8_t>(level));
+        _put(out, static_cast<uint32_t>(thread_id));
+        _put_string(out, text);
+    }
+
+    void binary_log_writer::flush() {
+        std::lock_guard lock(m_mutex);
+#ifdef ENGINE_HAS_MMAP
+        ::msync(m_data, m_size, MS_ASYNC);
+#else
+        std::fwrite(m_data, 1, m_size, m_file);
+        std::fflush(m_file);
+        m_size = 0;
+#endif
+    }
+
+    size_t binary_log_writer::bytes_written() const {
+        std::lock_guard lock(m_mutex);
+        return m_size;
+    }
+
+    uint32_t binary_log_writer::_thread_id() noexcept {
+        return static_cast<uint32_t>(spdlog::details::os::thread_id());
+    }
+
+    void binary_log_writer::_define(const name_id str) {
+        const uint32_t id = str.index();
+        if (id == 0)
+            return;
+
+        if (m_defined.size() <= id) {
+            m_defined.resize(std::max<size_t>(id + 1, m_defined.size() * 2));
+        }
+        if (m_defined[id])
+            return;
+        m_defined[id] = true;
+
+        std::byte *out = _reserve(1 + 4 + 4 + str.str().size());
+        _put(out, binary_log::record_type::string_def);
+        _put(out, id);
+        _put_string(out, str.str());
+    }
+
+    std::byte *binary_log_writer::_reserve(const size_t size) {
+        if (m_size + size > m_capacity) {
+#ifndef ENGINE_HAS_MMAP
+            // without a mapping, the buffer is written out whenever it fills up
+            std::fwrite(m_data, 1, m_size, m_file);
+            m_size = 0;
+#endif
+            if (m_size + size > m_capacity) {
+                _grow(std::max(m_capacity * 2, m_size + size));
+            }
+        }
+
+        std::byte *out = m_data + m_size;
+        m_size += size;
+        return out;
+    }
+
+    void binary_log_writer::_grow(const size_t min_capacity) {
+#ifdef ENGINE_HAS_MMAP
+        if (m_data) {
+            ::munmap(m_data, m_capacity);
+            m_data = nullptr;
+        }
+
+        if (::ftruncate(m_fd, static_cast<off_t>(min_capacity)) != 0) {
+            throw std::runtime_error("Failed to grow binary log file");
+        }
+
+        void *data = ::mmap(nullptr, min_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Failed to map binary log file");
+        }
+        m_data = static_cast<std::byte *>(data);
+#else
+        auto *data = new std::byte[min_capacity];
+        std::copy_n(m_data, m_size, data);
+        delete[] m_data;
+        m_data = data;
+#endif
+        m_capacity = min_capacity;
+    }
+
+    class binary_log_sink final : public spdlog::sinks::sink {
+      public:
+        binary_log_sink(std::shared_ptr<binary_log_writer> writer, const name_id logger)
+            : m_writer(std::move(writer)), m_logger(logger) {}
+
+        void log(const spdlog::details::log_msg &msg) override {
+            const std::string_view text(msg.payload.data(), msg.payload.size());
+            m_writer->write_text(m_logger, msg.level, msg.thread_id, text);
+        }
+
+        void flush() override { m_writer->flush(); }
+
+        [[nodiscard]] inline const std::shared_ptr<binary_log_writer> &writer() const noexcept { return m_writer; }
+        [[nodiscard]] inline name_id                                   logger() const noexcept { return m_logger; }
+
+        // records are formatted by the decoder
+        void set_pattern(const std::string &) override {}
+        void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+
+      private:
+        std::shared_ptr<binary_log_writer> m_writer;
+        name_id                            m_logger;
+    };
+
+    binary_logger_factory::binary_logger_factory(settings settings)
+        : m_writer(std::make_shared<binary_log_writer>(settings.path, settings.initial_size)),
+          m_ephemeral_factory(std::move(settings.ephemeral_factory)) {
+        if (!m_ephemeral_factory) {
+            m_ephemeral_factory = std::make_shared<default_logger_factory>();
+        }
+    }
+
+    std::shared_ptr<spdlog::logger> binary_logger_factory::create_logger(const std::string     &name,
+                                                                         const logger_settings &settings) {
+        if (settings.ephemeral_only) {
+            return m_ephemeral_factory->create_logger(name, settings);
+        }
+
+        auto logger = std::make_shared<spdlog::logger>(
+            name, std::make_shared<binary_log_sink>(m_writer, name_id::intern(std::string_view(name)))
+        );
+#ifndef NDEBUG
+        logger->set_level(spdlog::level::debug);
+#else
+        logger->set_level(spdlog::level::info);
+#endif
+        spdlog::register_logger(logger);
+        return logger;
+    }
+
+    event_logger::event_logger(std::shared_ptr<spdlog::logger> logger) : m_logger(std::move(logger)) {
+        if (!m_logger || m_logger->sinks().size() != 1)
+            return;
+
+        // only a logger that writes nowhere else can skip formatting its messages
+        if (const auto *sink = dynamic_cast<const binary_log_sink *>(m_logger->sinks().front().get())) {
+            m_writer = sink->writer();
+            m_name   = sink->logger();
+        }
+    }
+} // namespace engine
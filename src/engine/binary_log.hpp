@@ -0,0 +1,230 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/binary_log_format.hpp"
+#include "engine/logging.hpp"
+#include "engine/names.hpp"
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Appends binary log records (see binary_log_format.hpp) to a memory-mapped file. Strings are written once per file
+     * and referred to by id afterwards, and event arguments are stored raw, so writing a record is a few stores into the
+     * mapping. The file is decoded offline by the log_decode tool. Thread-safe.
+     */
+    class binary_log_writer {
+      public:
+        explicit binary_log_writer(const std::filesystem::path &path, size_t initial_size = size_t(4) << 20);
+        ~binary_log_writer();
+
+        binary_log_writer(const binary_log_writer &other)                = delete;
+        binary_log_writer(binary_log_writer &&other) noexcept            = delete;
+        binary_log_writer &operator=(const binary_log_writer &other)     = delete;
+        binary_log_writer &operator=(binary_log_writer &&other) noexcept = delete;
+
+        /**
+         * Writes a message that was already formatted.
+         */
+        void write_text(name_id logger, spdlog::level::level_enum level, size_t thread_id, std::string_view text);
+
+        /**
+         * Writes an event: the id of its format string and its arguments, unformatted. Arguments may be integers,
+         * floating point values, bools, enums and strings. Prefer ENGINE_BINARY_LOG, which interns the format string once
+         * per call site.
+         */
+        template <typename... Args>
+        void write_event(const name_id logger, const spdlog::level::level_enum level, const name_id format,
+                         const Args &...args) {
+            static_assert(sizeof...(Args) <= UINT16_MAX);
+
+            constexpr size_t header = 1 + 8 + 4 + 1 + 4 + 4 + 2;
+            const size_t     size   = header + (size_t(0) + ... + _arg_size(args));
+
+            std::lock_guard lock(m_mutex);
+            _define(logger);
+            _define(format);
+
+            std::byte *out = _reserve(size);
+            _put(out, binary_log::record_type::event);
+            _put(out, _ticks());
+            _put(out, logger.index());
+            _put(out, static_cast<uint8_t>(level));
+            _put(out, _thread_id());
+            _put(out, format.index());
+            _put(out, static_cast<uint16_t>(sizeof...(Args)));
+            (_put_arg(out, args), ...);
+        }
+
+        /**
+         * Asks the OS to write dirty pages back to the file, without waiting.
+         */
+        void flush();
+
+        [[nodiscard]] size_t bytes_written() const;
+
+      private:
+        mutable std::mutex m_mutex;
+        std::vector<bool>  m_defined;
+
+        std::byte *m_data     = nullptr;
+        size_t     m_size     = 0;
+        size_t     m_capacity = 0;
+
+#if defined(__unix__) || defined(__APPLE__)
+        int m_fd = -1;
+#else
+        std::FILE *m_file = nullptr;
+#endif
+
+        [[nodiscard]] static uint64_t _ticks() noexcept {
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        }
+
+        [[nodiscard]] static uint32_t _thread_id() noexcept;
+
+        template <typename T>
+        static void _put(std::byte *&out, const T value) noexcept {
+            static_assert(std::is_trivially_copyable_v<T>);
+            std::memcpy(out, &value, sizeof(T));
+            out += sizeof(T);
+        }
+
+        static void _put_string(std::byte *&out, const std::string_view str) noexcept {
+            _put(out, static_cast<uint32_t>(str.size()));
+            std::memcpy(out, str.data(), str.size());
+            out += str.size();
+        }
+
+        template <typename T>
+        [[nodiscard]] static constexpr size_t _arg_size(const T &value) noexcept {
+            if constexpr (std::same_as<T, bool>) {
+                return 2;
+            } else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+                return 9;
+            } else {
+                static_assert(std::convertible_to<const T &, std::string_view>, "Unsupported binary log argument");
+                return 5 + std::string_view(value).size();
+            }
+        }
+
+        template <typename T>
+        static void _put_arg(std::byte *&out, const T &value) noexcept {
+            if constexpr (std::same_as<T, bool>) {
+                _put(out, binary_log::arg_type::boolean);
+                _put(out, static_cast<uint8_t>(value));
+            } else if constexpr (std::is_enum_v<T>) {
+                _put_arg(out, static_cast<std::underlying_type_t<T>>(value));
+            } else if constexpr (std::floating_point<T>) {
+                _put(out, binary_log::arg_type::f64);
+                _put(out, static_cast<double>(value));
+            } else if constexpr (std::signed_integral<T>) {
+                _put(out, binary_log::arg_type::i64);
+                _put(out, static_cast<int64_t>(value));
+            } else if constexpr (std::unsigned_integral<T>) {
+                _put(out, binary_log::arg_type::u64);
+                _put(out, static_cast<uint64_t>(value));
+            } else {
+                _put(out, binary_log::arg_type::string);
+                _put_string(out, std::string_view(value));
+            }
+        }
+
+        void       _define(name_id str);
+        std::byte *_reserve(size_t size);
+        void       _grow(size_t min_capacity);
+    };
+
+    /**
+     * Creates loggers that write binary records to one file instead of text. Loggers created with ephemeral_only are
+     * not meant to reach a file, so they are created by ephemeral_factory instead (a default_logger_factory if none is
+     * given).
+     */
+    class binary_logger_factory final : public logger_factory {
+      public:
+        struct settings {
+            std::filesystem::path           path         = "logs/engine.binlog";
+            size_t                          initial_size = size_t(4) << 20;
+            std::shared_ptr<logger_factory> ephemeral_factory;
+        };
+
+        explicit binary_logger_factory(settings settings);
+
+        std::shared_ptr<spdlog::logger> create_logger(const std::string     &name,
+                                                      const logger_settings &settings) override;
+
+        [[nodiscard]] inline const std::shared_ptr<binary_log_writer> &writer() const noexcept { return m_writer; }
+
+      private:
+        std::shared_ptr<binary_log_writer> m_writer;
+        std::shared_ptr<logger_factory>    m_ephemeral_factory;
+    };
+
+    /**
+     * A logger, plus the binary log behind it when it was created by a binary_logger_factory. ENGINE_LOG writes an
+     * event to that log instead of formatting text, and formats through the logger as usual for every other factory, so
+     * call sites work however the logger was routed.
+     */
+    class event_logger {
+      public:
+        event_logger() = default;
+        explicit event_logger(std::shared_ptr<spdlog::logger> logger);
+
+        [[nodiscard]] inline spdlog::logger *operator->() const noexcept { return m_logger.get(); }
+        [[nodiscard]] inline explicit operator bool() const noexcept { return m_logger != nullptr; }
+
+        [[nodiscard]] inline const std::shared_ptr<spdlog::logger> &logger() const noexcept { return m_logger; }
+
+        // the binary log this logger writes to, or null if it writes text
+        [[nodiscard]] inline binary_log_writer *binary_writer() const noexcept { return m_writer.get(); }
+        [[nodiscard]] inline name_id            binary_name() const noexcept { return m_name; }
+
+      private:
+        std::shared_ptr<spdlog::logger>    m_logger;
+        std::shared_ptr<binary_log_writer> m_writer;
+        name_id                            m_name;
+    };
+
+} // namespace engine
+
+/**
+ * Writes an event to a binary_log_writer. The format string is interned once per call site, and the arguments are
+ * formatted with std::format syntax only when the log is decoded.
+ */
+#define ENGINE_BINARY_LOG(writer, logger, level, format, ...)                                                          \
+    do {                                                                                                               \
+        static const ::engine::name_id engine_binary_log_format = ::engine::name_id::intern(format);                   \
+        (writer).write_event((logger), (level), engine_binary_log_format __VA_OPT__(, ) __VA_ARGS__);                  \
+    } while (false)
+
+/**
+ * Logs through an event_logger: as an event when the logger writes to a binary log, so the arguments are only formatted
+ * when the log is decoded, and as formatted text otherwise. The level is checked first either way.
+ */
+#define ENGINE_LOG(logger, level, format, ...)                                                                         \
+    do {                                                                                                               \
+        const ::engine::event_logger &engine_log_logger = (logger);                                                    \
+        if (!engine_log_logger->should_log(level))                                                                     \
+            break;                                                                                                     \
+        if (::engine::binary_log_writer *engine_log_writer = engine_log_logger.binary_writer()) {                      \
+            ENGINE_BINARY_LOG(                                                                                         \
+                *engine_log_writer, engine_log_logger.binary_name(), (level), format __VA_OPT__(, ) __VA_ARGS__        \
+            );                                                                                                         \
+        } else {                                                                                                       \
+            engine_log_logger->log((level), format __VA_OPT__(, ) __VA_ARGS__);                                        \
+        }                                                                                                              \
+    } while (false)
@@ -0,0 +1,58 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Layout of binary log files, shared by the writer and the decoder tool. All values are little-endian and unaligned.
+ *
+ * A file starts with a file_header, followed by records. Each record starts with a one-byte record_type:
+ *
+ *   string_def  u32 id, u32 length, bytes              defines a string (logger name or format string) used by later
+ *                                                      records; each id is defined once per file before its first use
+ *   text        u64 ticks, u32 logger, u8 level,       a message spdlog already formatted
+ *               u32 thread, u32 length, bytes
+ *   event       u64 ticks, u32 logger, u8 level,       a format string id and its raw arguments, formatted only when
+ *               u32 thread, u32 format, u16 count,     the file is decoded
+ *               count * (u8 arg_type, value)
+ *   end         -                                      the rest of the file is unused
+ *
+ * Argument values are i64, u64 or f64 for the numeric types, u8 for bool, and u32 length + bytes for strings.
+ */
+namespace engine::binary_log {
+    inline constexpr std::array<char, 8> magic   = {'E', 'N', 'G', 'L', 'O', 'G', '\0', '\1'};
+    inline constexpr uint32_t            version = 1;
+
+    struct file_header {
+        std::array<char, 8> magic;
+        uint32_t            version;
+        uint32_t            reserved;
+
+        // ticks are steady clock counts; seconds = ticks * tick_numerator / tick_denominator
+        uint64_t tick_numerator;
+        uint64_t tick_denominator;
+
+        // the steady clock tick and system clock time (nanoseconds since the Unix epoch) when the file was opened
+        uint64_t start_ticks;
+        uint64_t start_unix_nanoseconds;
+    };
+
+    enum class record_type : uint8_t {
+        end        = 0,
+        string_def = 1,
+        text       = 2,
+        event      = 3,
+    };
+
+    enum class arg_type : uint8_t {
+        i64     = 0,
+        u64     = 1,
+        f64     = 2,
+        boolean = 3,
+        string  = 4,
+    };
+} // namespace engine::binary_log
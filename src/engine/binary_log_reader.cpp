@@ -0,0 +1,158 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "binary_log_reader.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+namespace engine::binary_log {
+    namespace {
+        template <typename T>
+        std::string format_argument(const std::string_view spec, const T &value) {
+            const std::string format = "{:" + std::string(spec) + "}";
+            return std::vformat(format, std::make_format_args(value));
+        }
+    } // namespace
+
+    reader::reader(const std::span<const char> data) : m_data(data) {
+        m_header = _read<file_header>();
+        if (m_header.magic != magic || m_header.version != version)
+            throw std::runtime_error("Not a binary log (or an unsupported version)");
+    }
+
+    bool reader::next(record &out) {
+        while (m_offset < m_data.size()) {
+            const auto type = _read<record_type>();
+            if (type == record_type::end)
+                break;
+
+            if (type == record_type::string_def) {
+                const auto id = _read<uint32_t>();
+                m_strings[id] = _read_string();
+                continue;
+            }
+
+            out.ticks  = _read<uint64_t>();
+            out.logger = _lookup(_read<uint32_t>());
+            out.level  = _read<uint8_t>();
+            out.thread = _read<uint32_t>();
+
+            if (type == record_type::text) {
+                out.text = _read_string();
+            } else if (type == record_type::event) {
+                const auto format = _read<uint32_t>();
+                const auto count  = _read<uint16_t>();
+
+                m_args.clear();
+                for (uint16_t i = 0; i < count; ++i) {
+                    switch (_read<arg_type>()) {
+                        case arg_type::i64:
+                            m_args.emplace_back(_read<int64_t>());
+                            break;
+                        case arg_type::u64:
+                            m_args.emplace_back(_read<uint64_t>());
+                            break;
+                        case arg_type::f64:
+                            m_args.emplace_back(_read<double>());
+                            break;
+                        case arg_type::boolean:
+                            m_args.emplace_back(_read<uint8_t>() != 0);
+                            break;
+                        case arg_type::string:
+                            m_args.emplace_back(_read_string());
+                            break;
+                        default:
+                            throw std::runtime_error("Unknown argument type");
+                    }
+                }
+                out.text = _format_event(_lookup(format), m_args);
+            } else {
+                throw std::runtime_error("Unknown record type");
+            }
+            return true;
+        }
+
+        m_offset = m_data.size();
+        return false;
+    }
+
+    std::string reader::format_time(const uint64_t ticks) const {
+        const auto elapsed = std::chrono::nanoseconds(static_cast<int64_t>(
+            static_cast<long double>(ticks - m_header.start_ticks) * m_header.tick_numerator * 1'000'000'000 /
+            m_header.tick_denominator
+        ));
+        const auto time = std::chrono::sys_time<std::chrono::nanoseconds>(
+            std::chrono::nanoseconds(m_header.start_unix_nanoseconds) + elapsed
+        );
+        return std::format("{:%F %T}", std::chrono::floor<std::chrono::microseconds>(time));
+    }
+
+    template <typename T>
+    T reader::_read() {
+        T value;
+        _need(sizeof(T));
+        std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return value;
+    }
+
+    std::string_view reader::_read_string() {
+        const auto length = _read<uint32_t>();
+        _need(length);
+        const std::string_view str(m_data.data() + m_offset, length);
+        m_offset += length;
+        return str;
+    }
+
+    void reader::_need(const size_t size) const {
+        if (m_offset + size > m_data.size())
+            throw std::runtime_error("Truncated record");
+    }
+
+    std::string_view reader::_lookup(const uint32_t id) const {
+        const auto it = m_strings.find(id);
+        return it != m_strings.end() ? it->second : "?";
+    }
+
+    // applies std::format replacement fields ("{}", "{0}", "{:.3f}", "{1:>8}") to decoded arguments
+    std::string reader::_format_event(const std::string_view format, const std::vector<argument> &args) {
+        std::string out;
+        size_t      next_arg = 0;
+
+        for (size_t i = 0; i < format.size(); ++i) {
+            const char c = format[i];
+            if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c) {
+                out += c;
+                ++i;
+                continue;
+            }
+            if (c != '{') {
+                out += c;
+                continue;
+            }
+
+            const size_t close = format.find('}', i);
+            if (close == std::string_view::npos) {
+                out += format.substr(i);
+                break;
+            }
+
+            const std::string_view field = format.substr(i + 1, close - i - 1);
+            const size_t           colon = field.find(':');
+            const std::string_view index = field.substr(0, colon);
+            const std::string_view spec  = colon == std::string_view::npos ? "" : field.substr(colon + 1);
+
+            const size_t arg = index.empty() ? next_arg++ : std::strtoul(std::string(index).c_str(), nullptr, 10);
+            out += arg < args.size()
+                     ? std::visit([&](const auto &value) { return format_argument(spec, value); }, args[arg])
+                     : "{?}";
+            i = close;
+        }
+        return out;
+    }
+} // namespace engine::binary_log
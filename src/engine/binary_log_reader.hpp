@@ -0,0 +1,74 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/binary_log_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace engine::binary_log {
+
+    /**
+     * A text or event record read back from a binary log, with an event's arguments already formatted into text.
+     */
+    struct record {
+        uint64_t         ticks  = 0;
+        std::string_view logger;
+        uint8_t          level  = 0;
+        uint32_t         thread = 0;
+        std::string      text;
+    };
+
+    /**
+     * Reads the records of a binary log held in memory, as the log_decode tool prints them. Strings in the records
+     * point into the data, which must outlive the reader. Throws std::runtime_error for data that is not a binary log
+     * or stops partway through a record.
+     */
+    class reader {
+      public:
+        explicit reader(std::span<const char> data);
+
+        /**
+         * Reads the next text or event record, taking in any string definitions before it.
+         *
+         * @return false once the log ends
+         */
+        bool next(record &out);
+
+        [[nodiscard]] inline const file_header &header() const noexcept { return m_header; }
+
+        /**
+         * @return The system clock time of a record's ticks, as "YYYY-MM-DD HH:MM:SS.ffffff"
+         */
+        [[nodiscard]] std::string format_time(uint64_t ticks) const;
+
+      private:
+        using argument = std::variant<int64_t, uint64_t, double, bool, std::string_view>;
+
+        std::span<const char> m_data;
+        size_t                m_offset = 0;
+        file_header           m_header{};
+
+        std::unordered_map<uint32_t, std::string_view> m_strings;
+        std::vector<argument>                          m_args; // the current event's, kept for their capacity
+
+        template <typename T>
+        T _read();
+        std::string_view _read_string();
+        void             _need(size_t size) const;
+
+        [[nodiscard]] std::string_view _lookup(uint32_t id) const;
+
+        [[nodiscard]] static std::string _format_event(std::string_view format, const std::vector<argument> &args);
+    };
+
+} // namespace engine::binary_log
@@ -0,0 +1,143 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * An open-addressing hash map from pointers to V, probed like flat_name_map: linear probing with backward-shift
+     * deletion, so there are no tombstones. The key is its own hash, so entries hold only the pointer and the value,
+     * and a null key marks an empty slot (null cannot be inserted). Capacity is only ever grown, so a map that keeps
+     * roughly the same size (objects joining and leaving a group every frame) stops allocating once it has grown.
+     */
+    template <typename K, typename V>
+    class flat_pointer_map {
+      public:
+        using key_type = const K *;
+
+        /**
+         * Inserts value for key unless key is already present.
+         *
+         * @return The value for key, and whether it was inserted
+         */
+        std::pair<V *, bool> try_emplace(const key_type key, V value) {
+            if ((m_size + 1) * 8 > m_entries.size() * 7) {
+                _rehash(std::max<size_t>(m_entries.size() * 2, 16));
+            }
+
+            for (size_t i = _home(key);; i = (i + 1) & m_mask) {
+                if (m_entries[i].key == nullptr) {
+                    m_entries[i] = entry{key, std::move(value)};
+                    ++m_size;
+                    return {&m_entries[i].value, true};
+                }
+                if (m_entries[i].key == key)
+                    return {&m_entries[i].value, false};
+            }
+        }
+
+        [[nodiscard]] V *find(const key_type key) noexcept {
+            const size_t i = _find_slot(key);
+            return i == npos ? nullptr : &m_entries[i].value;
+        }
+
+        [[nodiscard]] const V *find(const key_type key) const noexcept {
+            const size_t i = _find_slot(key);
+            return i == npos ? nullptr : &m_entries[i].value;
+        }
+
+        [[nodiscard]] inline bool contains(const key_type key) const noexcept { return _find_slot(key) != npos; }
+
+        bool erase(const key_type key) {
+            size_t hole = _find_slot(key);
+            if (hole == npos)
+                return false;
+
+            // shift the rest of the cluster back over the hole, so probes never need to skip deleted slots
+            for (size_t i = (hole + 1) & m_mask; m_entries[i].key != nullptr; i = (i + 1) & m_mask) {
+                const size_t home = _home(m_entries[i].key);
+                if (((i - home) & m_mask) >= ((i - hole) & m_mask)) {
+                    m_entries[hole] = std::move(m_entries[i]);
+                    hole            = i;
+                }
+            }
+
+            m_entries[hole] = entry{};
+            --m_size;
+            return true;
+        }
+
+        void reserve(const size_t count) {
+            const size_t capacity = std::bit_ceil(std::max<size_t>(count * 8 / 7 + 1, 16));
+            if (capacity > m_entries.size())
+                _rehash(capacity);
+        }
+
+        /**
+         * Empties the map, keeping its capacity.
+         */
+        void clear() noexcept {
+            std::ranges::fill(m_entries, entry{});
+            m_size = 0;
+        }
+
+        [[nodiscard]] inline size_t size() const noexcept { return m_size; }
+        [[nodiscard]] inline bool   empty() const noexcept { return m_size == 0; }
+
+      private:
+        static constexpr size_t npos = SIZE_MAX;
+
+        struct entry {
+            key_type key = nullptr;
+            V        value{};
+        };
+
+        std::vector<entry> m_entries;
+        size_t             m_mask  = 0;
+        size_t             m_shift = 64;
+        size_t             m_size  = 0;
+
+        // Fibonacci hashing: the multiply spreads the aligned low bits of the pointer into the high bits kept
+        [[nodiscard]] inline size_t _home(const key_type key) const noexcept {
+            return static_cast<size_t>((reinterpret_cast<uintptr_t>(key) * 0x9e3779b97f4a7c15ull) >> m_shift);
+        }
+
+        [[nodiscard]] size_t _find_slot(const key_type key) const noexcept {
+            if (m_size == 0)
+                return npos;
+
+            for (size_t i = _home(key); m_entries[i].key != nullptr; i = (i + 1) & m_mask) {
+                if (m_entries[i].key == key)
+                    return i;
+            }
+            return npos;
+        }
+
+        void _rehash(const size_t capacity) {
+            std::vector<entry> entries = std::exchange(m_entries, std::vector<entry>(capacity));
+            m_mask                     = capacity - 1;
+            m_shift                    = 64 - static_cast<size_t>(std::countr_zero(capacity));
+
+            for (entry &e : entries) {
+                if (e.key == nullptr)
+                    continue;
+
+                size_t i = _home(e.key);
+                while (m_entries[i].key != nullptr) {
+                    i = (i + 1) & m_mask;
+                }
+                m_entries[i] = std::move(e);
+            }
+        }
+    };
+
+} // namespace engine
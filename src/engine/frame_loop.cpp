@@ -0,0 +1,127 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "frame_loop.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace engine {
+    static frame_loop::clock::duration to_duration(const double seconds) {
+        return std::chrono::duration_cast<frame_loop::clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    static double to_seconds(const frame_loop::clock::duration duration) {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    frame_loop::frame_loop(const settings &settings) : m_settings(settings) {
+        m_settings.fixed_step          = std::max(m_settings.fixed_step, 1e-6);
+        m_settings.max_steps_per_frame = std::max<uint32_t>(m_settings.max_steps_per_frame, 1);
+        reset_clock();
+    }
+
+    frame_loop::frame_info frame_loop::advance(const std::function<void(double step)> &step) {
+        const clock::time_point now   = clock::now();
+        const double            delta = to_seconds(now - m_last_time);
+        m_last_time                   = now;
+        m_frame_time.record(static_cast<uint64_t>(delta * 1e6));
+
+        m_accumulator += delta;
+
+        uint32_t steps = 0;
+        while (m_accumulator >= m_settings.fixed_step && steps < m_settings.max_steps_per_frame) {
+            // the simulation trails real time by what is left in the accumulator after this step
+            m_step_end = now - to_duration(m_accumulator - m_settings.fixed_step);
+            step(m_settings.fixed_step);
+            m_accumulator -= m_settings.fixed_step;
+            ++steps;
+        }
+
+        // keep only the fraction of a step, so a long stall does not turn into a burst of catch-up frames
+        double dropped = 0.0;
+        if (m_accumulator >= m_settings.fixed_step) {
+            const double remainder = std::fmod(m_accumulator, m_settings.fixed_step);
+            dropped                = m_accumulator - remainder;
+            m_accumulator          = remainder;
+        }
+
+        m_last_frame = frame_info{
+            .index           = m_last_frame.index + 1,
+            .delta           = delta,
+            .steps           = steps,
+            .alpha           = m_accumulator / m_settings.fixed_step,
+            .dropped         = dropped,
+            .simulation_time = m_last_frame.simulation_time + steps * m_settings.fixed_step,
+        };
+        return m_last_frame;
+    }
+
+    void frame_loop::pace(const wait_function &wait) {
+        if (m_idle && wait) {
+            const double rate = m_settings.idle_frame_rate;
+            wait(rate > 0.0 ? 1.0 / rate : 0.0);
+            m_deadline = clock::now();
+            m_lateness = 0.0;
+            return;
+        }
+
+        if (m_settings.target_frame_rate <= 0.0) {
+            if (wait)
+                wait(0.0);
+            m_lateness = 0.0;
+            return;
+        }
+
+        const clock::duration period = to_duration(1.0 / m_settings.target_frame_rate);
+        m_deadline += period;
+
+        // pump events once every frame, late or not, or a loop that cannot keep up would never see any; it must not
+        // block, the remaining time is waited out below
+        if (wait)
+            wait(0.0);
+
+        clock::time_point now = clock::now();
+        if (now > m_deadline + period) {
+            // more than a frame behind: start over from now instead of rushing to catch up
+            m_deadline = now;
+        } else {
+            _sleep_until(m_deadline);
+            now = clock::now();
+        }
+
+        m_lateness = to_seconds(now - m_deadline);
+    }
+
+    void frame_loop::reset_clock() {
+        m_last_time   = clock::now();
+        m_deadline    = m_last_time;
+        m_step_end    = m_last_time;
+        m_accumulator = 0.0;
+    }
+
+    void frame_loop::set_target_frame_rate(const double rate) {
+        m_settings.target_frame_rate = rate;
+        m_deadline                   = clock::now();
+    }
+
+    void frame_loop::set_idle(const bool idle) {
+        if (m_idle && !idle) {
+            reset_clock();
+        }
+        m_idle = idle;
+    }
+
+    void frame_loop::_sleep_until(const clock::time_point deadline) const {
+        const clock::time_point sleep_until = deadline - to_duration(m_settings.spin_threshold);
+        if (clock::now() < sleep_until) {
+            std::this_thread::sleep_until(sleep_until);
+        }
+
+        while (clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+} // namespace engine
@@ -0,0 +1,125 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/metrics.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace engine {
+
+    /**
+     * Drives a fixed-timestep simulation from a variable-rate frame loop. Each frame, the real time elapsed since the
+     * previous frame is added to an accumulator and the simulation is stepped by a constant amount until the accumulator
+     * drops below one step; the leftover fraction is the interpolation alpha for rendering between the last two states.
+     *
+     * Frames are paced to a target rate by sleeping until shortly before the deadline and spinning for the remainder,
+     * which keeps wake-up jitter low without burning a core. In idle mode, pacing waits on OS events instead, so the
+     * loop only wakes when something happens or at a low fallback rate.
+     */
+    class frame_loop {
+      public:
+        using clock = std::chrono::steady_clock;
+
+        struct settings {
+            double fixed_step = 1.0 / 60.0;
+
+            // caps the steps run in a single frame; time beyond that is dropped rather than simulated later
+            uint32_t max_steps_per_frame = 8;
+
+            // 0 leaves frames unpaced
+            double target_frame_rate = 60.0;
+
+            // how long before a deadline to stop sleeping and start spinning, to absorb scheduler wake-up latency
+            double spin_threshold = 0.002;
+
+            // frame rate to fall back to while idle and no events arrive
+            double idle_frame_rate = 4.0;
+        };
+
+        struct frame_info {
+            uint64_t index;
+
+            // real time since the previous frame, in seconds
+            double delta;
+
+            // fixed steps run this frame
+            uint32_t steps;
+
+            // fraction of a step left in the accumulator, in [0, 1)
+            double alpha;
+
+            // simulated time dropped this frame because of max_steps_per_frame
+            double dropped;
+
+            // total simulated time
+            double simulation_time;
+        };
+
+        /**
+         * Processes OS events, returning early if one arrives before timeout seconds have passed (see os_wait).
+         */
+        using wait_function = std::function<void(double timeout)>;
+
+        explicit frame_loop(const settings &settings);
+
+        /**
+         * Measures the time since the previous call and runs step(fixed_step) as many times as it covers.
+         */
+        frame_info advance(const std::function<void(double step)> &step);
+
+        /**
+         * Blocks until the next frame should start. While idle, waits with wait(timeout) if one is given; otherwise
+         * calls wait(0.0) once, on every frame even when running late, then sleeps and spins up to the target rate's
+         * deadline.
+         */
+        void pace(const wait_function &wait = {});
+
+        /**
+         * Resets the clock so the time spent before this call (loading, a debugger break) is not simulated.
+         */
+        void reset_clock();
+
+        void set_target_frame_rate(double rate);
+
+        /**
+         * In idle mode frames are driven by OS events. The accumulator is reset on leaving idle, so the time spent idle
+         * is not simulated all at once.
+         */
+        void set_idle(bool idle);
+
+        [[nodiscard]] inline bool              idle() const noexcept { return m_idle; }
+        [[nodiscard]] inline const settings   &get_settings() const noexcept { return m_settings; }
+        [[nodiscard]] inline const frame_info &last_frame() const noexcept { return m_last_frame; }
+
+        /**
+         * @return How late the last paced frame started relative to its deadline, in seconds.
+         */
+        [[nodiscard]] inline double lateness() const noexcept { return m_lateness; }
+
+        /**
+         * While advance() runs a step, the real time that step brings the simulation up to. Input stamped before it
+         * belongs in the step (see input_queue::drain).
+         */
+        [[nodiscard]] inline clock::time_point step_end() const noexcept { return m_step_end; }
+
+      private:
+        settings          m_settings;
+        clock::time_point m_last_time;
+        clock::time_point m_deadline;
+        clock::time_point m_step_end;
+        double            m_accumulator = 0.0;
+        double            m_lateness    = 0.0;
+        bool              m_idle        = false;
+        frame_info        m_last_frame{};
+
+        metrics::histogram m_frame_time = metrics::registry::get().get_histogram("frame_time_microseconds");
+
+        void _sleep_until(clock::time_point deadline) const;
+    };
+
+} // namespace engine
@@ -0,0 +1,103 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "input.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace engine {
+
+    void input_state::begin_batch() noexcept {
+        keys_pressed.reset();
+        keys_released.reset();
+        buttons_pressed.reset();
+        buttons_released.reset();
+        scroll = glm::vec2(0.0f, 0.0f);
+    }
+
+    void input_state::apply(const input_event &event) noexcept {
+        switch (event.type) {
+        case input_event_type::key:
+            if (event.code >= key_count)
+                break;
+            if (event.action == input_action::press) {
+                keys.set(event.code);
+                keys_pressed.set(event.code);
+            } else if (event.action == input_action::release) {
+                keys.reset(event.code);
+                keys_released.set(event.code);
+            }
+            break;
+
+        case input_event_type::mouse_button:
+            if (event.code >= mouse_button_count)
+                break;
+            if (event.action == input_action::press) {
+                buttons.set(event.code);
+                buttons_pressed.set(event.code);
+            } else if (event.action == input_action::release) {
+                buttons.reset(event.code);
+                buttons_released.set(event.code);
+            }
+            break;
+
+        case input_event_type::cursor_position:
+            cursor = glm::vec2(event.x, event.y);
+            break;
+
+        case input_event_type::scroll:
+            scroll = glm::vec2(scroll.x + event.x, scroll.y + event.y);
+            break;
+
+        case input_event_type::cursor_enter:
+            cursor_inside = event.action == input_action::press;
+            break;
+
+        case input_event_type::focus:
+            focused = event.action == input_action::press;
+            break;
+
+        case input_event_type::character:
+            break;
+        }
+    }
+
+    input_queue::input_queue(const settings &settings)
+        : m_track_state(settings.track_state), m_events(std::bit_ceil(std::max<uint32_t>(settings.capacity, 1))),
+          m_mask(m_events.size() - 1) {
+        m_batch.reserve(m_events.size());
+    }
+
+    void input_queue::push(const input_event &event) noexcept {
+        if (size() == m_events.size()) {
+            if (m_track_state)
+                m_state.apply(m_events[m_head & m_mask]);
+            ++m_head;
+            ++m_dropped;
+            m_dropped_metric.increment();
+        }
+        m_events[m_tail++ & m_mask] = event;
+    }
+
+    std::span<const input_event> input_queue::drain(const clock::time_point until) {
+        m_batch.clear();
+        if (m_track_state)
+            m_state.begin_batch();
+
+        const clock::rep until_ticks = until.time_since_epoch().count();
+        for (; m_head != m_tail; ++m_head) {
+            const input_event &event = m_events[m_head & m_mask];
+            if (event.timestamp >= until_ticks)
+                break;
+            m_batch.push_back(event);
+            if (m_track_state)
+                m_state.apply(event);
+        }
+
+        m_events_metric.add(static_cast<int64_t>(m_batch.size()));
+        return m_batch;
+    }
+
+} // namespace engine
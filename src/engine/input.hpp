@@ -0,0 +1,147 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/metrics.hpp"
+
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace engine {
+
+    enum class input_event_type : uint8_t {
+        key,
+        character,
+        mouse_button,
+        cursor_position,
+        scroll,
+        cursor_enter,
+        focus,
+    };
+
+    enum class input_action : uint8_t {
+        release,
+        press,
+        repeat,
+    };
+
+    /**
+     * One input event as GLFW reported it. Key and button codes are GLFW's (GLFW_KEY_*, GLFW_MOUSE_BUTTON_*), and mods
+     * are its GLFW_MOD_* bits.
+     */
+    struct input_event {
+        using clock = std::chrono::steady_clock;
+
+        clock::rep       timestamp = 0; // ticks of clock since its epoch
+        float            x         = 0.0f; // cursor position or scroll offset
+        float            y         = 0.0f;
+        uint32_t         code      = 0; // key, mouse button or Unicode code point
+        input_event_type type      = input_event_type::key;
+        input_action     action    = input_action::press; // press or release for cursor_enter and focus too
+        uint8_t          mods      = 0;
+
+        [[nodiscard]] inline clock::time_point time() const noexcept {
+            return clock::time_point(clock::duration(timestamp));
+        }
+    };
+
+    static_assert(sizeof(input_event) == 24);
+
+    /**
+     * What the events drained so far add up to. The pressed and released sets and scroll only cover the last batch, so
+     * a key tapped within one step shows up as both pressed and released instead of being missed.
+     */
+    struct input_state {
+        static constexpr size_t key_count          = 512;
+        static constexpr size_t mouse_button_count = 8;
+
+        std::bitset<key_count>          keys; // held down
+        std::bitset<key_count>          keys_pressed;
+        std::bitset<key_count>          keys_released;
+        std::bitset<mouse_button_count> buttons; // held down
+        std::bitset<mouse_button_count> buttons_pressed;
+        std::bitset<mouse_button_count> buttons_released;
+        glm::vec2                       cursor{0.0f, 0.0f};
+        glm::vec2                       scroll{0.0f, 0.0f};
+        bool                            cursor_inside = false;
+        bool                            focused       = false;
+
+        /**
+         * Clears what only covers one batch.
+         */
+        void begin_batch() noexcept;
+
+        void apply(const input_event &event) noexcept;
+    };
+
+    /**
+     * Input events in the order they arrived, in a ring allocated up front, so pushing an event never allocates. The
+     * window's GLFW callbacks push into it while events are processed (os_poll, os_wait); the simulation drains it once
+     * per fixed step, taking the events stamped before the real time the step simulates up to (frame_loop::step_end),
+     * so input lands in the step it happened in rather than in whichever step first runs after the poll.
+     *
+     * Not thread-safe: GLFW calls its callbacks on the main thread, which is also where the simulation steps run.
+     */
+    class input_queue {
+      public:
+        using clock = input_event::clock;
+
+        struct settings {
+            // events held between drains, rounded up to a power of two
+            uint32_t capacity = 4096;
+
+            // whether drain() keeps state() up to date
+            bool track_state = true;
+        };
+
+        explicit input_queue(const settings &settings);
+
+        input_queue(const input_queue &other)                = delete;
+        input_queue(input_queue &&other) noexcept            = delete;
+        input_queue &operator=(const input_queue &other)     = delete;
+        input_queue &operator=(input_queue &&other) noexcept = delete;
+
+        /**
+         * Events have to be pushed in timestamp order. When the queue is full, the oldest event is dropped; it is still
+         * applied to state() so held keys stay right, but its press or release does not show up in a batch.
+         */
+        void push(const input_event &event) noexcept;
+
+        /**
+         * Takes the events stamped before until, oldest first, and applies them to state().
+         *
+         * @return The events taken, valid until the next drain
+         */
+        std::span<const input_event> drain(clock::time_point until);
+
+        /**
+         * @return What the last drain() returned
+         */
+        [[nodiscard]] inline std::span<const input_event> batch() const noexcept { return m_batch; }
+        [[nodiscard]] inline const input_state           &state() const noexcept { return m_state; }
+        [[nodiscard]] inline size_t                       size() const noexcept { return m_tail - m_head; }
+        [[nodiscard]] inline size_t                       capacity() const noexcept { return m_events.size(); }
+        [[nodiscard]] inline uint64_t                     dropped() const noexcept { return m_dropped; }
+
+      private:
+        bool                     m_track_state;
+        std::vector<input_event> m_events;
+        uint64_t                 m_mask;
+        uint64_t                 m_head    = 0; // the oldest event
+        uint64_t                 m_tail    = 0; // one past the newest event
+        uint64_t                 m_dropped = 0;
+        std::vector<input_event> m_batch; // reserved to the capacity, so draining does not allocate either
+        input_state              m_state;
+
+        metrics::counter m_events_metric  = metrics::registry::get().get_counter("input_events");
+        metrics::counter m_dropped_metric = metrics::registry::get().get_counter("input_events_dropped");
+    };
+
+} // namespace engine
@@ -0,0 +1,179 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "jobs.hpp"
+
+#include "profiler.hpp"
+
+namespace engine {
+    static thread_local const job_system *t_owner       = nullptr;
+    static thread_local size_t            t_queue_index = 0;
+
+    job_system::job_system(const settings &settings) : m_main_thread(std::this_thread::get_id()) {
+        uint32_t worker_count = settings.worker_count;
+        if (worker_count == 0) {
+            worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        }
+
+        m_queues.reserve(worker_count + 1);
+        for (uint32_t i = 0; i <= worker_count; ++i) {
+            m_queues.push_back(std::make_unique<work_queue>());
+        }
+
+        m_threads.reserve(worker_count);
+        for (uint32_t i = 1; i <= worker_count; ++i) {
+            m_threads.emplace_back([this, i] { _worker_main(i); });
+        }
+    }
+
+    job_system::~job_system() {
+        {
+            std::lock_guard lock(m_sleep_mutex);
+            m_running.store(false, std::memory_order_release);
+        }
+        m_wake.notify_all();
+
+        for (auto &thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void job_system::submit(job job, job_counter *counter) {
+        if (counter)
+            counter->add();
+
+        {
+            work_queue     &queue = *m_queues[_queue_index()];
+            std::lock_guard lock(queue.mutex);
+            queue.jobs.push_back(queued_job{std::move(job), counter});
+        }
+
+        m_queued.fetch_add(1, std::memory_order_release);
+        {
+            // pairs with the predicate check in _worker_main so a worker cannot miss this wakeup
+            std::lock_guard lock(m_sleep_mutex);
+        }
+        m_wake.notify_one();
+    }
+
+    void job_system::submit_main_thread(job job, job_counter *counter) {
+        if (counter)
+            counter->add();
+
+        std::lock_guard lock(m_main_queue.mutex);
+        m_main_queue.jobs.push_back(queued_job{std::move(job), counter});
+    }
+
+    void job_system::wait(const job_counter &counter) {
+        const size_t index = _queue_index();
+        const bool   main  = is_main_thread();
+
+        while (!counter.is_done()) {
+            if (main)
+                run_main_thread_jobs();
+
+            if (!_try_run_one(index)) {
+                std::this_thread::yield();
+            }
+        }
+
+        if (counter.exception())
+            std::rethrow_exception(counter.exception());
+    }
+
+    void job_system::run_main_thread_jobs() {
+        while (true) {
+            queued_job job;
+            {
+                std::lock_guard lock(m_main_queue.mutex);
+                if (m_main_queue.jobs.empty())
+                    return;
+
+                job = std::move(m_main_queue.jobs.front());
+                m_main_queue.jobs.pop_front();
+            }
+            _execute(job);
+        }
+    }
+
+    bool job_system::is_main_thread() const noexcept {
+        return std::this_thread::get_id() == m_main_thread;
+    }
+
+    void job_system::_worker_main(const size_t index) {
+        t_owner       = this;
+        t_queue_index = index;
+        ENGINE_PROFILE_THREAD("worker " + std::to_string(index));
+
+        while (m_running.load(std::memory_order_acquire)) {
+            if (_try_run_one(index))
+                continue;
+
+            std::unique_lock lock(m_sleep_mutex);
+            m_wake.wait(lock, [this] {
+                return !m_running.load(std::memory_order_acquire) || m_queued.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+    size_t job_system::_queue_index() const noexcept {
+        return t_owner == this ? t_queue_index : 0;
+    }
+
+    bool job_system::_try_pop(const size_t index, queued_job &out) {
+        work_queue     &queue = *m_queues[index];
+        std::lock_guard lock(queue.mutex);
+        if (queue.jobs.empty())
+            return false;
+
+        out = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+        return true;
+    }
+
+    bool job_system::_try_steal(const size_t thief, queued_job &out) {
+        const size_t count = m_queues.size();
+        for (size_t offset = 1; offset < count; ++offset) {
+            work_queue      &queue = *m_queues[(thief + offset) % count];
+            std::unique_lock lock(queue.mutex, std::try_to_lock);
+            if (!lock.owns_lock() || queue.jobs.empty())
+                continue;
+
+            out = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool job_system::_try_run_one(const size_t index) {
+        queued_job job;
+        if (!_try_pop(index, job) && !_try_steal(index, job))
+            return false;
+
+        m_queued.fetch_sub(1, std::memory_order_acq_rel);
+        _execute(job);
+        return true;
+    }
+
+    void job_system::_execute(queued_job &job) {
+        // counts the job done however it ends, so a throwing job cannot leave its waiters blocked
+        struct finish_guard {
+            job_counter *counter;
+
+            ~finish_guard() {
+                if (counter)
+                    counter->done();
+            }
+        } guard{job.counter};
+
+        try {
+            job.function();
+        } catch (...) {
+            if (!job.counter)
+                throw;
+            job.counter->fail(std::current_exception());
+        }
+    }
+} // namespace engine
@@ -0,0 +1,169 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Counts outstanding jobs so a caller can wait for a batch of work to finish. Keeps the first exception thrown by
+     * one of its jobs, which job_system::wait rethrows once the rest are done.
+     */
+    class job_counter {
+      public:
+        inline void add(const uint32_t count = 1) noexcept { m_pending.fetch_add(count, std::memory_order_relaxed); }
+        inline void done() noexcept { m_pending.fetch_sub(1, std::memory_order_acq_rel); }
+
+        /**
+         * Records a job's exception, unless one was recorded already. Called before that job's done(), so whoever sees
+         * the counter done sees the exception.
+         */
+        inline void fail(std::exception_ptr exception) noexcept {
+            if (!m_failed.exchange(true, std::memory_order_acq_rel))
+                m_exception = std::move(exception);
+        }
+
+        [[nodiscard]] inline bool is_done() const noexcept { return m_pending.load(std::memory_order_acquire) == 0; }
+
+        /**
+         * @return The first exception a job threw, or null. Only meaningful once is_done().
+         */
+        [[nodiscard]] inline const std::exception_ptr &exception() const noexcept { return m_exception; }
+
+      private:
+        std::atomic<uint32_t> m_pending = 0;
+        std::atomic<bool>     m_failed  = false;
+        std::exception_ptr    m_exception;
+    };
+
+    /**
+     * A work-stealing job scheduler. Every worker owns a deque: it pushes and pops its own jobs from the back while idle
+     * workers steal from the front of the others. The thread that constructs the job system is treated as the main
+     * thread; it does not run a worker loop but helps execute jobs while it waits, and it alone runs jobs submitted
+     * with main-thread affinity.
+     *
+     * A job that throws still counts as done. Its exception is kept in its counter and rethrown by wait(); a job
+     * submitted without a counter has nowhere to report it, so its exception ends the program like one escaping a
+     * std::thread.
+     */
+    class job_system {
+      public:
+        using job = std::function<void()>;
+
+        struct settings {
+            // 0 picks std::thread::hardware_concurrency() - 1
+            uint32_t worker_count = 0;
+        };
+
+        explicit job_system(const settings &settings);
+        ~job_system();
+
+        job_system(const job_system &other)                = delete;
+        job_system(job_system &&other) noexcept            = delete;
+        job_system &operator=(const job_system &other)     = delete;
+        job_system &operator=(job_system &&other) noexcept = delete;
+
+        /**
+         * Queues a job on the calling thread's deque (or the shared queue if called from outside the job system).
+         */
+        void submit(job job, job_counter *counter = nullptr);
+
+        /**
+         * Queues a job that will only ever run on the main thread, either in wait() or run_main_thread_jobs().
+         */
+        void submit_main_thread(job job, job_counter *counter = nullptr);
+
+        /**
+         * Blocks until the counter reaches zero, executing queued jobs in the meantime, then rethrows the first
+         * exception one of its jobs threw.
+         */
+        void wait(const job_counter &counter);
+
+        void run_main_thread_jobs();
+
+        /**
+         * Splits [0, count) into chunks of at most grain elements, runs f(begin, end) for each in parallel and waits for
+         * all of them. Rethrows the first exception f threw, once every chunk has finished.
+         */
+        template <typename F>
+        void parallel_for(const size_t count, size_t grain, F &&f) {
+            if (count == 0)
+                return;
+
+            grain = std::max<size_t>(grain, 1);
+            if (count <= grain) {
+                f(size_t(0), count);
+                return;
+            }
+
+            job_counter counter;
+            for (size_t begin = grain; begin < count; begin += grain) {
+                const size_t end = std::min(begin + grain, count);
+                submit([&f, begin, end] { f(begin, end); }, &counter);
+            }
+
+            // the queued chunks hold f and counter by reference, so they have to finish even if this one throws
+            try {
+                f(size_t(0), grain);
+            } catch (...) {
+                counter.fail(std::current_exception());
+            }
+            wait(counter);
+        }
+
+        /**
+         * @return The number of threads that execute jobs, including the main thread.
+         */
+        [[nodiscard]] inline uint32_t thread_count() const noexcept {
+            return static_cast<uint32_t>(m_threads.size()) + 1;
+        }
+
+        [[nodiscard]] bool is_main_thread() const noexcept;
+
+      private:
+        struct queued_job {
+            job          function;
+            job_counter *counter;
+        };
+
+        struct work_queue {
+            std::mutex             mutex;
+            std::deque<queued_job> jobs;
+        };
+
+        // index 0 is shared by the main thread and any thread outside the job system
+        std::vector<std::unique_ptr<work_queue>> m_queues;
+        work_queue                               m_main_queue;
+        std::vector<std::thread>                 m_threads;
+        std::thread::id                          m_main_thread;
+
+        std::atomic<bool>       m_running = true;
+        std::atomic<uint32_t>   m_queued  = 0;
+        std::mutex              m_sleep_mutex;
+        std::condition_variable m_wake;
+
+        void _worker_main(size_t index);
+
+        [[nodiscard]] size_t _queue_index() const noexcept;
+
+        bool _try_pop(size_t index, queued_job &out);
+        bool _try_steal(size_t thief, queued_job &out);
+        bool _try_run_one(size_t index);
+
+        static void _execute(queued_job &job);
+    };
+
+} // namespace engine
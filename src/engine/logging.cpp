@@ -3,7 +3,20 @@
 //
 #include "logging.hpp"
 
+#include "engine/metrics.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ranges>
+#include <thread>
 #include <utility>
+#include <vector>
+#include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/sinks/sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 namespace engine {
@@ -35,4 +48,321 @@ namespace engine {
 #endif
         return logger;
     }
+
+    routing_logger_factory::routing_logger_factory(std::shared_ptr<logger_factory> fallback)
+        : m_fallback(std::move(fallback)) {}
+
+    void routing_logger_factory::route(const std::string &logger_name, std::shared_ptr<logger_factory> factory) {
+        m_routes[logger_name] = std::move(factory);
+    }
+
+    void routing_logger_factory::route_list(const std::string_view                 logger_names,
+                                            const std::shared_ptr<logger_factory> &factory) {
+        for (const auto part : std::views::split(logger_names, ',')) {
+            const std::string_view name(part.begin(), part.end());
+            if (!name.empty())
+                route(std::string(name), factory);
+        }
+    }
+
+    std::shared_ptr<spdlog::logger> routing_logger_factory::create_logger(const std::string     &name,
+                                                                          const logger_settings &settings) {
+        if (const auto it = m_routes.find(name); it != m_routes.end()) {
+            return it->second->create_logger(name, settings);
+        }
+        return m_fallback->create_logger(name, settings);
+    }
+
+    struct log_target {
+        std::string name;
+        bool        ephemeral;
+    };
+
+    /**
+     * A bounded multi-producer queue of log messages (Vyukov's array queue, where each slot's sequence number says
+     * whether it is ready to be written or read) drained by one flusher thread.
+     */
+    class async_log_backend {
+      public:
+        explicit async_log_backend(const async_logger_factory::settings &settings)
+            : m_settings(settings), m_slots(std::bit_ceil(std::max<size_t>(settings.queue_capacity, 2))),
+              m_mask(m_slots.size() - 1) {
+            for (size_t i = 0; i < m_slots.size(); ++i) {
+                m_slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            m_console = std::make_shared<spdlog::sinks::stdout_color_sink_st>();
+            m_thread  = std::thread([this] { _flusher_main(); });
+        }
+
+        ~async_log_backend() {
+            {
+                std::lock_guard lock(m_wake_mutex);
+                m_running = false;
+            }
+            m_wake.notify_all();
+            m_thread.join();
+        }
+
+        async_log_backend(const async_log_backend &other)                = delete;
+        async_log_backend(async_log_backend &&other) noexcept            = delete;
+        async_log_backend &operator=(const async_log_backend &other)     = delete;
+        async_log_backend &operator=(async_log_backend &&other) noexcept = delete;
+
+        const log_target *add_target(const std::string &name, const bool ephemeral) {
+            std::lock_guard lock(m_sink_mutex);
+            if (!ephemeral && !m_file) {
+                m_file = std::make_shared<spdlog::sinks::rotating_file_sink_st>(
+                    (m_settings.log_directory / m_settings.file_name).string(), m_settings.max_file_size,
+                    m_settings.max_files
+                );
+                if (m_formatter)
+                    m_file->set_formatter(m_formatter->clone());
+            }
+            return &m_targets.emplace_back(log_target{.name = name, .ephemeral = ephemeral});
+        }
+
+        void push(const log_target *target, const spdlog::details::log_msg &msg) {
+            size_t pos;
+            while (!_try_claim(pos)) {
+                switch (m_settings.overflow) {
+                    case log_overflow_policy::drop:
+                        m_dropped.fetch_add(1, std::memory_order_relaxed);
+                        m_dropped_metric.increment();
+                        return;
+                    case log_overflow_policy::overwrite:
+                        if (_try_discard_oldest()) {
+                            m_dropped.fetch_add(1, std::memory_order_relaxed);
+                            m_dropped_metric.increment();
+                        }
+                        break;
+                    case log_overflow_policy::block:
+                        _wake();
+                        std::this_thread::yield();
+                        break;
+                }
+            }
+
+            log_slot &slot = m_slots[pos & m_mask];
+            slot.target    = target;
+            slot.level     = msg.level;
+            slot.time      = msg.time;
+            slot.thread_id = msg.thread_id;
+            slot.source    = msg.source;
+            slot.length    = msg.payload.size();
+            if (slot.length <= slot.text.size()) {
+                std::copy_n(msg.payload.data(), slot.length, slot.text.data());
+            } else {
+                slot.long_text.assign(msg.payload.data(), msg.payload.size());
+            }
+            slot.sequence.store(pos + 1, std::memory_order_release);
+
+            const size_t queued = pos - m_dequeue_pos.load(std::memory_order_relaxed);
+            if (msg.level >= spdlog::level::err || queued == m_slots.size() / 2) {
+                _wake();
+            }
+        }
+
+        /**
+         * Blocks until every message pushed before the call has been written and the sinks flushed.
+         */
+        void flush() {
+            std::unique_lock lock(m_wake_mutex);
+            const uint64_t   request = ++m_flush_requested;
+            m_wake_requested         = true;
+            m_wake.notify_all();
+            m_flushed.wait(lock, [&] { return m_flush_completed >= request || !m_running; });
+        }
+
+        void set_formatter(std::unique_ptr<spdlog::formatter> formatter) {
+            std::lock_guard lock(m_sink_mutex);
+            m_console->set_formatter(formatter->clone());
+            if (m_file)
+                m_file->set_formatter(formatter->clone());
+            m_formatter = std::move(formatter);
+        }
+
+        [[nodiscard]] size_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+      private:
+        struct log_slot {
+            std::atomic<size_t>           sequence;
+            const log_target             *target;
+            spdlog::level::level_enum     level;
+            spdlog::log_clock::time_point time;
+            size_t                        thread_id;
+            spdlog::source_loc            source;
+            size_t                        length;
+            std::array<char, 176>         text;
+            std::string                   long_text; // only used by messages that do not fit in text
+        };
+
+        async_logger_factory::settings m_settings;
+        std::vector<log_slot>          m_slots;
+        size_t                         m_mask;
+
+        alignas(64) std::atomic<size_t> m_enqueue_pos = 0;
+        alignas(64) std::atomic<size_t> m_dequeue_pos = 0;
+        alignas(64) std::atomic<size_t> m_dropped     = 0;
+
+        metrics::counter m_dropped_metric = metrics::registry::get().get_counter("log_messages_dropped");
+
+        std::mutex                                            m_sink_mutex;
+        std::deque<log_target>                                m_targets;
+        std::shared_ptr<spdlog::sinks::stdout_color_sink_st>  m_console;
+        std::shared_ptr<spdlog::sinks::rotating_file_sink_st> m_file;
+        std::unique_ptr<spdlog::formatter>                    m_formatter;
+
+        std::mutex              m_wake_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_flushed;
+        bool                    m_wake_requested  = false;
+        bool                    m_running         = true;
+        uint64_t                m_flush_requested = 0;
+        uint64_t                m_flush_completed = 0;
+        std::thread             m_thread;
+
+        bool _try_claim(size_t &pos) {
+            pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                const size_t    sequence = m_slots[pos & m_mask].sequence.load(std::memory_order_acquire);
+                const ptrdiff_t diff     = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        return true;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // claims the oldest published slot for reading; release it with _release
+        bool _try_acquire(size_t &pos) {
+            pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                const size_t    sequence = m_slots[pos & m_mask].sequence.load(std::memory_order_acquire);
+                const ptrdiff_t diff     = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        return true;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void _release(const size_t pos) {
+            m_slots[pos & m_mask].sequence.store(pos + m_mask + 1, std::memory_order_release);
+        }
+
+        bool _try_discard_oldest() {
+            size_t pos;
+            if (!_try_acquire(pos))
+                return false;
+            _release(pos);
+            return true;
+        }
+
+        void _wake() {
+            {
+                std::lock_guard lock(m_wake_mutex);
+                m_wake_requested = true;
+            }
+            m_wake.notify_one();
+        }
+
+        void _drain() {
+            std::lock_guard lock(m_sink_mutex);
+
+            size_t pos;
+            while (_try_acquire(pos)) {
+                const log_slot &slot = m_slots[pos & m_mask];
+
+                const char *text = slot.length <= slot.text.size() ? slot.text.data() : slot.long_text.data();
+                spdlog::details::log_msg msg(
+                    slot.time, slot.source, spdlog::string_view_t(slot.target->name.data(), slot.target->name.size()),
+                    slot.level, spdlog::string_view_t(text, slot.length)
+                );
+                msg.thread_id = slot.thread_id;
+
+                m_console->log(msg);
+                if (m_file && !slot.target->ephemeral) {
+                    m_file->log(msg);
+                }
+
+                _release(pos);
+            }
+
+            m_console->flush();
+            if (m_file)
+                m_file->flush();
+        }
+
+        void _flusher_main() {
+            std::unique_lock lock(m_wake_mutex);
+            for (;;) {
+                const uint64_t flush_request = m_flush_requested;
+                const bool     running       = m_running;
+                m_wake_requested             = false;
+
+                lock.unlock();
+                _drain();
+                lock.lock();
+
+                m_flush_completed = flush_request;
+                m_flushed.notify_all();
+
+                if (!running)
+                    break;
+
+                m_wake.wait_for(lock, m_settings.flush_interval, [this] { return m_wake_requested || !m_running; });
+            }
+        }
+    };
+
+    class async_ring_sink final : public spdlog::sinks::sink {
+      public:
+        async_ring_sink(std::shared_ptr<async_log_backend> backend, const log_target *target)
+            : m_backend(std::move(backend)), m_target(target) {}
+
+        void log(const spdlog::details::log_msg &msg) override { m_backend->push(m_target, msg); }
+        void flush() override { m_backend->flush(); }
+
+        void set_pattern(const std::string &pattern) override {
+            m_backend->set_formatter(std::make_unique<spdlog::pattern_formatter>(pattern));
+        }
+
+        void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override {
+            m_backend->set_formatter(std::move(sink_formatter));
+        }
+
+      private:
+        std::shared_ptr<async_log_backend> m_backend;
+        const log_target                  *m_target;
+    };
+
+    async_logger_factory::async_logger_factory(const settings &settings)
+        : m_backend(std::make_shared<async_log_backend>(settings)) {}
+
+    async_logger_factory::~async_logger_factory() = default;
+
+    std::shared_ptr<spdlog::logger> async_logger_factory::create_logger(const std::string     &name,
+                                                                        const logger_settings &settings) {
+        const log_target *target = m_backend->add_target(name, settings.ephemeral_only);
+        auto logger = std::make_shared<spdlog::logger>(name, std::make_shared<async_ring_sink>(m_backend, target));
+#ifndef NDEBUG
+        logger->set_level(spdlog::level::debug);
+#else
+        logger->set_level(spdlog::level::info);
+#endif
+        spdlog::register_logger(logger);
+        return logger;
+    }
+
+    size_t async_logger_factory::dropped_messages() const noexcept {
+        return m_backend->dropped();
+    }
 } // namespace engine
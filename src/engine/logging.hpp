@@ -6,6 +6,11 @@
 
 #include <spdlog/spdlog.h>
 
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string_view>
+
 namespace engine {
 
     struct logger_settings {
@@ -31,4 +36,73 @@ namespace engine {
         std::shared_ptr<spdlog::logger> create_logger(const std::string     &name,
                                                       const logger_settings &settings) override;
     };
+
+    /**
+     * Picks the factory for each logger by name, so individual loggers (such as "glfw" or "render") can be sent to a
+     * different backend without touching the code that creates them.
+     */
+    class routing_logger_factory final : public logger_factory {
+      public:
+        explicit routing_logger_factory(std::shared_ptr<logger_factory> fallback);
+
+        void route(const std::string &logger_name, std::shared_ptr<logger_factory> factory);
+
+        /**
+         * Routes every logger named in a comma-separated list (such as "glfw,render") to factory.
+         */
+        void route_list(std::string_view logger_names, const std::shared_ptr<logger_factory> &factory);
+
+        std::shared_ptr<spdlog::logger> create_logger(const std::string     &name,
+                                                      const logger_settings &settings) override;
+
+      private:
+        std::shared_ptr<logger_factory>                                     m_fallback;
+        std::map<std::string, std::shared_ptr<logger_factory>, std::less<>> m_routes;
+    };
+
+    enum class log_overflow_policy {
+        block,     // wait for the flusher to make room
+        drop,      // discard the new message
+        overwrite, // discard the oldest queued message
+    };
+
+    class async_log_backend;
+
+    /**
+     * Creates loggers that hand messages to a background flusher thread instead of writing them on the calling thread.
+     * A call formats the user's arguments into the message text (spdlog does that before any sink sees it) and copies
+     * it into a slot of a lock-free ring; the pattern (time, level, logger name) is applied and written to the console
+     * and, unless the logger is ephemeral_only, a rotating log file on the flusher thread.
+     *
+     * Every logger from one factory shares the ring and the flusher. Messages at error level or above wake the flusher
+     * right away.
+     */
+    class async_logger_factory final : public logger_factory {
+      public:
+        struct settings {
+            // rounded up to a power of two
+            size_t                    queue_capacity = 8192;
+            log_overflow_policy       overflow       = log_overflow_policy::block;
+            std::chrono::milliseconds flush_interval = std::chrono::milliseconds(50);
+
+            std::filesystem::path log_directory = "logs";
+            std::string           file_name     = "engine.log";
+            size_t                max_file_size = size_t(8) << 20;
+            size_t                max_files     = 3;
+        };
+
+        explicit async_logger_factory(const settings &settings);
+        ~async_logger_factory() override;
+
+        std::shared_ptr<spdlog::logger> create_logger(const std::string     &name,
+                                                      const logger_settings &settings) override;
+
+        /**
+         * @return How many messages were discarded by the drop or overwrite policies.
+         */
+        [[nodiscard]] size_t dropped_messages() const noexcept;
+
+      private:
+        std::shared_ptr<async_log_backend> m_backend;
+    };
 } // namespace engine
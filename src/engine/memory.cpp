@@ -0,0 +1,154 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "memory.hpp"
+
+#include <algorithm>
+
+namespace engine {
+    static constexpr size_t max_alignment = alignof(std::max_align_t);
+
+    static size_t align_up(const size_t value, const size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    pool_resource::pool_resource(const size_t blocks_per_chunk)
+        : m_blocks_per_chunk(std::max<size_t>(blocks_per_chunk, 1)) {}
+
+    pool_resource::~pool_resource() {
+        for (std::byte *chunk : m_chunks) {
+            ::operator delete(chunk, std::align_val_t(m_block_alignment));
+        }
+    }
+
+    void *pool_resource::allocate(const size_t size, const size_t alignment) {
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_block_size == 0) {
+                m_block_alignment = std::max(alignment, alignof(free_block));
+                m_block_size      = align_up(std::max(size, sizeof(free_block)), m_block_alignment);
+                if (m_pending_reserve > 0) {
+                    _add_chunk(m_pending_reserve);
+                    m_pending_reserve = 0;
+                }
+            }
+
+            if (size <= m_block_size && alignment <= m_block_alignment) {
+                if (!m_free_list) {
+                    _add_chunk(m_blocks_per_chunk);
+                }
+
+                free_block *block = m_free_list;
+                m_free_list       = block->next;
+                m_live_blocks.fetch_add(1, std::memory_order_relaxed);
+                return block;
+            }
+        }
+
+        return ::operator new(size, std::align_val_t(std::max(alignment, max_alignment)));
+    }
+
+    void pool_resource::deallocate(void *ptr, const size_t size, const size_t alignment) noexcept {
+        {
+            std::lock_guard lock(m_mutex);
+            if (size <= m_block_size && alignment <= m_block_alignment) {
+                auto *block = static_cast<free_block *>(ptr);
+                block->next = m_free_list;
+                m_free_list = block;
+                m_live_blocks.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        ::operator delete(ptr, std::align_val_t(std::max(alignment, max_alignment)));
+    }
+
+    void pool_resource::reserve(const size_t count) {
+        std::lock_guard lock(m_mutex);
+        if (m_block_size == 0) {
+            m_pending_reserve = std::max(m_pending_reserve, count);
+            return;
+        }
+
+        const size_t available = m_total_blocks - m_live_blocks.load(std::memory_order_relaxed);
+        if (available < count) {
+            _add_chunk(count - available);
+        }
+    }
+
+    void pool_resource::_add_chunk(const size_t blocks) {
+        auto *chunk =
+            static_cast<std::byte *>(::operator new(blocks * m_block_size, std::align_val_t(m_block_alignment)));
+        m_chunks.push_back(chunk);
+        m_total_blocks += blocks;
+
+        // thread the new blocks onto the free list in address order so bulk allocations come out contiguous
+        for (size_t i = blocks; i-- > 0;) {
+            auto *block = reinterpret_cast<free_block *>(chunk + i * m_block_size);
+            block->next = m_free_list;
+            m_free_list = block;
+        }
+    }
+
+    frame_arena::frame_arena(const size_t chunk_size) : m_chunk_size(chunk_size) {}
+
+    frame_arena::~frame_arena() {
+        _release();
+    }
+
+    void *frame_arena::allocate(const size_t size, const size_t alignment) {
+        void *ptr = m_chunks.empty() ? nullptr : _bump(size, alignment);
+        if (!ptr) {
+            _add_chunk(size + alignment);
+            ptr = _bump(size, alignment);
+        }
+
+        m_bytes_used += size;
+        m_peak_bytes_used = std::max(m_peak_bytes_used, m_bytes_used);
+        return ptr;
+    }
+
+    void frame_arena::reset() {
+        if (m_chunks.size() > 1) {
+            size_t total = 0;
+            for (const auto &c : m_chunks) {
+                total += c.size;
+            }
+            _release();
+            m_chunk_size = std::max(m_chunk_size, total);
+            _add_chunk(m_chunk_size);
+        }
+
+        m_offset     = 0;
+        m_bytes_used = 0;
+    }
+
+    void *frame_arena::_bump(const size_t size, const size_t alignment) {
+        const chunk    &current = m_chunks.back();
+        const uintptr_t base    = reinterpret_cast<uintptr_t>(current.data);
+        const uintptr_t address = align_up(base + m_offset, alignment);
+        if (address + size > base + current.size)
+            return nullptr;
+
+        m_offset = address + size - base;
+        return reinterpret_cast<void *>(address);
+    }
+
+    void frame_arena::_add_chunk(const size_t min_size) {
+        const size_t size = std::max(m_chunk_size, min_size);
+        m_chunks.push_back(chunk{
+            .data = static_cast<std::byte *>(::operator new(size, std::align_val_t(max_alignment))),
+            .size = size,
+        });
+        m_offset = 0;
+    }
+
+    void frame_arena::_release() {
+        for (const auto &c : m_chunks) {
+            ::operator delete(c.data, std::align_val_t(max_alignment));
+        }
+        m_chunks.clear();
+        m_offset = 0;
+    }
+} // namespace engine
@@ -0,0 +1,164 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * A pool of fixed-size blocks carved out of large chunks, with freed blocks kept on an intrusive free list. The block
+     * size is taken from the first allocation, so a pool can serve allocator-aware containers (such as
+     * std::allocate_shared) whose allocation size is only known after rebinding. Requests of any other size fall back to
+     * the global heap.
+     */
+    class pool_resource {
+      public:
+        explicit pool_resource(size_t blocks_per_chunk = 256);
+        ~pool_resource();
+
+        pool_resource(const pool_resource &other)                = delete;
+        pool_resource(pool_resource &&other) noexcept            = delete;
+        pool_resource &operator=(const pool_resource &other)     = delete;
+        pool_resource &operator=(pool_resource &&other) noexcept = delete;
+
+        [[nodiscard]] void *allocate(size_t size, size_t alignment);
+        void                deallocate(void *ptr, size_t size, size_t alignment) noexcept;
+
+        /**
+         * Ensures at least count blocks can be allocated without touching the global heap. If the block size is not
+         * known yet, the reservation is applied on the first allocation.
+         */
+        void reserve(size_t count);
+
+        [[nodiscard]] inline size_t block_size() const noexcept { return m_block_size; }
+        [[nodiscard]] inline size_t live_blocks() const noexcept { return m_live_blocks.load(std::memory_order_relaxed); }
+
+        /**
+         * @return How many chunks were requested from the global heap over the pool's lifetime.
+         */
+        [[nodiscard]] inline size_t chunk_allocations() const noexcept { return m_chunks.size(); }
+
+      private:
+        struct free_block {
+            free_block *next;
+        };
+
+        std::mutex m_mutex;
+
+        size_t m_block_size      = 0;
+        size_t m_block_alignment = 0;
+        size_t m_blocks_per_chunk;
+        size_t m_pending_reserve = 0;
+
+        free_block              *m_free_list = nullptr;
+        std::vector<std::byte *> m_chunks;
+        size_t                   m_total_blocks = 0; // in every chunk, so reserve need not walk the free list
+        std::atomic<size_t>      m_live_blocks  = 0;
+
+        void _add_chunk(size_t blocks);
+    };
+
+    /**
+     * A standard allocator drawing single-object allocations from a shared pool_resource. Copies (and rebinds) share the
+     * pool, and keep it alive for as long as any allocation made through them.
+     */
+    template <typename T>
+    class pool_allocator {
+      public:
+        using value_type = T;
+
+        explicit pool_allocator(std::shared_ptr<pool_resource> pool) noexcept : m_pool(std::move(pool)) {}
+
+        template <typename U>
+        pool_allocator(const pool_allocator<U> &other) noexcept : m_pool(other.pool()) {}
+
+        [[nodiscard]] T *allocate(const size_t n) {
+            if (n == 1)
+                return static_cast<T *>(m_pool->allocate(sizeof(T), alignof(T)));
+            return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+
+        void deallocate(T *ptr, const size_t n) noexcept {
+            if (n == 1) {
+                m_pool->deallocate(ptr, sizeof(T), alignof(T));
+            } else {
+                ::operator delete(ptr, std::align_val_t(alignof(T)));
+            }
+        }
+
+        [[nodiscard]] inline const std::shared_ptr<pool_resource> &pool() const noexcept { return m_pool; }
+
+        template <typename U>
+        bool operator==(const pool_allocator<U> &other) const noexcept {
+            return m_pool == other.pool();
+        }
+
+      private:
+        std::shared_ptr<pool_resource> m_pool;
+    };
+
+    /**
+     * A linear allocator for transient data. Allocation is a pointer bump and everything is released at once by reset(),
+     * so it only holds trivially destructible objects. Not thread-safe.
+     */
+    class frame_arena {
+      public:
+        explicit frame_arena(size_t chunk_size = 1 << 20);
+        ~frame_arena();
+
+        frame_arena(const frame_arena &other)                = delete;
+        frame_arena(frame_arena &&other) noexcept            = delete;
+        frame_arena &operator=(const frame_arena &other)     = delete;
+        frame_arena &operator=(frame_arena &&other) noexcept = delete;
+
+        [[nodiscard]] void *allocate(size_t size, size_t alignment);
+
+        template <typename T>
+        [[nodiscard]] T *allocate_array(const size_t count) {
+            static_assert(std::is_trivially_destructible_v<T>, "frame_arena never runs destructors");
+            return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        template <typename T, typename... Args>
+        T *create(Args &&...args) {
+            static_assert(std::is_trivially_destructible_v<T>, "frame_arena never runs destructors");
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Releases every allocation. Chunks are kept for reuse; if the last frame needed more than one, they are merged
+         * into a single chunk large enough for the whole frame.
+         */
+        void reset();
+
+        [[nodiscard]] inline size_t bytes_used() const noexcept { return m_bytes_used; }
+        [[nodiscard]] inline size_t peak_bytes_used() const noexcept { return m_peak_bytes_used; }
+
+      private:
+        struct chunk {
+            std::byte *data;
+            size_t     size;
+        };
+
+        std::vector<chunk> m_chunks;
+        size_t             m_chunk_size;
+        size_t             m_offset          = 0;
+        size_t             m_bytes_used      = 0;
+        size_t             m_peak_bytes_used = 0;
+
+        void *_bump(size_t size, size_t alignment);
+        void  _add_chunk(size_t min_size);
+        void  _release();
+    };
+
+} // namespace engine
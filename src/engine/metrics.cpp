@@ -0,0 +1,249 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace engine::metrics {
+    static std::atomic<int64_t> s_discarded_gauge = 0;
+
+    gauge::gauge() : m_value(&s_discarded_gauge) {}
+
+    uint64_t snapshot::histogram_value::quantile(const double q) const noexcept {
+        if (count == 0)
+            return 0;
+
+        const auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+        uint64_t   seen = 0;
+        for (uint32_t bucket = 0; bucket < buckets.size(); ++bucket) {
+            seen += buckets[bucket];
+            if (seen >= std::max<uint64_t>(rank, 1)) {
+                return histogram::bucket_lower_bound(bucket) + histogram::bucket_width(bucket) / 2;
+            }
+        }
+        return histogram::bucket_lower_bound(histogram::bucket_count - 1);
+    }
+
+    // splits "name{labels}" into the name and the labels without braces
+    static std::pair<std::string_view, std::string_view> split_labels(const std::string_view name) {
+        const size_t brace = name.find('{');
+        if (brace == std::string_view::npos || name.back() != '}')
+            return {name, {}};
+        return {name.substr(0, brace), name.substr(brace + 1, name.size() - brace - 2)};
+    }
+
+    static void write_family(std::ostream &out, const std::string_view prefix, const std::string_view family,
+                             const std::string_view type, std::string_view &last_family) {
+        if (family == last_family)
+            return;
+        last_family = family;
+        out << "# TYPE " << prefix << family << ' ' << type << '\n';
+    }
+
+    static void write_sample(std::ostream &out, const std::string_view prefix, const std::string_view family,
+                             const std::string_view suffix, const std::string_view labels,
+                             const std::string_view extra_label, const auto value) {
+        out << prefix << family << suffix;
+        if (!labels.empty() || !extra_label.empty()) {
+            out << '{' << labels << (!labels.empty() && !extra_label.empty() ? "," : "") << extra_label << '}';
+        }
+        out << ' ' << value << '\n';
+    }
+
+    void snapshot::write_text(std::ostream &out, const std::string_view prefix) const {
+        std::string_view last_family;
+
+        for (const auto &[name, value] : counters) {
+            const auto [family, labels] = split_labels(name.str());
+            write_family(out, prefix, family, "counter", last_family);
+            write_sample(out, prefix, family, "", labels, "", value);
+        }
+
+        for (const auto &[name, value] : gauges) {
+            const auto [family, labels] = split_labels(name.str());
+            write_family(out, prefix, family, "gauge", last_family);
+            write_sample(out, prefix, family, "", labels, "", value);
+        }
+
+        for (const auto &h : histograms) {
+            const auto [family, labels] = split_labels(h.name.str());
+            write_family(out, prefix, family, "summary", last_family);
+            write_sample(out, prefix, family, "", labels, "quantile=\"0.5\"", h.quantile(0.5));
+            write_sample(out, prefix, family, "", labels, "quantile=\"0.9\"", h.quantile(0.9));
+            write_sample(out, prefix, family, "", labels, "quantile=\"0.99\"", h.quantile(0.99));
+            write_sample(out, prefix, family, "", labels, "quantile=\"0.999\"", h.quantile(0.999));
+            write_sample(out, prefix, family, "_sum", labels, "", h.sum);
+            write_sample(out, prefix, family, "_count", labels, "", h.count);
+        }
+    }
+
+    registry &registry::get() {
+        static registry instance;
+        return instance;
+    }
+
+    registry::shard::~shard() {
+        for (auto &c : chunks) {
+            delete c.load(std::memory_order_relaxed);
+        }
+    }
+
+    counter registry::get_counter(const hashed_name name) {
+        return counter(_get_or_add(name, metric_kind::counter, 1).index);
+    }
+
+    counter registry::get_up_down_counter(const hashed_name name) {
+        return counter(_get_or_add(name, metric_kind::up_down_counter, 1).index);
+    }
+
+    gauge registry::get_gauge(const hashed_name name) {
+        const metric_info info = _get_or_add(name, metric_kind::gauge, 0);
+
+        std::lock_guard lock(m_mutex);
+        return gauge(&m_gauges[info.index]);
+    }
+
+    histogram registry::get_histogram(const hashed_name name) {
+        return histogram(_get_or_add(name, metric_kind::histogram, 1 + histogram::bucket_count).index);
+    }
+
+    snapshot registry::take_snapshot() const {
+        snapshot result;
+        result.time = std::chrono::system_clock::now();
+
+        std::lock_guard lock(m_mutex);
+        for (const metric_info &info : m_ordered) {
+            switch (info.kind) {
+                case metric_kind::counter:
+                    result.counters.push_back(snapshot::value{info.name, _sum(info.index)});
+                    break;
+                case metric_kind::up_down_counter:
+                    result.gauges.push_back(snapshot::value{info.name, _sum(info.index)});
+                    break;
+                case metric_kind::gauge:
+                    result.gauges.push_back(
+                        snapshot::value{info.name, m_gauges[info.index].load(std::memory_order_relaxed)}
+                    );
+                    break;
+                case metric_kind::histogram: {
+                    snapshot::histogram_value value{
+                        .name    = info.name,
+                        .count   = 0,
+                        .sum     = static_cast<uint64_t>(_sum(info.index)),
+                        .buckets = std::vector<uint64_t>(histogram::bucket_count),
+                    };
+                    for (uint32_t bucket = 0; bucket < histogram::bucket_count; ++bucket) {
+                        value.buckets[bucket] = static_cast<uint64_t>(_sum(info.index + 1 + bucket));
+                        value.count += value.buckets[bucket];
+                    }
+                    result.histograms.push_back(std::move(value));
+                    break;
+                }
+            }
+        }
+
+        const auto by_name = [](const auto &a, const auto &b) { return a.name.str() < b.name.str(); };
+        std::ranges::sort(result.counters, by_name);
+        std::ranges::sort(result.gauges, by_name);
+        std::ranges::sort(result.histograms, by_name);
+        return result;
+    }
+
+    registry::metric_info registry::_get_or_add(const hashed_name name, const metric_kind kind, const uint32_t slots) {
+        std::lock_guard lock(m_mutex);
+
+        if (const auto *found = m_metrics.find(name)) {
+            if (found->kind != kind) {
+                throw std::logic_error("Metric " + std::string(name.str) + " already exists as a different kind");
+            }
+            return *found;
+        }
+
+        metric_info info{.name = name_id::intern(name), .kind = kind, .index = 0};
+        if (kind == metric_kind::gauge) {
+            info.index = static_cast<uint32_t>(m_gauges.size());
+            m_gauges.emplace_back(0);
+        } else {
+            if (m_next_slot + slots > chunk_slots * max_chunks) {
+                throw std::runtime_error("Too many metrics");
+            }
+            info.index = m_next_slot;
+            m_next_slot += slots;
+        }
+
+        m_metrics.insert_or_assign(info.name, info);
+        m_ordered.push_back(info);
+        return info;
+    }
+
+    int64_t registry::_sum(const uint32_t slot) const {
+        int64_t total = 0;
+        for (const auto &s : m_shards) {
+            if (const chunk *c = s->chunks[slot / chunk_slots].load(std::memory_order_acquire)) {
+                total += c->values[slot % chunk_slots].load(std::memory_order_relaxed);
+            }
+        }
+        return total;
+    }
+
+    registry::shard &registry::_register_thread() {
+        registry       &self = get();
+        std::lock_guard lock(self.m_mutex);
+        t_shard = self.m_shards.emplace_back(std::make_unique<shard>()).get();
+        return *t_shard;
+    }
+
+    registry::chunk &registry::_add_chunk(shard &shard, const size_t index) {
+        auto *c = new chunk;
+        shard.chunks[index].store(c, std::memory_order_release);
+        return *c;
+    }
+
+    file_exporter::file_exporter(settings settings) : m_settings(std::move(settings)) {
+        if (m_settings.path.has_parent_path()) {
+            std::filesystem::create_directories(m_settings.path.parent_path());
+        }
+
+        m_thread = std::thread([this] {
+            std::unique_lock lock(m_mutex);
+            while (m_running) {
+                m_wake.wait_for(lock, m_settings.interval, [this] { return !m_running; });
+
+                lock.unlock();
+                write();
+                lock.lock();
+            }
+        });
+    }
+
+    file_exporter::~file_exporter() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_running = false;
+        }
+        m_wake.notify_all();
+        m_thread.join();
+    }
+
+    void file_exporter::write() const {
+        const snapshot values = registry::get().take_snapshot();
+
+        std::lock_guard       lock(m_write_mutex);
+        std::filesystem::path temporary = m_settings.path;
+        temporary += ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            if (!out)
+                return;
+            values.write_text(out, m_settings.prefix);
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporary, m_settings.path, error);
+    }
+} // namespace engine::metrics
@@ -0,0 +1,298 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/names.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace engine::metrics {
+
+    class registry;
+
+    /**
+     * A count that is only ever added to. Each thread adds into its own shard, so add() is an uncontended load and
+     * store; readers sum the shards.
+     *
+     * A default-constructed counter discards everything added to it.
+     */
+    class counter {
+      public:
+        counter() = default;
+
+        inline void add(int64_t value) const noexcept;
+        inline void increment() const noexcept { add(1); }
+        inline void decrement() const noexcept { add(-1); }
+
+      private:
+        uint32_t m_slot = 0;
+
+        explicit counter(const uint32_t slot) : m_slot(slot) {}
+
+        friend class registry;
+    };
+
+    /**
+     * A value that is set rather than accumulated, such as the size of a group. Stored in one place, so the last write
+     * wins.
+     */
+    class gauge {
+      public:
+        gauge();
+
+        inline void set(const int64_t value) const noexcept { m_value->store(value, std::memory_order_relaxed); }
+        inline void add(const int64_t value) const noexcept { m_value->fetch_add(value, std::memory_order_relaxed); }
+
+      private:
+        std::atomic<int64_t> *m_value;
+
+        explicit gauge(std::atomic<int64_t> *value) : m_value(value) {}
+
+        friend class registry;
+    };
+
+    /**
+     * A distribution of unsigned values (durations, sizes) in log-linear buckets: values below 8 get a bucket each,
+     * and every power of two above that is split into 8 buckets, so a bucket is never wider than 1/8 of its lower bound.
+     * Buckets are sharded per thread like counters.
+     */
+    class histogram {
+      public:
+        static constexpr uint32_t sub_bucket_bits = 3;
+        static constexpr uint32_t sub_buckets     = 1 << sub_bucket_bits;
+        static constexpr uint32_t bucket_count    = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+        histogram() = default;
+
+        inline void record(uint64_t value) const noexcept;
+
+        [[nodiscard]] static constexpr uint32_t bucket_of(const uint64_t value) noexcept {
+            if (value < sub_buckets)
+                return static_cast<uint32_t>(value);
+
+            const uint32_t shift = static_cast<uint32_t>(std::bit_width(value)) - sub_bucket_bits - 1;
+            return (shift + 1) * sub_buckets + static_cast<uint32_t>((value >> shift) - sub_buckets);
+        }
+
+        /**
+         * @return The smallest value that falls in the bucket.
+         */
+        [[nodiscard]] static constexpr uint64_t bucket_lower_bound(const uint32_t bucket) noexcept {
+            if (bucket < sub_buckets)
+                return bucket;
+
+            const uint32_t shift = bucket / sub_buckets - 1;
+            return static_cast<uint64_t>(sub_buckets + bucket % sub_buckets) << shift;
+        }
+
+        [[nodiscard]] static constexpr uint64_t bucket_width(const uint32_t bucket) noexcept {
+            return bucket < sub_buckets ? 1 : uint64_t(1) << (bucket / sub_buckets - 1);
+        }
+
+      private:
+        // the sum of every recorded value, followed by the buckets
+        uint32_t m_first_slot = 0;
+
+        explicit histogram(const uint32_t first_slot) : m_first_slot(first_slot) {}
+
+        friend class registry;
+    };
+
+    /**
+     * The values of every metric at one point in time.
+     */
+    struct snapshot {
+        struct value {
+            name_id name;
+            int64_t value;
+        };
+
+        struct histogram_value {
+            name_id               name;
+            uint64_t              count = 0;
+            uint64_t              sum   = 0;
+            std::vector<uint64_t> buckets; // histogram::bucket_count entries
+
+            /**
+             * @return The middle of the bucket holding the q-th quantile (0 <= q <= 1), or 0 if nothing was recorded.
+             */
+            [[nodiscard]] uint64_t quantile(double q) const noexcept;
+        };
+
+        std::chrono::system_clock::time_point time;
+
+        // each sorted by name
+        std::vector<value>           counters;
+        std::vector<value>           gauges; // including up/down counters
+        std::vector<histogram_value> histograms;
+
+        /**
+         * Writes the snapshot in the Prometheus text exposition format, with prefix prepended to every name. Names may
+         * carry labels, as in scene_objects{type="player"}. Histograms are written as summaries with their 0.5, 0.9,
+         * 0.99 and 0.999 quantiles.
+         */
+        void write_text(std::ostream &out, std::string_view prefix = "engine_") const;
+    };
+
+    /**
+     * Owns every metric. Metrics are looked up by name once (usually into a static or a member) and the handle is used
+     * from then on; looking a name up again returns the same metric. Metrics are never removed.
+     */
+    class registry {
+      public:
+        static registry &get();
+
+        registry(const registry &other)                = delete;
+        registry(registry &&other) noexcept            = delete;
+        registry &operator=(const registry &other)     = delete;
+        registry &operator=(registry &&other) noexcept = delete;
+
+        /**
+         * These throw std::logic_error if the name is already used by a different kind of metric.
+         */
+        [[nodiscard]] counter get_counter(hashed_name name);
+
+        /**
+         * A counter that may go down as well as up, such as a count of live objects. Snapshots list it with the gauges.
+         */
+        [[nodiscard]] counter get_up_down_counter(hashed_name name);
+
+        [[nodiscard]] gauge     get_gauge(hashed_name name);
+        [[nodiscard]] histogram get_histogram(hashed_name name);
+
+        [[nodiscard]] snapshot take_snapshot() const;
+
+      private:
+        static constexpr size_t chunk_slots = 256;
+        static constexpr size_t max_chunks  = 1024;
+
+        enum class metric_kind : uint8_t {
+            counter,
+            up_down_counter,
+            gauge,
+            histogram,
+        };
+
+        struct metric_info {
+            name_id     name;
+            metric_kind kind;
+            uint32_t    index; // the first slot, or the gauge's index
+        };
+
+        struct chunk {
+            std::array<std::atomic<int64_t>, chunk_slots> values{};
+        };
+
+        // only the owning thread writes to a shard; shards outlive their threads so their counts are kept
+        struct shard {
+            std::array<std::atomic<chunk *>, max_chunks> chunks{};
+
+            ~shard();
+        };
+
+        static inline thread_local constinit shard *t_shard = nullptr;
+
+        mutable std::mutex                  m_mutex;
+        flat_name_map<metric_info>          m_metrics;
+        std::vector<metric_info>            m_ordered;
+        std::vector<std::unique_ptr<shard>> m_shards;
+        std::deque<std::atomic<int64_t>>    m_gauges;
+
+        // slot 0 is where default-constructed counters and histograms write
+        uint32_t m_next_slot = 1 + histogram::bucket_count;
+
+        registry() = default;
+
+        metric_info _get_or_add(hashed_name name, metric_kind kind, uint32_t slots);
+
+        [[nodiscard]] int64_t _sum(uint32_t slot) const;
+
+        static shard &_register_thread();
+        static chunk &_add_chunk(shard &shard, size_t index);
+
+        [[nodiscard]] static inline std::atomic<int64_t> &_local_slot(const uint32_t slot) noexcept {
+            shard *s = t_shard;
+            if (!s) [[unlikely]]
+                s = &_register_thread();
+
+            const size_t index = slot / chunk_slots;
+            chunk       *c     = s->chunks[index].load(std::memory_order_relaxed);
+            if (!c) [[unlikely]]
+                c = &_add_chunk(*s, index);
+
+            return c->values[slot % chunk_slots];
+        }
+
+        // only the owning thread writes the slot, so no read-modify-write is needed
+        static inline void _local_add(const uint32_t slot, const int64_t value) noexcept {
+            std::atomic<int64_t> &v = _local_slot(slot);
+            v.store(v.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        friend class counter;
+        friend class histogram;
+    };
+
+    inline void counter::add(const int64_t value) const noexcept {
+        registry::_local_add(m_slot, value);
+    }
+
+    inline void histogram::record(const uint64_t value) const noexcept {
+        // a null histogram writes into slot 0 and the slots after it, which are reserved for it
+        registry::_local_add(m_first_slot, static_cast<int64_t>(value));
+        registry::_local_add(m_first_slot + 1 + bucket_of(value), 1);
+    }
+
+    /**
+     * Writes a snapshot of the registry to a file at a fixed interval from a background thread, in the Prometheus text
+     * format (for example for node_exporter's textfile collector). The file is replaced atomically, so readers never see
+     * a partial write. A last snapshot is written when the exporter is destroyed.
+     */
+    class file_exporter {
+      public:
+        struct settings {
+            std::filesystem::path     path     = "logs/metrics.prom";
+            std::chrono::milliseconds interval = std::chrono::seconds(1);
+            std::string               prefix   = "engine_";
+        };
+
+        explicit file_exporter(settings settings);
+        ~file_exporter();
+
+        file_exporter(const file_exporter &other)                = delete;
+        file_exporter(file_exporter &&other) noexcept            = delete;
+        file_exporter &operator=(const file_exporter &other)     = delete;
+        file_exporter &operator=(file_exporter &&other) noexcept = delete;
+
+        /**
+         * Writes a snapshot now, on the calling thread.
+         */
+        void write() const;
+
+      private:
+        settings           m_settings;
+        mutable std::mutex m_write_mutex;
+
+        std::mutex              m_mutex;
+        std::condition_variable m_wake;
+        bool                    m_running = true;
+        std::thread             m_thread;
+    };
+
+} // namespace engine::metrics
@@ -0,0 +1,65 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "names.hpp"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+
+namespace engine {
+    class name_table {
+      public:
+        static name_table &get() {
+            static name_table table;
+            return table;
+        }
+
+        name_id intern(const hashed_name str) {
+            {
+                std::shared_lock lock(m_mutex);
+                if (const name_id *found = m_index.find(str))
+                    return *found;
+            }
+
+            std::unique_lock lock(m_mutex);
+            if (const name_id *found = m_index.find(str))
+                return *found;
+
+            // deque never relocates its elements, so name_ids can point straight at them
+            const auto &e = m_entries.emplace_back(name_id::entry{
+                .str   = std::string(str.str),
+                .hash  = str.hash,
+                .index = static_cast<uint32_t>(m_entries.size() + 1),
+            });
+            const name_id id(&e);
+            m_index.insert_or_assign(id, id);
+            return id;
+        }
+
+        name_id find(const hashed_name str) const {
+            std::shared_lock lock(m_mutex);
+            if (const name_id *found = m_index.find(str))
+                return *found;
+            return {};
+        }
+
+      private:
+        mutable std::shared_mutex  m_mutex;
+        std::deque<name_id::entry> m_entries;
+        flat_name_map<name_id>     m_index;
+    };
+
+    name_id name_id::intern(const hashed_name str) {
+        if (str.str.empty())
+            return {};
+        return name_table::get().intern(str);
+    }
+
+    name_id name_id::find(const hashed_name str) {
+        if (str.str.empty())
+            return {};
+        return name_table::get().find(str);
+    }
+} // namespace engine
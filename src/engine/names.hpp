@@ -0,0 +1,257 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * 64-bit FNV-1a. Usable at compile time, and gives the same value at run time.
+     */
+    [[nodiscard]] constexpr uint64_t hash_name(const std::string_view str) noexcept {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (const char c : str) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    /**
+     * A string paired with its hash, used as the key for name lookups. The hash is computed once here rather than inside
+     * every probe; for a literal it can be computed at compile time with the _hn suffix (see literals below), and usually
+     * is anyway once inlined.
+     */
+    struct hashed_name {
+        std::string_view str;
+        uint64_t         hash;
+
+        /**
+         * For literals and character buffers: the name ends at the first NUL, which for a buffer may be before its end,
+         * or at the end of the array if it has none.
+         */
+        template <size_t N>
+        constexpr hashed_name(const char (&chars)[N])
+            : str(chars, static_cast<size_t>(std::find(chars, chars + N, '\0') - chars)), hash(hash_name(str)) {}
+
+        constexpr hashed_name(const std::string_view s) : str(s), hash(hash_name(s)) {}
+
+        /**
+         * For NUL-terminated strings only known at run time, such as a const char * from a file or a C API. Must not be
+         * null. Arrays still take the overload above, which never reads past their end.
+         */
+        template <typename P>
+            requires std::same_as<P, const char *> || std::same_as<P, char *>
+        constexpr hashed_name(const P s) : str(s), hash(hash_name(str)) {}
+
+        template <typename S>
+            requires std::same_as<S, std::string>
+        constexpr hashed_name(const S &s) : str(s), hash(hash_name(s)) {}
+
+        /**
+         * For strings whose hash is already known, such as an interned name's.
+         */
+        constexpr hashed_name(const std::string_view s, const uint64_t h) : str(s), hash(h) {}
+    };
+
+    namespace literals {
+        /**
+         * "name"_hn is a hashed_name whose hash is always computed at compile time.
+         */
+        consteval hashed_name operator""_hn(const char *str, const size_t length) {
+            return hashed_name(std::string_view(str, length));
+        }
+    } // namespace literals
+
+    /**
+     * An interned name: a pointer to the single copy of a string held in the global name table. Copying and comparing is
+     * as cheap as a pointer, and the string and its hash are available without touching the table. Interned strings live
+     * until the program exits. A default-constructed name_id is the empty name.
+     */
+    class name_id {
+      public:
+        constexpr name_id() noexcept = default;
+
+        /**
+         * Returns the name_id for str, adding it to the table if needed. Thread-safe.
+         */
+        [[nodiscard]] static name_id intern(hashed_name str);
+
+        /**
+         * @return The name_id for str if it was interned before, or the empty name if not. Never adds to the table.
+         */
+        [[nodiscard]] static name_id find(hashed_name str);
+
+        [[nodiscard]] inline std::string_view str() const noexcept { return m_entry ? m_entry->str : std::string_view(); }
+        [[nodiscard]] inline uint64_t         hash() const noexcept { return m_entry ? m_entry->hash : hash_name({}); }
+        [[nodiscard]] inline uint32_t         index() const noexcept { return m_entry ? m_entry->index : 0; }
+
+        [[nodiscard]] inline bool empty() const noexcept { return m_entry == nullptr; }
+
+        constexpr bool operator==(const name_id &other) const noexcept = default;
+
+      private:
+        struct entry {
+            std::string str;
+            uint64_t    hash;
+            uint32_t    index;
+        };
+
+        const entry *m_entry = nullptr;
+
+        constexpr explicit name_id(const entry *e) noexcept : m_entry(e) {}
+
+        friend class name_table;
+    };
+
+    /**
+     * An open-addressing hash map from name_id to V, looked up by hashed_name so a query never allocates or interns its
+     * key. Hashes live in their own array, so a probe walks one contiguous run of 64-bit values and only compares strings
+     * when a full hash matches. Uses linear probing with backward-shift deletion, so there are no tombstones.
+     */
+    template <typename V>
+    class flat_name_map {
+      public:
+        /**
+         * Inserts or replaces the value for name.
+         */
+        V &insert_or_assign(const name_id name, V value) {
+            if ((m_size + 1) * 8 > m_hashes.size() * 7) {
+                _rehash(std::max<size_t>(m_hashes.size() * 2, 16));
+            }
+
+            const uint64_t h = _stored_hash(name.hash());
+            for (size_t i = h & m_mask;; i = (i + 1) & m_mask) {
+                if (m_hashes[i] == 0) {
+                    m_hashes[i]  = h;
+                    m_entries[i] = entry{name, std::move(value)};
+                    ++m_size;
+                    return m_entries[i].value;
+                }
+                if (m_hashes[i] == h && m_entries[i].key == name) {
+                    m_entries[i].value = std::move(value);
+                    return m_entries[i].value;
+                }
+            }
+        }
+
+        [[nodiscard]] V *find(const hashed_name key) noexcept {
+            const size_t i = _find_slot(key);
+            return i == npos ? nullptr : &m_entries[i].value;
+        }
+
+        [[nodiscard]] const V *find(const hashed_name key) const noexcept {
+            const size_t i = _find_slot(key);
+            return i == npos ? nullptr : &m_entries[i].value;
+        }
+
+        [[nodiscard]] inline bool contains(const hashed_name key) const noexcept { return _find_slot(key) != npos; }
+
+        bool erase(const hashed_name key) {
+            size_t hole = _find_slot(key);
+            if (hole == npos)
+                return false;
+
+            // shift the rest of the cluster back over the hole, so probes never need to skip deleted slots
+            for (size_t i = (hole + 1) & m_mask; m_hashes[i] != 0; i = (i + 1) & m_mask) {
+                const size_t home = m_hashes[i] & m_mask;
+                if (((i - home) & m_mask) >= ((i - hole) & m_mask)) {
+                    m_hashes[hole]  = m_hashes[i];
+                    m_entries[hole] = std::move(m_entries[i]);
+                    hole            = i;
+                }
+            }
+
+            m_hashes[hole]  = 0;
+            m_entries[hole] = entry{};
+            --m_size;
+            return true;
+        }
+
+        template <typename F>
+        void for_each(F &&f) const {
+            for (size_t i = 0; i < m_hashes.size(); ++i) {
+                if (m_hashes[i] != 0)
+                    f(m_entries[i].key, m_entries[i].value);
+            }
+        }
+
+        void reserve(const size_t count) {
+            const size_t capacity = std::bit_ceil(std::max<size_t>(count * 8 / 7 + 1, 16));
+            if (capacity > m_hashes.size())
+                _rehash(capacity);
+        }
+
+        void clear() noexcept {
+            m_hashes.clear();
+            m_entries.clear();
+            m_mask = 0;
+            m_size = 0;
+        }
+
+        [[nodiscard]] inline size_t size() const noexcept { return m_size; }
+        [[nodiscard]] inline bool   empty() const noexcept { return m_size == 0; }
+
+      private:
+        static constexpr size_t npos = SIZE_MAX;
+
+        struct entry {
+            name_id key;
+            V       value{};
+        };
+
+        std::vector<uint64_t> m_hashes; // 0 marks an empty slot
+        std::vector<entry>    m_entries;
+        size_t                m_mask = 0;
+        size_t                m_size = 0;
+
+        [[nodiscard]] static constexpr uint64_t _stored_hash(const uint64_t hash) noexcept { return hash == 0 ? 1 : hash; }
+
+        [[nodiscard]] size_t _find_slot(const hashed_name key) const noexcept {
+            if (m_size == 0)
+                return npos;
+
+            const uint64_t h = _stored_hash(key.hash);
+            for (size_t i = h & m_mask; m_hashes[i] != 0; i = (i + 1) & m_mask) {
+                if (m_hashes[i] == h && m_entries[i].key.str() == key.str)
+                    return i;
+            }
+            return npos;
+        }
+
+        void _rehash(const size_t capacity) {
+            std::vector<uint64_t> hashes(capacity, 0);
+            std::vector<entry>    entries(capacity);
+            const size_t          mask = capacity - 1;
+
+            for (size_t i = 0; i < m_hashes.size(); ++i) {
+                if (m_hashes[i] == 0)
+                    continue;
+
+                size_t j = m_hashes[i] & mask;
+                while (hashes[j] != 0) {
+                    j = (j + 1) & mask;
+                }
+                hashes[j]  = m_hashes[i];
+                entries[j] = std::move(m_entries[i]);
+            }
+
+            m_hashes  = std::move(hashes);
+            m_entries = std::move(entries);
+            m_mask    = mask;
+        }
+    };
+
+} // namespace engine
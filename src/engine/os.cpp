@@ -3,14 +3,16 @@
 //
 
 #include "os.hpp"
+#include "binary_log.hpp"
 #include "logging.hpp"
+#include "profiler.hpp"
 
 #include <stdexcept>
 
 #include <spdlog/spdlog.h>
 
 namespace engine {
-    static spdlog::logger *glfw_error_logger = nullptr;
+    static event_logger glfw_error_logger;
 
     static bool check_glfw_version() {
         int major, minor;
@@ -20,6 +22,20 @@ namespace engine {
         return major == 3 && minor == 4;
     }
 
+    static input_action to_input_action(const int action) {
+        switch (action) {
+        case GLFW_PRESS:
+            return input_action::press;
+        case GLFW_REPEAT:
+            return input_action::repeat;
+        default:
+            return input_action::release;
+        }
+    }
+
+    static_assert(GLFW_KEY_LAST < input_state::key_count);
+    static_assert(GLFW_MOUSE_BUTTON_LAST < input_state::mouse_button_count);
+
     void os_init() {
         if (!glfwInit()) {
             throw std::runtime_error("Failed to initialize GLFW");
@@ -30,29 +46,45 @@ namespace engine {
             throw std::runtime_error("Incorrect GLFW version (requires GLFW 3.4).");
         }
 
-        glfw_error_logger = create_logger("glfw").get();
+        glfw_error_logger = event_logger(create_logger("glfw"));
 
         glfwSetErrorCallback(+[](int code, const char *description) {
             if (glfw_error_logger)
-                glfw_error_logger->error("({}) {}", code, description);
+                ENGINE_LOG(glfw_error_logger, spdlog::level::err, "({}) {}", code, description);
         });
     }
 
     void os_terminate() {
         spdlog::drop(glfw_error_logger->name());
-        glfw_error_logger = nullptr;
+        glfw_error_logger = {};
         glfwTerminate();
     }
 
     void os_poll() {
+        ENGINE_PROFILE_ZONE("os_poll");
         glfwPollEvents();
     }
 
+    void os_wait(const double timeout) {
+        ENGINE_PROFILE_ZONE("os_wait");
+
+        if (timeout > 0.0) {
+            glfwWaitEventsTimeout(timeout);
+        } else {
+            glfwPollEvents();
+        }
+    }
+
+    void os_wake() {
+        glfwPostEmptyEvent();
+    }
+
     window::window(const attributes &attributes)
         : m_windowed_is_decorated(attributes.decorated), m_mode(attributes.mode),
           m_windowed_size(attributes.windowed_size),
           m_exclusive_fullscreen_resolution(attributes.exclusive_fullscreen_resolution_override),
-          m_windowed_position(attributes.windowed_position.value_or(glm::ivec2(GLFW_ANY_POSITION, GLFW_ANY_POSITION))) {
+          m_windowed_position(attributes.windowed_position.value_or(glm::ivec2(GLFW_ANY_POSITION, GLFW_ANY_POSITION))),
+          m_input(attributes.input) {
         glfwDefaultWindowHints();
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
         glfwWindowHint(GLFW_RESIZABLE, attributes.resizable);
@@ -111,6 +143,55 @@ namespace engine {
         }
 
         glfwSetWindowUserPointer(m_window, this);
+
+        glfwSetKeyCallback(m_window, +[](GLFWwindow *handle, int key, int, int action, int mods) {
+            // keys without a GLFW code could only be told apart by scancode, which events do not keep
+            if (key == GLFW_KEY_UNKNOWN)
+                return;
+            _push_input(handle, input_event{
+                .code   = static_cast<uint32_t>(key),
+                .type   = input_event_type::key,
+                .action = to_input_action(action),
+                .mods   = static_cast<uint8_t>(mods),
+            });
+        });
+        glfwSetCharCallback(m_window, +[](GLFWwindow *handle, unsigned int codepoint) {
+            _push_input(handle, input_event{.code = codepoint, .type = input_event_type::character});
+        });
+        glfwSetMouseButtonCallback(m_window, +[](GLFWwindow *handle, int button, int action, int mods) {
+            _push_input(handle, input_event{
+                .code   = static_cast<uint32_t>(button),
+                .type   = input_event_type::mouse_button,
+                .action = to_input_action(action),
+                .mods   = static_cast<uint8_t>(mods),
+            });
+        });
+        glfwSetCursorPosCallback(m_window, +[](GLFWwindow *handle, double x, double y) {
+            _push_input(handle, input_event{
+                .x    = static_cast<float>(x),
+                .y    = static_cast<float>(y),
+                .type = input_event_type::cursor_position,
+            });
+        });
+        glfwSetScrollCallback(m_window, +[](GLFWwindow *handle, double x, double y) {
+            _push_input(handle, input_event{
+                .x    = static_cast<float>(x),
+                .y    = static_cast<float>(y),
+                .type = input_event_type::scroll,
+            });
+        });
+        glfwSetCursorEnterCallback(m_window, +[](GLFWwindow *handle, int entered) {
+            _push_input(handle, input_event{
+                .type   = input_event_type::cursor_enter,
+                .action = entered ? input_action::press : input_action::release,
+            });
+        });
+        glfwSetWindowFocusCallback(m_window, +[](GLFWwindow *handle, int focused) {
+            _push_input(handle, input_event{
+                .type   = input_event_type::focus,
+                .action = focused ? input_action::press : input_action::release,
+            });
+        });
     }
 
     window::~window() {
@@ -121,6 +202,10 @@ namespace engine {
         return glfwWindowShouldClose(m_window);
     }
 
+    bool window::is_iconified() const {
+        return glfwGetWindowAttrib(m_window, GLFW_ICONIFIED);
+    }
+
     vk::Extent2D window::get_extent() const {
         int w, h;
         glfwGetFramebufferSize(m_window, &w, &h);
@@ -133,6 +218,12 @@ namespace engine {
         return {x, y};
     }
 
+    void window::_push_input(GLFWwindow *handle, input_event event) noexcept {
+        // GLFW does not say when an event happened, so this is when events were processed, to within the callbacks
+        event.timestamp = input_queue::clock::now().time_since_epoch().count();
+        static_cast<window *>(glfwGetWindowUserPointer(handle))->m_input.push(event);
+    }
+
     vk::raii::SurfaceKHR window::create_surface(const vk::raii::Instance &instance) const {
         VkSurfaceKHR surface;
         if (glfwCreateWindowSurface(*instance, m_window, nullptr, &surface) != VK_SUCCESS) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "engine/input.hpp"
+
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <optional>
@@ -17,6 +19,16 @@ namespace engine {
     void os_terminate();
     void os_poll();
 
+    /**
+     * Processes events, sleeping for up to timeout seconds until one arrives.
+     */
+    void os_wait(double timeout);
+
+    /**
+     * Wakes a thread blocked in os_wait. Can be called from any thread.
+     */
+    void os_wake();
+
     class window {
       public:
         enum class mode {
@@ -47,6 +59,8 @@ namespace engine {
             bool                      scale_framebuffer = true;
             bool                      mouse_passthrough = false;
             std::optional<glm::ivec2> windowed_position = std::nullopt;
+
+            input_queue::settings input = {};
         };
 
         explicit window(const attributes &attributes);
@@ -59,12 +73,20 @@ namespace engine {
 
         [[nodiscard]] bool should_close() const;
 
+        [[nodiscard]] bool is_iconified() const;
+
         vk::Extent2D get_extent() const;
 
         glm::ivec2 get_position() const;
 
         vk::raii::SurfaceKHR create_surface(const vk::raii::Instance& instance) const;
 
+        /**
+         * The window's keyboard, mouse and focus events, pushed by its GLFW callbacks whenever events are processed.
+         */
+        [[nodiscard]] inline input_queue       &input() noexcept { return m_input; }
+        [[nodiscard]] inline const input_queue &input() const noexcept { return m_input; }
+
       private:
         bool                      m_windowed_is_decorated;
         mode                      m_mode;
@@ -74,6 +96,10 @@ namespace engine {
         GLFWmonitor              *m_fullscreen_monitor;
 
         GLFWwindow *m_window;
+        input_queue m_input;
+
+        // stamps the event with the current time and pushes it into the window's queue
+        static void _push_input(GLFWwindow *handle, input_event event) noexcept;
     };
 
 } // namespace engine
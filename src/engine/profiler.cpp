@@ -0,0 +1,189 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace engine {
+    static double milliseconds_between(const profiler::clock::time_point start, const profiler::clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    static void write_json_string(std::ostream &out, const std::string_view str) {
+        out << '"';
+        for (const char c : str) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out << escaped;
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    profiler &profiler::get() {
+        static profiler instance;
+        return instance;
+    }
+
+    void profiler::record(const name_id name, const clock::time_point start, const clock::time_point end) noexcept {
+        thread_buffer &buffer = _thread_buffer();
+
+        const size_t write = buffer.write.load(std::memory_order_relaxed);
+        if (write - buffer.read.load(std::memory_order_acquire) >= buffer_capacity) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer.events[write & (buffer_capacity - 1)] = zone_event{name, start, end};
+        buffer.write.store(write + 1, std::memory_order_release);
+    }
+
+    void profiler::frame_mark() {
+        const clock::time_point now = clock::now();
+        if (enabled()) {
+            record(m_frame_name, m_last_frame, now);
+        }
+        m_last_frame = now;
+
+        _collect();
+    }
+
+    void profiler::set_thread_name(std::string name) {
+        thread_buffer  &buffer = _thread_buffer();
+        std::lock_guard lock(m_mutex);
+        buffer.name = std::move(name);
+    }
+
+    void profiler::begin_capture() {
+        std::lock_guard lock(m_mutex);
+        m_capture.clear();
+        m_capture_start = clock::now();
+        m_capturing     = true;
+    }
+
+    void profiler::end_capture() {
+        _collect();
+
+        std::lock_guard lock(m_mutex);
+        m_capturing = false;
+    }
+
+    void profiler::write_chrome_trace(const std::filesystem::path &path) const {
+        std::ofstream out(path);
+        if (!out) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+
+        std::lock_guard lock(m_mutex);
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto &buffer : m_buffers) {
+            if (buffer->name.empty())
+                continue;
+
+            out << (first ? "" : ",\n") << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << buffer->thread_index
+                << R"(,"args":{"name":)";
+            write_json_string(out, buffer->name);
+            out << "}}";
+            first = false;
+        }
+
+        char number[32];
+        for (const auto &event : m_capture) {
+            out << (first ? "" : ",\n") << R"({"ph":"X","pid":1,"tid":)" << event.thread_index << ",\"name\":";
+            write_json_string(out, event.name.str());
+
+            // microseconds, to the nanosecond
+            std::snprintf(number, sizeof(number), "%.3f", milliseconds_between(m_capture_start, event.start) * 1000.0);
+            out << ",\"ts\":" << number;
+            std::snprintf(number, sizeof(number), "%.3f", milliseconds_between(event.start, event.end) * 1000.0);
+            out << ",\"dur\":" << number << '}';
+            first = false;
+        }
+        out << "\n]}\n";
+    }
+
+    std::vector<profiler::zone_stats> profiler::stats() const {
+        std::vector<zone_stats> result;
+
+        std::lock_guard     lock(m_mutex);
+        std::vector<double> sorted;
+        for (const auto &[id, window] : m_windows) {
+            if (window.samples.empty())
+                continue;
+
+            sorted.assign(window.samples.begin(), window.samples.end());
+            std::ranges::sort(sorted);
+
+            double total = 0.0;
+            for (const double sample : sorted) {
+                total += sample;
+            }
+
+            const size_t p99 = std::min(sorted.size() - 1, sorted.size() * 99 / 100);
+            result.push_back(zone_stats{
+                .name    = m_window_names.at(id).str(),
+                .samples = sorted.size(),
+                .min     = sorted.front(),
+                .average = total / static_cast<double>(sorted.size()),
+                .p99     = sorted[p99],
+                .max     = sorted.back(),
+            });
+        }
+
+        std::ranges::sort(result, [](const zone_stats &a, const zone_stats &b) { return a.average > b.average; });
+        return result;
+    }
+
+    profiler::thread_buffer &profiler::_thread_buffer() {
+        thread_local thread_buffer *t_buffer = nullptr;
+        if (!t_buffer) {
+            std::lock_guard lock(m_mutex);
+            auto           &buffer = m_buffers.emplace_back(std::make_unique<thread_buffer>());
+            buffer->thread_index   = static_cast<uint32_t>(m_buffers.size());
+            t_buffer               = buffer.get();
+        }
+        return *t_buffer;
+    }
+
+    void profiler::_collect() {
+        std::lock_guard lock(m_mutex);
+
+        for (const auto &buffer : m_buffers) {
+            const size_t read  = buffer->read.load(std::memory_order_relaxed);
+            const size_t write = buffer->write.load(std::memory_order_acquire);
+
+            for (size_t i = read; i < write; ++i) {
+                const zone_event &event = buffer->events[i & (buffer_capacity - 1)];
+
+                const uint32_t id     = event.name.index();
+                zone_window   &window = m_windows[id];
+                const double   sample = milliseconds_between(event.start, event.end);
+                if (window.samples.size() < stats_window) {
+                    window.samples.push_back(sample);
+                    m_window_names.try_emplace(id, event.name);
+                } else {
+                    window.samples[window.next] = sample;
+                    window.next                 = (window.next + 1) % stats_window;
+                }
+
+                if (m_capturing && event.start >= m_capture_start) {
+                    m_capture.push_back(captured_event{event.name, event.start, event.end, buffer->thread_index});
+                }
+            }
+
+            buffer->read.store(write, std::memory_order_release);
+        }
+    }
+} // namespace engine
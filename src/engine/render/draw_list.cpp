@@ -0,0 +1,308 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "draw_list.hpp"
+
+#include "engine/jobs.hpp"
+#include "engine/profiler.hpp"
+#include "engine/scene/scene.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ENGINE_CULL_SSE2 1
+#endif
+
+namespace engine {
+
+    // splits [0, count) across the job system, or runs it here without one
+    template <typename F>
+    static void for_ranges(job_system *jobs, const size_t count, const size_t grain, F &&f) {
+        if (jobs) {
+            jobs->parallel_for(count, grain, f);
+        } else if (count > 0) {
+            f(size_t(0), count);
+        }
+    }
+
+    frustum frustum::from_matrix(const glm::mat4 &view_projection) {
+        const auto row = [&](const int i) {
+            return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+        };
+        const auto plane = [](const glm::vec4 &a, const glm::vec4 &b, const float sign) {
+            const glm::vec4 p(a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z, a.w + sign * b.w);
+            const float     length = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+            return length > 0.0f ? glm::vec4(p.x / length, p.y / length, p.z / length, p.w / length) : p;
+        };
+
+        // each clip-space bound -w <= x <= w, -w <= y <= w and 0 <= z <= w is a plane in world space
+        const glm::vec4 x = row(0);
+        const glm::vec4 y = row(1);
+        const glm::vec4 z = row(2);
+        const glm::vec4 w = row(3);
+        return frustum{{
+            plane(w, x, 1.0f),
+            plane(w, x, -1.0f),
+            plane(w, y, 1.0f),
+            plane(w, y, -1.0f),
+            plane(z, z, 0.0f),
+            plane(w, z, -1.0f),
+        }};
+    }
+
+    bounds_soa bounds_soa::allocate(frame_arena &arena, const size_t count) {
+        const auto array = [&] { return static_cast<float *>(arena.allocate(count * sizeof(float), 16)); };
+        return bounds_soa{
+            .center_x = array(),
+            .center_y = array(),
+            .center_z = array(),
+            .extent_x = array(),
+            .extent_y = array(),
+            .extent_z = array(),
+            .count    = count,
+        };
+    }
+
+    size_t cull_bounds(
+        const frustum &frustum, const bounds_soa &bounds, const size_t begin, const size_t end, uint32_t *visible
+    ) {
+        size_t count = 0;
+        size_t i     = begin;
+
+#if ENGINE_CULL_SSE2
+        // a box is outside a plane when its center is further behind it than the box reaches along the normal
+        __m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+        for (int p = 0; p < 6; ++p) {
+            const glm::vec4 &plane = frustum.planes[p];
+            nx[p]                  = _mm_set1_ps(plane.x);
+            ny[p]                  = _mm_set1_ps(plane.y);
+            nz[p]                  = _mm_set1_ps(plane.z);
+            nw[p]                  = _mm_set1_ps(plane.w);
+            ax[p]                  = _mm_set1_ps(std::abs(plane.x));
+            ay[p]                  = _mm_set1_ps(std::abs(plane.y));
+            az[p]                  = _mm_set1_ps(std::abs(plane.z));
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= end; i += 4) {
+            const __m128 cx = _mm_loadu_ps(bounds.center_x + i);
+            const __m128 cy = _mm_loadu_ps(bounds.center_y + i);
+            const __m128 cz = _mm_loadu_ps(bounds.center_z + i);
+            const __m128 ex = _mm_loadu_ps(bounds.extent_x + i);
+            const __m128 ey = _mm_loadu_ps(bounds.extent_y + i);
+            const __m128 ez = _mm_loadu_ps(bounds.extent_z + i);
+
+            int inside = 0xf;
+            for (int p = 0; p < 6 && inside; ++p) {
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_add_ps(_mm_mul_ps(nz[p], cz), nw[p])
+                );
+                const __m128 reach =
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+                inside &= _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(distance, reach), zero));
+            }
+
+            while (inside) {
+                visible[count++] = static_cast<uint32_t>(i + std::countr_zero(static_cast<unsigned>(inside)));
+                inside &= inside - 1;
+            }
+        }
+#endif
+
+        for (; i < end; ++i) {
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; ++p) {
+                const glm::vec4 &plane    = frustum.planes[p];
+                const float      distance = plane.x * bounds.center_x[i] + plane.y * bounds.center_y[i] +
+                                       plane.z * bounds.center_z[i] + plane.w;
+                const float reach = std::abs(plane.x) * bounds.extent_x[i] + std::abs(plane.y) * bounds.extent_y[i] +
+                                    std::abs(plane.z) * bounds.extent_z[i];
+                inside = distance + reach >= 0.0f;
+            }
+            if (inside)
+                visible[count++] = static_cast<uint32_t>(i);
+        }
+
+        return count;
+    }
+
+    uint64_t make_sort_key(const uint16_t pipeline, const uint32_t material, const float depth, const bool translucent)
+        noexcept {
+        constexpr uint64_t depth_max = (uint64_t(1) << 24) - 1;
+
+        // written so that NaN lands on 0
+        const float    clamped   = depth > 0.0f ? std::min(depth, 1.0f) : 0.0f;
+        const uint64_t quantized = static_cast<uint64_t>(clamped * static_cast<float>(depth_max));
+        const uint64_t p         = pipeline & 0x7fffu;
+        const uint64_t m         = material & 0xffffffu;
+
+        if (!translucent)
+            return p << 48 | m << 24 | quantized;
+        return uint64_t(1) << 63 | (depth_max - quantized) << 39 | p << 24 | m;
+    }
+
+    template <int bits>
+    static void radix_sort_by(draw_sort_entry *entries, draw_sort_entry *scratch, const size_t count) {
+        constexpr int      digits  = (64 + bits - 1) / bits;
+        constexpr size_t   buckets = size_t(1) << bits;
+        constexpr uint64_t mask    = buckets - 1;
+
+        // one pass counts every digit at once
+        std::vector<uint32_t> histograms(digits * buckets);
+        for (size_t i = 0; i < count; ++i) {
+            for (int digit = 0; digit < digits; ++digit) {
+                ++histograms[digit * buckets + ((entries[i].key >> (digit * bits)) & mask)];
+            }
+        }
+
+        draw_sort_entry *from = entries;
+        draw_sort_entry *to   = scratch;
+        for (int digit = 0; digit < digits; ++digit) {
+            const int shift     = digit * bits;
+            uint32_t *histogram = histograms.data() + digit * buckets;
+            if (histogram[(from[0].key >> shift) & mask] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (size_t bucket = 0; bucket < buckets; ++bucket) {
+                offset += std::exchange(histogram[bucket], offset);
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                to[histogram[(from[i].key >> shift) & mask]++] = from[i];
+            }
+            std::swap(from, to);
+        }
+
+        if (from != entries)
+            std::memcpy(entries, from, count * sizeof(draw_sort_entry));
+    }
+
+    void radix_sort(const std::span<draw_sort_entry> entries, const std::span<draw_sort_entry> scratch) {
+        if (scratch.size() < entries.size()) {
+            throw std::invalid_argument("Radix sort scratch is smaller than what it sorts");
+        }
+
+        // wider digits halve the passes over large lists, but their tables cost more than small lists do
+        if (entries.size() >= 1 << 16) {
+            radix_sort_by<16>(entries.data(), scratch.data(), entries.size());
+        } else if (entries.size() > 1) {
+            radix_sort_by<8>(entries.data(), scratch.data(), entries.size());
+        }
+    }
+
+    std::shared_ptr<render_extraction> render_extraction::attach(const std::shared_ptr<scene::scene> &scene) {
+        std::shared_ptr<render_extraction> extraction(new render_extraction());
+
+        // allocates from the frame arena of whichever thread runs the phase, so it needs no claim on the arena
+        scene->add_phase(scene::phase_desc{
+            .name     = std::string(phase_name),
+            .reads    = {"world_transforms", "renderables"},
+            .after    = {std::string(scene::scene::transform_phase_name)},
+            .callback = [weak = std::weak_ptr(extraction), s = scene.get()](double) {
+                if (const auto self = weak.lock()) {
+                    self->m_draw_list = extract(*s, self->m_camera, s->get_frame_arena(), s->get_job_system().get());
+                }
+            },
+        });
+        return extraction;
+    }
+
+    draw_list render_extraction::extract(
+        scene::scene &scene, const camera_view &camera, frame_arena &arena, job_system *jobs
+    ) {
+        ENGINE_PROFILE_ZONE("render_extraction::extract");
+
+        size_t total = 0;
+        scene.components().view<renderable>().each_chunk([&](const size_t count, const auto *, const renderable *) {
+            total += count;
+        });
+        if (total == 0)
+            return {};
+
+        const auto **sources = arena.allocate_array<const renderable *>(total);
+        size_t       offset  = 0;
+        scene.components().view<renderable>().each_chunk([&](const size_t count, const auto *, const renderable *first) {
+            for (size_t row = 0; row < count; ++row) {
+                sources[offset++] = first + row;
+            }
+        });
+
+        const scene::transform_hierarchy &transforms = scene.transforms();
+        const size_t                      grain      = 4096;
+
+        bounds_soa bounds = bounds_soa::allocate(arena, total);
+        for_ranges(jobs, total, grain, [&](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const renderable &r = *sources[i];
+                bounds.set(i, r.bounds.transformed(transforms.get_world(r.transform)));
+            }
+        });
+
+        // each block culls into its own stretch of the array, and the results are closed up afterwards
+        const frustum view_frustum = frustum::from_matrix(camera.view_projection);
+        const size_t  blocks       = (total + grain - 1) / grain;
+        uint32_t     *visible      = arena.allocate_array<uint32_t>(total);
+        uint32_t     *found        = arena.allocate_array<uint32_t>(blocks);
+        for_ranges(jobs, blocks, 1, [&](const size_t begin, const size_t end) {
+            for (size_t block = begin; block < end; ++block) {
+                const size_t first = block * grain;
+                found[block] = static_cast<uint32_t>(
+                    cull_bounds(view_frustum, bounds, first, std::min(first + grain, total), visible + first)
+                );
+            }
+        });
+
+        size_t visible_count = 0;
+        for (size_t block = 0; block < blocks; ++block) {
+            std::memmove(visible + visible_count, visible + block * grain, found[block] * sizeof(uint32_t));
+            visible_count += found[block];
+        }
+        if (visible_count == 0)
+            return {.candidates = total};
+
+        auto *entries = arena.allocate_array<draw_sort_entry>(visible_count);
+        auto *scratch = arena.allocate_array<draw_sort_entry>(visible_count);
+        for_ranges(jobs, visible_count, grain, [&](const size_t begin, const size_t end) {
+            const float inverse_far = camera.far_plane > 0.0f ? 1.0f / camera.far_plane : 0.0f;
+            for (size_t j = begin; j < end; ++j) {
+                const uint32_t    i = visible[j];
+                const renderable &r = *sources[i];
+
+                const glm::vec3 center(bounds.center_x[i], bounds.center_y[i], bounds.center_z[i]);
+                const float     depth = glm::dot(center - camera.position, camera.forward) * inverse_far;
+                entries[j]            = {make_sort_key(r.pipeline, r.material, depth, r.translucent), i};
+            }
+        });
+
+        radix_sort({entries, visible_count}, {scratch, visible_count});
+
+        auto *draws = arena.allocate_array<draw_item>(visible_count);
+        for_ranges(jobs, visible_count, grain, [&](const size_t begin, const size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                const renderable &r = *sources[entries[j].index];
+
+                draws[j] = draw_item{
+                    .world    = transforms.get_world(r.transform),
+                    .sort_key = entries[j].key,
+                    .object   = r.object,
+                    .mesh     = r.mesh,
+                    .material = r.material,
+                    .pipeline = r.pipeline,
+                };
+            }
+        });
+
+        return {.draws = {draws, visible_count}, .candidates = total};
+    }
+
+} // namespace engine
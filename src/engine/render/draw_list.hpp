@@ -0,0 +1,176 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/memory.hpp"
+#include "engine/scene/spatial.hpp"
+#include "engine/scene/transform.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace engine {
+    class job_system;
+} // namespace engine
+
+namespace engine::scene {
+    class scene;
+} // namespace engine::scene
+
+namespace engine {
+
+    /**
+     * A component marking something to draw. It can sit on a scene object's entity or on an entity of its own (props,
+     * debris) that only borrows a node of the scene's transform hierarchy.
+     */
+    struct renderable {
+        scene::transform_handle transform; // places both the bounds and the draw
+        scene::aabb             bounds;    // in the transform's space
+        uint32_t                mesh        = 0;
+        uint32_t                material    = 0;
+        uint16_t                pipeline    = 0;
+        bool                    translucent = false;
+        uint64_t                object      = 0; // handed back in the draw, e.g. the scene object's id
+    };
+
+    struct camera_view {
+        glm::mat4 view_projection{1.0f}; // clip depth in [0, 1], as Vulkan uses
+        glm::vec3 position{0.0f};
+        glm::vec3 forward{0.0f, 0.0f, -1.0f};
+        float     far_plane = 1000.0f;
+    };
+
+    struct frustum {
+        std::array<glm::vec4, 6> planes; // normals point inwards; a point p is inside a plane when dot(xyz, p) + w >= 0
+
+        [[nodiscard]] static frustum from_matrix(const glm::mat4 &view_projection);
+    };
+
+    /**
+     * Boxes stored as separate arrays of center and half-extent components, so culling loads several boxes' worth of
+     * one component at a time. The arrays live in a frame arena.
+     */
+    struct bounds_soa {
+        float *center_x = nullptr;
+        float *center_y = nullptr;
+        float *center_z = nullptr;
+        float *extent_x = nullptr;
+        float *extent_y = nullptr;
+        float *extent_z = nullptr;
+        size_t count    = 0;
+
+        [[nodiscard]] static bounds_soa allocate(frame_arena &arena, size_t count);
+
+        inline void set(const size_t i, const scene::aabb &box) noexcept {
+            center_x[i] = (box.min.x + box.max.x) * 0.5f;
+            center_y[i] = (box.min.y + box.max.y) * 0.5f;
+            center_z[i] = (box.min.z + box.max.z) * 0.5f;
+            extent_x[i] = (box.max.x - box.min.x) * 0.5f;
+            extent_y[i] = (box.max.y - box.min.y) * 0.5f;
+            extent_z[i] = (box.max.z - box.min.z) * 0.5f;
+        }
+    };
+
+    /**
+     * Writes the indices in [begin, end) of the boxes at least partly inside the frustum to visible, in order, four
+     * boxes at a time where SSE2 is available.
+     *
+     * @return The number of indices written
+     */
+    size_t cull_bounds(const frustum &frustum, const bounds_soa &bounds, size_t begin, size_t end, uint32_t *visible);
+
+    /**
+     * Sort keys order draws so that state changes are rare and overdraw is low. Opaque draws come first, grouped by
+     * pipeline, then material, then front to back:
+     *
+     *   63: 0 | 62-48: pipeline | 47-24: material | 23-0: depth
+     *
+     * Translucent draws follow, back to front, and only then by pipeline and material:
+     *
+     *   63: 1 | 62-39: inverted depth | 38-24: pipeline | 23-0: material
+     *
+     * depth is the distance along the view direction over the far plane, clamped to [0, 1]. Pipeline and material ids are
+     * truncated to their fields.
+     */
+    [[nodiscard]] uint64_t make_sort_key(uint16_t pipeline, uint32_t material, float depth, bool translucent) noexcept;
+
+    struct draw_sort_entry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    /**
+     * Sorts entries by key, least significant digit first (16-bit digits for large lists, bytes otherwise), skipping
+     * digits every key shares. Stable. scratch must be at least as large as entries.
+     */
+    void radix_sort(std::span<draw_sort_entry> entries, std::span<draw_sort_entry> scratch);
+
+    struct draw_item {
+        glm::mat4 world;
+        uint64_t  sort_key;
+        uint64_t  object;
+        uint32_t  mesh;
+        uint32_t  material;
+        uint16_t  pipeline;
+    };
+
+    struct draw_list {
+        std::span<const draw_item> draws; // sorted by key; runs of the same mesh and material can be instanced
+        size_t                     candidates = 0;
+    };
+
+    /**
+     * Turns the renderables of a scene into a sorted draw list each frame, without touching the GPU: it gathers every
+     * renderable's world box into a bounds_soa, culls it against the camera, sorts what is left by make_sort_key, and
+     * packs the draws in that order. Everything it produces lives in the scene's frame arena, so a draw list is valid
+     * until the next scene update starts.
+     */
+    class render_extraction {
+      public:
+        static constexpr std::string_view phase_name = "render_extraction";
+
+        /**
+         * Adds the extraction phase to the scene, after transforms are updated. The phase does nothing once the
+         * extraction is destroyed. A scene can have only one.
+         *
+         * @throws std::invalid_argument if the scene already has an extraction phase
+         */
+        [[nodiscard]] static std::shared_ptr<render_extraction> attach(const std::shared_ptr<scene::scene> &scene);
+
+        render_extraction(const render_extraction &other)                = delete;
+        render_extraction(render_extraction &&other) noexcept            = delete;
+        render_extraction &operator=(const render_extraction &other)     = delete;
+        render_extraction &operator=(render_extraction &&other) noexcept = delete;
+
+        /**
+         * Sets the camera the next updates extract for. Must not be called during an update.
+         */
+        inline void set_camera(const camera_view &camera) noexcept { m_camera = camera; }
+
+        /**
+         * @return What the last update extracted
+         */
+        [[nodiscard]] inline const draw_list &get_draw_list() const noexcept { return m_draw_list; }
+
+        /**
+         * Runs an extraction directly, allocating from the arena and splitting the work across the job system if one is
+         * given. The scene's transforms must be up to date, and nothing may change them or the renderables meanwhile.
+         */
+        [[nodiscard]] static draw_list
+        extract(scene::scene &scene, const camera_view &camera, frame_arena &arena, job_system *jobs = nullptr);
+
+      private:
+        camera_view m_camera;
+        draw_list   m_draw_list;
+
+        render_extraction() = default;
+    };
+
+} // namespace engine
@@ -0,0 +1,480 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "gpu_memory.hpp"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+namespace engine {
+
+    static uint64_t align_up(const uint64_t value, const uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    double gpu_allocator::statistics::fragmentation() const noexcept {
+        const uint64_t free_bytes = reserved_bytes - used_bytes;
+        if (free_bytes == 0)
+            return 0.0;
+        return 1.0 - static_cast<double>(contiguous_free) / static_cast<double>(free_bytes);
+    }
+
+    gpu_allocator::gpu_allocator(std::unique_ptr<gpu_memory_source> source, const settings settings)
+        : m_source(std::move(source)), m_settings(settings) {
+        if (m_settings.block_size == 0)
+            throw std::invalid_argument("gpu_allocator block_size must not be 0");
+
+        const uint32_t type_count = static_cast<uint32_t>(m_source->memory_types().size());
+        for (uint32_t type = 0; type < type_count; ++type) {
+            m_pools.push_back(pool{.type = type, .linear = true, .blocks = {}});
+            m_pools.push_back(pool{.type = type, .linear = false, .blocks = {}});
+        }
+        m_budgets.resize(m_source->heap_count());
+        update_budgets();
+    }
+
+    gpu_allocator::~gpu_allocator() {
+        m_used_metric.add(-static_cast<int64_t>(get_statistics().used_bytes));
+
+        for (uint32_t index = 0; index < m_blocks.size(); ++index) {
+            if (m_blocks[index])
+                _free_block(index);
+        }
+        for (std::optional<dedicated_memory> &dedicated : m_dedicated) {
+            if (dedicated) {
+                m_source->free(dedicated->type, dedicated->memory);
+                _track(dedicated->type, -static_cast<int64_t>(dedicated->size));
+            }
+        }
+    }
+
+    gpu_allocation gpu_allocator::allocate(const memory_request &request) {
+        std::lock_guard lock(m_mutex);
+
+        const candidate_types candidates = _candidate_types(request);
+        if (candidates.count == 0)
+            throw std::invalid_argument("No memory type fits the request");
+        const std::span types(candidates.types.data(), candidates.count);
+
+        const bool dedicated = request.dedicated || request.size >= m_settings.dedicated_threshold;
+
+        // first within the budget of each heap, and only if nothing fits there beyond it
+        std::optional<gpu_allocation> allocation;
+        for (const bool within_budget : {true, false}) {
+            for (const uint32_t type : types) {
+                if (dedicated) {
+                    allocation = _allocate_dedicated(type, request, within_budget);
+                } else {
+                    const uint32_t pool = _pool_of(type, request.linear);
+                    if (within_budget)
+                        allocation = _allocate_in_blocks(pool, request);
+                    if (!allocation)
+                        allocation = _allocate_new_block(pool, request, within_budget);
+                }
+                if (allocation)
+                    return *allocation;
+            }
+        }
+        throw std::runtime_error(std::format("Out of GPU memory for an allocation of {} bytes", request.size));
+    }
+
+    void gpu_allocator::free(gpu_allocation &allocation) {
+        if (!allocation.valid())
+            return;
+
+        std::lock_guard lock(m_mutex);
+        _free(allocation);
+        allocation = {};
+    }
+
+    std::vector<gpu_allocator::defragmentation_move> gpu_allocator::begin_defragmentation(const uint64_t max_bytes) {
+        std::lock_guard lock(m_mutex);
+
+        std::vector<defragmentation_move> moves;
+        uint64_t                          moved = 0;
+
+        for (uint32_t p = 0; p < m_pools.size(); ++p) {
+            std::vector<uint32_t> blocks = m_pools[p].blocks;
+            std::erase_if(blocks, [&](const uint32_t index) {
+                return m_blocks[index]->evacuating || m_blocks[index]->ranges.empty();
+            });
+            if (blocks.size() < 2)
+                continue;
+
+            std::ranges::sort(blocks, [&](const uint32_t a, const uint32_t b) {
+                return m_blocks[a]->ranges.used_bytes() < m_blocks[b]->ranges.used_bytes();
+            });
+
+            // the emptiest blocks are emptied into the fullest ones, for as long as everything in them fits
+            for (size_t candidate = 0; candidate + 1 < blocks.size(); ++candidate) {
+                block &source = *m_blocks[blocks[candidate]];
+                if (moved + source.ranges.used_bytes() > max_bytes)
+                    break;
+
+                std::vector<gpu_allocation> sources;
+                source.ranges.for_each_allocation([&](const uint64_t offset, uint64_t, const uint32_t node) {
+                    const record &r = source.records[node];
+                    sources.push_back(gpu_allocation{
+                        .memory = source.memory.memory,
+                        .offset = offset,
+                        .size   = r.size,
+                        .mapped = source.memory.mapped ? source.memory.mapped + offset : nullptr,
+                        .type   = m_pools[p].type,
+                        .user   = r.user,
+                        .block  = blocks[candidate],
+                        .node   = node,
+                    });
+                });
+
+                source.evacuating = true;
+                std::vector<gpu_allocation> targets;
+                for (const gpu_allocation &from : sources) {
+                    const memory_request request{
+                        .size      = from.size,
+                        .alignment = source.records[from.node].alignment,
+                        .linear    = m_pools[p].linear,
+                        .user      = from.user,
+                    };
+
+                    std::optional<gpu_allocation> to;
+                    for (size_t target = blocks.size() - 1; target > candidate && !to; --target) {
+                        if (!m_blocks[blocks[target]]->evacuating)
+                            to = _allocate_in_block(blocks[target], request);
+                    }
+                    if (!to)
+                        break;
+                    targets.push_back(*to);
+                }
+
+                if (targets.size() < sources.size()) {
+                    for (gpu_allocation &to : targets) {
+                        _free(to);
+                    }
+                    source.evacuating = false;
+                    continue;
+                }
+
+                for (size_t i = 0; i < sources.size(); ++i) {
+                    moves.push_back(defragmentation_move{.from = sources[i], .to = targets[i]});
+                }
+                moved += source.ranges.used_bytes();
+            }
+        }
+        return moves;
+    }
+
+    void gpu_allocator::end_defragmentation(const std::span<const defragmentation_move> moves) {
+        std::lock_guard lock(m_mutex);
+
+        for (const defragmentation_move &move : moves) {
+            gpu_allocation from = move.from;
+            _free(from);
+        }
+        // blocks whose moves were not all ended are used again
+        for (const std::unique_ptr<block> &b : m_blocks) {
+            if (b)
+                b->evacuating = false;
+        }
+    }
+
+    void gpu_allocator::update_budgets() {
+        std::lock_guard lock(m_mutex);
+
+        for (uint32_t heap = 0; heap < m_budgets.size(); ++heap) {
+            m_budgets[heap] = m_source->budget(heap);
+        }
+    }
+
+    heap_budget gpu_allocator::budget(const uint32_t heap) const {
+        std::lock_guard lock(m_mutex);
+        return m_budgets.at(heap);
+    }
+
+    gpu_allocator::statistics gpu_allocator::get_statistics() const {
+        std::lock_guard lock(m_mutex);
+
+        statistics stats;
+        for (const std::unique_ptr<block> &b : m_blocks) {
+            if (!b)
+                continue;
+            ++stats.blocks;
+            stats.allocations += b->ranges.allocation_count();
+            stats.reserved_bytes += b->ranges.size();
+            stats.used_bytes += b->ranges.used_bytes();
+            stats.contiguous_free += b->ranges.largest_free();
+        }
+        for (const std::optional<dedicated_memory> &dedicated : m_dedicated) {
+            if (!dedicated)
+                continue;
+            ++stats.dedicated_allocations;
+            ++stats.allocations;
+            stats.reserved_bytes += dedicated->size;
+            stats.used_bytes += dedicated->size;
+        }
+        return stats;
+    }
+
+    gpu_allocator::candidate_types gpu_allocator::_candidate_types(const memory_request &request) const {
+        const std::span<const memory_type_info> types = m_source->memory_types();
+
+        candidate_types candidates;
+        uint32_t        preferences[32];
+        for (uint32_t type = 0; type < types.size() && type < 32; ++type) {
+            if (!(request.type_bits & 1u << type))
+                continue;
+
+            const memory_type_info &info = types[type];
+            uint32_t                preference = 0;
+            switch (request.usage) {
+                case memory_usage::device:
+                    preference = (info.device_local ? 4 : 0) + (info.host_visible ? 0 : 2);
+                    break;
+                case memory_usage::upload:
+                    if (!info.host_visible || !info.host_coherent)
+                        continue;
+                    preference = (info.device_local ? 0 : 4) + (info.host_cached ? 0 : 2);
+                    break;
+                case memory_usage::readback:
+                    if (!info.host_visible || !info.host_coherent)
+                        continue;
+                    preference = (info.host_cached ? 4 : 0) + (info.device_local ? 0 : 2);
+                    break;
+            }
+
+            // insertion sort, keeping equally preferred types in index order
+            uint32_t at = candidates.count++;
+            for (; at > 0 && preferences[at - 1] < preference; --at) {
+                candidates.types[at] = candidates.types[at - 1];
+                preferences[at]      = preferences[at - 1];
+            }
+            candidates.types[at] = type;
+            preferences[at]      = preference;
+        }
+        return candidates;
+    }
+
+    std::optional<gpu_allocation>
+    gpu_allocator::_allocate_in_blocks(const uint32_t pool, const memory_request &request) {
+        for (const uint32_t index : m_pools[pool].blocks) {
+            if (m_blocks[index]->evacuating)
+                continue;
+            if (std::optional<gpu_allocation> allocation = _allocate_in_block(index, request))
+                return allocation;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<gpu_allocation>
+    gpu_allocator::_allocate_new_block(const uint32_t pool, const memory_request &request, const bool within_budget) {
+        const uint32_t type = m_pools[pool].type;
+
+        // a pool's first three blocks are an eighth, a quarter and half of block_size
+        const uint32_t shift = 3 - static_cast<uint32_t>(std::min<size_t>(m_pools[pool].blocks.size(), 3));
+        uint64_t       size  = std::max(m_settings.block_size >> shift, request.size);
+
+        gpu_memory_source::block memory;
+        while (true) {
+            if (!within_budget || _fits_budget(type, size)) {
+                memory = m_source->allocate(type, size);
+                if (memory.memory != 0)
+                    break;
+            }
+            // a smaller block may still fit
+            if (size / 2 < request.size)
+                return std::nullopt;
+            size /= 2;
+        }
+
+        uint32_t index;
+        if (!m_unused_blocks.empty()) {
+            index = m_unused_blocks.back();
+            m_unused_blocks.pop_back();
+        } else {
+            index = static_cast<uint32_t>(m_blocks.size());
+            m_blocks.emplace_back();
+        }
+        m_blocks[index] = std::make_unique<block>(block{
+            .memory     = memory,
+            .ranges     = tlsf_allocator(size),
+            .pool       = pool,
+            .records    = {},
+            .evacuating = false,
+        });
+        m_pools[pool].blocks.push_back(index);
+
+        _track(type, static_cast<int64_t>(size));
+        m_blocks_metric.increment();
+
+        return _allocate_in_block(index, request);
+    }
+
+    std::optional<gpu_allocation>
+    gpu_allocator::_allocate_dedicated(const uint32_t type, const memory_request &request, const bool within_budget) {
+        if (within_budget && !_fits_budget(type, request.size))
+            return std::nullopt;
+
+        const gpu_memory_source::block memory = m_source->allocate(type, request.size);
+        if (memory.memory == 0)
+            return std::nullopt;
+
+        uint32_t index;
+        if (!m_unused_dedicated.empty()) {
+            index = m_unused_dedicated.back();
+            m_unused_dedicated.pop_back();
+        } else {
+            index = static_cast<uint32_t>(m_dedicated.size());
+            m_dedicated.emplace_back();
+        }
+        m_dedicated[index] = dedicated_memory{.memory = memory, .type = type, .size = request.size};
+
+        _track(type, static_cast<int64_t>(request.size));
+        ++m_allocation_count;
+        m_used_metric.add(static_cast<int64_t>(request.size));
+
+        return gpu_allocation{
+            .memory = memory.memory,
+            .offset = 0,
+            .size   = request.size,
+            .mapped = memory.mapped,
+            .type   = type,
+            .user   = request.user,
+            .block  = gpu_allocation::dedicated_block,
+            .node   = index,
+        };
+    }
+
+    std::optional<gpu_allocation>
+    gpu_allocator::_allocate_in_block(const uint32_t index, const memory_request &request) {
+        block &b = *m_blocks[index];
+
+        const std::optional<tlsf_allocator::allocation> range = b.ranges.allocate(request.size, request.alignment);
+        if (!range)
+            return std::nullopt;
+
+        if (range->node >= b.records.size())
+            b.records.resize(range->node + 1);
+        b.records[range->node] = record{.size = request.size, .alignment = request.alignment, .user = request.user};
+
+        ++m_allocation_count;
+        m_used_metric.add(static_cast<int64_t>(b.ranges.size_of(range->node)));
+
+        return gpu_allocation{
+            .memory = b.memory.memory,
+            .offset = range->offset,
+            .size   = request.size,
+            .mapped = b.memory.mapped ? b.memory.mapped + range->offset : nullptr,
+            .type   = m_pools[b.pool].type,
+            .user   = request.user,
+            .block  = index,
+            .node   = range->node,
+        };
+    }
+
+    void gpu_allocator::_free(gpu_allocation &allocation) {
+        --m_allocation_count;
+
+        if (allocation.dedicated()) {
+            const dedicated_memory dedicated = *m_dedicated.at(allocation.node);
+            m_dedicated[allocation.node].reset();
+            m_unused_dedicated.push_back(allocation.node);
+
+            m_source->free(dedicated.type, dedicated.memory);
+            _track(dedicated.type, -static_cast<int64_t>(dedicated.size));
+            m_used_metric.add(-static_cast<int64_t>(dedicated.size));
+            return;
+        }
+
+        block &b = *m_blocks.at(allocation.block);
+        m_used_metric.add(-static_cast<int64_t>(b.ranges.size_of(allocation.node)));
+        b.ranges.free(allocation.node);
+        if (!b.ranges.empty())
+            return;
+
+        // one empty block is kept per pool, unless it is being emptied on purpose
+        const bool another_empty = std::ranges::any_of(m_pools[b.pool].blocks, [&](const uint32_t index) {
+            return index != allocation.block && m_blocks[index]->ranges.empty();
+        });
+        if (b.evacuating || another_empty)
+            _free_block(allocation.block);
+    }
+
+    void gpu_allocator::_free_block(const uint32_t index) {
+        const block &b = *m_blocks[index];
+
+        std::erase(m_pools[b.pool].blocks, index);
+        m_source->free(m_pools[b.pool].type, b.memory);
+        _track(m_pools[b.pool].type, -static_cast<int64_t>(b.ranges.size()));
+        m_blocks_metric.decrement();
+
+        m_blocks[index].reset();
+        m_unused_blocks.push_back(index);
+    }
+
+    bool gpu_allocator::_fits_budget(const uint32_t type, const uint64_t size) const {
+        const heap_budget &budget = m_budgets[m_source->memory_types()[type].heap];
+        return budget.usage + size <= budget.budget;
+    }
+
+    void gpu_allocator::_track(const uint32_t type, const int64_t reserved) {
+        heap_budget &budget = m_budgets[m_source->memory_types()[type].heap];
+        budget.usage        = static_cast<uint64_t>(static_cast<int64_t>(budget.usage) + reserved);
+        m_reserved_metric.add(reserved);
+    }
+
+    ring_allocator::ring_allocator(const uint64_t size) : m_size(size) {
+        if (size == 0)
+            throw std::invalid_argument("ring_allocator needs a non-empty ring");
+    }
+
+    std::optional<uint64_t> ring_allocator::allocate(const uint64_t size, const uint64_t alignment) {
+        if (size > m_size)
+            return std::nullopt;
+
+        if (m_used == 0) {
+            m_head = m_tail = 0;
+        } else if (m_head == m_tail) {
+            return std::nullopt; // full
+        }
+
+        uint64_t offset = align_up(m_head, std::max<uint64_t>(alignment, 1));
+        if (m_head >= m_tail) {
+            // the free space is after the head and before the tail
+            if (offset + size > m_size) {
+                if (size > m_tail)
+                    return std::nullopt;
+                offset = 0;
+            }
+        } else if (offset + size > m_tail) {
+            return std::nullopt;
+        }
+
+        // whatever is skipped over stays in use until the frame is retired, like the allocation itself
+        const uint64_t taken = offset >= m_head ? offset + size - m_head : m_size - m_head + size;
+        m_used += taken;
+        m_frame_used += taken;
+        m_head = offset + size;
+        return offset;
+    }
+
+    void ring_allocator::end_frame(const uint64_t frame) {
+        m_frames.push_back(ring_allocator::frame{.value = frame, .end = m_head, .used = m_frame_used});
+        m_frame_used = 0;
+    }
+
+    void ring_allocator::retire(const uint64_t frame) {
+        while (!m_frames.empty() && m_frames.front().value <= frame) {
+            m_tail = m_frames.front().end;
+            m_used -= m_frames.front().used;
+            m_frames.pop_front();
+        }
+    }
+
+    std::optional<uint64_t> ring_allocator::oldest_frame() const noexcept {
+        if (m_frames.empty())
+            return std::nullopt;
+        return m_frames.front().value;
+    }
+
+} // namespace engine
@@ -0,0 +1,331 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/metrics.hpp"
+#include "engine/render/tlsf.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace engine {
+
+    enum class memory_usage : uint8_t {
+        device,   // only the GPU touches it
+        upload,   // written by the CPU through a persistent mapping, read by the GPU
+        readback, // written by the GPU, read by the CPU
+    };
+
+    // the properties of a Vulkan memory type the allocator chooses by
+    struct memory_type_info {
+        uint32_t heap          = 0;
+        bool     device_local  = false;
+        bool     host_visible  = false;
+        bool     host_coherent = false;
+        bool     host_cached   = false;
+    };
+
+    struct heap_budget {
+        uint64_t usage  = 0; // by the whole process
+        uint64_t budget = 0; // what the process can use before allocations start failing or being paged out
+    };
+
+    /**
+     * Where gpu_allocator gets its memory: vkAllocateMemory on a device, or plain bookkeeping in benchmarks.
+     */
+    class gpu_memory_source {
+      public:
+        struct block {
+            uint64_t   memory = 0;       // a VkDeviceMemory; 0 if the allocation failed
+            std::byte *mapped = nullptr; // host-visible memory is mapped for as long as it lives
+        };
+
+        virtual ~gpu_memory_source() = default;
+
+        [[nodiscard]] virtual std::span<const memory_type_info> memory_types() const = 0;
+        [[nodiscard]] virtual uint32_t                          heap_count() const   = 0;
+
+        /**
+         * May be slow (it is a driver query), so the allocator only asks in update_budgets().
+         */
+        [[nodiscard]] virtual heap_budget budget(uint32_t heap) const = 0;
+
+        /**
+         * @return A block with no memory if the memory type is out of memory
+         */
+        [[nodiscard]] virtual block allocate(uint32_t type, uint64_t size) = 0;
+        virtual void                free(uint32_t type, block block)       = 0;
+    };
+
+    struct memory_request {
+        uint64_t     size      = 0;
+        uint64_t     alignment = 1;
+        uint32_t     type_bits = ~0u; // as in VkMemoryRequirements
+        memory_usage usage     = memory_usage::device;
+
+        // buffers and linear images; they are kept in other blocks than optimal images, so bufferImageGranularity
+        // never needs padding between neighbours
+        bool linear = true;
+
+        // the resource asks for memory of its own (VkMemoryDedicatedRequirements)
+        bool dedicated = false;
+
+        // handed back with the allocation, to find the resource again when defragmenting
+        uint64_t user = 0;
+    };
+
+    struct gpu_allocation {
+        static constexpr uint32_t dedicated_block = UINT32_MAX;
+
+        uint64_t   memory = 0; // the VkDeviceMemory to bind to
+        uint64_t   offset = 0;
+        uint64_t   size   = 0;
+        std::byte *mapped = nullptr; // already at offset; null unless the memory is host visible
+        uint32_t   type   = 0;
+        uint64_t   user   = 0;
+
+        // the allocator's bookkeeping: the block and its tlsf node, or for dedicated memory the index of the record
+        uint32_t block = dedicated_block;
+        uint32_t node  = tlsf_allocator::no_node;
+
+        [[nodiscard]] inline bool valid() const noexcept { return memory != 0; }
+        [[nodiscard]] inline bool dedicated() const noexcept { return block == dedicated_block; }
+    };
+
+    /**
+     * Sub-allocates resources out of large blocks of device memory, so a scene of thousands of buffers and images makes
+     * a few dozen vkAllocateMemory calls instead of running into maxMemoryAllocationCount and per-allocation driver
+     * overhead.
+     *
+     * Each memory type has two pools of blocks, one for linear resources and one for optimal images, and each block is
+     * split up by a tlsf_allocator. A pool's first blocks are smaller than block_size, so a memory type that is barely
+     * used does not hold a whole block, and one empty block per pool is kept rather than freed so an allocation going
+     * back and forth across a block boundary does not allocate device memory each time. Requests as large as
+     * dedicated_threshold, or that ask for it, get memory of their own.
+     *
+     * New memory is only taken from heaps with room in their budget (VK_EXT_memory_budget) while any allowed memory
+     * type has room; the budgets are refreshed by update_budgets(), which should be called once a frame.
+     *
+     * Thread-safe.
+     */
+    class gpu_allocator {
+      public:
+        struct settings {
+            uint64_t block_size          = uint64_t(256) << 20;
+            uint64_t dedicated_threshold = uint64_t(64) << 20;
+        };
+
+        struct defragmentation_move {
+            gpu_allocation from;
+            gpu_allocation to;
+        };
+
+        struct statistics {
+            uint32_t blocks                = 0;
+            uint32_t dedicated_allocations = 0;
+            uint32_t allocations           = 0; // including dedicated ones
+            uint64_t reserved_bytes        = 0; // taken from the source
+            uint64_t used_bytes            = 0; // allocated out of it
+            uint64_t contiguous_free       = 0; // the largest free range of each block, summed
+
+            /**
+             * @return 0 when the free space of each block is one range, approaching 1 as it is scattered
+             */
+            [[nodiscard]] double fragmentation() const noexcept;
+        };
+
+        gpu_allocator(std::unique_ptr<gpu_memory_source> source, settings settings);
+
+        /**
+         * Every allocation should have been freed by now; any left have their memory freed regardless.
+         */
+        ~gpu_allocator();
+
+        gpu_allocator(const gpu_allocator &other)                = delete;
+        gpu_allocator(gpu_allocator &&other) noexcept            = delete;
+        gpu_allocator &operator=(const gpu_allocator &other)     = delete;
+        gpu_allocator &operator=(gpu_allocator &&other) noexcept = delete;
+
+        /**
+         * Takes the first memory type, in order of preference for the usage, that can hold the request. Device memory
+         * prefers device-local types, uploads prefer host-visible types that are not device local (leaving the small
+         * BAR heap to whoever asks for it), readbacks prefer cached ones; uploads and readbacks need host-visible and
+         * host-coherent memory.
+         *
+         * @throws std::invalid_argument if no memory type fits the request
+         * @throws std::runtime_error if every memory type that fits is out of memory
+         */
+        [[nodiscard]] gpu_allocation allocate(const memory_request &request);
+
+        /**
+         * Frees the allocation and resets it. Does nothing to an invalid allocation.
+         */
+        void free(gpu_allocation &allocation);
+
+        /**
+         * Plans moving allocations out of the emptiest blocks of each pool into fuller ones, so the emptied blocks can
+         * be freed, moving at most max_bytes. Only blocks that can be emptied completely are picked.
+         *
+         * For each move the caller copies the contents, binds the resource again to the new allocation (which means a
+         * new VkBuffer or VkImage, since binding is permanent), and once the copies have finished hands the moves to
+         * end_defragmentation(). In the meantime nothing is allocated in the blocks being emptied, and the moved
+         * allocations must not be freed.
+         */
+        [[nodiscard]] std::vector<defragmentation_move> begin_defragmentation(uint64_t max_bytes = UINT64_MAX);
+
+        /**
+         * Frees the sources of the moves, and the blocks that leaves empty.
+         */
+        void end_defragmentation(std::span<const defragmentation_move> moves);
+
+        /**
+         * Asks the source for the usage and budget of every heap.
+         */
+        void update_budgets();
+
+        /**
+         * @return The budget of a heap as of the last update_budgets(), with what this allocator has taken or given
+         * back since counted in its usage
+         */
+        [[nodiscard]] heap_budget budget(uint32_t heap) const;
+
+        [[nodiscard]] statistics get_statistics() const;
+
+        [[nodiscard]] inline const settings &get_settings() const noexcept { return m_settings; }
+        [[nodiscard]] inline gpu_memory_source &source() const noexcept { return *m_source; }
+
+      private:
+        struct record {
+            uint64_t size      = 0;
+            uint64_t alignment = 1;
+            uint64_t user      = 0;
+        };
+
+        struct dedicated_memory {
+            gpu_memory_source::block memory;
+            uint32_t                 type;
+            uint64_t                 size;
+        };
+
+        struct block {
+            gpu_memory_source::block memory;
+            tlsf_allocator           ranges;
+            uint32_t                 pool;
+            std::vector<record>      records; // by tlsf node
+            bool                     evacuating = false;
+        };
+
+        struct pool {
+            uint32_t              type;
+            bool                  linear;
+            std::vector<uint32_t> blocks;
+        };
+
+        mutable std::mutex                 m_mutex;
+        std::unique_ptr<gpu_memory_source> m_source;
+        settings                           m_settings;
+
+        std::vector<pool>                   m_pools; // two per memory type: linear, then optimal
+        std::vector<std::unique_ptr<block>> m_blocks; // null where a block was freed
+        std::vector<uint32_t>               m_unused_blocks;
+
+        std::vector<std::optional<dedicated_memory>> m_dedicated;
+        std::vector<uint32_t>                        m_unused_dedicated;
+        uint32_t                                     m_allocation_count = 0;
+
+        std::vector<heap_budget> m_budgets;
+
+        metrics::counter m_reserved_metric = metrics::registry::get().get_up_down_counter("gpu_memory_reserved_bytes");
+        metrics::counter m_used_metric     = metrics::registry::get().get_up_down_counter("gpu_memory_used_bytes");
+        metrics::counter m_blocks_metric   = metrics::registry::get().get_up_down_counter("gpu_memory_blocks");
+
+        struct candidate_types {
+            std::array<uint32_t, 32> types; // VK_MAX_MEMORY_TYPES
+            uint32_t                 count = 0;
+        };
+
+        // the memory types that can hold the request, most preferred first
+        [[nodiscard]] candidate_types _candidate_types(const memory_request &request) const;
+
+        [[nodiscard]] inline uint32_t _pool_of(const uint32_t type, const bool linear) const noexcept {
+            return type * 2 + (linear ? 0 : 1);
+        }
+
+        // tries the blocks the pool already has, which cost no budget
+        [[nodiscard]] std::optional<gpu_allocation> _allocate_in_blocks(uint32_t pool, const memory_request &request);
+
+        [[nodiscard]] std::optional<gpu_allocation>
+        _allocate_new_block(uint32_t pool, const memory_request &request, bool within_budget);
+
+        [[nodiscard]] std::optional<gpu_allocation>
+        _allocate_dedicated(uint32_t type, const memory_request &request, bool within_budget);
+
+        [[nodiscard]] std::optional<gpu_allocation> _allocate_in_block(uint32_t index, const memory_request &request);
+
+        void _free(gpu_allocation &allocation);
+        void _free_block(uint32_t index);
+
+        [[nodiscard]] bool _fits_budget(uint32_t type, uint64_t size) const;
+        void               _track(uint32_t type, int64_t reserved);
+    };
+
+    /**
+     * Hands out space in a ring buffer for data that lives a frame or two, such as staging copies. Space is handed out
+     * in order and given back a whole frame at a time, once that frame is retired. Only offsets are handed out; the
+     * memory is elsewhere. Not thread-safe.
+     */
+    class ring_allocator {
+      public:
+        explicit ring_allocator(uint64_t size);
+
+        /**
+         * Never splits an allocation across the end of the ring; space left at the end is skipped.
+         *
+         * @return Nothing if there is no room until more frames are retired
+         */
+        [[nodiscard]] std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment);
+
+        /**
+         * Closes the frame: everything allocated since the last end_frame() is given back when this frame is retired.
+         */
+        void end_frame(uint64_t frame);
+
+        /**
+         * Gives back the space of every frame up to and including this one.
+         */
+        void retire(uint64_t frame);
+
+        /**
+         * @return The oldest frame not retired yet, or nothing if every closed frame is
+         */
+        [[nodiscard]] std::optional<uint64_t> oldest_frame() const noexcept;
+
+        [[nodiscard]] inline uint64_t size() const noexcept { return m_size; }
+        [[nodiscard]] inline uint64_t used_bytes() const noexcept { return m_used; }
+
+      private:
+        struct frame {
+            uint64_t value;
+            uint64_t end; // the head when the frame was closed
+            uint64_t used;
+        };
+
+        uint64_t m_size;
+        uint64_t m_head       = 0; // where the next allocation goes
+        uint64_t m_tail       = 0; // the start of the oldest space still in use
+        uint64_t m_used       = 0; // including space skipped at the end
+        uint64_t m_frame_used = 0; // by the open frame
+
+        std::deque<frame> m_frames;
+    };
+
+} // namespace engine
@@ -0,0 +1,128 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "gpu_memory_vulkan.hpp"
+
+namespace engine {
+
+    vulkan_memory_source::vulkan_memory_source(const render_device &device)
+        : m_physical_device(device.physical_device()), m_device(device.device()),
+          m_memory_budget(device.has_memory_budget()) {
+        const vk::PhysicalDeviceMemoryProperties memory = m_physical_device.getMemoryProperties();
+
+        for (uint32_t i = 0; i < memory.memoryTypeCount; ++i) {
+            const vk::MemoryPropertyFlags flags = memory.memoryTypes[i].propertyFlags;
+            m_types.push_back(memory_type_info{
+                .heap          = memory.memoryTypes[i].heapIndex,
+                .device_local  = static_cast<bool>(flags & vk::MemoryPropertyFlagBits::eDeviceLocal),
+                .host_visible  = static_cast<bool>(flags & vk::MemoryPropertyFlagBits::eHostVisible),
+                .host_coherent = static_cast<bool>(flags & vk::MemoryPropertyFlagBits::eHostCoherent),
+                .host_cached   = static_cast<bool>(flags & vk::MemoryPropertyFlagBits::eHostCached),
+            });
+        }
+        for (uint32_t i = 0; i < memory.memoryHeapCount; ++i) {
+            m_heap_sizes.push_back(memory.memoryHeaps[i].size);
+        }
+        m_heap_usage.resize(m_heap_sizes.size());
+    }
+
+    heap_budget vulkan_memory_source::budget(const uint32_t heap) const {
+        if (!m_memory_budget)
+            return heap_budget{.usage = m_heap_usage.at(heap), .budget = m_heap_sizes.at(heap) / 10 * 8};
+
+        const auto chain = m_physical_device.getMemoryProperties2<
+            vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        const auto &budgets = chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        return heap_budget{.usage = budgets.heapUsage[heap], .budget = budgets.heapBudget[heap]};
+    }
+
+    gpu_memory_source::block vulkan_memory_source::allocate(const uint32_t type, const uint64_t size) {
+        vk::MemoryAllocateInfo allocate_info{};
+        allocate_info.setAllocationSize(size);
+        allocate_info.setMemoryTypeIndex(type);
+
+        vk::raii::DeviceMemory memory(nullptr);
+        try {
+            memory = vk::raii::DeviceMemory(m_device, allocate_info);
+        } catch (const vk::OutOfDeviceMemoryError &) {
+            return {};
+        } catch (const vk::OutOfHostMemoryError &) {
+            return {};
+        }
+
+        std::byte *mapped = nullptr;
+        if (m_types[type].host_visible) {
+            mapped = static_cast<std::byte *>(memory.mapMemory(0, VK_WHOLE_SIZE));
+        }
+
+        // freeing memory unmaps it, so the handle can be let go of here and freed through the dispatcher later
+        const uint64_t handle = std::bit_cast<uint64_t>(static_cast<VkDeviceMemory>(memory.release()));
+        m_allocation_sizes.emplace(handle, size);
+        m_heap_usage[m_types[type].heap] += size;
+        return block{.memory = handle, .mapped = mapped};
+    }
+
+    void vulkan_memory_source::free(const uint32_t type, const block block) {
+        m_device.getDispatcher()->vkFreeMemory(*m_device, std::bit_cast<VkDeviceMemory>(block.memory), nullptr);
+
+        const auto it = m_allocation_sizes.find(block.memory);
+        m_heap_usage[m_types[type].heap] -= it->second;
+        m_allocation_sizes.erase(it);
+    }
+
+    gpu_allocation bind_buffer_memory(
+        const vk::raii::Device &device, gpu_allocator &allocator, const vk::raii::Buffer &buffer,
+        const memory_usage usage, const uint64_t user
+    ) {
+        const auto chain = device.getBufferMemoryRequirements2<
+            vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(vk::BufferMemoryRequirementsInfo2(*buffer));
+        const vk::MemoryRequirements          &requirements = chain.get<vk::MemoryRequirements2>().memoryRequirements;
+        const vk::MemoryDedicatedRequirements &dedicated    = chain.get<vk::MemoryDedicatedRequirements>();
+
+        gpu_allocation allocation = allocator.allocate(memory_request{
+            .size      = requirements.size,
+            .alignment = requirements.alignment,
+            .type_bits = requirements.memoryTypeBits,
+            .usage     = usage,
+            .linear    = true,
+            .dedicated = static_cast<bool>(dedicated.prefersDedicatedAllocation),
+            .user      = user,
+        });
+        try {
+            buffer.bindMemory(to_vulkan_memory(allocation.memory), allocation.offset);
+        } catch (...) {
+            allocator.free(allocation);
+            throw;
+        }
+        return allocation;
+    }
+
+    gpu_allocation bind_image_memory(
+        const vk::raii::Device &device, gpu_allocator &allocator, const vk::raii::Image &image,
+        const memory_usage usage, const bool linear, const uint64_t user
+    ) {
+        const auto chain = device.getImageMemoryRequirements2<
+            vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(vk::ImageMemoryRequirementsInfo2(*image));
+        const vk::MemoryRequirements          &requirements = chain.get<vk::MemoryRequirements2>().memoryRequirements;
+        const vk::MemoryDedicatedRequirements &dedicated    = chain.get<vk::MemoryDedicatedRequirements>();
+
+        gpu_allocation allocation = allocator.allocate(memory_request{
+            .size      = requirements.size,
+            .alignment = requirements.alignment,
+            .type_bits = requirements.memoryTypeBits,
+            .usage     = usage,
+            .linear    = linear,
+            .dedicated = static_cast<bool>(dedicated.prefersDedicatedAllocation),
+            .user      = user,
+        });
+        try {
+            image.bindMemory(to_vulkan_memory(allocation.memory), allocation.offset);
+        } catch (...) {
+            allocator.free(allocation);
+            throw;
+        }
+        return allocation;
+    }
+
+} // namespace engine
@@ -0,0 +1,67 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/render/gpu_memory.hpp"
+#include "engine/render/render_device.hpp"
+
+#include <bit>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace engine {
+
+    /**
+     * Device memory for gpu_allocator. Host-visible memory is mapped once when allocated and stays mapped. Budgets come
+     * from VK_EXT_memory_budget where the device has it; elsewhere the budget is 80% of the heap and the usage is what
+     * this source has allocated.
+     */
+    class vulkan_memory_source final : public gpu_memory_source {
+      public:
+        explicit vulkan_memory_source(const render_device &device);
+
+        [[nodiscard]] std::span<const memory_type_info> memory_types() const override { return m_types; }
+        [[nodiscard]] uint32_t heap_count() const override { return static_cast<uint32_t>(m_heap_sizes.size()); }
+        [[nodiscard]] heap_budget budget(uint32_t heap) const override;
+
+        [[nodiscard]] block allocate(uint32_t type, uint64_t size) override;
+        void                free(uint32_t type, block block) override;
+
+      private:
+        const vk::raii::PhysicalDevice &m_physical_device;
+        const vk::raii::Device         &m_device;
+        bool                            m_memory_budget;
+
+        std::vector<memory_type_info> m_types;
+        std::vector<uint64_t>         m_heap_sizes;
+        std::vector<uint64_t>         m_heap_usage; // allocated through this source
+
+        // by memory, to take freed memory off the usage; only touched under the allocator's lock
+        std::unordered_map<uint64_t, uint64_t> m_allocation_sizes;
+    };
+
+    [[nodiscard]] inline vk::DeviceMemory to_vulkan_memory(const uint64_t memory) noexcept {
+        return vk::DeviceMemory(std::bit_cast<VkDeviceMemory>(memory));
+    }
+
+    /**
+     * Allocates memory for a buffer (honouring VkMemoryDedicatedRequirements) and binds it.
+     */
+    [[nodiscard]] gpu_allocation bind_buffer_memory(
+        const vk::raii::Device &device, gpu_allocator &allocator, const vk::raii::Buffer &buffer, memory_usage usage,
+        uint64_t user = 0
+    );
+
+    /**
+     * Allocates memory for an image (honouring VkMemoryDedicatedRequirements) and binds it. linear is whether the image
+     * has linear tiling.
+     */
+    [[nodiscard]] gpu_allocation bind_image_memory(
+        const vk::raii::Device &device, gpu_allocator &allocator, const vk::raii::Image &image, memory_usage usage,
+        bool linear = false, uint64_t user = 0
+    );
+
+} // namespace engine
@@ -5,36 +5,176 @@
 #include "render_device.hpp"
 
 #include "engine/logging.hpp"
+#include "engine/metrics.hpp"
+#include "engine/profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
 
 namespace engine {
 
-    render_device::render_device(const std::shared_ptr<window> &window)
-        : m_window(window), m_instance(nullptr), m_surface(nullptr), m_physical_device(nullptr) {
+    using startup_clock = std::chrono::steady_clock;
 
-        m_logger = create_logger("render");
+    static double seconds_since(const startup_clock::time_point start) {
+        return std::chrono::duration<double>(startup_clock::now() - start).count();
+    }
 
-        _create_instance();
-        m_surface = m_window->create_surface(m_instance);
-        _select_physical_device();
+    /**
+     * Prefers discrete GPUs, then integrated, virtual and software ones, and within a type the one with the most
+     * device-local memory.
+     */
+    static uint64_t score_physical_device(const vk::raii::PhysicalDevice &device) {
+        uint64_t type_rank = 0;
+        switch (device.getProperties().deviceType) {
+            case vk::PhysicalDeviceType::eDiscreteGpu:
+                type_rank = 4;
+                break;
+            case vk::PhysicalDeviceType::eIntegratedGpu:
+                type_rank = 3;
+                break;
+            case vk::PhysicalDeviceType::eVirtualGpu:
+                type_rank = 2;
+                break;
+            case vk::PhysicalDeviceType::eCpu:
+                type_rank = 1;
+                break;
+            default:
+                break;
+        }
 
-        {
-            const auto &props = m_physical_device.getProperties();
-            m_logger->info("Selected Physical Device: {}", props.deviceName.data());
+        uint64_t                                 device_local = 0;
+        const vk::PhysicalDeviceMemoryProperties memory       = device.getMemoryProperties();
+        for (uint32_t i = 0; i < memory.memoryHeapCount; ++i) {
+            if (memory.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+                device_local += memory.memoryHeaps[i].size;
         }
+
+        // memory is counted in MiB, which leaves the type in the top bits for any real amount of memory
+        return type_rank << 48 | std::min<uint64_t>(device_local >> 20, (uint64_t(1) << 48) - 1);
     }
 
-    render_device::~render_device() {}
+    static bool has_extension(const vk::raii::PhysicalDevice &device, const std::string_view name) {
+        for (const vk::ExtensionProperties &extension : device.enumerateDeviceExtensionProperties()) {
+            if (name == extension.extensionName.data())
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * Checks that cache data was written by this device and driver. Drivers are required to reject foreign data
+     * themselves, but not all of them do so gracefully.
+     */
+    static bool pipeline_cache_matches(const std::vector<char> &data, const vk::PhysicalDeviceProperties &properties) {
+        struct header {
+            uint32_t size;
+            uint32_t version;
+            uint32_t vendor;
+            uint32_t device;
+            uint8_t  uuid[VK_UUID_SIZE];
+        } h;
+
+        if (data.size() < sizeof(header))
+            return false;
+        std::memcpy(&h, data.data(), sizeof(header));
+
+        return h.size >= sizeof(header) && h.version == static_cast<uint32_t>(vk::PipelineCacheHeaderVersion::eOne) &&
+               h.vendor == properties.vendorID && h.device == properties.deviceID &&
+               std::memcmp(h.uuid, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+    }
+
+    render_device::render_device(const settings &settings)
+        : m_window(settings.window), m_instance(nullptr), m_surface(nullptr), m_physical_device(nullptr),
+          m_device(nullptr), m_graphics_queue(nullptr), m_transfer_queue(nullptr), m_pipeline_cache(nullptr) {
+        ENGINE_PROFILE_ZONE("render_device setup");
+
+        m_logger = event_logger(create_logger("render"));
+
+        auto start = startup_clock::now();
+        _create_instance();
+        if (m_window) {
+            m_surface = m_window->create_surface(m_instance);
+        }
+        m_startup_times.instance = seconds_since(start);
+
+        start = startup_clock::now();
+        _select_physical_device(settings.device_override);
+        _create_device();
+        m_startup_times.device = seconds_since(start);
+
+        start = startup_clock::now();
+        _create_pipeline_cache(settings.pipeline_cache_directory);
+        m_startup_times.pipeline_cache = seconds_since(start);
 
-    const std::shared_ptr<spdlog::logger> &render_device::logger() const {
+        ENGINE_LOG(
+            m_logger, spdlog::level::info,
+            "Device ready{}: instance {:.1f} ms, device {:.1f} ms, pipeline cache {:.1f} ms",
+            headless() ? " (headless)" : "", m_startup_times.instance * 1e3, m_startup_times.device * 1e3,
+            m_startup_times.pipeline_cache * 1e3
+        );
+
+        _publish_memory_heaps();
+    }
+
+    render_device::~render_device() {
+        try {
+            save_pipeline_cache();
+        } catch (const std::exception &e) {
+            ENGINE_LOG(m_logger, spdlog::level::err, "Failed to save the pipeline cache: {}", e.what());
+        }
+    }
+
+    const event_logger &render_device::logger() const {
         return m_logger;
     }
 
+    std::vector<uint32_t> render_device::queue_families() const {
+        if (m_transfer_queue_family == m_graphics_queue_family)
+            return {m_graphics_queue_family};
+        return {m_graphics_queue_family, m_transfer_queue_family};
+    }
+
+    void render_device::save_pipeline_cache() const {
+        if (m_pipeline_cache_path.empty())
+            return;
+        ENGINE_PROFILE_ZONE("render_device::save_pipeline_cache");
+
+        const std::vector<uint8_t> data = m_pipeline_cache.getData();
+
+        std::filesystem::create_directories(m_pipeline_cache_path.parent_path());
+        std::filesystem::path temporary = m_pipeline_cache_path;
+        temporary += ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!out)
+                throw std::runtime_error("Failed to write " + temporary.string());
+        }
+        std::filesystem::rename(temporary, m_pipeline_cache_path);
+
+        ENGINE_LOG(
+            m_logger, spdlog::level::debug, "Saved {} bytes of pipeline cache to {}", data.size(),
+            m_pipeline_cache_path.string()
+        );
+    }
+
     void render_device::_create_instance() {
         constexpr vk::ApplicationInfo app_info = vk::ApplicationInfo().setApiVersion(vk::ApiVersion14);
 
-        uint32_t     count;
-        const char **required_extensions = glfwGetRequiredInstanceExtensions(&count);
-        std::vector  extensions(required_extensions, required_extensions + count);
+        // a headless instance needs no extensions, and so works without GLFW being initialized
+        std::vector<const char *> extensions;
+        if (m_window) {
+            uint32_t     count;
+            const char **required_extensions = glfwGetRequiredInstanceExtensions(&count);
+            extensions.assign(required_extensions, required_extensions + count);
+        }
 
         vk::InstanceCreateInfo instance_create_info{};
         instance_create_info.setPApplicationInfo(&app_info);
@@ -42,7 +182,178 @@ namespace engine {
         m_instance = vk::raii::Instance(m_context, instance_create_info);
     }
 
-    void render_device::_select_physical_device() {
-        m_physical_device = m_instance.enumeratePhysicalDevices()[0];
+    void render_device::_select_physical_device(const std::string &device_override) {
+        std::vector<vk::raii::PhysicalDevice> devices = m_instance.enumeratePhysicalDevices();
+
+        size_t   best       = devices.size();
+        uint64_t best_score = 0;
+        for (size_t i = 0; i < devices.size(); ++i) {
+            const vk::PhysicalDeviceProperties props = devices[i].getProperties();
+            const std::string_view             name  = props.deviceName.data();
+
+            if (props.apiVersion < vk::ApiVersion13) {
+                ENGINE_LOG(
+                    m_logger, spdlog::level::debug, "Skipping physical device {}: Vulkan 1.3 is required", name
+                );
+                continue;
+            }
+            if (!_find_queue_family(devices[i])) {
+                ENGINE_LOG(
+                    m_logger, spdlog::level::debug,
+                    "Skipping physical device {}: no queue family can draw (and present)", name
+                );
+                continue;
+            }
+
+            const uint64_t score = score_physical_device(devices[i]);
+            ENGINE_LOG(m_logger, spdlog::level::debug, "Physical device {}: score {:#x}", name, score);
+
+            if (!device_override.empty()) {
+                if (name.find(device_override) != std::string_view::npos) {
+                    best = i;
+                    break;
+                }
+            } else if (best == devices.size() || score > best_score) {
+                best       = i;
+                best_score = score;
+            }
+        }
+
+        if (best == devices.size()) {
+            throw std::runtime_error(
+                device_override.empty() ? "No suitable physical device"
+                                        : "No suitable physical device matches \"" + device_override + "\""
+            );
+        }
+
+        m_physical_device       = std::move(devices[best]);
+        m_graphics_queue_family = *_find_queue_family(m_physical_device);
+
+        const auto &props = m_physical_device.getProperties();
+        ENGINE_LOG(m_logger, spdlog::level::info, "Selected Physical Device: {}", props.deviceName.data());
+    }
+
+    void render_device::_create_device() {
+        m_transfer_queue_family = _find_transfer_queue_family();
+
+        const float                            priority = 1.0f;
+        std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
+        for (const uint32_t family : queue_families()) {
+            vk::DeviceQueueCreateInfo queue_create_info{};
+            queue_create_info.setQueueFamilyIndex(family);
+            queue_create_info.setQueuePriorities(priority);
+            queue_create_infos.push_back(queue_create_info);
+        }
+
+        std::vector<const char *> extensions;
+        if (m_window) {
+            extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
+        m_memory_budget = has_extension(m_physical_device, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (m_memory_budget) {
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
+        // render graph barriers are recorded with vkCmdPipelineBarrier2, and uploads are tracked with a timeline
+        // semaphore
+        vk::PhysicalDeviceVulkan13Features features_13{};
+        features_13.setSynchronization2(true);
+        vk::PhysicalDeviceVulkan12Features features_12{};
+        features_12.setTimelineSemaphore(true);
+        features_12.setPNext(&features_13);
+
+        vk::DeviceCreateInfo device_create_info{};
+        device_create_info.setPNext(&features_12);
+        device_create_info.setQueueCreateInfos(queue_create_infos);
+        device_create_info.setPEnabledExtensionNames(extensions);
+        m_device         = vk::raii::Device(m_physical_device, device_create_info);
+        m_graphics_queue = vk::raii::Queue(m_device, m_graphics_queue_family, 0);
+        if (m_transfer_queue_family != m_graphics_queue_family) {
+            m_transfer_queue = vk::raii::Queue(m_device, m_transfer_queue_family, 0);
+            ENGINE_LOG(m_logger, spdlog::level::info, "Using queue family {} for transfers", m_transfer_queue_family);
+        }
+    }
+
+    void render_device::_create_pipeline_cache(const std::filesystem::path &directory) {
+        const vk::PhysicalDeviceProperties props = m_physical_device.getProperties();
+
+        std::vector<char> data;
+        if (!directory.empty()) {
+            // a driver update or a different GPU gets a cache of its own rather than one it would reject
+            std::string uuid;
+            for (const uint8_t byte : props.pipelineCacheUUID) {
+                uuid += std::format("{:02x}", byte);
+            }
+            const std::string file_name = std::format(
+                "pipeline_cache_{:04x}_{:04x}_{:08x}_{}.bin", props.vendorID, props.deviceID, props.driverVersion, uuid
+            );
+            m_pipeline_cache_path = directory / file_name;
+
+            if (std::ifstream in(m_pipeline_cache_path, std::ios::binary); in) {
+                data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            if (!data.empty() && !pipeline_cache_matches(data, props)) {
+                ENGINE_LOG(
+                    m_logger, spdlog::level::warn, "Ignoring pipeline cache {}: written by another device",
+                    m_pipeline_cache_path.string()
+                );
+                data.clear();
+            }
+        }
+
+        vk::PipelineCacheCreateInfo cache_create_info{};
+        cache_create_info.setInitialDataSize(data.size());
+        cache_create_info.setPInitialData(data.data());
+        try {
+            m_pipeline_cache = vk::raii::PipelineCache(m_device, cache_create_info);
+        } catch (const vk::SystemError &e) {
+            ENGINE_LOG(
+                m_logger, spdlog::level::warn, "Driver rejected the pipeline cache, starting empty: {}", e.what()
+            );
+            m_pipeline_cache = vk::raii::PipelineCache(m_device, vk::PipelineCacheCreateInfo{});
+        }
+
+        ENGINE_LOG(m_logger, spdlog::level::info, "Loaded {} bytes of pipeline cache", data.size());
+    }
+
+    std::optional<uint32_t> render_device::_find_queue_family(const vk::raii::PhysicalDevice &device) const {
+        if (m_window && !has_extension(device, VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+            return std::nullopt;
+
+        const std::vector<vk::QueueFamilyProperties> families = device.getQueueFamilyProperties();
+        for (uint32_t i = 0; i < families.size(); ++i) {
+            if (!(families[i].queueFlags & vk::QueueFlagBits::eGraphics))
+                continue;
+            if (m_window && !device.getSurfaceSupportKHR(i, *m_surface))
+                continue;
+            return i;
+        }
+        return std::nullopt;
+    }
+
+    uint32_t render_device::_find_transfer_queue_family() const {
+        const std::vector<vk::QueueFamilyProperties> families = m_physical_device.getQueueFamilyProperties();
+        for (uint32_t i = 0; i < families.size(); ++i) {
+            const vk::QueueFlags flags = families[i].queueFlags;
+            if ((flags & vk::QueueFlagBits::eTransfer) &&
+                !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
+                return i;
+        }
+        return m_graphics_queue_family;
+    }
+
+    void render_device::_publish_memory_heaps() const {
+        const vk::PhysicalDeviceMemoryProperties memory = m_physical_device.getMemoryProperties();
+        for (uint32_t i = 0; i < memory.memoryHeapCount; ++i) {
+            const vk::MemoryHeap &heap = memory.memoryHeaps[i];
+
+            const bool device_local = static_cast<bool>(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+            metrics::registry::get()
+                .get_gauge(
+                    "gpu_memory_heap_bytes{heap=\"" + std::to_string(i) +
+                    "\",device_local=\"" + (device_local ? "true" : "false") + "\"}"
+                )
+                .set(static_cast<int64_t>(heap.size));
+        }
     }
 } // namespace engine
@@ -4,31 +4,136 @@
 
 #pragma once
 
+#include "engine/binary_log.hpp"
 #include "engine/os.hpp"
 
+#include <filesystem>
+#include <optional>
 #include <spdlog/spdlog.h>
+#include <string>
+#include <vector>
 #include <vulkan/vulkan_raii.hpp>
 
 namespace engine {
 
     class render_device {
       public:
-        explicit render_device(const std::shared_ptr<window> &window);
+        struct settings {
+            // null for a headless device, which has no surface or swapchain and does not need GLFW, so it can run on a
+            // software driver such as lavapipe
+            std::shared_ptr<::engine::window> window;
+
+            // takes the first suitable physical device whose name contains this instead of the best-scoring one
+            std::string device_override;
+
+            // where the pipeline cache is loaded from and saved to; empty keeps it in memory only
+            std::filesystem::path pipeline_cache_directory = "cache";
+        };
+
+        // seconds spent in each step of construction
+        struct startup_times {
+            double instance       = 0.0; // including the surface
+            double device         = 0.0; // selecting the physical device and creating the logical one
+            double pipeline_cache = 0.0;
+        };
+
+        explicit render_device(const settings &settings);
+
+        /**
+         * Saves the pipeline cache.
+         */
         ~render_device();
 
-        const std::shared_ptr<spdlog::logger> &logger() const;
+        render_device(const render_device &other)                = delete;
+        render_device(render_device &&other) noexcept            = delete;
+        render_device &operator=(const render_device &other)     = delete;
+        render_device &operator=(render_device &&other) noexcept = delete;
+
+        const event_logger &logger() const;
+
+        /**
+         * Writes the pipeline cache to a temporary file and renames it over the old one, so a crash mid-write never
+         * leaves a truncated cache behind. Does nothing without a cache directory.
+         *
+         * @throws std::runtime_error if the file cannot be written
+         */
+        void save_pipeline_cache() const;
+
+        [[nodiscard]] inline bool headless() const noexcept { return m_window == nullptr; }
+
+        [[nodiscard]] inline const vk::raii::Instance &instance() const noexcept { return m_instance; }
+        [[nodiscard]] inline const vk::raii::Device   &device() const noexcept { return m_device; }
+        [[nodiscard]] inline const vk::raii::Queue    &graphics_queue() const noexcept { return m_graphics_queue; }
+        [[nodiscard]] inline uint32_t graphics_queue_family() const noexcept { return m_graphics_queue_family; }
+
+        /**
+         * A queue of a transfer-only family if the device has one, so uploads run alongside rendering; otherwise the
+         * graphics queue.
+         */
+        [[nodiscard]] inline const vk::raii::Queue &transfer_queue() const noexcept {
+            return m_transfer_queue_family == m_graphics_queue_family ? m_graphics_queue : m_transfer_queue;
+        }
+        [[nodiscard]] inline uint32_t transfer_queue_family() const noexcept { return m_transfer_queue_family; }
+
+        /**
+         * @return The distinct queue families in use, for resources shared between them with
+         * vk::SharingMode::eConcurrent
+         */
+        [[nodiscard]] std::vector<uint32_t> queue_families() const;
+
+        /**
+         * @return Whether VK_EXT_memory_budget is enabled, so heap budgets come from the driver
+         */
+        [[nodiscard]] inline bool has_memory_budget() const noexcept { return m_memory_budget; }
+
+        [[nodiscard]] inline const vk::raii::PhysicalDevice &physical_device() const noexcept {
+            return m_physical_device;
+        }
+
+        /**
+         * Pass this to every pipeline creation so pipelines compiled in earlier runs are not compiled again.
+         */
+        [[nodiscard]] inline const vk::raii::PipelineCache &pipeline_cache() const noexcept { return m_pipeline_cache; }
+
+        /**
+         * @return Empty if the pipeline cache is only kept in memory
+         */
+        [[nodiscard]] inline const std::filesystem::path &pipeline_cache_path() const noexcept {
+            return m_pipeline_cache_path;
+        }
+
+        [[nodiscard]] inline const startup_times &get_startup_times() const noexcept { return m_startup_times; }
 
       private:
-        std::shared_ptr<window>         m_window;
-        std::shared_ptr<spdlog::logger> m_logger;
+        std::shared_ptr<window> m_window;
+        event_logger            m_logger;
 
         vk::raii::Context        m_context;
         vk::raii::Instance       m_instance;
         vk::raii::SurfaceKHR     m_surface;
         vk::raii::PhysicalDevice m_physical_device;
+        vk::raii::Device         m_device;
+        vk::raii::Queue          m_graphics_queue;
+        vk::raii::Queue          m_transfer_queue;
+        vk::raii::PipelineCache  m_pipeline_cache;
+        uint32_t                 m_graphics_queue_family = 0;
+        uint32_t                 m_transfer_queue_family = 0;
+        bool                     m_memory_budget         = false;
+
+        std::filesystem::path m_pipeline_cache_path;
+        startup_times         m_startup_times;
 
         void _create_instance();
-        void _select_physical_device();
+        void _select_physical_device(const std::string &device_override);
+        void _create_device();
+        void _create_pipeline_cache(const std::filesystem::path &directory);
+        void _publish_memory_heaps() const;
+
+        // the queue family to draw with, or nothing if the device cannot draw (or present to the surface)
+        [[nodiscard]] std::optional<uint32_t> _find_queue_family(const vk::raii::PhysicalDevice &device) const;
+
+        // a family that can transfer but not draw or compute, or the graphics family if there is none
+        [[nodiscard]] uint32_t _find_transfer_queue_family() const;
     };
 
 } // namespace engine
@@ -0,0 +1,534 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "render_graph.hpp"
+
+#include "engine/profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace engine {
+
+    static constexpr uint32_t no_pass = UINT32_MAX;
+
+    static bool buffer_only(const resource_usage usage) {
+        return usage == resource_usage::vertex_buffer || usage == resource_usage::index_buffer ||
+               usage == resource_usage::indirect_buffer || usage == resource_usage::uniform_buffer;
+    }
+
+    static bool image_only(const resource_usage usage) {
+        return usage == resource_usage::sampled || usage == resource_usage::color_attachment ||
+               usage == resource_usage::depth_attachment || usage == resource_usage::depth_read ||
+               usage == resource_usage::present;
+    }
+
+    static uint64_t align_up(const uint64_t value, const uint64_t alignment) {
+        return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+    }
+
+    image_layout layout_of(const resource_usage usage) noexcept {
+        switch (usage) {
+            case resource_usage::sampled:
+                return image_layout::shader_read_only;
+            case resource_usage::storage_read:
+            case resource_usage::storage_write:
+                return image_layout::general;
+            case resource_usage::color_attachment:
+                return image_layout::color_attachment;
+            case resource_usage::depth_attachment:
+                return image_layout::depth_attachment;
+            case resource_usage::depth_read:
+                return image_layout::depth_read_only;
+            case resource_usage::transfer_src:
+                return image_layout::transfer_src;
+            case resource_usage::transfer_dst:
+                return image_layout::transfer_dst;
+            case resource_usage::present:
+                return image_layout::present;
+            default:
+                return image_layout::undefined;
+        }
+    }
+
+    render_graph::render_graph(settings settings) : m_settings(std::move(settings)) {}
+
+    resource_handle render_graph::create_image(std::string name, const image_desc &desc) {
+        return _add_resource(resource{.name = std::move(name), .image = true, .image_info = desc});
+    }
+
+    resource_handle render_graph::create_buffer(std::string name, const buffer_desc &desc) {
+        return _add_resource(resource{.name = std::move(name), .buffer_info = desc});
+    }
+
+    resource_handle render_graph::import_image(
+        std::string name, const image_desc &desc, const resource_usage initial, const resource_usage final
+    ) {
+        if (buffer_only(initial) || buffer_only(final)) {
+            throw std::invalid_argument("Image '" + name + "' cannot start or end in a buffer usage");
+        }
+        return _add_resource(resource{
+            .name          = std::move(name),
+            .image         = true,
+            .imported      = true,
+            .image_info    = desc,
+            .initial_usage = initial,
+            .final_usage   = final,
+        });
+    }
+
+    resource_handle render_graph::import_buffer(
+        std::string name, const buffer_desc &desc, const resource_usage initial, const resource_usage final
+    ) {
+        if (image_only(initial) || image_only(final)) {
+            throw std::invalid_argument("Buffer '" + name + "' cannot start or end in an image usage");
+        }
+        return _add_resource(resource{
+            .name          = std::move(name),
+            .imported      = true,
+            .buffer_info   = desc,
+            .initial_usage = initial,
+            .final_usage   = final,
+        });
+    }
+
+    void render_graph::add_pass(render_pass_desc desc) {
+        const auto check = [&](const resource_access &access, const bool write) {
+            if (access.resource.index >= m_resources.size()) {
+                throw std::invalid_argument("Pass '" + desc.name + "' uses an unknown resource");
+            }
+            const resource &r = m_resources[access.resource.index];
+            if (is_write(access.usage) != write) {
+                throw std::invalid_argument(
+                    "Pass '" + desc.name + "' lists a " + (write ? "read" : "write") + " of '" + r.name + "' as a " +
+                    (write ? "write" : "read")
+                );
+            }
+            if (access.discard && !write) {
+                throw std::invalid_argument("Pass '" + desc.name + "' discards '" + r.name + "' while reading it");
+            }
+            if (r.image ? buffer_only(access.usage) : image_only(access.usage)) {
+                throw std::invalid_argument("Pass '" + desc.name + "' uses '" + r.name + "' in a way it cannot be");
+            }
+        };
+        for (const resource_access &access : desc.reads) {
+            check(access, false);
+        }
+        for (const resource_access &access : desc.writes) {
+            check(access, true);
+        }
+
+        // an image is in one layout for the whole pass
+        std::vector<resource_access> accesses = desc.reads;
+        accesses.insert(accesses.end(), desc.writes.begin(), desc.writes.end());
+        for (size_t i = 0; i < accesses.size(); ++i) {
+            const resource_access &a = accesses[i];
+            for (size_t j = i + 1; j < accesses.size(); ++j) {
+                const resource_access &b = accesses[j];
+                if (a.resource == b.resource && m_resources[a.resource.index].image &&
+                    layout_of(a.usage) != layout_of(b.usage)) {
+                    throw std::invalid_argument(
+                        "Pass '" + desc.name + "' needs '" + m_resources[a.resource.index].name + "' in two layouts"
+                    );
+                }
+            }
+        }
+
+        m_passes.push_back(std::move(desc));
+    }
+
+    const render_graph::compiled_graph &render_graph::compile() {
+        _build_key();
+        if (!m_compiled_key.empty() && m_key == m_compiled_key) {
+            ++m_reuse_count;
+            return m_compiled;
+        }
+
+        ENGINE_PROFILE_ZONE("render_graph::compile");
+        m_compiled_key.clear();
+        m_compiled = {};
+
+        const std::vector<uint32_t> kept = _cull();
+
+        // merge each kept pass's accesses per resource, in pass order
+        std::vector<std::vector<access_event>> events(m_resources.size());
+        m_compiled.lifetimes.resize(m_resources.size());
+        for (uint32_t i = 0; i < kept.size(); ++i) {
+            const render_pass_desc &pass = m_passes[kept[i]];
+            m_compiled.passes.push_back(compiled_pass{kept[i], 0, 0});
+
+            const auto add = [&](const resource_access &access, const bool write) {
+                const uint32_t             r    = access.resource.index;
+                std::vector<access_event> &list = events[r];
+                if (list.empty() || list.back().pass != i) {
+                    list.push_back(access_event{
+                        .pass    = i,
+                        .layout  = m_resources[r].image ? layout_of(access.usage) : image_layout::undefined,
+                        .discard = true,
+                    });
+                }
+                access_event &event = list.back();
+                event.usages |= mask_of(access.usage);
+                event.write |= write;
+                event.discard &= write && access.discard;
+
+                lifetime &life = m_compiled.lifetimes[r];
+                life.first     = std::min(life.first, i);
+                life.last      = std::max(life.last, i);
+            };
+            for (const resource_access &access : pass.reads) {
+                add(access, false);
+            }
+            for (const resource_access &access : pass.writes) {
+                add(access, true);
+            }
+        }
+
+        const std::vector<usage_mask> alias_before = _place_memory(events);
+        _place_barriers(events, alias_before);
+
+        m_compiled_key = m_key;
+        ++m_compile_count;
+        return m_compiled;
+    }
+
+    void render_graph::execute(const barrier_function &record_barriers) {
+        const compiled_graph &compiled = compile();
+
+        ENGINE_PROFILE_ZONE("render_graph::execute");
+        for (const compiled_pass &pass : compiled.passes) {
+            if (pass.barrier_count > 0) {
+                record_barriers(compiled.barriers_before(pass));
+            }
+            if (const auto &callback = m_passes[pass.pass].callback) {
+                callback();
+            }
+        }
+        if (!compiled.final_barriers.empty()) {
+            record_barriers(compiled.final_barriers);
+        }
+    }
+
+    void render_graph::reset() {
+        m_resources.clear();
+        m_passes.clear();
+    }
+
+    const std::string &render_graph::resource_name(const resource_handle resource) const {
+        return m_resources.at(resource.index).name;
+    }
+
+    bool render_graph::is_image(const resource_handle resource) const {
+        return m_resources.at(resource.index).image;
+    }
+
+    const std::string &render_graph::pass_name(const uint32_t pass) const {
+        return m_passes.at(pass).name;
+    }
+
+    resource_handle render_graph::_add_resource(resource resource) {
+        m_resources.push_back(std::move(resource));
+        return resource_handle{static_cast<uint32_t>(m_resources.size() - 1)};
+    }
+
+    void render_graph::_build_key() {
+        m_key.clear();
+        m_key.push_back(m_resources.size());
+        for (const resource &r : m_resources) {
+            m_key.push_back(
+                uint64_t(r.image) | uint64_t(r.imported) << 1 | uint64_t(r.initial_usage) << 8 |
+                uint64_t(r.final_usage) << 16
+            );
+            if (r.image) {
+                const image_desc &d = r.image_info;
+                m_key.push_back(uint64_t(d.width) << 32 | d.height);
+                m_key.push_back(uint64_t(d.depth) << 32 | d.mip_levels);
+                m_key.push_back(uint64_t(d.layers) << 32 | d.samples);
+                m_key.push_back(uint64_t(d.format) << 32 | d.bytes_per_texel);
+            } else {
+                m_key.push_back(r.buffer_info.size);
+            }
+        }
+
+        m_key.push_back(m_passes.size());
+        for (const render_pass_desc &pass : m_passes) {
+            m_key.push_back(
+                uint64_t(pass.side_effects) | uint64_t(pass.reads.size()) << 1 | uint64_t(pass.writes.size()) << 32
+            );
+            for (const auto *list : {&pass.reads, &pass.writes}) {
+                for (const resource_access &access : *list) {
+                    m_key.push_back(
+                        uint64_t(access.resource.index) | uint64_t(access.usage) << 32 | uint64_t(access.discard) << 40
+                    );
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> render_graph::_cull() const {
+        // each pass depends on the last earlier writer of everything it reads, or writes without discarding
+        std::vector<std::vector<uint32_t>> dependencies(m_passes.size());
+        std::vector<uint32_t>              last_writer(m_resources.size(), no_pass);
+        std::vector<uint32_t>              work;
+        std::vector<uint8_t>               needed(m_passes.size(), 0);
+
+        for (uint32_t p = 0; p < m_passes.size(); ++p) {
+            const render_pass_desc &pass = m_passes[p];
+            for (const resource_access &access : pass.reads) {
+                if (last_writer[access.resource.index] != no_pass)
+                    dependencies[p].push_back(last_writer[access.resource.index]);
+            }
+            bool root = pass.side_effects;
+            for (const resource_access &access : pass.writes) {
+                if (!access.discard && last_writer[access.resource.index] != no_pass)
+                    dependencies[p].push_back(last_writer[access.resource.index]);
+                root |= m_resources[access.resource.index].imported;
+            }
+            for (const resource_access &access : pass.writes) {
+                last_writer[access.resource.index] = p;
+            }
+
+            if (root) {
+                needed[p] = 1;
+                work.push_back(p);
+            }
+        }
+
+        while (!work.empty()) {
+            const uint32_t p = work.back();
+            work.pop_back();
+            for (const uint32_t dependency : dependencies[p]) {
+                if (!needed[dependency]) {
+                    needed[dependency] = 1;
+                    work.push_back(dependency);
+                }
+            }
+        }
+
+        std::vector<uint32_t> kept;
+        for (uint32_t p = 0; p < m_passes.size(); ++p) {
+            if (needed[p])
+                kept.push_back(p);
+        }
+        return kept;
+    }
+
+    std::vector<usage_mask> render_graph::_place_memory(const std::vector<std::vector<access_event>> &events) {
+        const std::vector<lifetime> &lifetimes = m_compiled.lifetimes;
+
+        std::vector<memory_requirements> requirements(m_resources.size());
+        std::vector<uint32_t>            transients;
+        for (uint32_t r = 0; r < m_resources.size(); ++r) {
+            if (m_resources[r].imported || events[r].empty())
+                continue;
+            requirements[r] = _requirements(m_resources[r]);
+            m_compiled.requested_bytes += requirements[r].size;
+            transients.push_back(r);
+        }
+
+        // largest first, so the first resource in a block sets its size and later ones fit in around it
+        std::stable_sort(transients.begin(), transients.end(), [&](const uint32_t a, const uint32_t b) {
+            return requirements[a].size > requirements[b].size;
+        });
+
+        std::vector<placement>             &placements = m_compiled.placements;
+        std::vector<memory_block>          &blocks     = m_compiled.blocks;
+        std::vector<std::vector<uint32_t>>  residents;
+        std::vector<uint32_t>               in_the_way;
+        placements.assign(m_resources.size(), placement{});
+
+        const auto overlap_in_time = [&](const uint32_t a, const uint32_t b) {
+            return lifetimes[a].first <= lifetimes[b].last && lifetimes[b].first <= lifetimes[a].last;
+        };
+
+        for (const uint32_t r : transients) {
+            const memory_requirements &need  = requirements[r];
+            const bool                 image = m_resources[r].image;
+
+            for (uint32_t b = 0; b < blocks.size() && placements[r].block == placement::no_block; ++b) {
+                if (blocks[b].images != image || (blocks[b].type_bits & need.type_bits) == 0)
+                    continue;
+
+                in_the_way.clear();
+                for (const uint32_t other : residents[b]) {
+                    if (overlap_in_time(r, other))
+                        in_the_way.push_back(other);
+                }
+                std::sort(in_the_way.begin(), in_the_way.end(), [&](const uint32_t x, const uint32_t y) {
+                    return placements[x].offset < placements[y].offset;
+                });
+
+                // the lowest gap between resources alive at the same time that is large enough
+                uint64_t offset = 0;
+                bool     fits   = false;
+                for (const uint32_t other : in_the_way) {
+                    if (align_up(offset, need.alignment) + need.size <= placements[other].offset) {
+                        fits = true;
+                        break;
+                    }
+                    offset = std::max(offset, placements[other].offset + requirements[other].size);
+                }
+                offset = align_up(offset, need.alignment);
+                if (!fits && offset + need.size > blocks[b].size)
+                    continue;
+
+                placements[r] = placement{b, offset};
+                blocks[b].type_bits &= need.type_bits;
+                residents[b].push_back(r);
+            }
+
+            if (placements[r].block == placement::no_block) {
+                placements[r] = placement{static_cast<uint32_t>(blocks.size()), 0};
+                blocks.push_back(memory_block{need.size, need.type_bits, image});
+                residents.push_back({r});
+            }
+        }
+
+        for (const memory_block &block : blocks) {
+            m_compiled.allocated_bytes += block.size;
+        }
+
+        // what each resource did from its last write on, which whatever takes its memory next has to wait for
+        std::vector<usage_mask> last_use(m_resources.size(), 0);
+        for (const uint32_t r : transients) {
+            for (auto it = events[r].rbegin(); it != events[r].rend(); ++it) {
+                last_use[r] |= it->usages;
+                if (it->write)
+                    break;
+            }
+        }
+
+        std::vector<usage_mask> alias_before(m_resources.size(), 0);
+        for (const std::vector<uint32_t> &block : residents) {
+            for (const uint32_t r : block) {
+                const uint64_t begin = placements[r].offset;
+                const uint64_t end   = begin + requirements[r].size;
+                for (const uint32_t other : block) {
+                    const uint64_t other_begin = placements[other].offset;
+                    const uint64_t other_end   = other_begin + requirements[other].size;
+                    if (lifetimes[other].last < lifetimes[r].first && other_begin < end && begin < other_end)
+                        alias_before[r] |= last_use[other];
+                }
+            }
+        }
+        return alias_before;
+    }
+
+    void render_graph::_place_barriers(
+        const std::vector<std::vector<access_event>> &events, const std::vector<usage_mask> &alias_before
+    ) {
+        std::vector<std::vector<barrier>> per_pass(m_compiled.passes.size());
+
+        for (uint32_t r = 0; r < m_resources.size(); ++r) {
+            const resource                  &res  = m_resources[r];
+            const std::vector<access_event> &list = events[r];
+            const resource_handle            handle{r};
+
+            // the usages of the last write, the reads since, and the reads the barriers since already cover
+            usage_mask   last_write = 0;
+            usage_mask   readers    = 0;
+            usage_mask   covered    = 0;
+            image_layout layout     = image_layout::undefined;
+            bool         written    = false;
+            if (res.imported) {
+                // whatever left the resource in its initial usage also made it ready for that usage
+                if (is_write(res.initial_usage)) {
+                    last_write = mask_of(res.initial_usage);
+                } else {
+                    readers = covered = mask_of(res.initial_usage);
+                }
+                layout = res.image ? layout_of(res.initial_usage) : image_layout::undefined;
+            }
+
+            for (size_t i = 0; i < list.size(); ++i) {
+                const access_event &event = list[i];
+
+                if (!res.imported && i == 0) {
+                    if (!event.write) {
+                        throw std::logic_error(
+                            "Pass '" + m_passes[m_compiled.passes[event.pass].pass].name + "' reads '" + res.name +
+                            "' before any pass writes it"
+                        );
+                    }
+                    // images still need moving out of the undefined layout; buffers only wait for what used their
+                    // memory before
+                    const barrier first{handle, alias_before[r], event.usages, image_layout::undefined, event.layout,
+                                        alias_before[r] != 0};
+                    if (res.image || first.aliasing)
+                        per_pass[event.pass].push_back(first);
+                } else if (event.write) {
+                    // waiting for the reads since the last write also waits for that write
+                    per_pass[event.pass].push_back(barrier{
+                        handle, readers ? readers : last_write, event.usages,
+                        event.discard ? image_layout::undefined : layout, event.layout
+                    });
+                } else if (readers != 0 && event.layout == layout && (event.usages & ~covered) == 0) {
+                    readers |= event.usages;
+                    continue;
+                } else {
+                    // one barrier for this read and the reads in the same layout after it, up to the next write
+                    usage_mask after = event.usages;
+                    for (size_t j = i + 1; j < list.size() && !list[j].write && list[j].layout == event.layout; ++j) {
+                        after |= list[j].usages;
+                    }
+                    per_pass[event.pass].push_back(
+                        barrier{handle, readers ? readers : last_write, after, layout, event.layout}
+                    );
+                    readers |= event.usages;
+                    covered |= after;
+                    layout  = event.layout;
+                    continue;
+                }
+
+                last_write = event.usages;
+                readers    = 0;
+                covered    = 0;
+                layout     = event.layout;
+                written    = true;
+            }
+
+            if (res.imported) {
+                // a final read that a barrier since the last write already let go needs nothing more
+                const image_layout final_layout = res.image ? layout_of(res.final_usage) : image_layout::undefined;
+                const bool         used         = written || readers != 0;
+                const bool         covers_final = (mask_of(res.final_usage) & ~covered) == 0;
+                if ((used && (is_write(res.final_usage) || !covers_final)) || layout != final_layout) {
+                    m_compiled.final_barriers.push_back(barrier{
+                        handle, readers ? readers : last_write, mask_of(res.final_usage), layout, final_layout
+                    });
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < per_pass.size(); ++i) {
+            m_compiled.passes[i].first_barrier = static_cast<uint32_t>(m_compiled.barriers.size());
+            m_compiled.passes[i].barrier_count = static_cast<uint32_t>(per_pass[i].size());
+            m_compiled.barriers.insert(m_compiled.barriers.end(), per_pass[i].begin(), per_pass[i].end());
+        }
+    }
+
+    memory_requirements render_graph::_requirements(const resource &resource) const {
+        if (resource.image) {
+            if (m_settings.image_requirements)
+                return m_settings.image_requirements(resource.image_info);
+
+            const image_desc &desc   = resource.image_info;
+            uint64_t          texels = 0;
+            for (uint32_t mip = 0; mip < std::max(desc.mip_levels, 1u); ++mip) {
+                texels += uint64_t(std::max(desc.width >> mip, 1u)) * std::max(desc.height >> mip, 1u) *
+                          std::max(desc.depth >> mip, 1u);
+            }
+            return memory_requirements{
+                .size      = align_up(texels * desc.layers * desc.samples * desc.bytes_per_texel, 65536),
+                .alignment = 65536,
+            };
+        }
+
+        if (m_settings.buffer_requirements)
+            return m_settings.buffer_requirements(resource.buffer_info);
+        return memory_requirements{.size = align_up(resource.buffer_info.size, 256), .alignment = 256};
+    }
+
+} // namespace engine
@@ -0,0 +1,304 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * How a pass uses a resource. Each maps to the pipeline stages, memory accesses and (for images) layout a barrier
+     * has to wait for or prepare.
+     */
+    enum class resource_usage : uint8_t {
+        vertex_buffer,
+        index_buffer,
+        indirect_buffer,
+        uniform_buffer,
+        sampled,
+        storage_read,
+        storage_write,
+        color_attachment,
+        depth_attachment,
+        depth_read,
+        transfer_src,
+        transfer_dst,
+        present,
+    };
+
+    // a set of resource_usage values, one bit each
+    using usage_mask = uint32_t;
+
+    [[nodiscard]] constexpr usage_mask mask_of(const resource_usage usage) noexcept {
+        return usage_mask(1) << static_cast<uint32_t>(usage);
+    }
+
+    [[nodiscard]] constexpr bool is_write(const resource_usage usage) noexcept {
+        return usage == resource_usage::storage_write || usage == resource_usage::color_attachment ||
+               usage == resource_usage::depth_attachment || usage == resource_usage::transfer_dst;
+    }
+
+    enum class image_layout : uint8_t {
+        undefined, // contents are discarded; also the layout of every buffer
+        general,
+        color_attachment,
+        depth_attachment,
+        depth_read_only,
+        shader_read_only,
+        transfer_src,
+        transfer_dst,
+        present,
+    };
+
+    [[nodiscard]] image_layout layout_of(resource_usage usage) noexcept;
+
+    struct image_desc {
+        uint32_t width      = 1;
+        uint32_t height     = 1;
+        uint32_t depth      = 1;
+        uint32_t mip_levels = 1;
+        uint32_t layers     = 1;
+        uint32_t samples    = 1;
+        uint32_t format     = 0; // a VkFormat
+
+        // only used to estimate memory when the graph has no image_requirements function
+        uint32_t bytes_per_texel = 4;
+    };
+
+    struct buffer_desc {
+        uint64_t size = 0;
+    };
+
+    struct memory_requirements {
+        uint64_t size      = 0;
+        uint64_t alignment = 1;
+        uint32_t type_bits = ~0u; // memory types the resource can live in, as in VkMemoryRequirements
+    };
+
+    /**
+     * Names a resource of a render graph. Handles are only meaningful for the graph that made them, until its reset().
+     */
+    struct resource_handle {
+        static constexpr uint32_t invalid = UINT32_MAX;
+
+        uint32_t index = invalid;
+
+        [[nodiscard]] inline bool valid() const noexcept { return index != invalid; }
+
+        bool operator==(const resource_handle &other) const = default;
+    };
+
+    struct resource_access {
+        resource_handle resource;
+        resource_usage  usage;
+        // the pass overwrites the whole resource without reading it, so whatever was there before is not needed
+        bool discard = false;
+    };
+
+    /**
+     * Describes a pass of the frame. The pass waits for the last pass before it that wrote anything it reads, or that
+     * wrote anything it writes without discarding.
+     */
+    struct render_pass_desc {
+        std::string                  name;
+        std::vector<resource_access> reads;
+        std::vector<resource_access> writes;
+
+        // kept even if nothing uses what it writes, e.g. a readback or a capture
+        bool side_effects = false;
+
+        std::function<void()> callback;
+    };
+
+    /**
+     * A frame described as passes that read and write virtual images and buffers, compiled into the work to run:
+     *
+     * - Passes whose results nothing needs are culled. A pass is needed if it has side effects, writes an imported
+     *   resource, or writes something a needed pass depends on.
+     * - Barriers are placed before the passes that need them, as few as the accesses allow: reads in a row with the
+     *   same layout share the barrier before the first, reads need nothing after one another, and a write only waits
+     *   for the reads since the last write rather than for that write as well.
+     * - Transient (non-imported) resources whose lifetimes do not overlap share memory. Memory is split into blocks of
+     *   images and blocks of buffers; each resource, largest first, goes at the lowest offset of the first block where
+     *   nothing alive at the same time is in the way, and a new block is only made when none has room.
+     *
+     * A graph is declared again every frame after reset(). Compiling compares the declaration with the one compiled
+     * last, and when only the callbacks changed keeps the previous result. Compiling touches no GPU: the barriers and
+     * memory plan it produces are plain data, and recording them is left to the executor.
+     */
+    class render_graph {
+      public:
+        struct settings {
+            // the memory an image or buffer needs, e.g. from vkGetDeviceImageMemoryRequirements; when empty, estimated
+            // from the description with 64 KiB alignment for images and 256 bytes for buffers
+            std::function<memory_requirements(const image_desc &desc)>  image_requirements;
+            std::function<memory_requirements(const buffer_desc &desc)> buffer_requirements;
+        };
+
+        struct barrier {
+            resource_handle resource;
+            usage_mask      before     = 0; // what has to finish first; 0 if nothing does
+            usage_mask      after      = 0; // what waits
+            image_layout    old_layout = image_layout::undefined;
+            image_layout    new_layout = image_layout::undefined;
+            // the resource takes over memory last used by others, whose final usages are in before
+            bool aliasing = false;
+        };
+
+        struct compiled_pass {
+            uint32_t pass; // index in declaration order
+            uint32_t first_barrier;
+            uint32_t barrier_count;
+        };
+
+        struct lifetime {
+            uint32_t first = UINT32_MAX; // compiled pass indices, inclusive; first > last if the resource is unused
+            uint32_t last  = 0;
+        };
+
+        struct memory_block {
+            uint64_t size      = 0;
+            uint32_t type_bits = ~0u;
+            bool     images    = false;
+        };
+
+        struct placement {
+            static constexpr uint32_t no_block = UINT32_MAX;
+
+            uint32_t block  = no_block; // imported and unused resources have no memory of their own
+            uint64_t offset = 0;
+        };
+
+        struct compiled_graph {
+            std::vector<compiled_pass> passes; // the passes kept, in declaration order
+            std::vector<barrier>       barriers;
+            std::vector<barrier>       final_barriers; // move imported resources to their final usage
+            std::vector<lifetime>      lifetimes;      // by resource
+            std::vector<placement>     placements;     // by resource
+            std::vector<memory_block>  blocks;
+
+            uint64_t requested_bytes = 0; // what the transient resources would take without aliasing
+            uint64_t allocated_bytes = 0; // the sum of the blocks
+
+            [[nodiscard]] inline std::span<const barrier> barriers_before(const compiled_pass &pass) const noexcept {
+                return std::span(barriers).subspan(pass.first_barrier, pass.barrier_count);
+            }
+        };
+
+        /**
+         * Records a batch of barriers; called before each pass that needs any, and once at the end for final_barriers.
+         */
+        using barrier_function = std::function<void(std::span<const barrier> barriers)>;
+
+        explicit render_graph(settings settings);
+
+        render_graph(const render_graph &other)                = delete;
+        render_graph(render_graph &&other) noexcept            = delete;
+        render_graph &operator=(const render_graph &other)     = delete;
+        render_graph &operator=(render_graph &&other) noexcept = delete;
+
+        resource_handle create_image(std::string name, const image_desc &desc);
+        resource_handle create_buffer(std::string name, const buffer_desc &desc);
+
+        /**
+         * Adds a resource that lives outside the graph, such as a swapchain image or a persistent buffer. It is in the
+         * initial usage when the frame starts and is left in the final one, and passes that write it are never culled.
+         */
+        resource_handle
+        import_image(std::string name, const image_desc &desc, resource_usage initial, resource_usage final);
+        resource_handle
+        import_buffer(std::string name, const buffer_desc &desc, resource_usage initial, resource_usage final);
+
+        /**
+         * @throws std::invalid_argument if an access names an unknown resource, lists a write usage as a read or the
+         * other way round, or gives an image two layouts in the one pass
+         */
+        void add_pass(render_pass_desc desc);
+
+        /**
+         * Compiles the graph as declared, or keeps the last result if the declaration has not changed since.
+         *
+         * @throws std::logic_error if a pass reads a transient resource no earlier pass writes
+         */
+        const compiled_graph &compile();
+
+        /**
+         * Compiles if needed and runs the kept passes in order, recording barriers before each.
+         */
+        void execute(const barrier_function &record_barriers);
+
+        /**
+         * Forgets the declared passes and resources so the next frame can be declared. The compiled result is kept to
+         * be reused.
+         */
+        void reset();
+
+        [[nodiscard]] inline const compiled_graph &compiled() const noexcept { return m_compiled; }
+
+        [[nodiscard]] inline size_t resource_count() const noexcept { return m_resources.size(); }
+        [[nodiscard]] inline size_t pass_count() const noexcept { return m_passes.size(); }
+
+        [[nodiscard]] const std::string &resource_name(resource_handle resource) const;
+        [[nodiscard]] bool               is_image(resource_handle resource) const;
+        [[nodiscard]] const std::string &pass_name(uint32_t pass) const;
+
+        /**
+         * @return How many times the graph was actually compiled, and how many compiles reused the last result
+         */
+        [[nodiscard]] inline uint64_t compile_count() const noexcept { return m_compile_count; }
+        [[nodiscard]] inline uint64_t reuse_count() const noexcept { return m_reuse_count; }
+
+      private:
+        struct resource {
+            std::string    name;
+            bool           image    = false;
+            bool           imported = false;
+            image_desc     image_info;
+            buffer_desc    buffer_info;
+            resource_usage initial_usage = resource_usage::sampled;
+            resource_usage final_usage   = resource_usage::sampled;
+        };
+
+        // a resource's accesses in one kept pass, merged
+        struct access_event {
+            uint32_t     pass; // compiled pass index
+            usage_mask   usages  = 0;
+            image_layout layout  = image_layout::undefined;
+            bool         write   = false;
+            bool         discard = false; // every write in the pass discards, and nothing in it reads
+        };
+
+        settings                      m_settings;
+        std::vector<resource>         m_resources;
+        std::vector<render_pass_desc> m_passes;
+
+        compiled_graph        m_compiled;
+        std::vector<uint64_t> m_compiled_key; // the declaration m_compiled was made from
+        std::vector<uint64_t> m_key;
+        uint64_t              m_compile_count = 0;
+        uint64_t              m_reuse_count   = 0;
+
+        resource_handle _add_resource(resource resource);
+
+        // encodes everything about the declaration that compiling looks at, so it can be compared with the last one
+        void _build_key();
+
+        [[nodiscard]] std::vector<uint32_t> _cull() const;
+
+        // fills placements and blocks, and returns for each resource the usages of whatever used its memory before it
+        [[nodiscard]] std::vector<usage_mask> _place_memory(const std::vector<std::vector<access_event>> &events);
+
+        void _place_barriers(
+            const std::vector<std::vector<access_event>> &events, const std::vector<usage_mask> &alias_before
+        );
+
+        [[nodiscard]] memory_requirements _requirements(const resource &resource) const;
+    };
+
+} // namespace engine
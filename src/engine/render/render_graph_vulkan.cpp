@@ -0,0 +1,157 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "render_graph_vulkan.hpp"
+
+#include <vector>
+
+namespace engine {
+
+    using stage  = vk::PipelineStageFlagBits2;
+    using access = vk::AccessFlagBits2;
+
+    static constexpr vk::PipelineStageFlags2 shader_stages =
+        stage::eVertexShader | stage::eFragmentShader | stage::eComputeShader;
+
+    static constexpr vk::AccessFlags2 write_access = access::eShaderStorageWrite | access::eColorAttachmentWrite |
+                                                     access::eDepthStencilAttachmentWrite | access::eTransferWrite;
+
+    static vulkan_scope scope_of(const resource_usage usage) noexcept {
+        switch (usage) {
+            case resource_usage::vertex_buffer:
+                return {stage::eVertexAttributeInput, access::eVertexAttributeRead};
+            case resource_usage::index_buffer:
+                return {stage::eIndexInput, access::eIndexRead};
+            case resource_usage::indirect_buffer:
+                return {stage::eDrawIndirect, access::eIndirectCommandRead};
+            case resource_usage::uniform_buffer:
+                return {shader_stages, access::eUniformRead};
+            case resource_usage::sampled:
+                return {shader_stages, access::eShaderSampledRead};
+            case resource_usage::storage_read:
+                return {shader_stages, access::eShaderStorageRead};
+            case resource_usage::storage_write:
+                return {shader_stages, access::eShaderStorageRead | access::eShaderStorageWrite};
+            case resource_usage::color_attachment:
+                return {stage::eColorAttachmentOutput, access::eColorAttachmentRead | access::eColorAttachmentWrite};
+            case resource_usage::depth_attachment:
+                return {
+                    stage::eEarlyFragmentTests | stage::eLateFragmentTests,
+                    access::eDepthStencilAttachmentRead | access::eDepthStencilAttachmentWrite
+                };
+            case resource_usage::depth_read:
+                return {
+                    stage::eEarlyFragmentTests | stage::eLateFragmentTests | shader_stages,
+                    access::eDepthStencilAttachmentRead | access::eShaderSampledRead
+                };
+            case resource_usage::transfer_src:
+                return {stage::eAllTransfer, access::eTransferRead};
+            case resource_usage::transfer_dst:
+                return {stage::eAllTransfer, access::eTransferWrite};
+            case resource_usage::present:
+                // presentation is ordered by semaphores, not barriers
+                return {stage::eNone, access::eNone};
+        }
+        return {stage::eNone, access::eNone};
+    }
+
+    vulkan_scope to_vulkan_scope(const usage_mask usages) noexcept {
+        vulkan_scope scope{stage::eNone, access::eNone};
+        for (uint32_t usage = 0; usage <= static_cast<uint32_t>(resource_usage::present); ++usage) {
+            if (usages & mask_of(static_cast<resource_usage>(usage))) {
+                const vulkan_scope s = scope_of(static_cast<resource_usage>(usage));
+                scope.stages |= s.stages;
+                scope.access |= s.access;
+            }
+        }
+        return scope;
+    }
+
+    vk::ImageLayout to_vulkan_layout(const image_layout layout) noexcept {
+        switch (layout) {
+            case image_layout::undefined:
+                return vk::ImageLayout::eUndefined;
+            case image_layout::general:
+                return vk::ImageLayout::eGeneral;
+            case image_layout::color_attachment:
+                return vk::ImageLayout::eColorAttachmentOptimal;
+            case image_layout::depth_attachment:
+                return vk::ImageLayout::eDepthAttachmentOptimal;
+            case image_layout::depth_read_only:
+                return vk::ImageLayout::eDepthReadOnlyOptimal;
+            case image_layout::shader_read_only:
+                return vk::ImageLayout::eShaderReadOnlyOptimal;
+            case image_layout::transfer_src:
+                return vk::ImageLayout::eTransferSrcOptimal;
+            case image_layout::transfer_dst:
+                return vk::ImageLayout::eTransferDstOptimal;
+            case image_layout::present:
+                return vk::ImageLayout::ePresentSrcKHR;
+        }
+        return vk::ImageLayout::eUndefined;
+    }
+
+    void record_barriers(
+        const vk::raii::CommandBuffer &commands, const render_graph &graph,
+        const std::span<const render_graph::barrier> barriers, const std::span<const vk::Image> images,
+        const std::span<const vk::Buffer> buffers
+    ) {
+        std::vector<vk::MemoryBarrier2>       memory_barriers;
+        std::vector<vk::BufferMemoryBarrier2> buffer_barriers;
+        std::vector<vk::ImageMemoryBarrier2>  image_barriers;
+
+        for (const render_graph::barrier &barrier : barriers) {
+            const vulkan_scope before = to_vulkan_scope(barrier.before);
+            const vulkan_scope after  = to_vulkan_scope(barrier.after);
+            // only writes need making available; waiting on reads is an execution dependency alone
+            const vk::AccessFlags2 src_access = before.access & write_access;
+
+            if (barrier.aliasing) {
+                memory_barriers.push_back(
+                    vk::MemoryBarrier2(before.stages, src_access, after.stages, after.access)
+                );
+            }
+
+            if (graph.is_image(barrier.resource)) {
+                const bool depth = barrier.new_layout == image_layout::depth_attachment ||
+                                   barrier.new_layout == image_layout::depth_read_only;
+
+                vk::ImageMemoryBarrier2 image_barrier{};
+                image_barrier.setSrcStageMask(before.stages);
+                image_barrier.setSrcAccessMask(src_access);
+                image_barrier.setDstStageMask(after.stages);
+                image_barrier.setDstAccessMask(after.access);
+                image_barrier.setOldLayout(to_vulkan_layout(barrier.old_layout));
+                image_barrier.setNewLayout(to_vulkan_layout(barrier.new_layout));
+                image_barrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+                image_barrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+                image_barrier.setImage(images[barrier.resource.index]);
+                image_barrier.setSubresourceRange(vk::ImageSubresourceRange(
+                    depth ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor, 0,
+                    VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS
+                ));
+                image_barriers.push_back(image_barrier);
+            } else if (!barrier.aliasing) {
+                vk::BufferMemoryBarrier2 buffer_barrier{};
+                buffer_barrier.setSrcStageMask(before.stages);
+                buffer_barrier.setSrcAccessMask(src_access);
+                buffer_barrier.setDstStageMask(after.stages);
+                buffer_barrier.setDstAccessMask(after.access);
+                buffer_barrier.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+                buffer_barrier.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+                buffer_barrier.setBuffer(buffers[barrier.resource.index]);
+                buffer_barrier.setOffset(0);
+                buffer_barrier.setSize(VK_WHOLE_SIZE);
+                buffer_barriers.push_back(buffer_barrier);
+            }
+        }
+
+        vk::DependencyInfo dependency_info{};
+        dependency_info.setMemoryBarriers(memory_barriers);
+        dependency_info.setBufferMemoryBarriers(buffer_barriers);
+        dependency_info.setImageMemoryBarriers(image_barriers);
+        commands.pipelineBarrier2(dependency_info);
+    }
+
+} // namespace engine
@@ -0,0 +1,40 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/render/render_graph.hpp"
+
+#include <span>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace engine {
+
+    struct vulkan_scope {
+        vk::PipelineStageFlags2 stages;
+        vk::AccessFlags2        access;
+    };
+
+    /**
+     * @return The stages and accesses of every usage in the mask
+     */
+    [[nodiscard]] vulkan_scope to_vulkan_scope(usage_mask usages) noexcept;
+
+    [[nodiscard]] vk::ImageLayout to_vulkan_layout(image_layout layout) noexcept;
+
+    /**
+     * Records a batch of render graph barriers as a single vkCmdPipelineBarrier2, so it can be passed to
+     * render_graph::execute. images and buffers hold the resource behind each handle, by index; only the kind of the
+     * resource is read. Barriers for resources taking over aliased memory also get a global memory barrier, since what
+     * they wait for happened to other resources.
+     *
+     * The device needs the synchronization2 feature, which render_device enables.
+     */
+    void record_barriers(
+        const vk::raii::CommandBuffer &commands, const render_graph &graph,
+        std::span<const render_graph::barrier> barriers, std::span<const vk::Image> images,
+        std::span<const vk::Buffer> buffers
+    );
+
+} // namespace engine
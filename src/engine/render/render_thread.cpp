@@ -0,0 +1,143 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "render_thread.hpp"
+
+#include "engine/profiler.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace engine {
+
+    static uint64_t to_microseconds(const frame_packet::clock::duration duration) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+
+    void frame_packet::assign(const draw_list &list) {
+        draws.assign(list.draws.begin(), list.draws.end());
+        candidates = list.candidates;
+    }
+
+    null_render_backend::null_render_backend(const settings &settings) : m_settings(settings) {}
+
+    void null_render_backend::render(const frame_packet &packet) {
+        ENGINE_PROFILE_ZONE("null_render_backend::render");
+
+        // touches every draw the way recording commands would, so the cost of reading the packet is measured too
+        uint64_t hash = m_checksum.load(std::memory_order_relaxed);
+        for (const draw_item &draw : packet.draws) {
+            hash = (hash ^ draw.sort_key) * 0x100000001b3ull;
+            hash = (hash ^ (static_cast<uint64_t>(draw.mesh) << 32 | draw.material)) * 0x100000001b3ull;
+            hash = (hash ^ draw.object) * 0x100000001b3ull;
+        }
+        m_checksum.store(hash, std::memory_order_relaxed);
+        m_draws.fetch_add(packet.draws.size(), std::memory_order_relaxed);
+        m_frames.fetch_add(1, std::memory_order_relaxed);
+
+        if (m_settings.frame_time > 0.0) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(m_settings.frame_time));
+        }
+    }
+
+    render_thread::render_thread(std::unique_ptr<render_backend> backend, const settings &settings)
+        : m_settings(settings), m_backend(std::move(backend)), m_free(0) {
+        if (settings.frames_in_flight == 0 || settings.frames_in_flight > max_frames_in_flight) {
+            throw std::invalid_argument(
+                "frames_in_flight must be between 1 and " + std::to_string(max_frames_in_flight)
+            );
+        }
+        if (!m_backend) {
+            throw std::invalid_argument("render_thread needs a backend");
+        }
+
+        m_packets.resize(settings.frames_in_flight);
+        m_free.release(settings.frames_in_flight);
+        m_thread = std::thread([this] { _run(); });
+    }
+
+    render_thread::~render_thread() {
+        m_stopping.store(true, std::memory_order_relaxed);
+        m_ready.release();
+        m_thread.join();
+    }
+
+    frame_packet &render_thread::begin_frame() {
+        if (m_in_frame) {
+            throw std::logic_error("begin_frame called twice without end_frame");
+        }
+        if (m_failed.load(std::memory_order_acquire)) {
+            std::rethrow_exception(m_error);
+        }
+
+        const auto start = frame_packet::clock::now();
+        if (!m_free.try_acquire()) {
+            ENGINE_PROFILE_ZONE("render_thread wait");
+            m_free.acquire();
+        }
+        const auto now = frame_packet::clock::now();
+        m_wait.record(to_microseconds(now - start));
+
+        const uint64_t index  = m_submitted.load(std::memory_order_relaxed);
+        frame_packet  &packet = m_packets[index % m_packets.size()];
+        packet.index          = index;
+        packet.begun          = now;
+        m_in_frame            = true;
+        return packet;
+    }
+
+    void render_thread::end_frame() {
+        if (!m_in_frame) {
+            throw std::logic_error("end_frame called without begin_frame");
+        }
+        m_in_frame = false;
+
+        m_submitted.fetch_add(1, std::memory_order_relaxed);
+        m_ready.release();
+    }
+
+    void render_thread::wait_idle() {
+        const uint64_t submitted = m_submitted.load(std::memory_order_relaxed);
+        uint64_t       rendered  = m_rendered.load(std::memory_order_acquire);
+        while (rendered < submitted) {
+            m_rendered.wait(rendered, std::memory_order_acquire);
+            rendered = m_rendered.load(std::memory_order_acquire);
+        }
+    }
+
+    void render_thread::_run() {
+        ENGINE_PROFILE_THREAD("render");
+
+        for (uint64_t index = 0;; ++index) {
+            m_ready.acquire();
+            // the stop signal is released after every packet handed over before it, so those are drawn first
+            if (index == m_submitted.load(std::memory_order_relaxed) && m_stopping.load(std::memory_order_relaxed)) {
+                break;
+            }
+
+            const frame_packet &packet = m_packets[index % m_packets.size()];
+            if (!m_failed.load(std::memory_order_relaxed)) {
+                const auto start = frame_packet::clock::now();
+                try {
+                    m_backend->render(packet);
+                } catch (...) {
+                    // later packets are still taken and given back, so the main thread never waits on a slot forever
+                    m_error = std::current_exception();
+                    m_failed.store(true, std::memory_order_release);
+                }
+
+                const auto end     = frame_packet::clock::now();
+                const auto latency = end - packet.begun;
+                m_frame_time.record(to_microseconds(end - start));
+                m_latency.record(to_microseconds(latency));
+                m_last_latency.store(std::chrono::duration<double>(latency).count(), std::memory_order_relaxed);
+            }
+
+            m_rendered.store(index + 1, std::memory_order_release);
+            m_rendered.notify_all();
+            m_free.release();
+        }
+    }
+
+} // namespace engine
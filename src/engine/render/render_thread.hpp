@@ -0,0 +1,184 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/metrics.hpp"
+#include "engine/render/draw_list.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Everything the render thread needs to draw one frame, copied out of the scene so the simulation can move on to
+     * the next frame while this one is drawn. Packets are reused round-robin, so their vectors stop allocating once
+     * they have grown to the largest frame seen.
+     */
+    struct frame_packet {
+        using clock = std::chrono::steady_clock;
+
+        uint64_t               index           = 0;
+        double                 simulation_time = 0.0;
+        double                 alpha           = 0.0; // interpolation between the last two simulation steps
+        camera_view            camera;
+        std::vector<draw_item> draws; // sorted by key, as extracted
+        size_t                 candidates = 0;
+        clock::time_point      begun; // when the simulation side started filling the packet, for latency
+
+        /**
+         * Replaces the draws with a copy of the list, which only lives until the scene's next update.
+         */
+        void assign(const draw_list &list);
+    };
+
+    /**
+     * Draws frame packets. Called only from the render thread, one packet at a time and in order.
+     */
+    class render_backend {
+      public:
+        render_backend()          = default;
+        virtual ~render_backend() = default;
+
+        render_backend(const render_backend &other)                = delete;
+        render_backend(render_backend &&other) noexcept            = delete;
+        render_backend &operator=(const render_backend &other)     = delete;
+        render_backend &operator=(render_backend &&other) noexcept = delete;
+
+        virtual void render(const frame_packet &packet) = 0;
+    };
+
+    /**
+     * A backend that draws nothing, for running without a GPU. It walks every draw as command recording would, and can
+     * block for a fixed time per frame in place of waiting on the GPU, so pipelining, latency and throughput can be
+     * measured headless.
+     */
+    class null_render_backend final : public render_backend {
+      public:
+        struct settings {
+            // how long each frame waits after walking its draws, standing in for GPU work; 0 returns at once
+            double frame_time = 0.0;
+        };
+
+        explicit null_render_backend(const settings &settings);
+
+        void render(const frame_packet &packet) override;
+
+        [[nodiscard]] inline uint64_t frames() const noexcept { return m_frames.load(std::memory_order_relaxed); }
+        [[nodiscard]] inline uint64_t draws() const noexcept { return m_draws.load(std::memory_order_relaxed); }
+
+        /**
+         * @return A hash of every draw walked so far, in order, so a test can tell that what was drawn matches what was
+         * extracted
+         */
+        [[nodiscard]] inline uint64_t checksum() const noexcept { return m_checksum.load(std::memory_order_relaxed); }
+
+      private:
+        settings              m_settings;
+        std::atomic<uint64_t> m_frames   = 0;
+        std::atomic<uint64_t> m_draws    = 0;
+        std::atomic<uint64_t> m_checksum = 0;
+    };
+
+    /**
+     * Runs a render backend on a thread of its own, one frame behind the simulation: while the main thread updates the
+     * scene for frame N, the render thread draws the packet of frame N - 1.
+     *
+     * Packets go round a ring of frames_in_flight slots. The main thread claims a free slot with begin_frame(), fills
+     * it and hands it over with end_frame(); the render thread draws it and gives the slot back. Handoff is a pair of
+     * semaphores, so neither side takes a lock, and the main thread only blocks when it is frames_in_flight - 1 frames
+     * ahead. Two slots give double buffering, three let the simulation absorb a slow frame on the render side.
+     */
+    class render_thread {
+      public:
+        static constexpr uint32_t max_frames_in_flight = 8;
+
+        struct settings {
+            uint32_t frames_in_flight = 2;
+        };
+
+        /**
+         * @throws std::invalid_argument if frames_in_flight is outside [1, max_frames_in_flight]
+         */
+        render_thread(std::unique_ptr<render_backend> backend, const settings &settings);
+
+        /**
+         * Draws every packet already handed over, then stops the thread.
+         */
+        ~render_thread();
+
+        render_thread(const render_thread &other)                = delete;
+        render_thread(render_thread &&other) noexcept            = delete;
+        render_thread &operator=(const render_thread &other)     = delete;
+        render_thread &operator=(render_thread &&other) noexcept = delete;
+
+        /**
+         * Claims the next packet to fill, blocking while every slot is in flight. The packet holds whatever frame last
+         * used the slot. Main thread only, and not again before end_frame().
+         *
+         * @throws The exception the backend threw, if it failed on an earlier frame
+         */
+        [[nodiscard]] frame_packet &begin_frame();
+
+        /**
+         * Hands the packet claimed by begin_frame() to the render thread.
+         */
+        void end_frame();
+
+        /**
+         * Blocks until every packet handed over has been drawn.
+         */
+        void wait_idle();
+
+        [[nodiscard]] inline uint32_t frames_in_flight() const noexcept { return m_settings.frames_in_flight; }
+        [[nodiscard]] inline uint64_t frames_submitted() const noexcept {
+            return m_submitted.load(std::memory_order_relaxed);
+        }
+        [[nodiscard]] inline uint64_t frames_rendered() const noexcept {
+            return m_rendered.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return The time from begin_frame() to the backend finishing the last drawn frame, in seconds
+         */
+        [[nodiscard]] inline double last_latency() const noexcept {
+            return m_last_latency.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] inline render_backend &backend() const noexcept { return *m_backend; }
+
+      private:
+        settings                        m_settings;
+        std::unique_ptr<render_backend> m_backend;
+        std::vector<frame_packet>       m_packets;
+
+        std::counting_semaphore<max_frames_in_flight>     m_free;
+        std::counting_semaphore<max_frames_in_flight + 1> m_ready{0}; // one more for the stop signal
+
+        alignas(64) std::atomic<uint64_t> m_submitted = 0;
+        alignas(64) std::atomic<uint64_t> m_rendered  = 0;
+
+        std::atomic<double> m_last_latency = 0.0;
+        std::atomic<bool>   m_stopping     = false;
+        std::atomic<bool>   m_failed       = false;
+        std::exception_ptr  m_error; // set by the render thread before m_failed
+        bool                m_in_frame = false;
+
+        metrics::histogram m_latency    = metrics::registry::get().get_histogram("render_latency_microseconds");
+        metrics::histogram m_wait       = metrics::registry::get().get_histogram("render_wait_microseconds");
+        metrics::histogram m_frame_time = metrics::registry::get().get_histogram("render_frame_time_microseconds");
+
+        std::thread m_thread;
+
+        void _run();
+    };
+
+} // namespace engine
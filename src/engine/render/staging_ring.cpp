@@ -0,0 +1,214 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "staging_ring.hpp"
+
+#include "engine/profiler.hpp"
+#include "engine/render/gpu_memory_vulkan.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace engine {
+
+    static const staging_ring::settings &validated(const staging_ring::settings &settings) {
+        if (settings.size == 0)
+            throw std::invalid_argument("staging_ring size must not be 0");
+        if (settings.batches_in_flight == 0)
+            throw std::invalid_argument("staging_ring batches_in_flight must be at least 1");
+        return settings;
+    }
+
+    static vk::BufferCreateInfo ring_buffer_info(const uint64_t size) {
+        vk::BufferCreateInfo buffer_info{};
+        buffer_info.setSize(size);
+        buffer_info.setUsage(vk::BufferUsageFlagBits::eTransferSrc);
+        buffer_info.setSharingMode(vk::SharingMode::eExclusive);
+        return buffer_info;
+    }
+
+    /**
+     * Sorts copies by destination, keeping the order they were queued in for each, and calls record(destination,
+     * regions) once per destination.
+     */
+    template <typename Copy, typename Region, typename Record>
+    static void record_grouped(std::vector<Copy> &copies, std::vector<Region> &regions, Record &&record) {
+        std::ranges::stable_sort(copies, std::less{}, [](const Copy &copy) {
+            return static_cast<typename decltype(copy.destination)::CType>(copy.destination);
+        });
+
+        for (size_t first = 0; first < copies.size();) {
+            size_t last = first;
+            regions.clear();
+            for (; last < copies.size() && copies[last].destination == copies[first].destination; ++last) {
+                regions.push_back(copies[last].region);
+            }
+            record(copies[first].destination, regions);
+            first = last;
+        }
+    }
+
+    staging_ring::staging_ring(const render_device &device, gpu_allocator &allocator, const settings &settings)
+        : m_device(device), m_allocator(allocator), m_settings(validated(settings)),
+          m_buffer(device.device(), ring_buffer_info(settings.size)),
+          m_memory(bind_buffer_memory(device.device(), allocator, m_buffer, memory_usage::upload)),
+          m_ring(settings.size), m_semaphore(nullptr) {
+        const vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> semaphore_info(
+            vk::SemaphoreCreateInfo{}, vk::SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline, 0)
+        );
+        m_semaphore = vk::raii::Semaphore(device.device(), semaphore_info.get<vk::SemaphoreCreateInfo>());
+
+        // what the device copies fastest from, and at least 16 so the texel size of the usual formats divides it
+        m_image_alignment = std::max<uint64_t>(
+            16, device.physical_device().getProperties().limits.optimalBufferCopyOffsetAlignment
+        );
+
+        for (uint32_t i = 0; i < m_settings.batches_in_flight; ++i) {
+            vk::CommandPoolCreateInfo pool_info{};
+            pool_info.setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+            pool_info.setQueueFamilyIndex(device.transfer_queue_family());
+            vk::raii::CommandPool pool(device.device(), pool_info);
+
+            vk::CommandBufferAllocateInfo commands_info{};
+            commands_info.setCommandPool(*pool);
+            commands_info.setLevel(vk::CommandBufferLevel::ePrimary);
+            commands_info.setCommandBufferCount(1);
+            vk::raii::CommandBuffers commands(device.device(), commands_info);
+
+            m_batches.push_back(batch{.pool = std::move(pool), .commands = std::move(commands.front())});
+        }
+    }
+
+    staging_ring::~staging_ring() {
+        try {
+            _wait(m_submitted);
+        } catch (const std::exception &e) {
+            ENGINE_LOG(m_device.logger(), spdlog::level::err, "Failed to wait for uploads: {}", e.what());
+        }
+        m_buffer.clear();
+        m_allocator.free(m_memory);
+    }
+
+    void
+    staging_ring::upload(const vk::Buffer destination, const uint64_t offset, const std::span<const std::byte> data) {
+        if (data.empty())
+            return;
+
+        const uint64_t source = _stage(data, 16);
+        m_buffer_copies.push_back(buffer_copy{
+            .destination = destination,
+            .region      = vk::BufferCopy(source, offset, data.size()),
+        });
+    }
+
+    void staging_ring::upload(
+        const vk::Image destination, vk::BufferImageCopy region, const std::span<const std::byte> data
+    ) {
+        if (data.empty())
+            return;
+
+        region.setBufferOffset(_stage(data, m_image_alignment));
+        m_image_copies.push_back(image_copy{.destination = destination, .region = region});
+    }
+
+    uint64_t staging_ring::submit() {
+        if (m_buffer_copies.empty() && m_image_copies.empty())
+            return m_submitted;
+        ENGINE_PROFILE_ZONE("staging_ring::submit");
+
+        const uint64_t value = m_submitted + 1;
+        batch         &b     = m_batches[value % m_batches.size()];
+
+        // the batch's command buffer was last used for this value, which has to be done with it
+        if (value > m_batches.size())
+            _wait(value - m_batches.size());
+        b.pool.reset();
+
+        b.commands.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        // consecutive uploads into consecutive ranges of a buffer are staged next to each other too, and become one
+        // region
+        std::vector<vk::BufferCopy> buffer_regions;
+        record_grouped(
+            m_buffer_copies, buffer_regions,
+            [&](const vk::Buffer destination, std::vector<vk::BufferCopy> &regions) {
+                size_t merged = 0;
+                for (size_t i = 1; i < regions.size(); ++i) {
+                    vk::BufferCopy &last = regions[merged];
+                    if (regions[i].srcOffset == last.srcOffset + last.size &&
+                        regions[i].dstOffset == last.dstOffset + last.size) {
+                        last.size += regions[i].size;
+                    } else {
+                        regions[++merged] = regions[i];
+                    }
+                }
+                regions.resize(merged + 1);
+                b.commands.copyBuffer(*m_buffer, destination, regions);
+            }
+        );
+
+        std::vector<vk::BufferImageCopy> image_regions;
+        record_grouped(
+            m_image_copies, image_regions,
+            [&](const vk::Image destination, const std::vector<vk::BufferImageCopy> &regions) {
+                b.commands.copyBufferToImage(*m_buffer, destination, vk::ImageLayout::eTransferDstOptimal, regions);
+            }
+        );
+
+        b.commands.end();
+
+        const vk::CommandBufferSubmitInfo command_info(*b.commands);
+        const vk::SemaphoreSubmitInfo     signal_info(*m_semaphore, value, vk::PipelineStageFlagBits2::eAllTransfer);
+        vk::SubmitInfo2                   submit_info{};
+        submit_info.setCommandBufferInfos(command_info);
+        submit_info.setSignalSemaphoreInfos(signal_info);
+        m_device.transfer_queue().submit2(submit_info);
+
+        m_ring.end_frame(value);
+        m_submitted = value;
+        m_buffer_copies.clear();
+        m_image_copies.clear();
+        return value;
+    }
+
+    uint64_t staging_ring::_stage(const std::span<const std::byte> data, const uint64_t alignment) {
+        if (data.size() > m_settings.size)
+            throw std::invalid_argument("Upload is larger than the staging ring");
+
+        m_ring.retire(m_semaphore.getCounterValue());
+
+        std::optional<uint64_t> offset = m_ring.allocate(data.size(), alignment);
+        while (!offset) {
+            m_stall_metric.increment();
+            // the copies queued so far fill the ring by themselves
+            if (!m_ring.oldest_frame())
+                submit();
+
+            const uint64_t oldest = *m_ring.oldest_frame();
+            _wait(oldest);
+            m_ring.retire(oldest);
+            offset = m_ring.allocate(data.size(), alignment);
+        }
+
+        std::memcpy(m_memory.mapped + *offset, data.data(), data.size());
+        m_uploaded_metric.add(static_cast<int64_t>(data.size()));
+        return *offset;
+    }
+
+    void staging_ring::_wait(const uint64_t value) const {
+        if (m_semaphore.getCounterValue() >= value)
+            return;
+        ENGINE_PROFILE_ZONE("staging_ring wait");
+
+        const vk::Semaphore   semaphore = *m_semaphore;
+        vk::SemaphoreWaitInfo wait_info{};
+        wait_info.setSemaphores(semaphore);
+        wait_info.setValues(value);
+        if (m_device.device().waitSemaphores(wait_info, UINT64_MAX) != vk::Result::eSuccess)
+            throw std::runtime_error("Failed to wait for the staging ring semaphore");
+    }
+
+} // namespace engine
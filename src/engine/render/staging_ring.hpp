@@ -0,0 +1,121 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/metrics.hpp"
+#include "engine/render/gpu_memory.hpp"
+#include "engine/render/render_device.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace engine {
+
+    /**
+     * Uploads data to buffers and images through a persistently mapped ring buffer. upload() copies the data into the
+     * ring straight away and queues a GPU copy; submit() records every queued copy into one command buffer, merging
+     * copies that are contiguous in both the ring and the destination, and submits it to the transfer queue. Ring
+     * space comes back once the GPU has finished a batch, which a timeline semaphore tracks, so a frame's uploads cost
+     * one submission and no per-upload allocations.
+     *
+     * Work that reads uploaded data waits on semaphore() for the value submit() returned. When the transfer queue is
+     * of another family than the one reading (render_device::queue_families()), destinations have to be created with
+     * vk::SharingMode::eConcurrent across both. Images have to be in vk::ImageLayout::eTransferDstOptimal by the time
+     * the batch runs. Copies in one batch are not ordered against each other, so uploads that overlap in a destination
+     * belong in separate batches.
+     *
+     * Not thread-safe; when the device has no transfer-only queue family, submit() uses the graphics queue, and must
+     * not race with other submissions to it.
+     */
+    class staging_ring {
+      public:
+        struct settings {
+            uint64_t size = uint64_t(64) << 20;
+
+            // batches that can be on the GPU at once before submit() waits for the oldest
+            uint32_t batches_in_flight = 3;
+        };
+
+        staging_ring(const render_device &device, gpu_allocator &allocator, const settings &settings);
+
+        /**
+         * Waits for every submitted batch to finish. Queued copies that were never submitted are dropped.
+         */
+        ~staging_ring();
+
+        staging_ring(const staging_ring &other)                = delete;
+        staging_ring(staging_ring &&other) noexcept            = delete;
+        staging_ring &operator=(const staging_ring &other)     = delete;
+        staging_ring &operator=(staging_ring &&other) noexcept = delete;
+
+        /**
+         * If the ring is full, submits what is queued and waits for the oldest batch to finish.
+         *
+         * @throws std::invalid_argument if the data is larger than the ring
+         */
+        void upload(vk::Buffer destination, uint64_t offset, std::span<const std::byte> data);
+
+        /**
+         * region.bufferOffset is filled in; the rest of region describes where the data goes, tightly packed unless
+         * bufferRowLength or bufferImageHeight say otherwise.
+         *
+         * @throws std::invalid_argument if the data is larger than the ring
+         */
+        void upload(vk::Image destination, vk::BufferImageCopy region, std::span<const std::byte> data);
+
+        /**
+         * Submits the queued copies, if any.
+         *
+         * @return The value semaphore() reaches once every copy queued so far has finished
+         */
+        uint64_t submit();
+
+        [[nodiscard]] inline const vk::raii::Semaphore &semaphore() const noexcept { return m_semaphore; }
+        [[nodiscard]] inline uint64_t                   submitted() const noexcept { return m_submitted; }
+        [[nodiscard]] inline uint64_t                   used_bytes() const noexcept { return m_ring.used_bytes(); }
+
+      private:
+        struct buffer_copy {
+            vk::Buffer     destination;
+            vk::BufferCopy region;
+        };
+
+        struct image_copy {
+            vk::Image           destination;
+            vk::BufferImageCopy region;
+        };
+
+        struct batch {
+            vk::raii::CommandPool   pool;
+            vk::raii::CommandBuffer commands;
+        };
+
+        const render_device &m_device;
+        gpu_allocator       &m_allocator;
+        settings             m_settings;
+
+        vk::raii::Buffer    m_buffer;
+        gpu_allocation      m_memory;
+        ring_allocator      m_ring;
+        vk::raii::Semaphore m_semaphore;
+        std::vector<batch>  m_batches;
+        uint64_t            m_submitted       = 0; // the semaphore value of the last batch
+        uint64_t            m_image_alignment = 16;
+
+        std::vector<buffer_copy> m_buffer_copies;
+        std::vector<image_copy>  m_image_copies;
+
+        metrics::counter m_uploaded_metric = metrics::registry::get().get_counter("staging_uploaded_bytes");
+        metrics::counter m_stall_metric    = metrics::registry::get().get_counter("staging_stalls");
+
+        // copies the data into the ring and returns where it went
+        uint64_t _stage(std::span<const std::byte> data, uint64_t alignment);
+
+        void _wait(uint64_t value) const;
+    };
+
+} // namespace engine
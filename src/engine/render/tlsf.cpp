@@ -0,0 +1,205 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "tlsf.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace engine {
+
+    tlsf_allocator::tlsf_allocator(const uint64_t size) : m_size(size) {
+        if (size == 0)
+            throw std::invalid_argument("tlsf_allocator needs a non-empty range");
+
+        for (auto &heads : m_heads) {
+            heads.fill(no_node);
+        }
+
+        m_first               = _new_node();
+        m_nodes[m_first].size = size;
+        m_nodes[m_first].free = true;
+        _insert_free(m_first);
+    }
+
+    std::optional<tlsf_allocator::allocation> tlsf_allocator::allocate(uint64_t size, uint64_t alignment) {
+        size      = std::max<uint64_t>(size, 1);
+        alignment = std::max<uint64_t>(alignment, 1);
+        if (size > m_size || alignment > m_size)
+            return std::nullopt;
+
+        const auto aligned = [&](const uint32_t n) {
+            return (m_nodes[n].offset + alignment - 1) / alignment * alignment;
+        };
+
+        // the head of the first list large enough usually happens to be aligned already; only when it is not is the
+        // search repeated for a range that fits with any amount of padding
+        uint32_t n = _find_free(_search_class_of(size));
+        if (n == no_node || aligned(n) + size > m_nodes[n].offset + m_nodes[n].size) {
+            n = _find_free(_search_class_of(size + alignment - 1));
+            if (n == no_node)
+                return std::nullopt;
+        }
+        _remove_free(n);
+
+        if (const uint64_t padding = aligned(n) - m_nodes[n].offset; padding > 0) {
+            _split(n, padding);
+            const uint32_t rest = m_nodes[n].next_physical;
+            _insert_free(n);
+            n = rest;
+        }
+        if (m_nodes[n].size > size) {
+            _split(n, size);
+            _insert_free(m_nodes[n].next_physical);
+        }
+
+        m_nodes[n].free = false;
+        m_used_bytes += m_nodes[n].size;
+        ++m_allocation_count;
+        return allocation{.offset = m_nodes[n].offset, .node = n};
+    }
+
+    void tlsf_allocator::free(uint32_t n) {
+        if (n >= m_nodes.size() || m_nodes[n].free)
+            throw std::logic_error("tlsf_allocator::free of a node that is not allocated");
+
+        m_nodes[n].free = true;
+        m_used_bytes -= m_nodes[n].size;
+        --m_allocation_count;
+
+        if (const uint32_t next = m_nodes[n].next_physical; next != no_node && m_nodes[next].free) {
+            _remove_free(next);
+            _merge_next(n);
+        }
+        if (const uint32_t prev = m_nodes[n].prev_physical; prev != no_node && m_nodes[prev].free) {
+            _remove_free(prev);
+            _merge_next(prev);
+            n = prev;
+        }
+        _insert_free(n);
+    }
+
+    uint64_t tlsf_allocator::largest_free() const noexcept {
+        if (m_first_bitmap == 0)
+            return 0;
+
+        const uint32_t first  = 63 - std::countl_zero(m_first_bitmap);
+        const uint32_t second = 31 - std::countl_zero(m_second_bitmaps[first]);
+
+        uint64_t largest = 0;
+        for (uint32_t n = m_heads[first][second]; n != no_node; n = m_nodes[n].next_free) {
+            largest = std::max(largest, m_nodes[n].size);
+        }
+        return largest;
+    }
+
+    tlsf_allocator::size_class tlsf_allocator::_class_of(const uint64_t size) noexcept {
+        if (size < second_level)
+            return {0, static_cast<uint32_t>(size)};
+
+        const uint32_t width = static_cast<uint32_t>(std::bit_width(size));
+        const uint32_t shift = width - 1 - second_level_bits;
+        return {width - second_level_bits, static_cast<uint32_t>(size >> shift) - second_level};
+    }
+
+    tlsf_allocator::size_class tlsf_allocator::_search_class_of(uint64_t size) noexcept {
+        if (size >= second_level) {
+            // round up to the next class boundary, so any range in the class found is large enough
+            size += (uint64_t(1) << (std::bit_width(size) - 1 - second_level_bits)) - 1;
+        }
+        return _class_of(size);
+    }
+
+    uint32_t tlsf_allocator::_find_free(const size_class from) const noexcept {
+        uint32_t first      = from.first;
+        uint32_t second_map = m_second_bitmaps[first] & (~0u << from.second);
+        if (second_map == 0) {
+            const uint64_t first_map = first + 1 < 64 ? m_first_bitmap & (~uint64_t(0) << (first + 1)) : 0;
+            if (first_map == 0)
+                return no_node;
+            first      = static_cast<uint32_t>(std::countr_zero(first_map));
+            second_map = m_second_bitmaps[first];
+        }
+        return m_heads[first][std::countr_zero(second_map)];
+    }
+
+    uint32_t tlsf_allocator::_new_node() {
+        if (!m_unused_nodes.empty()) {
+            const uint32_t n = m_unused_nodes.back();
+            m_unused_nodes.pop_back();
+            m_nodes[n] = node{};
+            return n;
+        }
+        m_nodes.emplace_back();
+        return static_cast<uint32_t>(m_nodes.size() - 1);
+    }
+
+    void tlsf_allocator::_release_node(const uint32_t n) {
+        m_unused_nodes.push_back(n);
+    }
+
+    void tlsf_allocator::_insert_free(const uint32_t n) {
+        const auto [first, second] = _class_of(m_nodes[n].size);
+
+        const uint32_t head  = m_heads[first][second];
+        m_nodes[n].free      = true;
+        m_nodes[n].prev_free = no_node;
+        m_nodes[n].next_free = head;
+        if (head != no_node)
+            m_nodes[head].prev_free = n;
+        m_heads[first][second] = n;
+
+        m_first_bitmap |= uint64_t(1) << first;
+        m_second_bitmaps[first] |= 1u << second;
+    }
+
+    void tlsf_allocator::_remove_free(const uint32_t n) {
+        const auto [first, second] = _class_of(m_nodes[n].size);
+
+        const uint32_t prev = m_nodes[n].prev_free;
+        const uint32_t next = m_nodes[n].next_free;
+        if (prev != no_node) {
+            m_nodes[prev].next_free = next;
+        } else {
+            m_heads[first][second] = next;
+        }
+        if (next != no_node)
+            m_nodes[next].prev_free = prev;
+        m_nodes[n].prev_free = m_nodes[n].next_free = no_node;
+
+        if (m_heads[first][second] == no_node) {
+            m_second_bitmaps[first] &= ~(1u << second);
+            if (m_second_bitmaps[first] == 0)
+                m_first_bitmap &= ~(uint64_t(1) << first);
+        }
+    }
+
+    void tlsf_allocator::_split(const uint32_t n, const uint64_t size) {
+        const uint32_t rest = _new_node();
+
+        m_nodes[rest].offset        = m_nodes[n].offset + size;
+        m_nodes[rest].size          = m_nodes[n].size - size;
+        m_nodes[rest].free          = true;
+        m_nodes[rest].prev_physical = n;
+        m_nodes[rest].next_physical = m_nodes[n].next_physical;
+        if (m_nodes[n].next_physical != no_node)
+            m_nodes[m_nodes[n].next_physical].prev_physical = rest;
+
+        m_nodes[n].size          = size;
+        m_nodes[n].next_physical = rest;
+    }
+
+    void tlsf_allocator::_merge_next(const uint32_t n) {
+        const uint32_t next = m_nodes[n].next_physical;
+
+        m_nodes[n].size += m_nodes[next].size;
+        m_nodes[n].next_physical = m_nodes[next].next_physical;
+        if (m_nodes[next].next_physical != no_node)
+            m_nodes[m_nodes[next].next_physical].prev_physical = n;
+
+        _release_node(next);
+    }
+
+} // namespace engine
@@ -0,0 +1,121 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Two-level segregated fit over a range of offsets; the memory itself lives elsewhere (in a VkDeviceMemory, say).
+     * Free ranges are kept in lists by size class, 32 classes per power of two, with a bitmap over the lists, so
+     * allocating and freeing take constant time: finding a range is two bit scans, and a freed range is merged with
+     * free neighbours at once.
+     *
+     * Ranges are tracked in nodes that are reused once freed, so an allocation is named by its node index.
+     */
+    class tlsf_allocator {
+      public:
+        static constexpr uint32_t no_node = UINT32_MAX;
+
+        struct allocation {
+            uint64_t offset;
+            uint32_t node;
+        };
+
+        explicit tlsf_allocator(uint64_t size);
+
+        /**
+         * @return Nothing if no free range is large enough
+         */
+        [[nodiscard]] std::optional<allocation> allocate(uint64_t size, uint64_t alignment);
+
+        void free(uint32_t node);
+
+        /**
+         * @return The size of an allocated node
+         */
+        [[nodiscard]] inline uint64_t size_of(const uint32_t node) const noexcept { return m_nodes[node].size; }
+
+        [[nodiscard]] inline uint64_t size() const noexcept { return m_size; }
+        [[nodiscard]] inline uint64_t used_bytes() const noexcept { return m_used_bytes; }
+        [[nodiscard]] inline uint64_t free_bytes() const noexcept { return m_size - m_used_bytes; }
+        [[nodiscard]] inline uint32_t allocation_count() const noexcept { return m_allocation_count; }
+        [[nodiscard]] inline bool     empty() const noexcept { return m_allocation_count == 0; }
+
+        /**
+         * @return The largest free range; looks at every range in the largest non-empty class
+         */
+        [[nodiscard]] uint64_t largest_free() const noexcept;
+
+        /**
+         * Calls function(offset, size, node) for every allocation, in address order.
+         */
+        template <typename Function>
+        void for_each_allocation(Function &&function) const {
+            for (uint32_t n = m_first; n != no_node; n = m_nodes[n].next_physical) {
+                if (!m_nodes[n].free)
+                    function(m_nodes[n].offset, m_nodes[n].size, n);
+            }
+        }
+
+      private:
+        static constexpr uint32_t second_level_bits = 5;
+        static constexpr uint32_t second_level      = 1u << second_level_bits;
+        static constexpr uint32_t first_level       = 64 - second_level_bits + 1;
+
+        struct node {
+            uint64_t offset        = 0;
+            uint64_t size          = 0;
+            uint32_t prev_physical = no_node;
+            uint32_t next_physical = no_node;
+            uint32_t prev_free     = no_node;
+            uint32_t next_free     = no_node;
+            bool     free          = false;
+        };
+
+        struct size_class {
+            uint32_t first;
+            uint32_t second;
+        };
+
+        uint64_t m_size;
+        uint64_t m_used_bytes       = 0;
+        uint32_t m_allocation_count = 0;
+        uint32_t m_first            = no_node; // the node at offset 0
+
+        std::vector<node>     m_nodes;
+        std::vector<uint32_t> m_unused_nodes;
+
+        uint64_t                                                    m_first_bitmap = 0;
+        std::array<uint32_t, first_level>                           m_second_bitmaps{};
+        std::array<std::array<uint32_t, second_level>, first_level> m_heads;
+
+        // the class a range of this size is listed under
+        [[nodiscard]] static size_class _class_of(uint64_t size) noexcept;
+
+        // the first class whose every range is at least this large
+        [[nodiscard]] static size_class _search_class_of(uint64_t size) noexcept;
+
+        // the first free node in this class or a larger one
+        [[nodiscard]] uint32_t _find_free(size_class from) const noexcept;
+
+        uint32_t _new_node();
+        void     _release_node(uint32_t n);
+
+        void _insert_free(uint32_t n);
+        void _remove_free(uint32_t n);
+
+        // splits the range after the first size bytes of a node off into a free node of its own
+        void _split(uint32_t n, uint64_t size);
+
+        // merges a node with the next one, which is freed
+        void _merge_next(uint32_t n);
+    };
+
+} // namespace engine
@@ -0,0 +1,384 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "resources.hpp"
+
+#include "engine/metrics.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ENGINE_HAS_MMAP 1
+#endif
+
+namespace engine {
+    // summed over every resource_manager
+    struct resource_metrics {
+        metrics::counter resident_bytes = metrics::registry::get().get_up_down_counter("resources_resident_bytes");
+        metrics::counter resident_count = metrics::registry::get().get_up_down_counter("resources_resident");
+
+        metrics::counter loads_completed = metrics::registry::get().get_counter("resource_loads_completed");
+        metrics::counter loads_failed    = metrics::registry::get().get_counter("resource_loads_failed");
+        metrics::counter evictions       = metrics::registry::get().get_counter("resource_evictions");
+    };
+
+    static const resource_metrics &published_metrics() {
+        static const resource_metrics instance;
+        return instance;
+    }
+
+    mapped_file::mapped_file(const std::filesystem::path &path) {
+#ifdef ENGINE_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat " + path.string());
+        }
+
+        m_size = static_cast<size_t>(st.st_size);
+        if (m_size > 0) {
+            void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED) {
+                throw std::runtime_error("Failed to map " + path.string());
+            }
+            ::madvise(data, m_size, MADV_SEQUENTIAL);
+            m_data   = static_cast<const std::byte *>(data);
+            m_mapped = true;
+        } else {
+            ::close(fd);
+        }
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+
+        m_size = static_cast<size_t>(file.tellg());
+        if (m_size > 0) {
+            auto *data = new std::byte[m_size];
+            file.seekg(0);
+            if (!file.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(m_size))) {
+                delete[] data;
+                throw std::runtime_error("Failed to read " + path.string());
+            }
+            m_data = data;
+        }
+#endif
+    }
+
+    mapped_file::~mapped_file() {
+        if (!m_data)
+            return;
+
+#ifdef ENGINE_HAS_MMAP
+        if (m_mapped) {
+            ::munmap(const_cast<std::byte *>(m_data), m_size);
+            return;
+        }
+#endif
+        delete[] m_data;
+    }
+
+    void resource_entry::_unpinned() const noexcept {
+        resource_manager *manager = m_manager.load(std::memory_order_acquire);
+        if (manager && manager->m_over_budget.load(std::memory_order_relaxed))
+            manager->collect();
+    }
+
+    void resource_entry::wait() const {
+        resource_state state = m_state.load(std::memory_order_acquire);
+        while (state == resource_state::loading) {
+            m_state.wait(state, std::memory_order_acquire);
+            state = m_state.load(std::memory_order_acquire);
+        }
+    }
+
+    resource_manager::resource_manager(settings settings)
+        : m_root(std::move(settings.root)), m_budget(settings.budget_bytes) {}
+
+    resource_manager::~resource_manager() {
+        wait_idle();
+
+        // handles may outlive the manager; they keep their value but are no longer tracked
+        std::lock_guard lock(m_mutex);
+        while (m_lru_head) {
+            _unlink(m_lru_head);
+        }
+        m_entries.for_each([](name_id, const std::shared_ptr<resource_entry> &entry) {
+            entry->m_manager.store(nullptr, std::memory_order_release);
+        });
+
+        published_metrics().resident_bytes.add(-static_cast<int64_t>(m_stats.resident_bytes));
+        published_metrics().resident_count.add(-static_cast<int64_t>(m_stats.resident_count));
+    }
+
+    void resource_manager::set_job_system(std::shared_ptr<job_system> job_system) {
+        wait_idle();
+        m_job_system = std::move(job_system);
+    }
+
+    bool resource_manager::contains(const hashed_name path) const {
+        std::lock_guard lock(m_mutex);
+        return m_entries.contains(path);
+    }
+
+    void resource_manager::set_budget(const size_t budget_bytes) {
+        m_budget.store(budget_bytes, std::memory_order_relaxed);
+        collect();
+    }
+
+    void resource_manager::collect() {
+        std::vector<std::shared_ptr<void>> evicted;
+
+        std::lock_guard lock(m_mutex);
+        evicted = _evict_to_budget();
+        // the budget may have changed without anything being evicted
+        _update_over_budget();
+    }
+
+    void resource_manager::wait_idle() {
+        if (m_job_system) {
+            m_job_system->wait(m_in_flight);
+        }
+    }
+
+    resource_manager::statistics resource_manager::stats() const {
+        std::lock_guard lock(m_mutex);
+        return m_stats;
+    }
+
+    std::vector<resource_manager::resource_info> resource_manager::list() const {
+        std::vector<resource_info> result;
+
+        std::lock_guard lock(m_mutex);
+        result.reserve(m_entries.size());
+        m_entries.for_each([&](name_id, const std::shared_ptr<resource_entry> &entry) {
+            result.push_back(resource_info{.path = entry->m_path, .type = entry->m_type, .persistent = entry->m_persistent});
+        });
+        return result;
+    }
+
+    std::shared_ptr<resource_entry> resource_manager::_request(const hashed_name path, const std::type_index type) {
+        std::shared_ptr<resource_entry> entry;
+        {
+            std::lock_guard lock(m_mutex);
+            if (const auto *found = m_entries.find(path)) {
+                entry = *found;
+                if (entry->m_type != type) {
+                    throw std::invalid_argument("Resource " + std::string(path.str) + " was requested as another type");
+                }
+
+                entry->m_pins.fetch_add(1, std::memory_order_relaxed);
+
+                // failed loads are retried on the next request
+                const resource_state state = entry->state();
+                if (state == resource_state::ready) {
+                    _touch(entry.get());
+                }
+                if (state == resource_state::ready || state == resource_state::loading)
+                    return entry;
+            } else {
+                if (!m_loaders.contains(type)) {
+                    throw std::logic_error("No loader registered for resource " + std::string(path.str));
+                }
+                entry = std::make_shared<resource_entry>(name_id::intern(path), type);
+                entry->m_pins.fetch_add(1, std::memory_order_relaxed);
+                entry->m_manager.store(this, std::memory_order_relaxed);
+                m_entries.insert_or_assign(entry->m_path, entry);
+            }
+
+            entry->m_state.store(resource_state::loading, std::memory_order_relaxed);
+            ++m_stats.loads_started;
+        }
+
+        _start_load(entry);
+        return entry;
+    }
+
+    std::shared_ptr<resource_entry> resource_manager::_add(
+        const hashed_name name, const std::type_index type, std::shared_ptr<void> value, const size_t bytes
+    ) {
+        std::shared_ptr<void> replaced; // destroyed after the mutex is released, as for evicted values
+
+        std::lock_guard lock(m_mutex);
+
+        std::shared_ptr<resource_entry> entry;
+        if (const auto *found = m_entries.find(name)) {
+            entry = *found;
+            if (entry->m_type != type || entry->state() == resource_state::loading) {
+                throw std::invalid_argument("Resource " + std::string(name.str) + " already exists");
+            }
+            _unlink(entry.get());
+            if (entry->state() == resource_state::ready) {
+                _remove_resident(entry->m_bytes);
+            }
+        } else {
+            entry = std::make_shared<resource_entry>(name_id::intern(name), type);
+            entry->m_manager.store(this, std::memory_order_relaxed);
+            m_entries.insert_or_assign(entry->m_path, entry);
+        }
+
+        replaced            = std::exchange(entry->m_value, std::move(value));
+        entry->m_bytes      = bytes;
+        entry->m_persistent = true;
+        entry->m_pins.fetch_add(1, std::memory_order_relaxed);
+        entry->m_state.store(resource_state::ready, std::memory_order_release);
+
+        _add_resident(bytes);
+        return entry;
+    }
+
+    void resource_manager::_start_load(const std::shared_ptr<resource_entry> &entry) {
+        type_loader loader;
+        {
+            std::lock_guard lock(m_mutex);
+            loader = m_loaders.at(entry->m_type);
+        }
+
+        if (!m_job_system) {
+            _load(entry, loader);
+            return;
+        }
+
+        m_job_system->submit([this, entry, loader = std::move(loader)] { _load(entry, loader); }, &m_in_flight);
+    }
+
+    void resource_manager::_load(const std::shared_ptr<resource_entry> &entry, const type_loader &loader) {
+        std::shared_ptr<void> value;
+        size_t                bytes = 0;
+        std::string           error;
+
+        try {
+            const mapped_file file(m_root / entry->m_path.str());
+            value = loader.load(file.bytes());
+            if (!value) {
+                error = "Loader returned nothing";
+            } else {
+                bytes = loader.resident_bytes(value.get(), file.size());
+            }
+        } catch (const std::exception &e) {
+            error = e.what();
+        }
+
+        std::vector<std::shared_ptr<void>> evicted;
+        {
+            std::lock_guard lock(m_mutex);
+            if (error.empty()) {
+                entry->m_value = std::move(value);
+                entry->m_bytes = bytes;
+                entry->m_error.clear();
+                entry->m_state.store(resource_state::ready, std::memory_order_release);
+
+                _add_resident(bytes);
+                ++m_stats.loads_completed;
+                published_metrics().loads_completed.increment();
+
+                _touch(entry.get());
+                evicted = _evict_to_budget();
+            } else {
+                entry->m_error = std::move(error);
+                entry->m_state.store(resource_state::failed, std::memory_order_release);
+                ++m_stats.loads_failed;
+                published_metrics().loads_failed.increment();
+            }
+        }
+
+        entry->m_state.notify_all();
+    }
+
+    void resource_manager::_add_resident(const size_t bytes) {
+        m_stats.resident_bytes += bytes;
+        m_stats.peak_resident_bytes = std::max(m_stats.peak_resident_bytes, m_stats.resident_bytes);
+        ++m_stats.resident_count;
+
+        published_metrics().resident_bytes.add(static_cast<int64_t>(bytes));
+        published_metrics().resident_count.increment();
+        _update_over_budget();
+    }
+
+    void resource_manager::_remove_resident(const size_t bytes) {
+        m_stats.resident_bytes -= bytes;
+        --m_stats.resident_count;
+
+        published_metrics().resident_bytes.add(-static_cast<int64_t>(bytes));
+        published_metrics().resident_count.decrement();
+        _update_over_budget();
+    }
+
+    void resource_manager::_update_over_budget() {
+        m_over_budget.store(m_stats.resident_bytes > m_budget.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    void resource_manager::_touch(resource_entry *entry) {
+        if (entry->m_persistent || m_lru_head == entry)
+            return;
+
+        _unlink(entry);
+        entry->m_lru_next = m_lru_head;
+        if (m_lru_head) {
+            m_lru_head->m_lru_prev = entry;
+        } else {
+            m_lru_tail = entry;
+        }
+        m_lru_head      = entry;
+        entry->m_in_lru = true;
+    }
+
+    void resource_manager::_unlink(resource_entry *entry) {
+        if (!entry->m_in_lru)
+            return;
+
+        if (entry->m_lru_prev) {
+            entry->m_lru_prev->m_lru_next = entry->m_lru_next;
+        } else {
+            m_lru_head = entry->m_lru_next;
+        }
+        if (entry->m_lru_next) {
+            entry->m_lru_next->m_lru_prev = entry->m_lru_prev;
+        } else {
+            m_lru_tail = entry->m_lru_prev;
+        }
+
+        entry->m_lru_prev = nullptr;
+        entry->m_lru_next = nullptr;
+        entry->m_in_lru   = false;
+    }
+
+    std::vector<std::shared_ptr<void>> resource_manager::_evict_to_budget() {
+        const size_t                       budget = m_budget.load(std::memory_order_relaxed);
+        std::vector<std::shared_ptr<void>> evicted;
+
+        resource_entry *entry = m_lru_tail;
+        while (entry && m_stats.resident_bytes > budget) {
+            resource_entry *prev = entry->m_lru_prev;
+
+            // a handle can only be created under the mutex or copied from another handle, so no pins means none can
+            // appear while we evict
+            if (entry->m_pins.load(std::memory_order_acquire) == 0) {
+                _unlink(entry);
+                _remove_resident(entry->m_bytes);
+                ++m_stats.evictions;
+                published_metrics().evictions.increment();
+
+                evicted.push_back(std::move(entry->m_value));
+                entry->m_bytes = 0;
+                entry->m_state.store(resource_state::unloaded, std::memory_order_release);
+            }
+
+            entry = prev;
+        }
+        return evicted;
+    }
+} // namespace engine
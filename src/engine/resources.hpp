@@ -0,0 +1,362 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/jobs.hpp"
+#include "engine/names.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * A read-only view of a whole file. Memory-mapped where the platform supports it, read into memory otherwise. Throws
+     * std::runtime_error if the file cannot be opened.
+     */
+    class mapped_file {
+      public:
+        explicit mapped_file(const std::filesystem::path &path);
+        ~mapped_file();
+
+        mapped_file(const mapped_file &other)                = delete;
+        mapped_file(mapped_file &&other) noexcept            = delete;
+        mapped_file &operator=(const mapped_file &other)     = delete;
+        mapped_file &operator=(mapped_file &&other) noexcept = delete;
+
+        [[nodiscard]] inline std::span<const std::byte> bytes() const noexcept { return {m_data, m_size}; }
+        [[nodiscard]] inline size_t                     size() const noexcept { return m_size; }
+
+      private:
+        const std::byte *m_data   = nullptr;
+        size_t           m_size   = 0;
+        bool             m_mapped = false;
+    };
+
+    enum class resource_state : uint8_t {
+        unloaded,
+        loading,
+        ready,
+        failed,
+    };
+
+    class resource_manager;
+
+    /**
+     * Book-keeping for one resource, shared by the manager and every handle to it. Handles pin the resource: it is only
+     * evicted once no handle refers to it, and dropping the last pin evicts right away if the manager is over budget.
+     */
+    class resource_entry {
+      public:
+        resource_entry(const name_id path, const std::type_index type) : m_path(path), m_type(type) {}
+
+        [[nodiscard]] inline name_id            path() const noexcept { return m_path; }
+        [[nodiscard]] inline resource_state     state() const noexcept { return m_state.load(std::memory_order_acquire); }
+        [[nodiscard]] inline const std::string &error() const noexcept { return m_error; }
+
+        /**
+         * Blocks until the resource is no longer loading.
+         */
+        void wait() const;
+
+      private:
+        name_id                     m_path;
+        std::type_index             m_type;
+        std::atomic<resource_state> m_state = resource_state::unloaded;
+        std::atomic<uint32_t>       m_pins  = 0;
+
+        // cleared when the manager is destroyed, since handles may outlive it
+        std::atomic<resource_manager *> m_manager = nullptr;
+
+        // written under the manager's mutex before the state is published
+        std::shared_ptr<void> m_value;
+        size_t                m_bytes      = 0;
+        bool                  m_persistent = false;
+        std::string           m_error;
+
+        // intrusive LRU list of resident, evictable entries (most recently used at the front)
+        resource_entry *m_lru_prev = nullptr;
+        resource_entry *m_lru_next = nullptr;
+        bool            m_in_lru   = false;
+
+        friend class resource_manager;
+        template <typename T>
+        friend class resource_handle;
+
+        void _unpinned() const noexcept;
+    };
+
+    /**
+     * A typed, reference-counted reference to a resource. Holding one keeps the resource resident; get() returns null
+     * until it has finished loading.
+     */
+    template <typename T>
+    class resource_handle {
+      public:
+        resource_handle() = default;
+
+        resource_handle(const resource_handle &other) : m_entry(other.m_entry) { _pin(); }
+        resource_handle(resource_handle &&other) noexcept : m_entry(std::move(other.m_entry)) {}
+
+        resource_handle &operator=(const resource_handle &other) {
+            if (this != &other) {
+                _unpin();
+                m_entry = other.m_entry;
+                _pin();
+            }
+            return *this;
+        }
+
+        resource_handle &operator=(resource_handle &&other) noexcept {
+            if (this != &other) {
+                _unpin();
+                m_entry = std::move(other.m_entry);
+            }
+            return *this;
+        }
+
+        ~resource_handle() { _unpin(); }
+
+        [[nodiscard]] T *get() const noexcept {
+            if (!m_entry || m_entry->state() != resource_state::ready)
+                return nullptr;
+            return static_cast<T *>(m_entry->m_value.get());
+        }
+
+        /**
+         * Waits for the resource to load.
+         * @return The resource, or null if loading failed.
+         */
+        T *wait() const {
+            if (!m_entry)
+                return nullptr;
+            m_entry->wait();
+            return get();
+        }
+
+        [[nodiscard]] inline T *operator->() const noexcept { return get(); }
+        [[nodiscard]] inline T &operator*() const noexcept { return *get(); }
+
+        [[nodiscard]] inline resource_state state() const noexcept {
+            return m_entry ? m_entry->state() : resource_state::unloaded;
+        }
+
+        [[nodiscard]] inline bool ready() const noexcept { return state() == resource_state::ready; }
+        [[nodiscard]] inline bool valid() const noexcept { return m_entry != nullptr; }
+
+        [[nodiscard]] inline std::string_view path() const noexcept {
+            return m_entry ? m_entry->path().str() : std::string_view();
+        }
+
+        [[nodiscard]] inline std::string_view error() const noexcept {
+            return m_entry ? std::string_view(m_entry->error()) : std::string_view();
+        }
+
+      private:
+        std::shared_ptr<resource_entry> m_entry;
+
+        // adopts a pin the manager took under its lock, so the entry cannot be evicted before the handle exists
+        explicit resource_handle(std::shared_ptr<resource_entry> entry) noexcept : m_entry(std::move(entry)) {}
+
+        friend class resource_manager;
+
+        void _pin() const noexcept {
+            if (m_entry)
+                m_entry->m_pins.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void _unpin() const noexcept {
+            if (m_entry && m_entry->m_pins.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                m_entry->_unpinned();
+        }
+    };
+
+    template <typename T>
+    concept reports_resident_bytes = requires(const T &t) {
+        { t.resident_bytes() } -> std::convertible_to<size_t>;
+    };
+
+    /**
+     * Loads typed resources from files on background jobs. Requests for a path that is already loading or loaded share
+     * one entry. Loaded resources count against a byte budget; when it is exceeded, resources that no handle refers to
+     * are evicted in least-recently-requested order, and are loaded again the next time they are requested. Eviction
+     * runs when a load completes, when the last handle to a resource is dropped, and on collect().
+     *
+     * A resource is charged its file size, unless T has a resident_bytes() member.
+     */
+    class resource_manager {
+      public:
+        struct settings {
+            std::filesystem::path root;
+            size_t                budget_bytes = size_t(256) << 20;
+        };
+
+        struct resource_info {
+            name_id         path;
+            std::type_index type;
+            bool            persistent; // added from memory rather than loaded from a file
+        };
+
+        struct statistics {
+            size_t resident_bytes      = 0;
+            size_t peak_resident_bytes = 0;
+            size_t resident_count      = 0;
+            size_t loads_started       = 0;
+            size_t loads_completed     = 0;
+            size_t loads_failed        = 0;
+            size_t evictions           = 0;
+        };
+
+        /**
+         * Builds a T from the file's bytes. The bytes are only valid during the call.
+         */
+        template <typename T>
+        using loader = std::function<std::shared_ptr<T>(std::span<const std::byte> data)>;
+
+        explicit resource_manager(settings settings);
+        ~resource_manager();
+
+        resource_manager(const resource_manager &other)                = delete;
+        resource_manager(resource_manager &&other) noexcept            = delete;
+        resource_manager &operator=(const resource_manager &other)     = delete;
+        resource_manager &operator=(resource_manager &&other) noexcept = delete;
+
+        /**
+         * Without a job system, loads run on the requesting thread.
+         */
+        void set_job_system(std::shared_ptr<job_system> job_system);
+
+        template <typename T>
+        void set_loader(loader<T> load) {
+            std::lock_guard lock(m_mutex);
+            m_loaders[typeid(T)] = type_loader{
+                .load           = [load = std::move(load)](const std::span<const std::byte> data) -> std::shared_ptr<void> {
+                    return load(data);
+                },
+                .resident_bytes = [](const void *value, const size_t file_size) -> size_t {
+                    if constexpr (reports_resident_bytes<T>) {
+                        return static_cast<const T *>(value)->resident_bytes();
+                    } else {
+                        return file_size;
+                    }
+                },
+            };
+        }
+
+        /**
+         * Requests the resource at path (relative to the root) and returns immediately. Throws std::invalid_argument if
+         * the path was requested before as a different type, or std::logic_error if T has no loader.
+         */
+        template <typename T>
+        resource_handle<T> load(const hashed_name path) {
+            return resource_handle<T>(_request(path, typeid(T)));
+        }
+
+        /**
+         * Adds a resource that already exists in memory. It is never evicted.
+         */
+        template <typename T>
+        resource_handle<T> add(const hashed_name name, std::shared_ptr<T> value, const size_t bytes = 0) {
+            return resource_handle<T>(_add(name, typeid(T), std::move(value), bytes));
+        }
+
+        /**
+         * @return A handle to a resource that was loaded or added before, without requesting a load. Null if there is
+         * none.
+         */
+        template <typename T>
+        resource_handle<T> find(const hashed_name path) const {
+            std::lock_guard lock(m_mutex);
+            const auto     *entry = m_entries.find(path);
+            if (!entry || (*entry)->m_type != typeid(T))
+                return {};
+
+            (*entry)->m_pins.fetch_add(1, std::memory_order_relaxed);
+            return resource_handle<T>(*entry);
+        }
+
+        [[nodiscard]] bool contains(hashed_name path) const;
+
+        void                        set_budget(size_t budget_bytes);
+        [[nodiscard]] inline size_t budget() const noexcept { return m_budget.load(std::memory_order_relaxed); }
+
+        /**
+         * Evicts unreferenced resources until the resident size fits the budget.
+         */
+        void collect();
+
+        /**
+         * Blocks until every requested load has finished, running queued jobs in the meantime.
+         */
+        void wait_idle();
+
+        [[nodiscard]] statistics stats() const;
+
+        /**
+         * @return Every resource that was requested or added, loaded or not, in no particular order.
+         */
+        [[nodiscard]] std::vector<resource_info> list() const;
+
+      private:
+        struct type_loader {
+            std::function<std::shared_ptr<void>(std::span<const std::byte>)> load;
+            size_t (*resident_bytes)(const void *value, size_t file_size);
+        };
+
+        std::filesystem::path       m_root;
+        std::atomic<size_t>         m_budget;
+        std::shared_ptr<job_system> m_job_system;
+
+        mutable std::mutex                               m_mutex;
+        flat_name_map<std::shared_ptr<resource_entry>>   m_entries;
+        std::unordered_map<std::type_index, type_loader> m_loaders;
+        resource_entry                                  *m_lru_head = nullptr;
+        resource_entry                                  *m_lru_tail = nullptr;
+        statistics                                       m_stats;
+
+        job_counter m_in_flight;
+
+        // resident bytes exceed the budget; lets a dropped handle skip the mutex when there is nothing to evict
+        std::atomic<bool> m_over_budget = false;
+
+        friend class resource_entry;
+
+        // both return the entry with a pin already taken for the handle
+        std::shared_ptr<resource_entry> _request(hashed_name path, std::type_index type);
+        std::shared_ptr<resource_entry>
+        _add(hashed_name name, std::type_index type, std::shared_ptr<void> value, size_t bytes);
+
+        void _load(const std::shared_ptr<resource_entry> &entry, const type_loader &loader);
+        void _start_load(const std::shared_ptr<resource_entry> &entry);
+
+        // keep m_stats and the published metrics in step
+        void _add_resident(size_t bytes);
+        void _remove_resident(size_t bytes);
+
+        void _update_over_budget();
+
+        void _touch(resource_entry *entry);
+        void _unlink(resource_entry *entry);
+
+        /**
+         * @return The evicted values. Callers destroy them once the mutex is released, since a value may hold handles
+         * to other resources, whose release can re-enter the manager.
+         */
+        [[nodiscard]] std::vector<std::shared_ptr<void>> _evict_to_budget();
+    };
+
+} // namespace engine
@@ -0,0 +1,170 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "spatial.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace engine::scene {
+
+    class scene;
+    class scene_object;
+    struct update_group;
+
+    using spawn_callback = std::function<void(uint64_t id, const std::shared_ptr<scene_object> &object)>;
+
+    struct spawn_options {
+        std::string                   name;
+        std::shared_ptr<update_group> group;
+        uint64_t                      parent_id = 0;
+        spawn_callback                on_spawned;
+    };
+
+    /**
+     * Records structural changes to a scene (spawn, destroy, rename, reparent, update group membership, spatial
+     * bounds) so they can be made from parallel work and applied later at a single sync point.
+     *
+     * Each thread records into its own buffer (see scene::commands()). When the scene flushes, commands from every buffer
+     * are applied in order of their key, then in the order they were recorded. Recording under the id of the object doing
+     * the work (with_key) therefore gives the same result regardless of which thread ran it.
+     */
+    class command_buffer {
+      public:
+        /**
+         * Sets the key used to order commands recorded after this call.
+         */
+        inline command_buffer &with_key(const uint64_t key) noexcept {
+            m_key = key;
+            return *this;
+        }
+
+        /**
+         * Spawns an object of type T with copies of args. The name, update group and parent (0 for none) are applied
+         * right after it is created, then on_spawned is called with the new object.
+         */
+        template <typename T, typename... Args>
+        command_buffer &spawn_with(spawn_options options, Args &&...args) {
+            _record(spawn_command{
+                .create =
+                    [... args = std::forward<Args>(args)](auto &s) mutable {
+                        return s.template emplace_object<T>(std::move(args)...);
+                    },
+                .insert_into_group = &_insert_into_group<T, update_group>,
+                .options           = std::move(options),
+            });
+            return *this;
+        }
+
+        template <typename T, typename... Args>
+        command_buffer &spawn(Args &&...args) {
+            return spawn_with<T>(spawn_options{}, std::forward<Args>(args)...);
+        }
+
+        inline command_buffer &destroy(const uint64_t id) {
+            _record(destroy_command{id});
+            return *this;
+        }
+
+        inline command_buffer &rename(const uint64_t id, std::string name) {
+            _record(rename_command{id, std::move(name)});
+            return *this;
+        }
+
+        /**
+         * Moves an object under a new parent, or to the root if parent_id is 0.
+         */
+        inline command_buffer &reparent(const uint64_t id, const uint64_t parent_id) {
+            _record(reparent_command{id, parent_id});
+            return *this;
+        }
+
+        inline command_buffer &add_to_group(const uint64_t id, std::shared_ptr<update_group> group) {
+            _record(group_command{id, std::move(group), true});
+            return *this;
+        }
+
+        inline command_buffer &remove_from_group(const uint64_t id, std::shared_ptr<update_group> group) {
+            _record(group_command{id, std::move(group), false});
+            return *this;
+        }
+
+        /**
+         * Sets an object's box in the spatial index, as scene::set_object_bounds does. An empty box takes it out.
+         */
+        inline command_buffer &set_bounds(const uint64_t id, const aabb &local_bounds) {
+            _record(bounds_command{id, local_bounds});
+            return *this;
+        }
+
+        [[nodiscard]] inline bool   empty() const noexcept { return m_commands.empty(); }
+        [[nodiscard]] inline size_t size() const noexcept { return m_commands.size(); }
+
+      private:
+        struct spawn_command {
+            // templated on the spawned type, so scene and update_group only need to be complete where spawn is used
+            std::function<std::pair<uint64_t, std::shared_ptr<scene_object>>(scene &)> create;
+            void (*insert_into_group)(const std::shared_ptr<update_group> &, const std::shared_ptr<scene_object> &);
+
+            spawn_options options;
+        };
+
+        struct destroy_command {
+            uint64_t id;
+        };
+
+        struct rename_command {
+            uint64_t    id;
+            std::string name;
+        };
+
+        struct reparent_command {
+            uint64_t id;
+            uint64_t parent_id;
+        };
+
+        struct group_command {
+            uint64_t                      id;
+            std::shared_ptr<update_group> group;
+            bool                          insert;
+        };
+
+        struct bounds_command {
+            uint64_t id;
+            aabb     local_bounds;
+        };
+
+        using command_payload = std::variant<
+            spawn_command, destroy_command, rename_command, reparent_command, group_command, bounds_command>;
+
+        struct command {
+            uint64_t        key;
+            uint64_t        sequence;
+            command_payload payload;
+        };
+
+        std::vector<command> m_commands;
+        uint64_t             m_key      = 0;
+        uint64_t             m_sequence = 0;
+
+        template <typename T, typename G>
+        static void _insert_into_group(const std::shared_ptr<G> &group, const std::shared_ptr<scene_object> &object) {
+            group->insert(std::static_pointer_cast<T>(object));
+        }
+
+        template <typename P>
+        void _record(P &&p) {
+            m_commands.push_back(command{m_key, m_sequence++, std::forward<P>(p)});
+        }
+
+        friend class scene;
+    };
+} // namespace engine::scene
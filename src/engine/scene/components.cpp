@@ -0,0 +1,253 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "components.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace engine::scene {
+    component_id detail::next_component_id() {
+        static std::atomic<component_id> s_next_id = 0;
+        return s_next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    component_column::component_column(const component_info &info) : m_info(&info) {}
+
+    component_column::~component_column() {
+        _release();
+    }
+
+    component_column::component_column(component_column &&other) noexcept
+        : m_info(other.m_info), m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)),
+          m_capacity(std::exchange(other.m_capacity, 0)) {}
+
+    component_column &component_column::operator=(component_column &&other) noexcept {
+        if (this != &other) {
+            _release();
+            m_info     = other.m_info;
+            m_data     = std::exchange(other.m_data, nullptr);
+            m_size     = std::exchange(other.m_size, 0);
+            m_capacity = std::exchange(other.m_capacity, 0);
+        }
+        return *this;
+    }
+
+    void *component_column::push_uninitialized() {
+        if (m_size == m_capacity) {
+            reserve(m_capacity == 0 ? 16 : m_capacity * 2);
+        }
+        return at(m_size++);
+    }
+
+    void component_column::swap_remove(const size_t row) {
+        assert(row < m_size);
+
+        const size_t last = m_size - 1;
+        m_info->destroy(at(row));
+        if (row != last) {
+            m_info->move_construct(at(row), at(last));
+            m_info->destroy(at(last));
+        }
+        --m_size;
+    }
+
+    void component_column::reserve(const size_t capacity) {
+        if (capacity <= m_capacity)
+            return;
+
+        const auto alignment = std::align_val_t(m_info->alignment);
+        auto      *data      = static_cast<std::byte *>(::operator new(capacity * m_info->size, alignment));
+
+        for (size_t i = 0; i < m_size; ++i) {
+            m_info->move_construct(data + i * m_info->size, at(i));
+            m_info->destroy(at(i));
+        }
+
+        if (m_data)
+            ::operator delete(m_data, alignment);
+
+        m_data     = data;
+        m_capacity = capacity;
+    }
+
+    void component_column::_release() {
+        if (!m_data)
+            return;
+
+        for (size_t i = 0; i < m_size; ++i) {
+            m_info->destroy(at(i));
+        }
+        ::operator delete(m_data, std::align_val_t(m_info->alignment));
+
+        m_data     = nullptr;
+        m_size     = 0;
+        m_capacity = 0;
+    }
+
+    archetype::archetype(const std::vector<const component_info *> &infos) {
+        m_signature.reserve(infos.size());
+        m_columns.reserve(infos.size());
+        for (const auto *info : infos) {
+            m_signature.push_back(info->id);
+            m_columns.emplace_back(*info);
+        }
+    }
+
+    bool archetype::contains(const component_id id) const noexcept {
+        return std::ranges::binary_search(m_signature, id);
+    }
+
+    component_column *archetype::find_column(const component_id id) noexcept {
+        const auto it = std::ranges::lower_bound(m_signature, id);
+        if (it == m_signature.end() || *it != id)
+            return nullptr;
+        return &m_columns[it - m_signature.begin()];
+    }
+
+    component_storage::component_storage() {
+        _get_or_create_archetype({});
+    }
+
+    component_storage::~component_storage() = default;
+
+    entity component_storage::create_entity() {
+        uint32_t index;
+        if (!m_free_indices.empty()) {
+            index = m_free_indices.back();
+            m_free_indices.pop_back();
+        } else {
+            index = static_cast<uint32_t>(m_records.size());
+            m_records.emplace_back();
+        }
+
+        archetype *empty = m_archetypes.front().get();
+
+        entity_record &rec = m_records[index];
+        const entity   e{.index = index, .generation = rec.generation};
+        rec.arch = empty;
+        rec.row  = static_cast<uint32_t>(empty->m_entities.size());
+        empty->m_entities.push_back(e);
+
+        ++m_live_count;
+        return e;
+    }
+
+    void component_storage::destroy_entity(const entity e) {
+        if (!is_alive(e))
+            return;
+
+        entity_record &rec = m_records[e.index];
+        _remove_row(rec.arch, rec.row);
+
+        rec.arch = nullptr;
+        rec.row  = 0;
+        ++rec.generation;
+        m_free_indices.push_back(e.index);
+        --m_live_count;
+    }
+
+    bool component_storage::is_alive(const entity e) const noexcept {
+        return e.index < m_records.size() && m_records[e.index].arch != nullptr &&
+               m_records[e.index].generation == e.generation;
+    }
+
+    component_storage::entity_record &component_storage::_record(const entity e) {
+        if (!is_alive(e)) {
+            throw std::out_of_range("Entity handle is not alive");
+        }
+        return m_records[e.index];
+    }
+
+    archetype *component_storage::_get_or_create_archetype(std::vector<const component_info *> infos) {
+        std::ranges::sort(infos, {}, &component_info::id);
+
+        std::vector<component_id> signature;
+        signature.reserve(infos.size());
+        for (const auto *info : infos) {
+            signature.push_back(info->id);
+        }
+
+        if (const auto it = m_archetype_index.find(signature); it != m_archetype_index.end()) {
+            return it->second;
+        }
+
+        auto *arch = m_archetypes.emplace_back(std::make_unique<archetype>(infos)).get();
+        m_archetype_index.emplace(std::move(signature), arch);
+        return arch;
+    }
+
+    archetype *component_storage::_archetype_with(archetype *source, const component_info &info) {
+        if (const auto it = source->m_add_edges.find(info.id); it != source->m_add_edges.end()) {
+            return it->second;
+        }
+
+        std::vector<const component_info *> infos;
+        infos.reserve(source->m_columns.size() + 1);
+        for (const auto &column : source->m_columns) {
+            infos.push_back(&column.info());
+        }
+        infos.push_back(&info);
+
+        archetype *target                = _get_or_create_archetype(std::move(infos));
+        source->m_add_edges[info.id]     = target;
+        target->m_remove_edges[info.id]  = source;
+        return target;
+    }
+
+    archetype *component_storage::_archetype_without(archetype *source, const component_id id) {
+        if (const auto it = source->m_remove_edges.find(id); it != source->m_remove_edges.end()) {
+            return it->second;
+        }
+
+        std::vector<const component_info *> infos;
+        infos.reserve(source->m_columns.size());
+        for (const auto &column : source->m_columns) {
+            if (column.info().id != id)
+                infos.push_back(&column.info());
+        }
+
+        archetype *target           = _get_or_create_archetype(std::move(infos));
+        source->m_remove_edges[id]  = target;
+        target->m_add_edges[id]     = source;
+        return target;
+    }
+
+    void component_storage::_move_entity(const entity e, archetype *destination) {
+        entity_record &rec    = m_records[e.index];
+        archetype     *source = rec.arch;
+        if (source == destination)
+            return;
+
+        const uint32_t row = rec.row;
+        for (auto &column : source->m_columns) {
+            if (component_column *target = destination->find_column(column.info().id)) {
+                column.info().move_construct(target->push_uninitialized(), column.at(row));
+            }
+        }
+
+        _remove_row(source, row);
+
+        rec.arch = destination;
+        rec.row  = static_cast<uint32_t>(destination->m_entities.size());
+        destination->m_entities.push_back(e);
+    }
+
+    void component_storage::_remove_row(archetype *arch, const uint32_t row) {
+        for (auto &column : arch->m_columns) {
+            column.swap_remove(row);
+        }
+
+        const uint32_t last = static_cast<uint32_t>(arch->m_entities.size() - 1);
+        if (row != last) {
+            const entity moved    = arch->m_entities[last];
+            arch->m_entities[row] = moved;
+            m_records[moved.index].row = row;
+        }
+        arch->m_entities.pop_back();
+    }
+} // namespace engine::scene
@@ -0,0 +1,326 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine::scene {
+
+    using component_id = uint32_t;
+
+    /**
+     * Type-erased description of a component type, used by archetype columns to move and destroy their elements.
+     */
+    struct component_info {
+        component_id id;
+        size_t       size;
+        size_t       alignment;
+
+        void (*move_construct)(void *dst, void *src);
+        void (*destroy)(void *ptr);
+    };
+
+    namespace detail {
+        component_id next_component_id();
+    } // namespace detail
+
+    template <typename T>
+    const component_info &component_info_of() {
+        using type = std::remove_cvref_t<T>;
+        static_assert(std::is_nothrow_move_constructible_v<type>, "components must be nothrow move constructible");
+
+        static const component_info info{
+            .id             = detail::next_component_id(),
+            .size           = sizeof(type),
+            .alignment      = alignof(type),
+            .move_construct = +[](void *dst, void *src) { new (dst) type(std::move(*static_cast<type *>(src))); },
+            .destroy        = +[](void *ptr) { static_cast<type *>(ptr)->~type(); },
+        };
+        return info;
+    }
+
+    template <typename T>
+    component_id component_id_of() {
+        return component_info_of<T>().id;
+    }
+
+    /**
+     * A lightweight handle to an entity in a component_storage. The generation detects handles to destroyed entities.
+     */
+    struct entity {
+        static constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+
+        uint32_t index      = invalid_index;
+        uint32_t generation = 0;
+
+        [[nodiscard]] constexpr bool is_null() const noexcept { return index == invalid_index; }
+
+        constexpr bool operator==(const entity &other) const noexcept = default;
+    };
+
+    /**
+     * A contiguous, type-erased array holding one component type for every entity in an archetype.
+     */
+    class component_column {
+      public:
+        explicit component_column(const component_info &info);
+        ~component_column();
+
+        component_column(const component_column &other)            = delete;
+        component_column &operator=(const component_column &other) = delete;
+        component_column(component_column &&other) noexcept;
+        component_column &operator=(component_column &&other) noexcept;
+
+        [[nodiscard]] inline const component_info &info() const noexcept { return *m_info; }
+        [[nodiscard]] inline size_t                size() const noexcept { return m_size; }
+
+        [[nodiscard]] inline void *at(const size_t row) noexcept { return m_data + row * m_info->size; }
+
+        template <typename T>
+        [[nodiscard]] T *data() noexcept {
+            return std::launder(reinterpret_cast<T *>(m_data));
+        }
+
+        /**
+         * Grows the column by one element and returns a pointer to the uninitialized storage for it. The caller must
+         * construct a component there before the column is used again.
+         */
+        void *push_uninitialized();
+
+        /**
+         * Destroys the element at row and moves the last element into its place.
+         */
+        void swap_remove(size_t row);
+
+        void reserve(size_t capacity);
+
+      private:
+        const component_info *m_info;
+        std::byte            *m_data     = nullptr;
+        size_t                m_size     = 0;
+        size_t                m_capacity = 0;
+
+        void _release();
+    };
+
+    /**
+     * A table of every entity sharing the exact same set of component types. Each component type is stored in its own
+     * column (structure of arrays), so iterating a component touches memory linearly.
+     */
+    class archetype {
+      public:
+        explicit archetype(const std::vector<const component_info *> &infos);
+
+        [[nodiscard]] inline const std::vector<component_id> &signature() const noexcept { return m_signature; }
+        [[nodiscard]] inline const std::vector<entity>       &entities() const noexcept { return m_entities; }
+        [[nodiscard]] inline size_t                           size() const noexcept { return m_entities.size(); }
+
+        [[nodiscard]] bool contains(component_id id) const noexcept;
+
+        /**
+         * @return The column holding the component, or nullptr if the archetype does not contain it.
+         */
+        [[nodiscard]] component_column *find_column(component_id id) noexcept;
+
+        template <typename T>
+        [[nodiscard]] T *column_data() noexcept {
+            component_column *column = find_column(component_id_of<T>());
+            return column ? column->data<T>() : nullptr;
+        }
+
+      private:
+        std::vector<component_id>     m_signature;
+        std::vector<component_column> m_columns;
+        std::vector<entity>           m_entities;
+
+        std::map<component_id, archetype *> m_add_edges;
+        std::map<component_id, archetype *> m_remove_edges;
+
+        friend class component_storage;
+    };
+
+    class component_storage;
+
+    /**
+     * Iterates every entity that has all of Ts. Archetypes are walked one at a time and their columns linearly.
+     */
+    template <typename... Ts>
+    class component_view {
+      public:
+        explicit component_view(component_storage &storage) : m_storage(storage) {}
+
+        /**
+         * Calls f(Ts&...) or f(entity, Ts&...) for every matching entity.
+         */
+        template <typename F>
+        void each(F &&f);
+
+        /**
+         * Calls f(count, const entity *, Ts *...) once per matching archetype, with pointers to the start of each
+         * column. Useful for batched or vectorized updates.
+         */
+        template <typename F>
+        void each_chunk(F &&f);
+
+        [[nodiscard]] size_t count() const;
+
+      private:
+        component_storage &m_storage;
+    };
+
+    /**
+     * Dense entity/component storage. This lives alongside the scene_object hierarchy as an opt-in storage layer for
+     * hot simulation data.
+     */
+    class component_storage {
+      public:
+        component_storage();
+        ~component_storage();
+
+        component_storage(const component_storage &other)                = delete;
+        component_storage(component_storage &&other) noexcept            = delete;
+        component_storage &operator=(const component_storage &other)     = delete;
+        component_storage &operator=(component_storage &&other) noexcept = delete;
+
+        entity create_entity();
+
+        template <typename... Ts>
+        entity create_entity(Ts &&...components) {
+            const entity e = create_entity();
+            (emplace_component<std::remove_cvref_t<Ts>>(e, std::forward<Ts>(components)), ...);
+            return e;
+        }
+
+        void destroy_entity(entity e);
+
+        [[nodiscard]] bool is_alive(entity e) const noexcept;
+
+        [[nodiscard]] inline size_t entity_count() const noexcept { return m_live_count; }
+
+        /**
+         * Constructs a component of type T on the entity, replacing any existing one.
+         */
+        template <typename T, typename... Args>
+        T &emplace_component(const entity e, Args &&...args) {
+            const component_info &info = component_info_of<T>();
+            entity_record        &rec  = _record(e);
+
+            if (component_column *column = rec.arch->find_column(info.id)) {
+                T *ptr = static_cast<T *>(column->at(rec.row));
+                *ptr   = T(std::forward<Args>(args)...);
+                return *ptr;
+            }
+
+            T value(std::forward<Args>(args)...);
+            _move_entity(e, _archetype_with(rec.arch, info));
+
+            void *slot = rec.arch->find_column(info.id)->push_uninitialized();
+            return *new (slot) T(std::move(value));
+        }
+
+        template <typename T>
+        void remove_component(const entity e) {
+            const entity_record &rec = _record(e);
+            const component_id   id  = component_id_of<T>();
+            if (rec.arch->contains(id)) {
+                _move_entity(e, _archetype_without(rec.arch, id));
+            }
+        }
+
+        template <typename T>
+        [[nodiscard]] T *get_component(const entity e) {
+            if (!is_alive(e))
+                return nullptr;
+
+            const entity_record &rec    = m_records[e.index];
+            component_column    *column = rec.arch->find_column(component_id_of<T>());
+            return column ? static_cast<T *>(column->at(rec.row)) : nullptr;
+        }
+
+        template <typename T>
+        [[nodiscard]] bool has_component(const entity e) const {
+            return is_alive(e) && m_records[e.index].arch->contains(component_id_of<T>());
+        }
+
+        template <typename... Ts>
+        [[nodiscard]] component_view<Ts...> view() {
+            return component_view<Ts...>(*this);
+        }
+
+        [[nodiscard]] inline const std::vector<std::unique_ptr<archetype>> &archetypes() const noexcept {
+            return m_archetypes;
+        }
+
+      private:
+        struct entity_record {
+            archetype *arch       = nullptr;
+            uint32_t   row        = 0;
+            uint32_t   generation = 1;
+        };
+
+        std::vector<entity_record> m_records;
+        std::vector<uint32_t>      m_free_indices;
+        size_t                     m_live_count = 0;
+
+        std::vector<std::unique_ptr<archetype>>           m_archetypes;
+        std::map<std::vector<component_id>, archetype *> m_archetype_index;
+
+        entity_record &_record(entity e);
+
+        archetype *_get_or_create_archetype(std::vector<const component_info *> infos);
+        archetype *_archetype_with(archetype *source, const component_info &info);
+        archetype *_archetype_without(archetype *source, component_id id);
+
+        /**
+         * Moves an entity's row into another archetype. Components missing from the destination are destroyed, and
+         * columns the source does not have are left for the caller to push.
+         */
+        void _move_entity(entity e, archetype *destination);
+        void _remove_row(archetype *arch, uint32_t row);
+    };
+
+    template <typename... Ts>
+    template <typename F>
+    void component_view<Ts...>::each(F &&f) {
+        each_chunk([&f](const size_t count, const entity *entities, Ts *...columns) {
+            for (size_t i = 0; i < count; ++i) {
+                if constexpr (std::is_invocable_v<F &, entity, Ts &...>) {
+                    f(entities[i], columns[i]...);
+                } else {
+                    f(columns[i]...);
+                }
+            }
+        });
+    }
+
+    template <typename... Ts>
+    template <typename F>
+    void component_view<Ts...>::each_chunk(F &&f) {
+        for (const auto &arch : m_storage.archetypes()) {
+            if (arch->size() == 0 || !(arch->contains(component_id_of<Ts>()) && ...))
+                continue;
+
+            f(arch->size(), arch->entities().data(), arch->template column_data<Ts>()...);
+        }
+    }
+
+    template <typename... Ts>
+    size_t component_view<Ts...>::count() const {
+        size_t total = 0;
+        for (const auto &arch : m_storage.archetypes()) {
+            if ((arch->contains(component_id_of<Ts>()) && ...))
+                total += arch->size();
+        }
+        return total;
+    }
+} // namespace engine::scene
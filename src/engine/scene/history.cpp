@@ -0,0 +1,635 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "history.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace engine::scene {
+    /*
+     * Layout of scene_delta::changes, little-endian like snapshots:
+     *
+     *   uint32_t version
+     *   uint32_t count, uint64_t[]                 ids of destroyed objects
+     *   uint32_t count, object changes             created or changed objects: uint64_t id, uint8_t fields, then each
+     *                                              field present, in the order of the field bits below
+     *   uint32_t count, group changes              string phase, uint32_t group index, uint32_t run count, then per
+     *                                              run uint8_t typed and uint32_t count, uint64_t[] ids
+     *   uint32_t slot count, uint32_t keep,        the id allocator: its slot count and the free list, whose first
+     *   uint32_t count, uint32_t[]                 keep entries are unchanged
+     *   uint32_t count, uint32_t[2][]              slot index and generation of dirty slots that end up free
+     *
+     * A delta is applied in that order: destroys, then creates, then field changes (parents last), then groups and
+     * the allocator.
+     */
+    static constexpr uint32_t delta_version = 1;
+
+    static constexpr uint8_t field_created     = 1 << 0; // string type name
+    static constexpr uint8_t field_parent      = 1 << 1; // uint64_t id, or 0
+    static constexpr uint8_t field_transform   = 1 << 2; // glm::mat4
+    static constexpr uint8_t field_name        = 1 << 3; // string
+    static constexpr uint8_t field_state       = 1 << 4; // uint32_t size, bytes
+    static constexpr uint8_t field_state_patch = 1 << 5; // uint32_t size, uint32_t count, then byte_run and bytes each
+
+    // changed ranges closer together than this are merged, since each range costs a byte_run
+    static constexpr uint32_t patch_merge_gap = sizeof(uint64_t);
+
+    struct byte_run {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    template <typename T>
+    static void write_array(snapshot_writer &out, const std::span<const T> values) {
+        out.write(static_cast<uint32_t>(values.size()));
+        out.write_bytes(std::as_bytes(values));
+    }
+
+    template <typename T>
+    static std::vector<T> read_array(snapshot_reader &in) {
+        const auto     count = in.read<uint32_t>();
+        const auto     bytes = in.read_bytes(static_cast<size_t>(count) * sizeof(T));
+        std::vector<T> values(count);
+        if (count != 0)
+            std::memcpy(values.data(), bytes.data(), bytes.size());
+        return values;
+    }
+
+    // one direction of a delta, collected in sections that finish() joins
+    struct delta_builder {
+        std::vector<uint64_t>  destroyed;
+        std::vector<std::byte> objects;
+        uint32_t               object_count = 0;
+        std::vector<std::byte> groups;
+        uint32_t               group_count = 0;
+
+        uint32_t                                   slot_count = 0;
+        uint32_t                                   keep       = 0;
+        std::vector<uint32_t>                      free_tail;
+        std::vector<std::pair<uint32_t, uint32_t>> generations;
+
+        void finish(std::vector<std::byte> &out) const {
+            snapshot_writer w(out);
+            w.write(delta_version);
+            write_array<uint64_t>(w, destroyed);
+            w.write(object_count);
+            w.write_bytes(objects);
+            w.write(group_count);
+            w.write_bytes(groups);
+            w.write(slot_count);
+            w.write(keep);
+            write_array<uint32_t>(w, free_tail);
+            w.write(static_cast<uint32_t>(generations.size()));
+            for (const auto &[index, generation] : generations) {
+                w.write(index);
+                w.write(generation);
+            }
+        }
+    };
+
+    static const snapshot_types::object_type &type_of(const scene_object &object) {
+        const auto *type = snapshot_types::get().find_object_type(typeid(object));
+        if (!type) {
+            throw std::logic_error(std::string("Scene object type ") + typeid(object).name() +
+                                   " is not registered with snapshot_types");
+        }
+        return *type;
+    }
+
+    static uint8_t created_fields(const auto &image) {
+        uint8_t fields = field_created | field_transform | field_state;
+        if (image.parent != 0)
+            fields |= field_parent;
+        if (!image.name.empty())
+            fields |= field_name;
+        return fields;
+    }
+
+    static void write_object(delta_builder &out, const uint64_t id, const uint8_t fields, const auto &image,
+                             const std::span<const byte_run> runs = {}) {
+        snapshot_writer w(out.objects);
+        w.write(id);
+        w.write(fields);
+        if (fields & field_created)
+            w.write_string(image.type->name.str());
+        if (fields & field_parent)
+            w.write(image.parent);
+        if (fields & field_transform)
+            w.write(image.local);
+        if (fields & field_name)
+            w.write_string(image.name.str());
+        if (fields & field_state) {
+            w.write(static_cast<uint32_t>(image.state.size()));
+            w.write_bytes(image.state);
+        }
+        if (fields & field_state_patch) {
+            w.write(static_cast<uint32_t>(image.state.size()));
+            w.write(static_cast<uint32_t>(runs.size()));
+            for (const byte_run &run : runs) {
+                w.write(run);
+                w.write_bytes(std::span(image.state).subspan(run.offset, run.size));
+            }
+        }
+        ++out.object_count;
+    }
+
+    static void write_group(delta_builder &out, const std::string_view phase, const uint32_t index, const auto &runs) {
+        snapshot_writer w(out.groups);
+        w.write_string(phase);
+        w.write(index);
+        w.write(static_cast<uint32_t>(runs.size()));
+        for (const auto &run : runs) {
+            w.write(static_cast<uint8_t>(run.typed));
+            write_array<uint64_t>(w, run.ids);
+        }
+        ++out.group_count;
+    }
+
+    /**
+     * Finds the ranges where two states of the same size differ.
+     *
+     * @return The size of the patch made of those ranges
+     */
+    static size_t diff_state(const std::span<const std::byte> before, const std::span<const std::byte> after,
+                             std::vector<byte_run> &runs) {
+        runs.clear();
+        size_t patch_size = 2 * sizeof(uint32_t);
+
+        const size_t size = before.size();
+        for (size_t i = 0; i < size;) {
+            if (before[i] == after[i]) {
+                ++i;
+                continue;
+            }
+
+            size_t end = i + 1;
+            for (size_t j = end; j < size && j - end < patch_merge_gap; ++j) {
+                if (before[j] != after[j])
+                    end = j + 1;
+            }
+
+            runs.push_back(byte_run{.offset = static_cast<uint32_t>(i), .size = static_cast<uint32_t>(end - i)});
+            patch_size += sizeof(byte_run) + (end - i);
+            i = end;
+        }
+        return patch_size;
+    }
+
+    scene_history::scene_history(std::shared_ptr<scene> scene, const settings settings)
+        : m_scene(std::move(scene)), m_settings(settings) {
+        if (m_scene->m_track_changes) {
+            throw std::logic_error("The scene is already being recorded by another history");
+        }
+        m_settings.max_frames = std::max<size_t>(m_settings.max_frames, 1);
+
+        const auto &slots = m_scene->m_objects;
+        m_objects.resize(slots.slot_count());
+        for (const auto &object : m_scene->get_scene_objects()) {
+            object_image &image = m_objects[slot_handle::from_id(object->get_id()).index];
+            _read_object(*object, image);
+            image.type = &type_of(*object);
+        }
+
+        for (const auto &phase : m_scene->m_phases.phases()) {
+            for (const auto &group : phase->update_groups()) {
+                m_groups[group.get()] = group_image{.version = group->on_update.version(), .runs = _read_group(*group)};
+            }
+        }
+
+        m_free.assign(slots.free_slots().begin(), slots.free_slots().end());
+        m_slot_count = slots.slot_count();
+        m_scene->m_objects.reset_free_low_water();
+
+        (void)m_scene->_take_dirty();
+        m_scene->m_track_changes = true;
+    }
+
+    scene_history::~scene_history() {
+        m_scene->m_track_changes = false;
+        (void)m_scene->_take_dirty();
+    }
+
+    const scene_delta &scene_history::capture(const double step, const std::span<const std::byte> input) {
+        frame_record record;
+        record.delta.frame = m_frame + 1;
+        record.delta.step  = step;
+        record.delta.input.assign(input.begin(), input.end());
+        _diff(record.delta.changes, record.undo);
+
+        m_frame = record.delta.frame;
+        m_frames.push_back(std::move(record));
+        while (m_frames.size() > m_settings.max_frames) {
+            m_frames.pop_front();
+        }
+        return m_frames.back().delta;
+    }
+
+    void scene_history::restore(const uint64_t frame) {
+        if (frame < oldest_frame() || frame > m_frame) {
+            throw std::out_of_range("Frame " + std::to_string(frame) + " is not in the scene history");
+        }
+
+        // changes since the last capture are undone first, like a frame of their own
+        std::vector<std::byte> forward;
+        std::vector<std::byte> backward;
+        _diff(forward, backward);
+        _apply(backward);
+
+        while (!m_frames.empty() && m_frames.back().delta.frame > frame) {
+            _apply(m_frames.back().undo);
+            m_frames.pop_back();
+        }
+
+        // brings the copy in line with the restored scene; the result is the inverse of what was undone
+        forward.clear();
+        backward.clear();
+        _diff(forward, backward);
+        m_frame = frame;
+    }
+
+    const scene_delta &scene_history::apply(const scene_delta &delta) {
+        _apply(delta.changes);
+        return capture(delta.step, delta.input);
+    }
+
+    std::optional<uint64_t> scene_history::replay(const std::span<const scene_delta> frames,
+                                                  const input_callback &apply_input) {
+        std::optional<uint64_t> diverged;
+        for (const scene_delta &expected : frames) {
+            if (apply_input)
+                apply_input(expected.input);
+            m_scene->update(expected.step);
+
+            const scene_delta &actual = capture(expected.step, expected.input);
+            if (!diverged && actual.changes != expected.changes)
+                diverged = expected.frame;
+        }
+        return diverged;
+    }
+
+    std::optional<uint64_t> scene_history::replay_from(const uint64_t frame, const input_callback &apply_input) {
+        std::vector<scene_delta> recorded;
+        for (const frame_record &record : m_frames) {
+            if (record.delta.frame > frame)
+                recorded.push_back(record.delta);
+        }
+
+        restore(frame);
+        return replay(recorded, apply_input);
+    }
+
+    const scene_delta *scene_history::find(const uint64_t frame) const {
+        if (m_frames.empty() || frame < m_frames.front().delta.frame || frame > m_frame)
+            return nullptr;
+        return &m_frames[frame - m_frames.front().delta.frame].delta;
+    }
+
+    void scene_history::_read_object(const scene_object &object, object_image &image) const {
+        image.id = object.get_id();
+
+        const auto parent = object.get_parent();
+        image.parent      = parent && m_scene->get_scene_object(parent->get_id()) == parent ? parent->get_id() : 0;
+        image.name        = object.m_name;
+        image.local       = object.m_transform.is_null() ? glm::mat4(1.0f)
+                                                         : m_scene->transforms().get_local(object.m_transform);
+
+        image.state.clear();
+        snapshot_writer out(image.state);
+        object.save_state(out);
+    }
+
+    std::vector<scene_history::run_image> scene_history::_read_group(const update_group &group) {
+        std::vector<run_image> runs;
+        for (const auto &run : group.on_update.runs()) {
+            if (run.objects.empty())
+                continue;
+
+            run_image &image = runs.emplace_back(run_image{.typed = run.batch != nullptr, .ids = {}});
+            image.ids.reserve(run.objects.size());
+            for (const auto &object : run.objects) {
+                image.ids.push_back(object->get_id());
+            }
+        }
+        return runs;
+    }
+
+    void scene_history::_diff(std::vector<std::byte> &forward, std::vector<std::byte> &backward) {
+        scene        &scene = *m_scene;
+        delta_builder fwd;
+        delta_builder back;
+
+        // dirty ids become a bit per slot, so slots are visited once each and in index order whatever thread marked
+        // them; slots that were free keep the oldest generation marked there, which is put back on restore
+        auto &slots = scene.m_objects;
+
+        struct free_slot {
+            uint32_t index;
+            uint32_t generation;
+        };
+        std::vector<free_slot> were_free;
+        for (const uint64_t id : scene._take_dirty()) {
+            const slot_handle h = slot_handle::from_id(id);
+            if (h.index / 64 >= m_dirty_slots.size())
+                m_dirty_slots.resize(h.index / 64 + 1);
+            m_dirty_slots[h.index / 64] |= uint64_t(1) << (h.index % 64);
+            if (h.index >= m_objects.size() || m_objects[h.index].id == 0)
+                were_free.push_back(free_slot{.index = h.index, .generation = h.generation});
+        }
+        std::ranges::sort(were_free, [](const free_slot &a, const free_slot &b) {
+            return a.index != b.index ? a.index < b.index : a.generation < b.generation;
+        });
+        const auto repeated = std::ranges::unique(were_free, {}, &free_slot::index);
+        were_free.erase(repeated.begin(), repeated.end());
+
+        if (slots.slot_count() > m_objects.size())
+            m_objects.resize(slots.slot_count());
+
+        std::vector<byte_run> runs;
+        for (size_t word = 0; word < m_dirty_slots.size(); ++word) {
+            for (uint64_t bits = std::exchange(m_dirty_slots[word], 0); bits != 0; bits &= bits - 1) {
+                const auto slot = static_cast<uint32_t>(word * 64 + std::countr_zero(bits));
+                if (slot >= m_objects.size())
+                    continue;
+
+                object_image &image = m_objects[slot];
+                const auto   *found =
+                    slots.occupied(slot) ? slots.get(slot_handle{.index = slot, .generation = slots.generation(slot)})
+                                         : nullptr;
+                const scene_object *object = found ? found->get() : nullptr;
+
+                if (image.id != 0 && (!object || object->get_id() != image.id)) {
+                    fwd.destroyed.push_back(image.id);
+                    write_object(back, image.id, created_fields(image), image);
+                    image.id = 0;
+                }
+                if (!object)
+                    continue;
+
+                if (image.id == 0) {
+                    _read_object(*object, image);
+                    image.type = &type_of(*object);
+                    write_object(fwd, image.id, created_fields(image), image);
+                    back.destroyed.push_back(image.id);
+                    continue;
+                }
+
+                _read_object(*object, m_scratch);
+                m_scratch.type = image.type;
+
+                uint8_t fields = 0;
+                if (m_scratch.parent != image.parent)
+                    fields |= field_parent;
+                if (std::memcmp(&m_scratch.local, &image.local, sizeof(glm::mat4)) != 0)
+                    fields |= field_transform;
+                if (m_scratch.name != image.name)
+                    fields |= field_name;
+                if (m_scratch.state.size() != image.state.size()) {
+                    fields |= field_state;
+                } else if (!image.state.empty() &&
+                           std::memcmp(m_scratch.state.data(), image.state.data(), image.state.size()) != 0) {
+                    const size_t patch_size = diff_state(image.state, m_scratch.state, runs);
+                    fields |= patch_size < sizeof(uint32_t) + image.state.size() ? field_state_patch : field_state;
+                }
+
+                if (fields == 0)
+                    continue;
+
+                write_object(fwd, image.id, fields, m_scratch, runs);
+                write_object(back, image.id, fields, image, runs);
+                std::swap(image, m_scratch);
+            }
+        }
+
+        for (const auto &phase : scene.m_phases.phases()) {
+            uint32_t index = 0;
+            for (const auto &group : phase->update_groups()) {
+                group_image &image = m_groups[group.get()];
+                if (const uint64_t version = group->on_update.version(); version != image.version) {
+                    auto current = _read_group(*group);
+                    if (current != image.runs) {
+                        write_group(fwd, phase->get_name(), index, current);
+                        write_group(back, phase->get_name(), index, image.runs);
+                        image.runs = std::move(current);
+                    }
+                    image.version = version;
+                }
+                ++index;
+            }
+        }
+
+        // the free list only changed above its low-water mark, so only that part is stored
+        const auto   free = slots.free_slots();
+        const size_t keep = std::min({slots.free_low_water(), m_free.size(), free.size()});
+
+        fwd.slot_count = static_cast<uint32_t>(slots.slot_count());
+        fwd.keep       = static_cast<uint32_t>(keep);
+        fwd.free_tail.assign(free.begin() + static_cast<ptrdiff_t>(keep), free.end());
+
+        back.slot_count = static_cast<uint32_t>(m_slot_count);
+        back.keep       = static_cast<uint32_t>(keep);
+        back.free_tail.assign(m_free.begin() + static_cast<ptrdiff_t>(keep), m_free.end());
+
+        m_free.resize(keep);
+        m_free.insert(m_free.end(), fwd.free_tail.begin(), fwd.free_tail.end());
+        m_slot_count = slots.slot_count();
+        slots.reset_free_low_water();
+
+        for (const uint64_t id : fwd.destroyed) {
+            const uint32_t slot = slot_handle::from_id(id).index;
+            if (slot < fwd.slot_count && !slots.occupied(slot))
+                fwd.generations.emplace_back(slot, slots.generation(slot));
+        }
+        for (const free_slot &slot : were_free) {
+            if (slot.index < fwd.slot_count && !slots.occupied(slot.index))
+                fwd.generations.emplace_back(slot.index, slots.generation(slot.index));
+            if (slot.index < back.slot_count)
+                back.generations.emplace_back(slot.index, slot.generation);
+        }
+
+        fwd.finish(forward);
+        back.finish(backward);
+    }
+
+    void scene_history::_apply(const std::span<const std::byte> changes) {
+        scene          &scene = *m_scene;
+        snapshot_reader in(changes, delta_version);
+        if (in.read<uint32_t>() != delta_version) {
+            throw std::runtime_error("Unsupported scene delta version");
+        }
+
+        scene.remove_objects(read_array<uint64_t>(in));
+
+        // parents are linked once every object exists, and objects being reparented are moved to the root first, so no
+        // intermediate hierarchy can contain a cycle
+        std::vector<std::pair<std::shared_ptr<scene_object>, uint64_t>> parents;
+
+        const auto object_count = in.read<uint32_t>();
+        for (uint32_t i = 0; i < object_count; ++i) {
+            const auto id     = in.read<uint64_t>();
+            const auto fields = in.read<uint8_t>();
+
+            std::shared_ptr<scene_object>      object;
+            const snapshot_types::object_type *type = nullptr;
+            if (fields & field_created) {
+                const std::string_view type_name = in.read_string();
+                type                             = snapshot_types::get().find_object_type(hashed_name(type_name));
+                if (!type) {
+                    throw std::runtime_error("Scene delta uses unregistered object type " + std::string(type_name));
+                }
+                object = type->create_at(scene, id);
+            } else {
+                object = scene.get_scene_object(id);
+                if (!object) {
+                    throw std::runtime_error("Scene delta changes an object the scene does not have");
+                }
+            }
+            scene._mark_dirty(id);
+
+            if (fields & field_parent) {
+                object->set_parent(nullptr);
+                parents.emplace_back(object, in.read<uint64_t>());
+            }
+            if (fields & field_transform)
+                object->set_local_transform(in.read<glm::mat4>());
+            if (fields & field_name)
+                scene.rename_object(id, hashed_name(in.read_string()));
+
+            if (fields & (field_state | field_state_patch)) {
+                if (!type)
+                    type = &type_of(*object);
+
+                if (fields & field_state) {
+                    const auto      size = in.read<uint32_t>();
+                    snapshot_reader state(in.read_bytes(size), type->version);
+                    object->load_state(state);
+                } else {
+                    m_scratch.state.clear();
+                    snapshot_writer current(m_scratch.state);
+                    object->save_state(current);
+
+                    const auto size = in.read<uint32_t>();
+                    if (size != m_scratch.state.size()) {
+                        throw std::runtime_error("Scene delta patches object state of a different size");
+                    }
+                    const auto run_count = in.read<uint32_t>();
+                    for (uint32_t r = 0; r < run_count; ++r) {
+                        const auto run = in.read<byte_run>();
+                        if (run.offset > size || run.size > size - run.offset) {
+                            throw std::runtime_error("Scene delta patch is out of bounds");
+                        }
+                        std::memcpy(m_scratch.state.data() + run.offset, in.read_bytes(run.size).data(), run.size);
+                    }
+
+                    snapshot_reader state(m_scratch.state, type->version);
+                    object->load_state(state);
+                }
+            }
+        }
+
+        for (const auto &[object, parent_id] : parents) {
+            if (parent_id == 0)
+                continue;
+            const auto parent = scene.get_scene_object(parent_id);
+            if (!parent) {
+                throw std::runtime_error("Scene delta parents an object to one the scene does not have");
+            }
+            object->set_parent(parent);
+        }
+
+        const auto group_count = in.read<uint32_t>();
+        for (uint32_t i = 0; i < group_count; ++i) {
+            const std::string_view phase_name = in.read_string();
+            const auto             index      = in.read<uint32_t>();
+            const auto             phase      = scene.get_phase(phase_name);
+            if (!phase || index >= phase->update_groups().size()) {
+                throw std::runtime_error("Scene delta refers to an unknown update group in phase " +
+                                         std::string(phase_name));
+            }
+
+            update_group &group = **std::next(phase->update_groups().begin(), index);
+            group.on_update.clear();
+
+            const auto run_count = in.read<uint32_t>();
+            for (uint32_t r = 0; r < run_count; ++r) {
+                const bool typed = in.read<uint8_t>() != 0;
+
+                const snapshot_types::object_type *type = nullptr;
+                for (const uint64_t id : read_array<uint64_t>(in)) {
+                    const auto object = scene.get_scene_object(id);
+                    if (!object)
+                        continue;
+
+                    // a run holds one type, so it is looked up once
+                    if (typed && !type)
+                        type = snapshot_types::get().find_object_type(typeid(*object));
+                    if (type) {
+                        type->insert_into_group(group, object);
+                    } else {
+                        group.insert(object);
+                    }
+                }
+            }
+        }
+
+        auto      &slots      = scene.m_objects;
+        const auto slot_count = in.read<uint32_t>();
+        const auto keep       = in.read<uint32_t>();
+        slots.restore_free_slots(slot_count, keep, read_array<uint32_t>(in));
+
+        const auto generation_count = in.read<uint32_t>();
+        for (uint32_t i = 0; i < generation_count; ++i) {
+            const auto index      = in.read<uint32_t>();
+            const auto generation = in.read<uint32_t>();
+            if (index >= slots.slot_count() || slots.occupied(index) || generation == 0) {
+                throw std::runtime_error("Scene delta sets the generation of an invalid slot");
+            }
+
+            scene._mark_dirty(slot_handle{.index = index, .generation = slots.generation(index)}.to_id());
+            slots.set_generation(index, generation);
+        }
+    }
+
+    // the fixed part of a journal record, followed by the input and the changes
+    struct delta_record_header {
+        uint64_t frame;
+        double   step;
+        uint64_t input_size;
+        uint64_t changes_size;
+    };
+
+    void write_delta(std::ostream &out, const scene_delta &delta) {
+        const delta_record_header header{
+            .frame        = delta.frame,
+            .step         = delta.step,
+            .input_size   = delta.input.size(),
+            .changes_size = delta.changes.size(),
+        };
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(delta.input.data()), static_cast<std::streamsize>(delta.input.size()));
+        out.write(reinterpret_cast<const char *>(delta.changes.data()),
+                  static_cast<std::streamsize>(delta.changes.size()));
+    }
+
+    std::optional<scene_delta> read_delta(std::istream &in) {
+        delta_record_header header{};
+        if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+            return std::nullopt;
+
+        scene_delta delta{
+            .frame   = header.frame,
+            .step    = header.step,
+            .input   = std::vector<std::byte>(header.input_size),
+            .changes = std::vector<std::byte>(header.changes_size),
+        };
+        if (!in.read(reinterpret_cast<char *>(delta.input.data()), static_cast<std::streamsize>(header.input_size)) ||
+            !in.read(reinterpret_cast<char *>(delta.changes.data()), static_cast<std::streamsize>(header.changes_size))) {
+            return std::nullopt;
+        }
+        return delta;
+    }
+} // namespace engine::scene
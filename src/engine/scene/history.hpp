@@ -0,0 +1,196 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "scene.hpp"
+#include "snapshot.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace engine::scene {
+
+    /**
+     * The changes that take a scene from one frame to the next, as captured by scene_history, along with what is needed
+     * to simulate the frame again.
+     */
+    struct scene_delta {
+        uint64_t               frame = 0;
+        double                 step  = 0.0; // the delta scene::update ran with
+        std::vector<std::byte> input;       // whatever the game recorded for the frame
+        std::vector<std::byte> changes;
+    };
+
+    /**
+     * Appends a delta to a stream, e.g. a journal of every frame since a history started recording an empty scene.
+     */
+    void write_delta(std::ostream &out, const scene_delta &delta);
+
+    /**
+     * @return The next delta in the stream, or nullopt at the end of it (including a truncated last record).
+     */
+    std::optional<scene_delta> read_delta(std::istream &in);
+
+    /**
+     * Records a scene frame by frame as compact deltas, so it can be rolled back to an earlier frame, simulated again
+     * from there, or rebuilt elsewhere.
+     *
+     * The history keeps a copy of what a snapshot would hold for every object (type, name, parent, local transform and
+     * the output of save_state) and of update group membership. capture() compares only the objects marked dirty since
+     * the last capture against that copy, and stores what changed together with its inverse. Objects are marked when
+     * they are created, destroyed, renamed, reparented or moved through set_local_transform; other changes to what
+     * save_state writes must be reported with scene_object::mark_dirty(). State that changed by the same number of
+     * bytes is stored as the byte ranges that differ.
+     *
+     * Ids are kept: restoring brings destroyed objects back under their old ids and puts the scene's id allocator back
+     * as it was, so simulating again from a restored frame hands out the same ids. Objects brought back are new
+     * instances, and as with snapshots, component storage is not recorded. Children brought back to a parent are added
+     * after its other children.
+     *
+     * Every object type must be registered with snapshot_types. Only one history may record a scene at a time, and none
+     * of its functions may be called during an update.
+     */
+    class scene_history {
+      public:
+        struct settings {
+            // frames kept for restore and replay; the oldest is dropped once there are more
+            size_t max_frames = 600;
+        };
+
+        using input_callback = std::function<void(std::span<const std::byte> input)>;
+
+        /**
+         * Starts recording the scene as it is now, which becomes frame 0.
+         *
+         * @throws std::logic_error if another history records the scene, or an object's type is not registered
+         */
+        scene_history(std::shared_ptr<scene> scene, settings settings);
+        ~scene_history();
+
+        scene_history(const scene_history &other)                = delete;
+        scene_history(scene_history &&other) noexcept            = delete;
+        scene_history &operator=(const scene_history &other)     = delete;
+        scene_history &operator=(scene_history &&other) noexcept = delete;
+
+        /**
+         * Records everything that changed since the last capture as the next frame. Call it once per frame, after
+         * scene::update, passing the delta and the input the update used if the frame should be replayable.
+         *
+         * @return The frame's delta, valid until the next capture, restore or apply
+         */
+        const scene_delta &capture(double step = 0.0, std::span<const std::byte> input = {});
+
+        /**
+         * Puts the scene back as it was when the frame was captured, including any changes made since the last capture,
+         * and forgets every later frame.
+         *
+         * @throws std::out_of_range if the frame is older than oldest_frame() or newer than frame()
+         */
+        void restore(uint64_t frame);
+
+        /**
+         * Brings the scene forward by a delta captured elsewhere, then captures it as the next frame. The scene must be
+         * in the state the delta was captured from; a history started on an empty scene records everything, so its
+         * deltas rebuild the same scene, ids included, when applied in order to another empty scene with the same phases
+         * and update groups.
+         *
+         * @throws std::runtime_error if the delta is malformed or refers to a type, phase or group the scene lacks
+         */
+        const scene_delta &apply(const scene_delta &delta);
+
+        /**
+         * Simulates recorded frames again from the current state: for each frame, hands its input to apply_input (if
+         * set), runs scene::update with its step, and captures. Passing the frames recorded after the current one
+         * checks that the simulation is deterministic.
+         *
+         * @return The first frame whose changes differ from the recording, or nullopt if every frame matched
+         */
+        std::optional<uint64_t> replay(std::span<const scene_delta> frames, const input_callback &apply_input);
+
+        /**
+         * Restores a frame, then replays every frame recorded after it. With a different apply_input this re-simulates
+         * from a past frame with corrected input, as rollback networking does.
+         */
+        std::optional<uint64_t> replay_from(uint64_t frame, const input_callback &apply_input);
+
+        /**
+         * @return The last captured frame
+         */
+        [[nodiscard]] inline uint64_t frame() const noexcept { return m_frame; }
+
+        /**
+         * @return The oldest frame restore can reach
+         */
+        [[nodiscard]] inline uint64_t oldest_frame() const noexcept {
+            return m_frames.empty() ? m_frame : m_frames.front().delta.frame - 1;
+        }
+
+        /**
+         * @return The delta that produced the frame, if it is still kept
+         */
+        [[nodiscard]] const scene_delta *find(uint64_t frame) const;
+
+      private:
+        struct object_image {
+            uint64_t                           id   = 0; // 0 while the slot holds nothing
+            const snapshot_types::object_type *type = nullptr;
+            uint64_t                           parent = 0;
+            name_id                            name;
+            glm::mat4                          local{1.0f};
+            std::vector<std::byte>             state;
+        };
+
+        struct run_image {
+            bool                  typed; // inserted with its concrete type, so it runs through a batch function
+            std::vector<uint64_t> ids;
+
+            bool operator==(const run_image &other) const = default;
+        };
+
+        struct group_image {
+            uint64_t               version = 0;
+            std::vector<run_image> runs;
+        };
+
+        struct frame_record {
+            scene_delta            delta;
+            std::vector<std::byte> undo;
+        };
+
+        std::shared_ptr<scene> m_scene;
+        settings               m_settings;
+
+        uint64_t                 m_frame = 0;
+        std::deque<frame_record> m_frames;
+
+        // the scene as of the last capture
+        std::vector<object_image>                             m_objects; // by slot index
+        std::unordered_map<const update_group *, group_image> m_groups;
+        std::vector<uint32_t>                                 m_free;
+        size_t                                                m_slot_count = 0;
+
+        std::vector<uint64_t> m_dirty_slots; // a bit per slot, only set during _diff
+        object_image          m_scratch;
+
+        void _read_object(const scene_object &object, object_image &image) const;
+
+        [[nodiscard]] static std::vector<run_image> _read_group(const update_group &group);
+
+        // compares the dirty objects and changed groups against the copy, writes both directions and updates the copy
+        void _diff(std::vector<std::byte> &forward, std::vector<std::byte> &backward);
+
+        // makes the changes in the scene, marking everything it touches so the next _diff picks them up
+        void _apply(std::span<const std::byte> changes);
+    };
+
+} // namespace engine::scene
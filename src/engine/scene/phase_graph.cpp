@@ -0,0 +1,365 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "phase_graph.hpp"
+
+#include "engine/jobs.hpp"
+#include "engine/profiler.hpp"
+#include "scene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <queue>
+#include <stdexcept>
+
+namespace engine::scene {
+    using clock = std::chrono::steady_clock;
+
+    static double seconds_since(const clock::time_point origin) {
+        return std::chrono::duration<double>(clock::now() - origin).count();
+    }
+
+    template <typename T>
+    static bool contains(const std::vector<T> &values, const T &value) {
+        return std::ranges::find(values, value) != values.end();
+    }
+
+    static bool intersects(const std::vector<std::string> &a, const std::vector<std::string> &b) {
+        return std::ranges::any_of(a, [&](const std::string &name) { return contains(b, name); });
+    }
+
+    phase::phase(phase_desc desc, const phase_id id)
+        : m_desc(std::move(desc)), m_id(id), m_profile_name(name_id::intern(std::string_view(m_desc.name))) {}
+
+    std::shared_ptr<update_group> phase::push_end_new_update_group() {
+        const auto it          = m_update_groups.emplace_back(std::make_shared<update_group>());
+        m_update_group_map[it] = --m_update_groups.end();
+        return it;
+    }
+
+    std::shared_ptr<update_group> phase::push_front_new_update_group() {
+        const auto it          = m_update_groups.emplace_front(std::make_shared<update_group>());
+        m_update_group_map[it] = m_update_groups.begin();
+        return it;
+    }
+
+    std::shared_ptr<update_group> phase::push_new_update_group_after(const std::shared_ptr<update_group> &group) {
+        const auto after        = std::next(m_update_group_map.at(group));
+        const auto it           = m_update_groups.emplace(after, std::make_shared<update_group>());
+        m_update_group_map[*it] = it;
+        return *it;
+    }
+
+    std::shared_ptr<update_group> phase::push_new_update_group_before(const std::shared_ptr<update_group> &group) {
+        const auto before       = m_update_group_map.at(group);
+        const auto it           = m_update_groups.emplace(before, std::make_shared<update_group>());
+        m_update_group_map[*it] = it;
+        return *it;
+    }
+
+    void phase::run(job_system *jobs, const double delta) const {
+        ENGINE_PROFILE_ZONE_NAMED(m_profile_name);
+
+        if (m_desc.callback)
+            m_desc.callback(delta);
+
+        for (auto it = m_update_groups.begin(); it != m_update_groups.end();) {
+            if (!jobs || !(*it)->independent) {
+                (*it)->update(jobs, delta);
+                ++it;
+                continue;
+            }
+
+            // run every adjacent independent group concurrently, then wait before moving past them
+            job_counter counter;
+            for (; it != m_update_groups.end() && (*it)->independent; ++it) {
+                jobs->submit([jobs, group = *it, delta] { group->update(jobs, delta); }, &counter);
+            }
+            jobs->wait(counter);
+        }
+    }
+
+    bool phase::conflicts_with(const phase &other) const {
+        if (is_undeclared() || other.is_undeclared())
+            return true;
+        return intersects(m_desc.writes, other.m_desc.writes) || intersects(m_desc.writes, other.m_desc.reads) ||
+               intersects(m_desc.reads, other.m_desc.writes);
+    }
+
+    std::shared_ptr<phase> phase_graph::add_phase(phase_desc desc) {
+        if (m_phase_names.contains(desc.name)) {
+            throw std::invalid_argument("A phase named '" + desc.name + "' already exists");
+        }
+
+        const auto id = static_cast<phase_id>(m_phases.size());
+        m_phase_names.emplace(desc.name, id);
+
+        m_successors.emplace_back();
+        m_predecessors.emplace_back();
+        m_phases.emplace_back(std::make_shared<phase>(std::move(desc), id));
+
+        // compile only adds conflict edges between phases that nothing orders yet, which cannot close a cycle, so the
+        // constraints of the phases not compiled yet are the only ones to try
+        std::vector<std::pair<phase_id, phase_id>> added;
+        _add_constraint_edges(added);
+        try {
+            static_cast<void>(_sort());
+        } catch (const std::logic_error &) {
+            _remove_edges(added);
+            const std::string name = m_phases.back()->get_name();
+            m_phase_names.erase(name);
+            m_phases.pop_back();
+            m_successors.pop_back();
+            m_predecessors.pop_back();
+            throw std::logic_error("The ordering constraints of phase '" + name + "' contain a cycle");
+        }
+        _remove_edges(added);
+        return m_phases.back();
+    }
+
+    std::shared_ptr<phase> phase_graph::find_phase(const std::string_view name) const {
+        if (const auto it = m_phase_names.find(name); it != m_phase_names.end()) {
+            return m_phases[it->second];
+        }
+        return nullptr;
+    }
+
+    void phase_graph::compile() {
+        const size_t count = m_phases.size();
+        if (m_compiled_count == count)
+            return;
+
+        // every edge added here, so a cycle can be undone
+        std::vector<std::pair<phase_id, phase_id>> added;
+        _add_constraint_edges(added);
+
+        // conflicting phases that are not ordered yet run in registration order
+        for (size_t n = m_compiled_count; n < count; ++n) {
+            const auto id = static_cast<phase_id>(n);
+            for (phase_id m = 0; m < id; ++m) {
+                if (m_phases[m]->conflicts_with(*m_phases[n]) && !_reachable(m, id) && !_reachable(id, m) &&
+                    _add_edge(m, id))
+                    added.emplace_back(m, id);
+            }
+        }
+
+        std::vector<phase_id> order;
+        try {
+            order = _sort();
+        } catch (...) {
+            _remove_edges(added);
+            throw;
+        }
+
+        m_order          = std::move(order);
+        m_compiled_count = count;
+    }
+
+    void phase_graph::run(job_system *jobs, const double delta) {
+        compile();
+
+        const size_t count = m_phases.size();
+        m_start_times.assign(count, 0.0);
+        m_report.phase_times.assign(count, 0.0);
+
+        const auto frame_start = clock::now();
+
+        const auto run_phase = [&](const phase_id id) {
+            m_start_times[id] = seconds_since(frame_start);
+            m_phases[id]->run(jobs, delta);
+            m_report.phase_times[id] = seconds_since(frame_start) - m_start_times[id];
+        };
+
+        if (!jobs || count <= 1) {
+            for (const phase_id id : m_order) {
+                run_phase(id);
+                if (m_sync_point)
+                    m_sync_point();
+            }
+        } else {
+            // a phase's commands are applied before anything ordered after it starts, so phases run in waves of every
+            // phase whose predecessors are done, with the sync point in between
+            std::vector<uint32_t> &pending   = m_pending;
+            std::vector<phase_id> &wave      = m_wave;
+            std::vector<phase_id> &next_wave = m_next_wave;
+            pending.resize(count);
+            wave.clear();
+            for (const phase_id id : m_order) {
+                pending[id] = static_cast<uint32_t>(m_predecessors[id].size());
+                if (pending[id] == 0)
+                    wave.push_back(id);
+            }
+
+            while (!wave.empty()) {
+                if (wave.size() == 1) {
+                    run_phase(wave.front());
+                } else {
+                    job_counter counter;
+                    for (const phase_id id : wave) {
+                        jobs->submit([&run_phase, id] { run_phase(id); }, &counter);
+                    }
+                    jobs->wait(counter);
+                }
+
+                if (m_sync_point)
+                    m_sync_point();
+
+                next_wave.clear();
+                for (const phase_id id : wave) {
+                    for (const phase_id next : m_successors[id]) {
+                        if (--pending[next] == 0)
+                            next_wave.push_back(next);
+                    }
+                }
+                std::ranges::sort(next_wave);
+                wave.swap(next_wave);
+            }
+        }
+
+        _build_report(seconds_since(frame_start));
+    }
+
+    bool phase_graph::_has_edge(const phase_id from, const phase_id to) const {
+        return contains(m_successors[from], to);
+    }
+
+    bool phase_graph::_reachable(const phase_id from, const phase_id to) const {
+        std::vector<bool>     visited(m_phases.size(), false);
+        std::vector<phase_id> stack{from};
+        while (!stack.empty()) {
+            const phase_id id = stack.back();
+            stack.pop_back();
+            if (id == to)
+                return true;
+
+            for (const phase_id next : m_successors[id]) {
+                if (!visited[next]) {
+                    visited[next] = true;
+                    stack.push_back(next);
+                }
+            }
+        }
+        return false;
+    }
+
+    bool phase_graph::_add_edge(const phase_id from, const phase_id to) {
+        if (from == to || _has_edge(from, to))
+            return false;
+
+        m_successors[from].push_back(to);
+        m_predecessors[to].push_back(from);
+        return true;
+    }
+
+    void phase_graph::_add_constraint_edges(std::vector<std::pair<phase_id, phase_id>> &added) {
+        const auto add = [&](const phase_id from, const phase_id to) {
+            if (_add_edge(from, to))
+                added.emplace_back(from, to);
+        };
+
+        // in both directions, since older phases may name newer ones
+        for (size_t n = m_compiled_count; n < m_phases.size(); ++n) {
+            const auto  id   = static_cast<phase_id>(n);
+            const auto &desc = m_phases[n]->get_desc();
+
+            for (const auto &name : desc.after) {
+                if (const auto it = m_phase_names.find(name); it != m_phase_names.end())
+                    add(it->second, id);
+            }
+            for (const auto &name : desc.before) {
+                if (const auto it = m_phase_names.find(name); it != m_phase_names.end())
+                    add(id, it->second);
+            }
+
+            for (phase_id m = 0; m < m_compiled_count; ++m) {
+                const auto &other = m_phases[m]->get_desc();
+                if (contains(other.after, desc.name))
+                    add(id, m);
+                if (contains(other.before, desc.name))
+                    add(m, id);
+            }
+        }
+    }
+
+    void phase_graph::_remove_edges(const std::vector<std::pair<phase_id, phase_id>> &added) {
+        // edges are appended, so taking them off in reverse leaves the lists as they were
+        for (auto it = added.rbegin(); it != added.rend(); ++it) {
+            m_successors[it->first].pop_back();
+            m_predecessors[it->second].pop_back();
+        }
+    }
+
+    std::vector<phase_id> phase_graph::_sort() const {
+        const size_t          count = m_phases.size();
+        std::vector<uint32_t> in_degree(count);
+        for (size_t i = 0; i < count; ++i) {
+            in_degree[i] = static_cast<uint32_t>(m_predecessors[i].size());
+        }
+
+        // lowest id first among ready phases keeps the order deterministic
+        std::priority_queue<phase_id, std::vector<phase_id>, std::greater<>> ready;
+        for (phase_id i = 0; i < count; ++i) {
+            if (in_degree[i] == 0)
+                ready.push(i);
+        }
+
+        std::vector<phase_id> order;
+        order.reserve(count);
+        while (!ready.empty()) {
+            const phase_id id = ready.top();
+            ready.pop();
+            order.push_back(id);
+
+            for (const phase_id next : m_successors[id]) {
+                if (--in_degree[next] == 0)
+                    ready.push(next);
+            }
+        }
+
+        if (order.size() != count) {
+            throw std::logic_error("Phase ordering constraints contain a cycle");
+        }
+        return order;
+    }
+
+    void phase_graph::_build_report(const double wall_time) {
+        const size_t               count       = m_phases.size();
+        const std::vector<double> &start_times = m_start_times;
+        std::vector<double>       &finish      = m_finish;
+        std::vector<phase_id>     &via         = m_via;
+
+        // longest path through the graph weighted by the measured phase times
+        finish.assign(count, 0.0);
+        via.assign(count, static_cast<phase_id>(-1));
+        for (const phase_id id : m_order) {
+            double earliest = 0.0;
+            for (const phase_id prev : m_predecessors[id]) {
+                if (finish[prev] > earliest) {
+                    earliest = finish[prev];
+                    via[id]  = prev;
+                }
+            }
+            finish[id] = earliest + m_report.phase_times[id];
+        }
+
+        m_report.wall_time          = wall_time;
+        m_report.critical_path_time = 0.0;
+        m_report.critical_path.clear();
+
+        if (count == 0)
+            return;
+
+        phase_id last = 0;
+        for (phase_id id = 1; id < count; ++id) {
+            if (finish[id] > finish[last] || (finish[id] == finish[last] && start_times[id] > start_times[last]))
+                last = id;
+        }
+
+        m_report.critical_path_time = finish[last];
+        for (phase_id id = last; id != static_cast<phase_id>(-1); id = via[id]) {
+            m_report.critical_path.push_back(id);
+        }
+        std::ranges::reverse(m_report.critical_path);
+    }
+} // namespace engine::scene
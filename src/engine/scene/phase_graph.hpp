@@ -0,0 +1,178 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/names.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace engine {
+    class job_system;
+} // namespace engine
+
+namespace engine::scene {
+
+    struct update_group;
+
+    using phase_id = uint32_t;
+
+    /**
+     * Describes a phase of the frame (pre-physics, physics, animation, ...).
+     *
+     * reads and writes name the data the phase touches; two phases conflict when one writes something the other reads
+     * or writes. Conflicting phases never run concurrently, and unless after/before already orders them they run in
+     * registration order. A phase that declares neither reads nor writes may touch anything, so it conflicts with every
+     * other phase.
+     */
+    struct phase_desc {
+        std::string              name;
+        std::vector<std::string> reads;
+        std::vector<std::string> writes;
+        std::vector<std::string> after;
+        std::vector<std::string> before;
+
+        // optional work run before the phase's update groups
+        std::function<void(double delta)> callback;
+    };
+
+    /**
+     * A phase of the frame, owning an ordered list of update groups.
+     */
+    class phase {
+      public:
+        explicit phase(phase_desc desc, phase_id id);
+
+        [[nodiscard]] inline phase_id           get_id() const noexcept { return m_id; }
+        [[nodiscard]] inline const std::string &get_name() const noexcept { return m_desc.name; }
+        [[nodiscard]] inline const phase_desc  &get_desc() const noexcept { return m_desc; }
+
+        std::shared_ptr<update_group> push_end_new_update_group();
+        std::shared_ptr<update_group> push_front_new_update_group();
+        std::shared_ptr<update_group> push_new_update_group_after(const std::shared_ptr<update_group> &group);
+        std::shared_ptr<update_group> push_new_update_group_before(const std::shared_ptr<update_group> &group);
+
+        [[nodiscard]] inline const std::list<std::shared_ptr<update_group>> &update_groups() const noexcept {
+            return m_update_groups;
+        }
+
+        void run(job_system *jobs, double delta) const;
+
+        /**
+         * @return Whether the two phases cannot run concurrently based on their declared reads and writes.
+         */
+        [[nodiscard]] bool conflicts_with(const phase &other) const;
+
+        /**
+         * @return Whether the phase declares neither reads nor writes.
+         */
+        [[nodiscard]] inline bool is_undeclared() const noexcept {
+            return m_desc.reads.empty() && m_desc.writes.empty();
+        }
+
+      private:
+        phase_desc m_desc;
+        phase_id   m_id;
+        name_id    m_profile_name;
+
+        std::list<std::shared_ptr<update_group>> m_update_groups;
+
+        std::map<std::shared_ptr<update_group>, typename decltype(m_update_groups)::iterator> m_update_group_map;
+    };
+
+    /**
+     * The phases of a scene compiled into a dependency graph. Phases with no path between them run concurrently when a
+     * job system is available: the graph runs in waves, each made of every phase whose predecessors have all finished,
+     * with the sync point between waves.
+     */
+    class phase_graph {
+      public:
+        struct frame_report {
+            double                wall_time          = 0.0;
+            double                critical_path_time = 0.0;
+            std::vector<phase_id> critical_path;
+            std::vector<double>   phase_times; // indexed by phase_id, in seconds
+        };
+
+        /**
+         * @throws std::invalid_argument if a phase with the same name already exists
+         * @throws std::logic_error if the phase's after/before constraints form a cycle with the phases already added.
+         * The phase is then not added.
+         */
+        std::shared_ptr<phase> add_phase(phase_desc desc);
+
+        [[nodiscard]] std::shared_ptr<phase> find_phase(std::string_view name) const;
+
+        [[nodiscard]] inline const std::vector<std::shared_ptr<phase>> &phases() const noexcept { return m_phases; }
+
+        /**
+         * Adds the edges for every phase registered since the last compile and recomputes the execution order. Adding
+         * update groups to an existing phase does not require recompiling.
+         *
+         * @throws std::logic_error if the edges form a cycle, which add_phase already rules out. The graph is then left
+         * as it was compiled last.
+         */
+        void compile();
+
+        void run(job_system *jobs, double delta);
+
+        /**
+         * Sets a function run whenever no phase is executing: after each phase when phases run one at a time, or after
+         * each wave when they run concurrently. Either way it runs after every phase, before any phase ordered after it
+         * starts.
+         */
+        inline void set_sync_point(std::function<void()> sync) { m_sync_point = std::move(sync); }
+
+        /**
+         * @return Timings of the last run, including the chain of phases that bounded the frame time.
+         */
+        [[nodiscard]] inline const frame_report &last_report() const noexcept { return m_report; }
+
+        [[nodiscard]] inline const std::vector<phase_id> &execution_order() const noexcept { return m_order; }
+
+      private:
+        std::vector<std::shared_ptr<phase>>          m_phases;
+        std::vector<std::vector<phase_id>>           m_successors;
+        std::vector<std::vector<phase_id>>           m_predecessors;
+        std::map<std::string, phase_id, std::less<>> m_phase_names;
+
+        size_t                m_compiled_count = 0;
+        std::vector<phase_id> m_order;
+        frame_report          m_report;
+        std::function<void()> m_sync_point;
+
+        // run's scratch, kept between frames so a run does not allocate
+        std::vector<double>   m_start_times;
+        std::vector<double>   m_finish;
+        std::vector<phase_id> m_via;
+        std::vector<uint32_t> m_pending;
+        std::vector<phase_id> m_wave;
+        std::vector<phase_id> m_next_wave;
+
+        [[nodiscard]] bool _has_edge(phase_id from, phase_id to) const;
+        [[nodiscard]] bool _reachable(phase_id from, phase_id to) const;
+
+        // returns whether the edge is new
+        bool _add_edge(phase_id from, phase_id to);
+
+        // the after/before edges of every phase added since the last compile; the ones that are new go into added
+        void _add_constraint_edges(std::vector<std::pair<phase_id, phase_id>> &added);
+        void _remove_edges(const std::vector<std::pair<phase_id, phase_id>> &added);
+
+        /**
+         * @return Every phase, in an order that respects every edge
+         * @throws std::logic_error if the edges form a cycle
+         */
+        [[nodiscard]] std::vector<phase_id> _sort() const;
+        void _build_report(double wall_time);
+    };
+} // namespace engine::scene
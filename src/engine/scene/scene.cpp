@@ -4,8 +4,23 @@
 
 #include "scene.hpp"
 
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <ranges>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
 namespace engine::scene {
-    void scene_object::set_name(const std::string &name) {
+    uint32_t detail::next_object_type_id() {
+        static std::atomic<uint32_t> s_next_id = 0;
+        return s_next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void scene_object::set_name(const name_id name) {
         m_name = name;
     }
 
@@ -20,7 +35,13 @@ namespace engine::scene {
     }
 
     void scene_object::_add_child(const std::shared_ptr<scene_object> &child) {
-        m_children.insert(child);
+        m_children.push_back(child);
+        on_child_added(child);
+    }
+
+    void scene_object::_remove_child(const std::shared_ptr<scene_object> &child) {
+        if (std::erase(m_children, child) > 0)
+            on_child_removed(child);
     }
 
     void scene_object::_set_parent(const std::shared_ptr<scene_object> &parent) {
@@ -28,97 +49,660 @@ namespace engine::scene {
     }
 
     void scene_object::set_parent(const std::shared_ptr<scene_object> &parent) {
-        const auto old_parent = m_parent;
+        const auto old_parent = m_parent.lock();
+        if (old_parent == parent)
+            return;
 
-        m_parent = parent;
-        m_parent->_add_child(shared_from_this());
+        const auto self = shared_from_this();
+
+        if (const auto s = m_scene.lock(); s && !m_transform.is_null()) {
+            const transform_handle parent_transform = parent ? parent->m_transform : transform_handle{};
+            s->transforms().set_parent(m_transform, parent_transform);
+        }
+
+        if (old_parent)
+            old_parent->_remove_child(self);
+
+        _set_parent(parent);
+        if (parent)
+            parent->_add_child(self);
 
-        on_parent_changed(old_parent, m_parent);
+        if (const auto s = m_scene.lock())
+            s->mark_dirty(m_id);
+
+        on_parent_changed(old_parent, parent);
     }
 
-    void scene_object::update(double delta) {}
+    void scene_object::set_local_transform(const glm::mat4 &local) {
+        if (const auto s = m_scene.lock(); s && !m_transform.is_null()) {
+            s->transforms().set_local(m_transform, local);
+            s->mark_dirty(m_id);
+        }
+    }
+
+    void scene_object::set_bounds(const aabb &local_bounds) {
+        if (const auto s = m_scene.lock())
+            s->commands().with_key(m_id).set_bounds(m_id, local_bounds);
+    }
+
+    void scene_object::mark_dirty() const {
+        if (const auto s = m_scene.lock())
+            s->mark_dirty(m_id);
+    }
 
-    std::shared_ptr<scene_object> scene::get_scene_object(const std::string &name) const {
-        if (const auto &it = m_named_objects.find(name); it != m_named_objects.end()) {
-            return it->second;
+    glm::mat4 scene_object::get_local_transform() const {
+        if (const auto s = m_scene.lock(); s && !m_transform.is_null()) {
+            return s->transforms().get_local(m_transform);
         }
-        return nullptr;
+        return glm::mat4(1.0f);
     }
 
-    std::shared_ptr<scene_object> scene::get_scene_object(const uint64_t id) const {
-        if (const auto &it = m_objects.find(id); it != m_objects.end()) {
-            return it->second;
+    glm::mat4 scene_object::get_world_transform() const {
+        if (const auto s = m_scene.lock(); s && !m_transform.is_null()) {
+            return s->transforms().get_world(m_transform);
         }
-        return nullptr;
+        return glm::mat4(1.0f);
     }
 
-    bool scene::has_scene_object(const std::string &name) const {
-        return m_named_objects.contains(name);
+    void scene_object::update(double delta) {}
+
+    void scene_object::sleep(const sleep_options &options) const {
+        if (const auto s = m_scene.lock())
+            s->sleep_object(m_id, options);
     }
 
-    bool scene::has_scene_object(const uint64_t id) const {
-        return m_objects.contains(id);
+    void scene_object::sleep_for(const double seconds) const {
+        sleep(sleep_options{.seconds = seconds});
+    }
+
+    void scene_object::sleep_for_frames(const uint64_t frames) const {
+        sleep(sleep_options{.frames = frames});
+    }
+
+    void scene_object::sleep_until(const name_id event) const {
+        sleep(sleep_options{.event = event});
+    }
+
+    void scene_object::wake() const {
+        if (const auto s = m_scene.lock())
+            s->wake_object(m_id);
+    }
+
+    void update_group::_publish_size() {
+        if (m_size_gauge_name != profile_name) {
+            const std::string labels = "{group=\"" + std::string(profile_name.str()) + "\"}";
+            m_size_gauge             = metrics::registry::get().get_gauge("update_group_objects" + labels);
+            m_awake_gauge            = metrics::registry::get().get_gauge("update_group_awake_objects" + labels);
+            m_size_gauge_name        = profile_name;
+        }
+        m_size_gauge.set(static_cast<int64_t>(size()));
+        m_awake_gauge.set(static_cast<int64_t>(awake_size()));
+    }
+
+    static std::string type_name(const std::type_index type) {
+#if defined(__GNUG__)
+        int                                         status = 0;
+        std::unique_ptr<char, decltype(&std::free)> demangled(
+            abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), &std::free
+        );
+        if (status == 0)
+            return demangled.get();
+#endif
+        return type.name();
     }
 
-    uint64_t scene::add_resource(const std::shared_ptr<void> &resource) {
-        return m_resources.emplace(++m_last_resource_id, resource).first->first;
+    static std::atomic<uint64_t> s_next_scene_uid = 1;
+
+    scene::scene() : m_uid(s_next_scene_uid.fetch_add(1, std::memory_order_relaxed)) {
+        m_phases.set_sync_point([this] { flush_commands(); });
+
+        // update code may touch any object, so phases that read or write objects are ordered around this one
+        m_default_phase = m_phases.add_phase(phase_desc{
+            .name   = std::string(default_phase_name),
+            .writes = {std::string(objects_resource_name)},
+        });
+
+        // reads the local matrices objects set, so it never overlaps a phase that updates objects
+        m_phases.add_phase(phase_desc{
+            .name     = std::string(transform_phase_name),
+            .reads    = {std::string(objects_resource_name)},
+            .writes   = {"world_transforms"},
+            .after    = {std::string(default_phase_name)},
+            .callback = [this](double) { m_transforms.update(m_job_system.get()); },
+        });
+
+        m_phases.add_phase(phase_desc{
+            .name     = std::string(spatial_phase_name),
+            .reads    = {"world_transforms"},
+            .writes   = {"spatial_index"},
+            .after    = {std::string(transform_phase_name)},
+            .callback = [this](double) { _refresh_bounds(); },
+        });
     }
 
-    uint64_t scene::add_resource(const std::string &name, const std::shared_ptr<void> &resource) {
-        const auto it           = m_resources.emplace(++m_last_resource_id, resource).first;
-        m_named_resources[name] = it->second;
-        return it->first;
+    scene::~scene() {
+        for (const auto &object : m_objects.values()) {
+            object->m_type_counter.decrement();
+        }
+        m_sleeping_metric.add(-static_cast<int64_t>(m_sleeping_count));
     }
 
-    std::shared_ptr<void> scene::get_resource(const std::string &name) const {
-        if (const auto &it = m_named_resources.find(name); it != m_named_resources.end()) {
-            return it->second;
+    std::shared_ptr<scene_object> scene::get_scene_object(const hashed_name name) const {
+        if (const auto *object = m_named_objects.find(name)) {
+            return *object;
         }
         return nullptr;
     }
 
-    std::shared_ptr<void> scene::get_resource(const uint64_t id) const {
-        if (const auto &it = m_resources.find(id); it != m_resources.end()) {
-            return it->second;
+    std::shared_ptr<scene_object> scene::get_scene_object(const uint64_t id) const {
+        if (const auto *object = m_objects.get(slot_handle::from_id(id))) {
+            return *object;
         }
         return nullptr;
     }
 
-    bool scene::has_resource(const std::string &name) const {
-        return m_named_resources.contains(name);
+    bool scene::has_scene_object(const hashed_name name) const {
+        return m_named_objects.contains(name);
     }
 
-    bool scene::has_resource(const uint64_t id) const {
-        return m_resources.contains(id);
+    bool scene::has_scene_object(const uint64_t id) const {
+        return m_objects.contains(slot_handle::from_id(id));
     }
 
     std::shared_ptr<update_group> scene::push_end_new_update_group() {
-        const auto it          = m_update_groups.emplace_back(std::make_shared<update_group>());
-        m_update_group_map[it] = --m_update_groups.end();
-        return it;
+        return m_default_phase->push_end_new_update_group();
     }
 
     std::shared_ptr<update_group> scene::push_front_new_update_group() {
-        const auto it          = m_update_groups.emplace_front(std::make_shared<update_group>());
-        m_update_group_map[it] = m_update_groups.begin();
-        return it;
+        return m_default_phase->push_front_new_update_group();
     }
 
     std::shared_ptr<update_group> scene::push_new_update_group_after(const std::shared_ptr<update_group> &group) {
-        const auto after = ++m_update_group_map[group];
-        const auto it    = m_update_groups.emplace(after, std::make_shared<update_group>());
-        return *it;
+        return m_default_phase->push_new_update_group_after(group);
     }
 
     std::shared_ptr<update_group> scene::push_new_update_group_before(const std::shared_ptr<update_group> &group) {
-        const auto after = m_update_group_map[group];
-        const auto it    = m_update_groups.emplace(after, std::make_shared<update_group>());
-        return *it;
+        return m_default_phase->push_new_update_group_before(group);
+    }
+
+    std::shared_ptr<phase> scene::add_phase(phase_desc desc) {
+        return m_phases.add_phase(std::move(desc));
+    }
+
+    std::shared_ptr<phase> scene::get_phase(const std::string_view name) const {
+        return m_phases.find_phase(name);
+    }
+
+    bool scene::remove_object(const uint64_t id) {
+        const uint64_t ids[] = {id};
+        return remove_objects(ids) == 1;
+    }
+
+    size_t scene::remove_objects(const std::span<const uint64_t> ids) {
+        // taken rather than borrowed, so an on_parent_changed that removes objects gets a vector of its own
+        std::vector<std::shared_ptr<scene_object>> removed = std::exchange(m_removed, {});
+        removed.reserve(ids.size());
+        for (const uint64_t id : ids) {
+            const auto handle = slot_handle::from_id(id);
+            if (const auto *object = m_objects.get(handle)) {
+                removed.push_back(*object);
+                m_objects.erase(handle);
+                _mark_dirty(id);
+            }
+        }
+
+        if (removed.empty()) {
+            m_removed = std::move(removed);
+            return 0;
+        }
+
+        for (const auto &object : removed) {
+            object->m_removing = true;
+
+            _unindex_name(object);
+            object->m_type_counter.decrement();
+
+            m_components.destroy_entity(object->m_entity);
+
+            if (const auto parent = object->m_parent.lock()) {
+                parent->_remove_child(object);
+                object->_set_parent(nullptr);
+            }
+            for (const auto &child : std::exchange(object->m_children, {})) {
+                child->_set_parent(nullptr);
+                _mark_dirty(child->m_id);
+                child->on_parent_changed(object, nullptr);
+            }
+
+            _clear_bounds(object->m_id);
+            if (object->m_asleep) {
+                // its timers and event waits are ignored from here on
+                ++object->m_sleep_serial;
+                object->m_asleep = false;
+                --m_sleeping_count;
+                m_sleeping_metric.decrement();
+            }
+            if (!object->m_transform.is_null()) {
+                m_transforms.destroy(object->m_transform);
+                object->m_transform = {};
+            }
+        }
+
+        for (const auto &phase : m_phases.phases()) {
+            for (const auto &group : phase->update_groups()) {
+                group->on_update.erase(removed);
+            }
+        }
+
+        for (const auto &object : removed) {
+            object->m_removing = false;
+            object->internal_detach_from_scene();
+        }
+
+        const size_t count = removed.size();
+        removed.clear();
+        m_removed = std::move(removed);
+        return count;
+    }
+
+    void scene::rename_object(const uint64_t id, const hashed_name name) {
+        const auto *found = m_objects.get(slot_handle::from_id(id));
+        if (!found)
+            return;
+
+        const auto &object = *found;
+        _unindex_name(object);
+
+        const name_id interned = name_id::intern(name);
+        object->set_name(interned);
+        if (!interned.empty())
+            m_named_objects.insert_or_assign(interned, object);
+        _mark_dirty(id);
+    }
+
+    void scene::set_object_bounds(const uint64_t id, const aabb &local_bounds) {
+        const auto *found = m_objects.get(slot_handle::from_id(id));
+        if (!found)
+            return;
+
+        if (local_bounds.empty()) {
+            _clear_bounds(id);
+            return;
+        }
+
+        const uint32_t slot = slot_handle::from_id(id).index;
+        if (slot >= m_bounded_by_slot.size())
+            m_bounded_by_slot.resize(slot + 1, no_bounds);
+
+        const transform_handle transform = (*found)->m_transform;
+        const aabb world = local_bounds.transformed(m_transforms.get_world(transform));
+        if (const uint32_t index = m_bounded_by_slot[slot]; index != no_bounds) {
+            bounded_object &bounded = m_bounded[index];
+            bounded.local           = local_bounds;
+            bounded.stale           = true;
+            m_spatial->move(bounded.proxy, world);
+            return;
+        }
+
+        m_bounded_by_slot[slot] = static_cast<uint32_t>(m_bounded.size());
+        m_bounded.push_back(bounded_object{
+            .id        = id,
+            .transform = transform,
+            .local     = local_bounds,
+            .proxy     = m_spatial->insert(id, world),
+            .stale     = true,
+        });
+    }
+
+    void scene::sleep_object(const uint64_t id, const sleep_options &options) {
+        _thread_buffers().sleeps.push_back(sleep_request{.id = id, .options = options, .wake = false});
+    }
+
+    void scene::wake_object(const uint64_t id) {
+        _thread_buffers().sleeps.push_back(sleep_request{.id = id, .options = {}, .wake = true});
+    }
+
+    void scene::signal(const name_id event) {
+        _thread_buffers().signals.push_back(event);
+    }
+
+    void scene::_apply_sleeps(std::vector<sleep_request> &requests, std::vector<name_id> &signals) {
+        // in object order, then in the order each thread recorded them, so the order objects are updated in after they
+        // wake does not depend on which thread asked
+        std::ranges::stable_sort(requests, std::less{}, &sleep_request::id);
+        _find_objects(requests | std::views::transform(&sleep_request::id));
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const auto *found = m_found[i];
+            if (!found)
+                continue;
+            if (requests[i].wake) {
+                _wake(*found);
+            } else {
+                _sleep(*found, requests[i].options);
+            }
+        }
+
+        std::ranges::sort(signals, std::less{}, &name_id::hash);
+        const auto [first, last] = std::ranges::unique(signals);
+        signals.erase(first, last);
+        for (const name_id event : signals) {
+            auto *sleepers = m_event_sleepers.find(hashed_name(event.str(), event.hash()));
+            if (!sleepers)
+                continue;
+            for (const sleep_ref &ref : std::exchange(*sleepers, {})) {
+                const auto *found = m_objects.get(slot_handle::from_id(ref.id));
+                if (found && (*found)->m_sleep_serial == ref.serial)
+                    _wake(*found);
+            }
+        }
+        _refresh_awake();
+    }
+
+    void scene::_sleep(const std::shared_ptr<scene_object> &object, const sleep_options &options) {
+        const uint32_t serial = ++object->m_sleep_serial;
+        object->m_wake_frame  = options.frames ? m_frame + *options.frames + 1 : UINT64_MAX;
+        object->m_wake_time   = options.seconds ? m_time + *options.seconds : 0.0;
+
+        const uint64_t deadline =
+            std::min(object->m_wake_frame, options.seconds ? _frame_at(object->m_wake_time) : UINT64_MAX);
+        if (deadline != UINT64_MAX)
+            m_timers.schedule(timer_wheel::timer{.deadline = deadline, .id = object->m_id, .serial = serial});
+
+        if (!options.event.empty()) {
+            auto *sleepers = m_event_sleepers.find(hashed_name(options.event.str(), options.event.hash()));
+            if (!sleepers)
+                sleepers = &m_event_sleepers.insert_or_assign(options.event, {});
+
+            // waits of objects that woke some other way pile up until the event is signalled, so they are dropped
+            // whenever the list would grow
+            if (sleepers->size() == sleepers->capacity()) {
+                std::erase_if(*sleepers, [this](const sleep_ref &ref) {
+                    const auto *found = m_objects.get(slot_handle::from_id(ref.id));
+                    return !found || (*found)->m_sleep_serial != ref.serial;
+                });
+            }
+            sleepers->push_back(sleep_ref{.id = object->m_id, .serial = serial});
+        }
+
+        if (!object->m_asleep) {
+            object->m_asleep = true;
+            ++m_sleeping_count;
+            m_sleeping_metric.increment();
+            _sleep_changed(object);
+        }
+    }
+
+    void scene::_wake(const std::shared_ptr<scene_object> &object) {
+        if (!object->m_asleep)
+            return;
+
+        ++object->m_sleep_serial;
+        object->m_asleep = false;
+        --m_sleeping_count;
+        m_sleeping_metric.decrement();
+        _sleep_changed(object);
+    }
+
+    void scene::_wake_due(const double start) {
+        // a thousandth of an update of slack, so summed deltas that land a hair early still count
+        const double                              slack = m_delta * 1e-3;
+        const std::span<const timer_wheel::timer> due   = m_timers.advance();
+        _find_objects(due | std::views::transform(&timer_wheel::timer::id));
+        for (size_t i = 0; i < due.size(); ++i) {
+            const timer_wheel::timer &timer = due[i];
+            const auto               *found = m_found[i];
+            if (!found)
+                continue;
+
+            const scene_object &object = **found;
+            if (object.m_sleep_serial != timer.serial)
+                continue;
+
+            if (m_frame < object.m_wake_frame && start + slack < object.m_wake_time) {
+                m_timers.schedule(timer_wheel::timer{
+                    .deadline = std::min(object.m_wake_frame, _frame_at(object.m_wake_time)),
+                    .id       = timer.id,
+                    .serial   = timer.serial,
+                });
+                continue;
+            }
+            _wake(*found);
+        }
+        _refresh_awake();
+    }
+
+    uint64_t scene::_frame_at(const double time) const {
+        // the next update starts at m_time; with no delta to go by, it checks again then
+        if (m_delta <= 0.0 || time <= m_time)
+            return m_frame + 1;
+        return m_frame + 1 + static_cast<uint64_t>(std::ceil((time - m_time) / m_delta - 1e-6));
+    }
+
+    void scene::_sleep_changed(const std::shared_ptr<scene_object> &object) {
+        if (!std::exchange(object->m_sleep_changed, true))
+            m_sleep_changes.push_back(sleep_change{.object = object, .was_asleep = !object->m_asleep});
+    }
+
+    void scene::_refresh_awake() {
+        if (m_sleep_changes.empty())
+            return;
+
+        // objects that fell asleep and woke again since the last refresh are where they were
+        for (auto &[object, was_asleep] : m_sleep_changes) {
+            object->m_sleep_changed = false;
+            if (object->m_asleep != was_asleep)
+                (object->m_asleep ? m_slept : m_woken).push_back(std::move(object));
+        }
+
+        for (const auto &phase : m_phases.phases()) {
+            for (const auto &group : phase->update_groups()) {
+                group->on_update.refresh_awake(m_slept, m_woken);
+            }
+        }
+        m_sleep_changes.clear();
+        m_slept.clear();
+        m_woken.clear();
+    }
+
+    void scene::set_spatial_index(std::unique_ptr<spatial_index> index) {
+        if (!index) {
+            throw std::invalid_argument("A scene needs a spatial index");
+        }
+
+        std::vector<spatial_index::proxy> proxies;
+        proxies.reserve(m_bounded.size());
+        for (const bounded_object &bounded : m_bounded) {
+            proxies.push_back(
+                index->insert(bounded.id, bounded.local.transformed(m_transforms.get_world(bounded.transform)))
+            );
+        }
+
+        for (size_t i = 0; i < m_bounded.size(); ++i) {
+            m_bounded[i].proxy = proxies[i];
+        }
+        m_spatial = std::move(index);
     }
 
-    void scene::update(const double delta) const {
-        for (const auto &it : m_update_groups) {
-            it->update(delta);
+    void scene::_clear_bounds(const uint64_t id) {
+        const uint32_t slot = slot_handle::from_id(id).index;
+        if (slot >= m_bounded_by_slot.size() || m_bounded_by_slot[slot] == no_bounds)
+            return;
+
+        const uint32_t index = std::exchange(m_bounded_by_slot[slot], no_bounds);
+        m_spatial->remove(m_bounded[index].proxy);
+
+        if (index != m_bounded.size() - 1) {
+            m_bounded[index]                                                 = m_bounded.back();
+            m_bounded_by_slot[slot_handle::from_id(m_bounded[index].id).index] = index;
+        }
+        m_bounded.pop_back();
+    }
+
+    void scene::_refresh_bounds() {
+        for (bounded_object &bounded : m_bounded) {
+            if (!bounded.stale && !m_transforms.changed(bounded.transform))
+                continue;
+
+            m_spatial->move(bounded.proxy, bounded.local.transformed(m_transforms.get_world(bounded.transform)));
+            bounded.stale = false;
         }
     }
+
+    void scene::_unindex_name(const std::shared_ptr<scene_object> &object) {
+        if (object->m_name.empty())
+            return;
+
+        const hashed_name key{object->m_name.str(), object->m_name.hash()};
+        if (const auto *indexed = m_named_objects.find(key); indexed && *indexed == object) {
+            m_named_objects.erase(key);
+        }
+    }
+
+    metrics::counter scene::_object_counter(const std::type_index type) {
+        return metrics::registry::get().get_up_down_counter("scene_objects{type=\"" + type_name(type) + "\"}");
+    }
+
+    scene::thread_buffers &scene::_thread_buffers() {
+        struct cached_buffers {
+            uint64_t        scene_uid = 0;
+            thread_buffers *buffers   = nullptr;
+        };
+        thread_local cached_buffers t_cache;
+
+        if (t_cache.scene_uid == m_uid)
+            return *t_cache.buffers;
+
+        std::lock_guard lock(m_buffer_mutex);
+        auto           &buffers = m_thread_buffers[std::this_thread::get_id()];
+        if (!buffers)
+            buffers = std::make_unique<thread_buffers>();
+
+        t_cache = cached_buffers{.scene_uid = m_uid, .buffers = buffers.get()};
+        return *buffers;
+    }
+
+    command_buffer &scene::commands() {
+        return _thread_buffers().commands;
+    }
+
+    frame_arena &scene::get_frame_arena() {
+        return _thread_buffers().arena;
+    }
+
+    std::vector<uint64_t> scene::_take_dirty() {
+        std::lock_guard       lock(m_buffer_mutex);
+        std::vector<uint64_t> dirty;
+        for (const auto &buffers : m_thread_buffers | std::views::values) {
+            dirty.insert(dirty.end(), buffers->dirty.begin(), buffers->dirty.end());
+            buffers->dirty.clear();
+        }
+        return dirty;
+    }
+
+    void scene::flush_commands() {
+        std::vector<command_buffer::command> pending;
+        std::vector<sleep_request>           sleeps;
+        std::vector<name_id>                 signals;
+        {
+            std::lock_guard lock(m_buffer_mutex);
+            for (const auto &buffers : m_thread_buffers | std::views::values) {
+                auto &buffer = buffers->commands;
+                std::ranges::move(buffer.m_commands, std::back_inserter(pending));
+                buffer.m_commands.clear();
+                buffer.m_key = 0;
+
+                sleeps.insert(sleeps.end(), buffers->sleeps.begin(), buffers->sleeps.end());
+                buffers->sleeps.clear();
+                signals.insert(signals.end(), buffers->signals.begin(), buffers->signals.end());
+                buffers->signals.clear();
+            }
+        }
+
+        // objects destroyed below were put to sleep first, which remove_objects undoes
+        if (!sleeps.empty() || !signals.empty())
+            _apply_sleeps(sleeps, signals);
+
+        if (pending.empty())
+            return;
+
+        std::ranges::stable_sort(pending, [](const command_buffer::command &a, const command_buffer::command &b) {
+            return a.key != b.key ? a.key < b.key : a.sequence < b.sequence;
+        });
+
+        // consecutive destroys are removed as one batch
+        std::vector<uint64_t> destroyed;
+        const auto            flush_destroyed = [&] {
+            if (!destroyed.empty()) {
+                remove_objects(destroyed);
+                destroyed.clear();
+            }
+        };
+
+        for (auto &cmd : pending) {
+            if (const auto *destroy = std::get_if<command_buffer::destroy_command>(&cmd.payload)) {
+                destroyed.push_back(destroy->id);
+                continue;
+            }
+            flush_destroyed();
+
+            std::visit(
+                [this]<typename C>(C &c) {
+                    if constexpr (std::is_same_v<C, command_buffer::spawn_command>) {
+                        const auto [id, object] = c.create(*this);
+                        if (!c.options.name.empty())
+                            rename_object(id, c.options.name);
+                        if (c.options.group)
+                            c.insert_into_group(c.options.group, object);
+                        if (c.options.parent_id != 0) {
+                            if (const auto parent = get_scene_object(c.options.parent_id))
+                                object->set_parent(parent);
+                        }
+                        if (c.options.on_spawned)
+                            c.options.on_spawned(id, object);
+                    } else if constexpr (std::is_same_v<C, command_buffer::rename_command>) {
+                        rename_object(c.id, c.name);
+                    } else if constexpr (std::is_same_v<C, command_buffer::reparent_command>) {
+                        if (const auto object = get_scene_object(c.id)) {
+                            object->set_parent(c.parent_id != 0 ? get_scene_object(c.parent_id) : nullptr);
+                        }
+                    } else if constexpr (std::is_same_v<C, command_buffer::group_command>) {
+                        if (const auto object = get_scene_object(c.id)) {
+                            if (c.insert) {
+                                c.group->insert(object);
+                            } else {
+                                c.group->erase(object);
+                            }
+                        }
+                    } else if constexpr (std::is_same_v<C, command_buffer::bounds_command>) {
+                        set_object_bounds(c.id, c.local_bounds);
+                    }
+                },
+                cmd.payload
+            );
+        }
+        flush_destroyed();
+    }
+
+    void scene::update(const double delta) {
+        ENGINE_PROFILE_ZONE("scene::update");
+
+        {
+            // every thread's arena, as nothing runs between updates
+            std::lock_guard lock(m_buffer_mutex);
+            size_t          bytes = 0;
+            for (const auto &buffers : m_thread_buffers | std::views::values) {
+                bytes += buffers->arena.bytes_used();
+                buffers->arena.reset();
+            }
+            m_frame_arena_bytes.record(bytes);
+        }
+
+        const double start = m_time;
+        ++m_frame;
+        m_time += delta;
+        m_delta = delta;
+        _wake_due(start);
+
+        m_phases.run(m_job_system.get(), delta);
+    }
 } // namespace engine::scene
@@ -4,22 +4,67 @@
 
 #pragma once
 
+#include "commands.hpp"
+#include "components.hpp"
+#include "engine/flat_map.hpp"
+#include "engine/jobs.hpp"
+#include "engine/memory.hpp"
+#include "engine/metrics.hpp"
+#include "engine/names.hpp"
+#include "engine/profiler.hpp"
+#include "engine/resources.hpp"
+#include "engine/slot_map.hpp"
+#include "phase_graph.hpp"
+#include "spatial.hpp"
+#include "timer_wheel.hpp"
+#include "transform.hpp"
+
+#include <algorithm>
 #include <functional>
-#include <list>
 #include <map>
 #include <memory>
-#include <set>
-#include <unordered_set>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <typeindex>
 #include <utility>
+#include <vector>
 
 namespace engine::scene {
 
     class scene;
     class scene_object;
+    class snapshot_writer;
+    class snapshot_reader;
 
     template <typename... Args>
     class update_phase;
 
+    namespace detail {
+        uint32_t next_object_type_id();
+    } // namespace detail
+
+    /**
+     * A small dense id per scene object type, so a scene finds a type's pool and counter without a map lookup.
+     */
+    template <typename T>
+    uint32_t object_type_id_of() {
+        static const uint32_t id = detail::next_object_type_id();
+        return id;
+    }
+
+    /**
+     * When a sleeping object wakes: at whichever of these comes first. With none set, it sleeps until woken explicitly.
+     */
+    struct sleep_options {
+        std::optional<uint64_t> frames  = std::nullopt; // scene updates to skip
+        std::optional<double>   seconds = std::nullopt; // scene time to sleep for, rounded up to whole updates
+        name_id                 event   = {};           // wakes when the scene is signalled with it
+    };
+
     /**
      * An object within a scene
      */
@@ -37,19 +82,99 @@ namespace engine::scene {
 
         template <std::derived_from<scene_object> T, typename... Args>
         [[nodiscard]] static std::shared_ptr<T> create_orphaned(Args &&...args) {
-            // ReSharper disable once CppSmartPointerVsMakeFunction
-            return create(std::weak_ptr<scene>(), 0, std::forward<Args>(args)...);
+            return create<T>(nullptr, std::weak_ptr<scene>(), 0, std::forward<Args>(args)...);
         }
 
         [[nodiscard]] inline const std::weak_ptr<scene> &get_scene() const noexcept { return m_scene; }
         [[nodiscard]] inline uint64_t                    get_id() const noexcept { return m_id; }
-        [[nodiscard]] std::string_view                   get_name() const { return m_name; }
+        [[nodiscard]] std::string_view                   get_name() const { return m_name.str(); }
 
+        /**
+         * Moves this object under a new parent, or to the root of the scene if parent is null. The object's transform
+         * follows it in the scene's transform hierarchy.
+         */
         void set_parent(const std::shared_ptr<scene_object> &parent);
 
+        [[nodiscard]] inline std::shared_ptr<scene_object> get_parent() const noexcept { return m_parent.lock(); }
+
+        [[nodiscard]] inline std::span<const std::shared_ptr<scene_object>> get_children() const noexcept {
+            return m_children;
+        }
+
+        /**
+         * @return The node of this object in the scene's transform hierarchy (null for orphaned objects).
+         */
+        [[nodiscard]] inline transform_handle get_transform() const noexcept { return m_transform; }
+
+        /**
+         * Sets the local matrix right away, so it can be read back at once. Safe to call from parallel updates for the
+         * object being updated: the matrix and its dirty flag are this object's own, and the transform phase, which
+         * reads them, is ordered against every phase that writes scene objects.
+         */
+        void set_local_transform(const glm::mat4 &local);
+
+        [[nodiscard]] glm::mat4 get_local_transform() const;
+
+        /**
+         * @return The world transform as of the scene's last transform update.
+         */
+        [[nodiscard]] glm::mat4 get_world_transform() const;
+
+        /**
+         * Puts this object in the scene's spatial index. Recorded through the calling thread's commands() and applied
+         * at the next sync point, so it is safe to call from parallel updates. See scene::set_object_bounds.
+         */
+        void set_bounds(const aabb &local_bounds);
+
+        /**
+         * Tells the scene's history, if one is recording, that something save_state writes has changed. Changes to the
+         * object's name, parent and local transform (through set_local_transform) are noticed without it. Safe to call
+         * from parallel updates.
+         */
+        void mark_dirty() const;
+
+        /**
+         * @return The entity backing this object's components, or a null entity if no component was ever added.
+         */
+        [[nodiscard]] inline entity get_entity() const noexcept { return m_entity; }
+
+        /**
+         * Stores a component for this object in the scene's component storage, creating the backing entity on first
+         * use. Hot simulation data should live here rather than in members of the object.
+         */
+        template <typename T, typename... Args>
+        T &emplace_component(Args &&...args);
+
+        template <typename T>
+        [[nodiscard]] T *get_component() const;
+
         virtual void update(double delta);
 
-        // TODO: draw system
+        /**
+         * Puts the object to sleep, so its update groups skip it until it wakes. See scene::sleep_object.
+         */
+        void sleep(const sleep_options &options) const;
+        void sleep_for(double seconds) const;
+        void sleep_for_frames(uint64_t frames) const;
+        void sleep_until(name_id event) const;
+
+        void wake() const;
+
+        /**
+         * @return Whether the object is asleep, as of the last sync point.
+         */
+        [[nodiscard]] inline bool is_asleep() const noexcept { return m_asleep; }
+
+        /**
+         * Writes the object's own state to a snapshot. Its name, parent and transform are saved by the scene; only
+         * types registered with snapshot_types can be saved.
+         */
+        virtual void save_state(snapshot_writer &out) const {}
+
+        /**
+         * Reads back what save_state wrote.
+         */
+        virtual void load_state(snapshot_reader &in) {}
 
       protected:
         virtual void on_attach_to_scene() {}
@@ -64,58 +189,384 @@ namespace engine::scene {
         std::weak_ptr<scene> m_scene;
         uint64_t             m_id;
 
-        std::shared_ptr<scene_object>           m_parent;
-        std::set<std::shared_ptr<scene_object>> m_children;
+        std::weak_ptr<scene_object>                m_parent;
+        std::vector<std::shared_ptr<scene_object>> m_children;
+
+        name_id m_name;
+
+        entity           m_entity;
+        transform_handle m_transform;
+        metrics::counter m_type_counter; // scene_objects{type="..."} for its concrete type, set when it is spawned
+
+        bool m_asleep        = false; // only changed by the scene at sync points
+        bool m_removing      = false; // set while scene::remove_objects takes the object out of its update groups
+        bool m_sleep_changed = false; // listed in the scene's sleep changes, until it next refreshes its update groups
 
-        std::string m_name = std::string();
+        // the scene's sleep bookkeeping, kept in the object rather than in a table as large as the scene, which every
+        // sleep and wake would miss the cache on; the serial is bumped on every sleep and wake, so the timers and event
+        // waits of earlier sleeps are ignored
+        uint32_t m_sleep_serial = 0;
+        uint64_t m_wake_frame   = UINT64_MAX;
+        double   m_wake_time    = 0.0; // when sleeping for seconds; timers that fire before it are scheduled again
 
-        void set_name(const std::string &name);
+        void set_name(name_id name);
 
         friend class scene;
+        friend class scene_snapshot;
+        friend class scene_history;
+
+        template <typename... Args>
+        friend class update_phase;
 
         void internal_attach_to_scene(const std::shared_ptr<scene> &scene);
         void internal_detach_from_scene();
 
         void _add_child(const std::shared_ptr<scene_object> &child);
+        void _remove_child(const std::shared_ptr<scene_object> &child);
         void _set_parent(const std::shared_ptr<scene_object> &parent);
 
+        /**
+         * Allocates the object and its control block as a single block from the pool, or from the global heap when no
+         * pool is given.
+         */
         template <std::derived_from<scene_object> T, typename... Args>
-        [[nodiscard]] static std::shared_ptr<T> create(std::weak_ptr<scene> &&scene, const uint64_t id, Args &&...args) {
-            // ReSharper disable once CppSmartPointerVsMakeFunction
-            return std::shared_ptr<T>(new T(scene, id, std::forward<Args>(args)...));
+        [[nodiscard]] static std::shared_ptr<T> create(
+            const std::shared_ptr<pool_resource> &pool, std::weak_ptr<scene> &&scene, const uint64_t id, Args &&...args
+        ) {
+            if (!pool)
+                return std::make_shared<T>(scene, id, std::forward<Args>(args)...);
+            return std::allocate_shared<T>(pool_allocator<T>(pool), scene, id, std::forward<Args>(args)...);
         }
     };
 
+    /**
+     * A set of objects updated through one scene_object member function. Objects are stored in dense arrays grouped
+     * by concrete type, in insertion order, so iteration is deterministic and each run of same-typed objects is updated
+     * with a single indirect call to that type's batch function.
+     *
+     * Only awake objects are updated: each run also keeps its awake objects in an array of their own, so a run of
+     * mostly sleeping objects costs as much as its awake ones. Putting objects to sleep and waking them reorders that
+     * array (deterministically) but leaves objects() and version() alone.
+     */
     template <typename... Args>
     class update_phase {
       public:
         using update_func = void (scene_object::*)(Args...);
-        explicit update_phase(const update_func f, std::unordered_set<std::shared_ptr<scene_object>> &set)
-            : m_objects(set), m_update_function(f) {}
+        using batch_func  = void (*)(std::span<const std::shared_ptr<scene_object>> objects, Args... args);
+
+        struct type_run {
+            std::type_index                            type;
+            batch_func                                 batch; // nullptr falls back to virtual dispatch
+            std::vector<std::shared_ptr<scene_object>> objects;
+            std::vector<std::shared_ptr<scene_object>> awake;           // the objects updated, a subset of objects
+            bool                                       erasing = false; // holds an object a batch erase is removing
+            std::vector<size_t>                        holes;           // refresh_awake's scratch
+        };
+
+        explicit update_phase(const update_func f) : m_update_function(f) {}
+
+        /**
+         * @return A number that changes whenever an object is added or removed.
+         */
+        [[nodiscard]] inline uint64_t version() const noexcept { return m_version; }
+
+        /**
+         * Adds an object to the run for its type. When batch is nullptr the object is updated through the phase's
+         * member function pointer instead. An object that is asleep is only updated once it wakes.
+         */
+        void insert(const std::type_index type, const batch_func batch, const std::shared_ptr<scene_object> &object) {
+            if (m_run_of.contains(object.get()))
+                return;
+
+            auto it = std::ranges::find_if(m_runs, [&](const type_run &run) {
+                return run.type == type && run.batch == batch;
+            });
+            if (it == m_runs.end()) {
+                it = m_runs.insert(m_runs.end(), type_run{type, batch, {}, {}, false, {}});
+            }
+
+            it->objects.push_back(object);
+            size_t awake = asleep;
+            if (!object->is_asleep()) {
+                awake = it->awake.size();
+                it->awake.push_back(object);
+            }
+            m_run_of.try_emplace(object.get(), member{static_cast<size_t>(it - m_runs.begin()), awake});
+            ++m_version;
+        }
+
+        bool erase(const std::shared_ptr<scene_object> &object) {
+            const member *found = m_run_of.find(object.get());
+            if (!found)
+                return false;
+
+            const member m   = *found;
+            type_run    &run = m_runs[m.run];
+            m_run_of.erase(object.get());
+            run.objects.erase(std::ranges::find(run.objects, object));
+            if (m.awake != asleep) {
+                // keeps the order, so a group nothing sleeps in updates in insertion order
+                run.awake.erase(run.awake.begin() + static_cast<ptrdiff_t>(m.awake));
+                _reindex_awake(run, m.awake);
+            }
+            ++m_version;
+            return true;
+        }
+
+        /**
+         * Removes the objects scene::remove_objects is removing, which it marks for the duration, with a single pass
+         * over each run that holds any of them. Objects not in the phase are skipped.
+         */
+        size_t erase(const std::span<const std::shared_ptr<scene_object>> objects) {
+            size_t found = 0;
+            for (const auto &object : objects) {
+                if (const member *m = m_run_of.find(object.get())) {
+                    m_runs[m->run].erasing = true;
+                    m_run_of.erase(object.get());
+                    ++found;
+                }
+            }
+            if (found == 0)
+                return 0;
+
+            const auto removing = [](const std::shared_ptr<scene_object> &object) { return object->m_removing; };
+            for (auto &run : m_runs) {
+                if (!std::exchange(run.erasing, false))
+                    continue;
+
+                // keeps the order of what is left, as erase does
+                const auto first = std::ranges::find_if(run.awake, removing);
+                if (first != run.awake.end()) {
+                    const auto from = static_cast<size_t>(first - run.awake.begin());
+                    std::erase_if(run.awake, removing);
+                    _reindex_awake(run, from);
+                }
+                std::erase_if(run.objects, removing);
+            }
+            ++m_version;
+            return found;
+        }
+
+        void clear() {
+            m_runs.clear();
+            m_run_of.clear();
+            ++m_version;
+        }
+
+        /**
+         * Takes a batch of objects that fell asleep out of the awake objects of their runs and puts a batch that woke
+         * back in. The woken take the places the sleepers left, in the order given, and the last awake objects of a
+         * run fill whatever places are left over, so the cost follows the objects that changed rather than the awake
+         * ones. Objects not in the phase are skipped.
+         */
+        void refresh_awake(
+            const std::span<const std::shared_ptr<scene_object>> slept,
+            const std::span<const std::shared_ptr<scene_object>> woken
+        ) {
+            for (const auto &object : slept) {
+                member *m = m_run_of.find(object.get());
+                if (!m || m->awake == asleep)
+                    continue;
+                type_run &run = m_runs[m->run];
+                run.awake[m->awake].reset();
+                run.holes.push_back(std::exchange(m->awake, asleep));
+            }
+
+            for (const auto &object : woken) {
+                member *m = m_run_of.find(object.get());
+                if (!m || m->awake != asleep)
+                    continue;
+                type_run &run = m_runs[m->run];
+                if (run.holes.empty()) {
+                    m->awake = run.awake.size();
+                    run.awake.push_back(object);
+                } else {
+                    m->awake = run.holes.back();
+                    run.holes.pop_back();
+                    run.awake[m->awake] = object;
+                }
+            }
+
+            for (auto &run : m_runs) {
+                // from the back, so the last awake object is never itself a hole
+                std::ranges::sort(run.holes, std::greater{});
+                for (const size_t hole : run.holes) {
+                    if (hole != run.awake.size() - 1) {
+                        run.awake[hole]                            = std::move(run.awake.back());
+                        m_run_of.find(run.awake[hole].get())->awake = hole;
+                    }
+                    run.awake.pop_back();
+                }
+                run.holes.clear();
+            }
+        }
+
+        [[nodiscard]] bool contains(const std::shared_ptr<scene_object> &object) const {
+            return m_run_of.contains(object.get());
+        }
+
+        [[nodiscard]] size_t size() const noexcept { return m_run_of.size(); }
+
+        [[nodiscard]] size_t awake_size() const noexcept {
+            size_t count = 0;
+            for (const auto &run : m_runs) {
+                count += run.awake.size();
+            }
+            return count;
+        }
+
+        [[nodiscard]] const std::vector<type_run> &runs() const noexcept { return m_runs; }
 
         void run_updates(Args... args) {
-            for (const auto &object : m_objects) {
-                std::invoke(m_update_function, object, std::forward<Args>(args)...);
+            for (const auto &run : m_runs) {
+                if (run.batch) {
+                    run.batch(run.awake, args...);
+                } else {
+                    for (const auto &object : run.awake) {
+                        std::invoke(m_update_function, object, args...);
+                    }
+                }
             }
         }
 
+        /**
+         * Updates the phase's objects in chunks of at most chunk_size objects, spread across the job system. Each chunk
+         * still belongs to a single type run.
+         */
+        void run_updates_parallel(job_system &jobs, const size_t chunk_size, Args... args) {
+            job_counter counter;
+            for (const auto &run : m_runs) {
+                const size_t count = run.awake.size();
+                for (size_t begin = 0; begin < count; begin += chunk_size) {
+                    const auto chunk =
+                        std::span<const std::shared_ptr<scene_object>>(run.awake).subspan(
+                            begin, std::min(chunk_size, count - begin)
+                        );
+                    jobs.submit(
+                        [this, &run, chunk, args...] {
+                            if (run.batch) {
+                                run.batch(chunk, args...);
+                            } else {
+                                for (const auto &object : chunk) {
+                                    std::invoke(m_update_function, object, args...);
+                                }
+                            }
+                        },
+                        &counter
+                    );
+                }
+            }
+            jobs.wait(counter);
+        }
+
       private:
-        std::unordered_set<std::shared_ptr<scene_object>> &m_objects;
-        update_func                                        m_update_function;
+        static constexpr size_t asleep = SIZE_MAX;
+
+        struct member {
+            size_t run;
+            size_t awake; // index in the run's awake objects, or asleep
+        };
+
+        std::vector<type_run>                  m_runs;
+        flat_pointer_map<scene_object, member> m_run_of; // keeps its capacity, so churn does not allocate
+        update_func                            m_update_function;
+        uint64_t                               m_version = 0;
+
+        void _reindex_awake(type_run &run, const size_t first) {
+            for (size_t i = first; i < run.awake.size(); ++i) {
+                m_run_of.find(run.awake[i].get())->awake = i;
+            }
+        }
     };
 
     struct update_group {
-        std::unordered_set<std::shared_ptr<scene_object>> objects;
+        update_phase<double> on_update{&scene_object::update};
+
+        /**
+         * When set (and the scene has a job system), the group's objects are updated in parallel chunks. The objects'
+         * update functions must then be safe to run concurrently with each other.
+         */
+        bool   parallel   = false;
+        size_t chunk_size = 256;
+
+        /**
+         * Independent groups that are adjacent in the scene's update order may run concurrently with each other. Groups
+         * that are not independent still act as barriers, so ordering relative to them is preserved.
+         */
+        bool independent = false;
+
+        /**
+         * Shown for this group's zone in the profiler.
+         */
+        name_id profile_name = name_id::intern("update_group");
+
+        /**
+         * Inserts an object whose exact type is known, so its run is updated with non-virtual calls to T::update.
+         */
+        template <std::derived_from<scene_object> T>
+        void insert(const std::shared_ptr<T> &object) {
+            if (typeid(*object) == typeid(T)) {
+                on_update.insert(typeid(T), &batch_update<T>, object);
+            } else {
+                insert(std::static_pointer_cast<scene_object>(object));
+            }
+        }
+
+        inline void insert(const std::shared_ptr<scene_object> &object) {
+            on_update.insert(typeid(*object), nullptr, object);
+        }
 
-        update_phase<double> on_update{&scene_object::update, objects};
+        inline bool erase(const std::shared_ptr<scene_object> &object) { return on_update.erase(object); }
 
-        inline void insert(const std::shared_ptr<scene_object> &object) { objects.insert(object); }
+        [[nodiscard]] inline size_t size() const noexcept { return on_update.size(); }
+        [[nodiscard]] inline size_t awake_size() const noexcept { return on_update.awake_size(); }
 
         inline void update(const double delta) { on_update.run_updates(delta); }
+
+        inline void update(job_system *jobs, const double delta) {
+            ENGINE_PROFILE_ZONE_NAMED(profile_name);
+            _publish_size();
+
+            if (parallel && jobs) {
+                on_update.run_updates_parallel(*jobs, chunk_size, delta);
+            } else {
+                on_update.run_updates(delta);
+            }
+        }
+
+      private:
+        name_id        m_size_gauge_name;
+        metrics::gauge m_size_gauge;
+        metrics::gauge m_awake_gauge;
+
+        // groups that share a profile_name share the gauge
+        void _publish_size();
+
+        template <std::derived_from<scene_object> T>
+        static void batch_update(const std::span<const std::shared_ptr<scene_object>> objects, const double delta) {
+            for (const auto &object : objects) {
+                static_cast<T *>(object.get())->T::update(delta);
+            }
+        }
     };
 
-    class scene : std::enable_shared_from_this<scene> {
+    class scene : public std::enable_shared_from_this<scene> {
       public:
+        static constexpr std::string_view default_phase_name   = "update";
+        static constexpr std::string_view transform_phase_name = "transform";
+        static constexpr std::string_view spatial_phase_name   = "spatial";
+
+        // what the default phase declares it writes; phases that read or write scene objects should name it too
+        static constexpr std::string_view objects_resource_name = "scene_objects";
+
+        scene();
+        ~scene();
+
+        scene(const scene &other)                = delete;
+        scene(scene &&other) noexcept            = delete;
+        scene &operator=(const scene &other)     = delete;
+        scene &operator=(scene &&other) noexcept = delete;
+
         /**
          * @tparam T The scene object type
          * @tparam Args
@@ -124,12 +575,18 @@ namespace engine::scene {
          */
         template <std::derived_from<scene_object> T, typename... Args>
         std::pair<uint64_t, std::shared_ptr<scene_object>> emplace_object(Args &&...args) {
-            const auto id = ++m_last_object_id;
-            const auto &[it, s] = m_objects.emplace(
-                id, scene_object::create<T>(weak_from_this(), id, std::forward<Args>(args)...)
-            );
-            it->second->on_attach_to_scene();
-            return {it->first, it->second};
+            // a copy: on_attach_to_scene may add or remove objects, which moves the slot map's values
+            const object_type &type   = _object_type<T>();
+            const auto         id     = m_objects.next_handle().to_id();
+            const auto         object = *m_objects.get(m_objects.insert(
+                scene_object::create<T>(type.pool, weak_from_this(), id, std::forward<Args>(args)...)
+            ));
+            object->m_transform    = m_transforms.create();
+            object->m_type_counter = type.counter;
+            type.counter.increment();
+            _mark_dirty(id);
+            object->on_attach_to_scene();
+            return {id, object};
         }
 
         /**
@@ -140,72 +597,449 @@ namespace engine::scene {
          * @return A pair [id, object]
          */
         template <std::derived_from<scene_object> T, typename... Args>
-        std::pair<uint64_t, std::shared_ptr<scene_object>> emplace_object_named(const std::string &name, Args &&...args) {
-            const auto id = ++m_last_object_id;
-            const auto &[it, s] = m_objects.emplace(
-                id, scene_object::create<T>(weak_from_this(), id, std::forward<Args>(args)...)
-            );
+        std::pair<uint64_t, std::shared_ptr<scene_object>> emplace_object_named(const hashed_name name, Args &&...args) {
+            // a copy, as in emplace_object
+            const object_type &type   = _object_type<T>();
+            const auto         id     = m_objects.next_handle().to_id();
+            const auto         object = *m_objects.get(m_objects.insert(
+                scene_object::create<T>(type.pool, weak_from_this(), id, std::forward<Args>(args)...)
+            ));
 
-            it->second->set_name(name);
+            const name_id interned = name_id::intern(name);
+            object->set_name(interned);
+            object->m_transform    = m_transforms.create();
+            object->m_type_counter = type.counter;
 
-            m_named_objects[name] = it->second;
+            m_named_objects.insert_or_assign(interned, object);
+            type.counter.increment();
+            _mark_dirty(id);
 
-            it->second->on_attach_to_scene();
-            return {it->first, it->second};
+            object->on_attach_to_scene();
+            return {id, object};
         }
 
         template <std::derived_from<scene_object> T, typename... Args>
         std::pair<uint64_t, std::shared_ptr<scene_object>>
         emplace_object_ug(const std::shared_ptr<update_group> &update_group, Args &&...args) {
             const auto pair = emplace_object<T>(std::forward<Args>(args)...);
-            update_group->insert(pair.second);
+            update_group->insert(std::static_pointer_cast<T>(pair.second));
             return pair;
         }
 
         template <std::derived_from<scene_object> T, typename... Args>
         std::pair<uint64_t, std::shared_ptr<scene_object>>
-        emplace_object_named_ug(const std::string &name, const std::shared_ptr<update_group> &update_group, Args &&...args) {
+        emplace_object_named_ug(const hashed_name name, const std::shared_ptr<update_group> &update_group, Args &&...args) {
             const auto pair = emplace_object_named<T>(name, std::forward<Args>(args)...);
-            update_group->insert(pair.second);
+            update_group->insert(std::static_pointer_cast<T>(pair.second));
             return pair;
         }
 
-        std::shared_ptr<scene_object> get_scene_object(const std::string &name) const;
+        /**
+         * Spawns count objects of type T, each constructed with the same arguments. Storage for all of them is reserved
+         * up front in the scene's pool for T.
+         *
+         * @return The [id, object] pairs, in spawn order
+         */
+        template <std::derived_from<scene_object> T, typename... Args>
+        std::vector<std::pair<uint64_t, std::shared_ptr<scene_object>>> emplace_objects(const size_t count, const Args &...args) {
+            _object_pool<T>()->reserve(count);
+            m_objects.reserve(m_objects.size() + count);
+
+            std::vector<std::pair<uint64_t, std::shared_ptr<scene_object>>> objects;
+            objects.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                objects.push_back(emplace_object<T>(args...));
+            }
+            return objects;
+        }
+
+        template <std::derived_from<scene_object> T, typename... Args>
+        std::vector<std::pair<uint64_t, std::shared_ptr<scene_object>>>
+        emplace_objects_ug(const size_t count, const std::shared_ptr<update_group> &update_group, const Args &...args) {
+            auto objects = emplace_objects<T>(count, args...);
+            for (const auto &[_, object] : objects) {
+                update_group->insert(std::static_pointer_cast<T>(object));
+            }
+            return objects;
+        }
+
+        /**
+         * Removes an object from the scene, its name, its update groups and its components, then detaches it.
+         *
+         * @return false if no object has the id
+         */
+        bool remove_object(uint64_t id);
+
+        /**
+         * Removes many objects at once, visiting each update group only once.
+         *
+         * @return The number of objects removed
+         */
+        size_t remove_objects(std::span<const uint64_t> ids);
+
+        /**
+         * Renames an object, replacing its previous entry in the name index. An empty name removes it from the index.
+         */
+        void rename_object(uint64_t id, hashed_name name);
+
+        /**
+         * Puts an object to sleep: its update groups skip it, so it costs nothing per update, until it wakes as options
+         * says. Putting a sleeping object to sleep again replaces what it waits for. Recorded and applied at the next
+         * sync point, like commands(), so it is safe to call from parallel updates; the object is updated for the rest
+         * of the current phase. Time and frame waits are kept in a timer wheel and checked at the start of each update,
+         * so the object is updated in the update it wakes in.
+         *
+         * Sleep is not saved in snapshots or recorded by scene_history.
+         */
+        void sleep_object(uint64_t id, const sleep_options &options);
+
+        /**
+         * Wakes a sleeping object at the next sync point.
+         */
+        void wake_object(uint64_t id);
+
+        /**
+         * Wakes every object sleeping until event. Applied at the next sync point after every sleep recorded up to it,
+         * so an object that goes to sleep for an event in the same phase as it is signalled does not miss it.
+         */
+        void signal(name_id event);
+
+        /**
+         * @return The number of updates run
+         */
+        [[nodiscard]] inline uint64_t get_frame() const noexcept { return m_frame; }
+
+        /**
+         * @return The total of every update's delta
+         */
+        [[nodiscard]] inline double get_time() const noexcept { return m_time; }
+
+        [[nodiscard]] inline size_t get_sleeping_count() const noexcept { return m_sleeping_count; }
+
+        /**
+         * Keeps an object in the scene's spatial index, with a box given in its own space. The index holds the box
+         * around it in world space, which follows the object's world transform: it is refreshed in the "spatial" phase,
+         * after transforms are updated, for every object whose world transform changed. Until then a new or changed box
+         * is placed using the world transform of the last update. An empty box takes the object out of the index.
+         *
+         * Applied at once, so it must be called from the main thread outside parallel work; update code should use
+         * scene_object::set_bounds (or commands().set_bounds) instead. Bounds are not saved in snapshots or recorded by
+         * scene_history.
+         */
+        void set_object_bounds(uint64_t id, const aabb &local_bounds);
+
+        /**
+         * @return The index of every object with bounds, as of the last "spatial" phase. Queries return object ids.
+         */
+        [[nodiscard]] inline const spatial_index &spatial() const noexcept { return *m_spatial; }
+
+        /**
+         * Replaces the spatial index (an aabb_tree by default) and moves every object with bounds into it. Must not be
+         * called during an update.
+         */
+        void set_spatial_index(std::unique_ptr<spatial_index> index);
+
+        /**
+         * @return The calling thread's command buffer for this scene. Structural changes made from update code (and in
+         * particular from parallel work) should be recorded here rather than applied directly.
+         */
+        [[nodiscard]] command_buffer &commands();
+
+        /**
+         * Applies every recorded command, ordered by key then by recording order. Runs automatically at the end of each
+         * phase (or wave of concurrent phases; see phase_graph). Must not be called while other threads record.
+         */
+        void flush_commands();
+
+        /**
+         * Records that an object changed, for the scene_history recording this scene. Does nothing when none is.
+         */
+        inline void mark_dirty(const uint64_t id) { _mark_dirty(id); }
+
+        std::shared_ptr<scene_object> get_scene_object(hashed_name name) const;
         std::shared_ptr<scene_object> get_scene_object(uint64_t id) const;
 
-        bool has_scene_object(const std::string &name) const;
+        bool has_scene_object(hashed_name name) const;
         bool has_scene_object(uint64_t id) const;
 
-        uint64_t add_resource(const std::shared_ptr<void> &resource);
-        uint64_t add_resource(const std::string &name, const std::shared_ptr<void> &resource);
+        /**
+         * @return Every object in the scene, stored densely. Order changes when objects are removed.
+         */
+        [[nodiscard]] inline std::span<const std::shared_ptr<scene_object>> get_scene_objects() const noexcept {
+            return m_objects.values();
+        }
+
+        /**
+         * Adds a resource that already exists in memory. It stays resident for the lifetime of the scene.
+         */
+        template <typename T>
+        resource_handle<T> add_resource(const hashed_name name, std::shared_ptr<T> resource, const size_t bytes = 0) {
+            return m_resources.add<T>(name, std::move(resource), bytes);
+        }
+
+        /**
+         * Starts loading a resource from a file in the background. See resource_manager::load.
+         */
+        template <typename T>
+        resource_handle<T> load_resource(const hashed_name path) {
+            return m_resources.load<T>(path);
+        }
+
+        /**
+         * @return The resource if it was added or requested before as a T, or a null handle.
+         */
+        template <typename T>
+        resource_handle<T> get_resource(const hashed_name name) const {
+            return m_resources.find<T>(name);
+        }
 
-        std::shared_ptr<void> get_resource(const std::string &name) const;
-        std::shared_ptr<void> get_resource(uint64_t id) const;
+        [[nodiscard]] inline bool has_resource(const hashed_name name) const { return m_resources.contains(name); }
 
-        bool has_resource(const std::string &name) const;
-        bool has_resource(uint64_t id) const;
+        [[nodiscard]] inline resource_manager       &resources() noexcept { return m_resources; }
+        [[nodiscard]] inline const resource_manager &resources() const noexcept { return m_resources; }
 
+        /**
+         * These add update groups to the default "update" phase.
+         */
         std::shared_ptr<update_group> push_end_new_update_group();
         std::shared_ptr<update_group> push_front_new_update_group();
         std::shared_ptr<update_group> push_new_update_group_after(const std::shared_ptr<update_group> &group);
         std::shared_ptr<update_group> push_new_update_group_before(const std::shared_ptr<update_group> &group);
 
-        void update(double delta) const;
+        /**
+         * Registers a phase of the frame. The phase graph is recompiled incrementally on the next update.
+         *
+         * @throws std::logic_error if the phase's ordering constraints form a cycle; the phase is then not added
+         */
+        std::shared_ptr<phase> add_phase(phase_desc desc);
+
+        [[nodiscard]] std::shared_ptr<phase> get_phase(std::string_view name) const;
+
+        [[nodiscard]] inline const std::shared_ptr<phase> &get_default_phase() const noexcept { return m_default_phase; }
+
+        /**
+         * @return Per-phase timings and the critical path of the last update.
+         */
+        [[nodiscard]] inline const phase_graph::frame_report &get_frame_report() const noexcept {
+            return m_phases.last_report();
+        }
+
+        void update(double delta);
+
+        /**
+         * @return The calling thread's arena for transient allocations, which live until the start of the next update.
+         * Each thread gets its own, so objects in parallel and independent update groups can allocate from it too.
+         */
+        [[nodiscard]] frame_arena &get_frame_arena();
+
+        /**
+         * Sets the job system used for parallel and independent update groups and for resource loads. Without one, every
+         * group runs serially and resources load on the calling thread.
+         */
+        inline void set_job_system(std::shared_ptr<job_system> jobs) {
+            m_resources.set_job_system(jobs);
+            m_job_system = std::move(jobs);
+        }
+
+        [[nodiscard]] inline const std::shared_ptr<job_system> &get_job_system() const noexcept { return m_job_system; }
+
+        [[nodiscard]] inline transform_hierarchy       &transforms() noexcept { return m_transforms; }
+        [[nodiscard]] inline const transform_hierarchy &transforms() const noexcept { return m_transforms; }
+
+        [[nodiscard]] inline component_storage       &components() noexcept { return m_components; }
+        [[nodiscard]] inline const component_storage &components() const noexcept { return m_components; }
 
       private:
-        uint64_t m_last_object_id   = 0;
-        uint64_t m_last_resource_id = 0;
+        phase_graph            m_phases;
+        std::shared_ptr<phase> m_default_phase;
+
+        slot_map<std::shared_ptr<scene_object>>      m_objects;
+        flat_name_map<std::shared_ptr<scene_object>> m_named_objects;
+
+        resource_manager m_resources{resource_manager::settings{}};
+
+        component_storage   m_components;
+        transform_hierarchy m_transforms;
+
+        struct bounded_object {
+            uint64_t             id;
+            transform_handle     transform;
+            aabb                 local;
+            spatial_index::proxy proxy;
+            bool                 stale; // placed with an old world transform or box; refreshed in the next spatial phase
+        };
+
+        std::unique_ptr<spatial_index> m_spatial = std::make_unique<aabb_tree>(aabb_tree::settings{});
+        std::vector<bounded_object>    m_bounded;
+        std::vector<uint32_t>          m_bounded_by_slot; // index into m_bounded, or no_bounds
+        static constexpr uint32_t      no_bounds = UINT32_MAX;
+
+        std::shared_ptr<job_system> m_job_system;
+
+        struct sleep_request {
+            uint64_t      id;
+            sleep_options options;
+            bool          wake; // options are ignored
+        };
+
+        struct sleep_ref {
+            uint64_t id;
+            uint32_t serial;
+        };
+
+        uint64_t                              m_frame = 0;
+        double                                m_time  = 0.0;
+        double                                m_delta = 0.0; // of the last update, to turn seconds into updates
+        timer_wheel                           m_timers;
+        flat_name_map<std::vector<sleep_ref>> m_event_sleepers;
+        size_t                                m_sleeping_count = 0;
+
+        // objects that fell asleep or woke since the update groups were last refreshed, each listed once with whether
+        // it was asleep before, and the two batches _refresh_awake sorts them into; kept for their capacity
+        struct sleep_change {
+            std::shared_ptr<scene_object> object;
+            bool                          was_asleep;
+        };
+        std::vector<sleep_change>                  m_sleep_changes;
+        std::vector<std::shared_ptr<scene_object>> m_slept;
+        std::vector<std::shared_ptr<scene_object>> m_woken;
+
+        std::vector<const std::shared_ptr<scene_object> *> m_found; // _find_objects' results, kept for its capacity
+
+        metrics::counter m_sleeping_metric = metrics::registry::get().get_up_down_counter("scene_sleeping_objects");
 
-        std::vector<std::shared_ptr<update_group>> m_update_phases;
+        // what each thread records into between sync points
+        struct thread_buffers {
+            command_buffer             commands;
+            std::vector<uint64_t>      dirty; // ids marked since the history last captured
+            std::vector<sleep_request> sleeps;
+            std::vector<name_id>       signals;
+            frame_arena                arena; // reset by every update
+        };
 
-        std::list<std::shared_ptr<update_group>> m_update_groups;
+        const uint64_t                                             m_uid;
+        std::mutex                                                 m_buffer_mutex;
+        std::map<std::thread::id, std::unique_ptr<thread_buffers>> m_thread_buffers;
 
-        std::map<std::shared_ptr<update_group>, typename decltype(m_update_groups)::iterator> m_update_group_map;
+        // set while a scene_history records the scene; only changed between updates
+        bool m_track_changes = false;
 
-        std::map<uint64_t, std::shared_ptr<scene_object>> m_objects;
-        std::map<uint64_t, std::shared_ptr<void>>         m_resources;
+        struct object_type {
+            std::shared_ptr<pool_resource> pool;
+            // scene_objects{type="..."} is the number of live objects of each type, across every scene
+            metrics::counter counter;
+        };
 
-        std::map<std::string, std::shared_ptr<scene_object>> m_named_objects;
-        std::map<std::string, std::shared_ptr<void>>         m_named_resources;
+        std::vector<object_type>                   m_object_types; // indexed by object_type_id_of, grown on first spawn
+        std::vector<std::shared_ptr<scene_object>> m_removed; // remove_objects' scratch, kept for its capacity
+
+        metrics::histogram m_frame_arena_bytes = metrics::registry::get().get_histogram("frame_arena_bytes");
+
+        void _unindex_name(const std::shared_ptr<scene_object> &object);
+
+        void _apply_sleeps(std::vector<sleep_request> &requests, std::vector<name_id> &signals);
+        void _sleep(const std::shared_ptr<scene_object> &object, const sleep_options &options);
+        void _wake(const std::shared_ptr<scene_object> &object);
+
+        // wakes the objects whose timers are due at the start of an update that started at start
+        void _wake_due(double start);
+
+        // looks up every id into m_found (null where the object is gone) before anything reads the objects, so the
+        // cache misses of the lookups overlap rather than each waiting on the work done with the last object
+        template <std::ranges::input_range R>
+        void _find_objects(R &&ids) {
+            m_found.clear();
+            for (const uint64_t id : ids) {
+                m_found.push_back(m_objects.get(slot_handle::from_id(id)));
+            }
+        }
+
+        // the first update starting at or after a scene time, as far as the last update's delta tells
+        [[nodiscard]] uint64_t _frame_at(double time) const;
+
+        // notes that the object fell asleep or woke, for the next _refresh_awake
+        void _sleep_changed(const std::shared_ptr<scene_object> &object);
+
+        // moves the objects that fell asleep or woke since the last call in or out of the awake objects of every
+        // update group they are in
+        void _refresh_awake();
+
+        void _clear_bounds(uint64_t id);
+
+        // moves the boxes of objects whose world transform changed in the last transform update
+        void _refresh_bounds();
+
+        metrics::counter _object_counter(std::type_index type);
+
+        thread_buffers &_thread_buffers();
+
+        inline void _mark_dirty(const uint64_t id) {
+            if (m_track_changes)
+                _thread_buffers().dirty.push_back(id);
+        }
+
+        // takes every thread's dirty ids, unsorted and possibly repeated
+        std::vector<uint64_t> _take_dirty();
+
+        friend class scene_snapshot;
+        friend class snapshot_types;
+        friend class scene_history;
+
+        /**
+         * Creates an object with exactly the given id, whose slot must be free. Used to bring back destroyed objects.
+         */
+        template <std::derived_from<scene_object> T>
+        std::shared_ptr<scene_object> _emplace_object_at(const uint64_t id) {
+            // a copy, as in emplace_object
+            const object_type &type   = _object_type<T>();
+            const auto         object = *m_objects.get(m_objects.emplace_at(
+                slot_handle::from_id(id), scene_object::create<T>(type.pool, weak_from_this(), id)
+            ));
+            object->m_transform    = m_transforms.create();
+            object->m_type_counter = type.counter;
+            type.counter.increment();
+            _mark_dirty(id);
+            object->on_attach_to_scene();
+            return object;
+        }
+
+        template <std::derived_from<scene_object> T>
+        const object_type &_object_type() {
+            const uint32_t id = object_type_id_of<T>();
+            if (id >= m_object_types.size()) {
+                m_object_types.resize(id + 1);
+            }
+
+            object_type &type = m_object_types[id];
+            if (!type.pool) {
+                type.pool    = std::make_shared<pool_resource>();
+                type.counter = _object_counter(typeid(T));
+            }
+            return type;
+        }
+
+        template <std::derived_from<scene_object> T>
+        const std::shared_ptr<pool_resource> &_object_pool() {
+            return _object_type<T>().pool;
+        }
     };
+
+    template <typename T, typename... Args>
+    T &scene_object::emplace_component(Args &&...args) {
+        const auto s = m_scene.lock();
+        if (!s) {
+            throw std::logic_error("Cannot add components to an object that is not attached to a scene");
+        }
+
+        if (!s->components().is_alive(m_entity)) {
+            m_entity = s->components().create_entity();
+        }
+        return s->components().emplace_component<T>(m_entity, std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    T *scene_object::get_component() const {
+        const auto s = m_scene.lock();
+        return s ? s->components().get_component<T>(m_entity) : nullptr;
+    }
 } // namespace engine::scene
@@ -0,0 +1,460 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace engine::scene {
+    namespace format = snapshot_format;
+
+    static_assert(sizeof(glm::mat4) == sizeof(format::object_record::local_transform));
+
+    snapshot_types &snapshot_types::get() {
+        static snapshot_types instance;
+        return instance;
+    }
+
+    void snapshot_types::_add_object_type(object_type type) {
+        std::lock_guard lock(m_mutex);
+
+        if (const auto it = m_object_types_by_type.find(type.type); it != m_object_types_by_type.end()) {
+            object_type &existing = m_object_types[it->second];
+            m_object_types_by_name.erase(hashed_name{existing.name.str(), existing.name.hash()});
+            m_object_types_by_name.insert_or_assign(type.name, it->second);
+            existing = type;
+            return;
+        }
+
+        m_object_types_by_type.emplace(type.type, m_object_types.size());
+        m_object_types_by_name.insert_or_assign(type.name, m_object_types.size());
+        m_object_types.push_back(type);
+    }
+
+    void snapshot_types::_add_resource_type(resource_type type) {
+        std::lock_guard lock(m_mutex);
+
+        if (const auto it = m_resource_types_by_type.find(type.type); it != m_resource_types_by_type.end()) {
+            resource_type &existing = m_resource_types[it->second];
+            m_resource_types_by_name.erase(hashed_name{existing.name.str(), existing.name.hash()});
+            m_resource_types_by_name.insert_or_assign(type.name, it->second);
+            existing = type;
+            return;
+        }
+
+        m_resource_types_by_type.emplace(type.type, m_resource_types.size());
+        m_resource_types_by_name.insert_or_assign(type.name, m_resource_types.size());
+        m_resource_types.push_back(type);
+    }
+
+    const snapshot_types::object_type *snapshot_types::find_object_type(const std::type_index type) const {
+        std::lock_guard lock(m_mutex);
+        const auto      it = m_object_types_by_type.find(type);
+        return it != m_object_types_by_type.end() ? &m_object_types[it->second] : nullptr;
+    }
+
+    const snapshot_types::object_type *snapshot_types::find_object_type(const hashed_name name) const {
+        std::lock_guard lock(m_mutex);
+        const auto     *index = m_object_types_by_name.find(name);
+        return index ? &m_object_types[*index] : nullptr;
+    }
+
+    const snapshot_types::resource_type *snapshot_types::find_resource_type(const std::type_index type) const {
+        std::lock_guard lock(m_mutex);
+        const auto      it = m_resource_types_by_type.find(type);
+        return it != m_resource_types_by_type.end() ? &m_resource_types[it->second] : nullptr;
+    }
+
+    const snapshot_types::resource_type *snapshot_types::find_resource_type(const hashed_name name) const {
+        std::lock_guard lock(m_mutex);
+        const auto     *index = m_resource_types_by_name.find(name);
+        return index ? &m_resource_types[*index] : nullptr;
+    }
+
+    static void check(const bool condition, const char *what) {
+        if (!condition) {
+            throw std::runtime_error(std::string("Invalid scene snapshot: ") + what);
+        }
+    }
+
+    template <typename T>
+    std::span<const T> snapshot_view::_section(const format::section &section) const {
+        const uint64_t size = m_header->file_size;
+        check(section.offset % alignof(T) == 0, "misaligned section");
+        check(section.offset <= size && section.count <= (size - section.offset) / sizeof(T), "section out of bounds");
+        return {reinterpret_cast<const T *>(m_data.data() + section.offset), static_cast<size_t>(section.count)};
+    }
+
+    snapshot_view::snapshot_view(const std::span<const std::byte> data) : m_data(data) {
+        check(reinterpret_cast<uintptr_t>(data.data()) % 16 == 0, "data must be 16-byte aligned");
+        check(data.size() >= sizeof(format::file_header), "too small");
+
+        m_header = reinterpret_cast<const format::file_header *>(data.data());
+        check(m_header->magic == format::magic, "bad magic");
+        check(m_header->version == format::version, "unsupported version");
+        check(m_header->file_size <= data.size(), "truncated");
+        m_data = data.first(m_header->file_size);
+
+        m_strings   = _section<format::string_record>(m_header->strings);
+        m_types     = _section<format::type_record>(m_header->types);
+        m_objects   = _section<format::object_record>(m_header->objects);
+        m_groups    = _section<format::group_record>(m_header->groups);
+        m_members   = _section<uint32_t>(m_header->members);
+        m_resources = _section<format::resource_record>(m_header->resources);
+
+        // everything is checked here, so the accessors and the loader can trust the tables
+        const uint64_t size         = m_data.size();
+        const auto     valid_string = [&](const uint32_t index) { return index < m_strings.size(); };
+
+        for (const auto &str : m_strings) {
+            check(str.offset <= size && str.size <= size - str.offset, "string out of bounds");
+        }
+        for (const auto &type : m_types) {
+            check(valid_string(type.name), "bad type name");
+        }
+        for (size_t i = 0; i < m_objects.size(); ++i) {
+            const auto &object = m_objects[i];
+            check(object.state_offset <= size && object.state_size <= size - object.state_offset, "state out of bounds");
+            check(object.type < m_types.size(), "bad object type");
+            check(object.parent == format::none || object.parent < i, "parent after child");
+            check(object.name == format::none || valid_string(object.name), "bad object name");
+        }
+        for (const auto &group : m_groups) {
+            check(valid_string(group.phase) && valid_string(group.profile_name), "bad group name");
+            check(group.first_member <= m_members.size() && group.member_count <= m_members.size() - group.first_member,
+                  "group members out of bounds");
+        }
+        for (const uint32_t member : m_members) {
+            check(member < m_objects.size(), "bad group member");
+        }
+        for (const auto &resource : m_resources) {
+            check(valid_string(resource.path) && valid_string(resource.type), "bad resource");
+        }
+    }
+
+    std::string_view snapshot_view::string(const uint32_t index) const {
+        const auto &str = m_strings[index];
+        return {reinterpret_cast<const char *>(m_data.data() + str.offset), static_cast<size_t>(str.size)};
+    }
+
+    // collects the tables of a snapshot before they are laid out in the file
+    struct snapshot_tables {
+        std::vector<format::string_record>   strings;
+        std::vector<format::type_record>     types;
+        std::vector<format::object_record>   objects;
+        std::vector<format::group_record>    groups;
+        std::vector<uint32_t>                members;
+        std::vector<format::resource_record> resources;
+        std::vector<std::byte>               data; // offsets into it are made absolute once the layout is known
+
+        std::unordered_map<uint32_t, uint32_t>        string_of_name;
+        std::unordered_map<std::type_index, uint32_t> type_of;
+
+        uint32_t add_string(const name_id name) {
+            const auto [it, added] = string_of_name.try_emplace(name.index(), static_cast<uint32_t>(strings.size()));
+            if (added) {
+                strings.push_back(format::string_record{.offset = data.size(), .size = name.str().size()});
+                snapshot_writer(data).write_bytes(std::as_bytes(std::span(name.str())));
+            }
+            return it->second;
+        }
+
+        uint32_t add_type(const scene_object &object) {
+            const std::type_index type = typeid(object);
+            if (const auto it = type_of.find(type); it != type_of.end())
+                return it->second;
+
+            const auto *registered = snapshot_types::get().find_object_type(type);
+            if (!registered) {
+                throw std::logic_error(std::string("Scene object type ") + type.name() +
+                                       " is not registered with snapshot_types");
+            }
+
+            const auto index = static_cast<uint32_t>(types.size());
+            types.push_back(format::type_record{.name = add_string(registered->name), .version = registered->version});
+            type_of.emplace(type, index);
+            return index;
+        }
+    };
+
+    static uint64_t align_up(const uint64_t offset) {
+        return (offset + 15) & ~uint64_t(15);
+    }
+
+    std::vector<std::byte> scene_snapshot::encode(const scene &scene) {
+        snapshot_tables tables;
+
+        const auto objects     = scene.get_scene_objects();
+        const auto in_scene    = [&](const scene_object *object) {
+            return object && scene.get_scene_object(object->get_id()).get() == object;
+        };
+
+        // parents before children, and children in their parent's order, so the loader can link them as it goes
+        std::vector<const scene_object *> order;
+        order.reserve(objects.size());
+
+        uint32_t max_slot = 0;
+        for (const auto &object : objects) {
+            max_slot = std::max(max_slot, slot_handle::from_id(object->get_id()).index);
+        }
+        std::vector<uint32_t> record_of_slot(objects.empty() ? 0 : max_slot + 1, format::none);
+
+        std::vector<const scene_object *> stack;
+        for (const auto &root : objects) {
+            if (const auto parent = root->get_parent(); parent && in_scene(parent.get()))
+                continue;
+
+            stack.push_back(root.get());
+            while (!stack.empty()) {
+                const scene_object *object = stack.back();
+                stack.pop_back();
+
+                record_of_slot[slot_handle::from_id(object->get_id()).index] = static_cast<uint32_t>(order.size());
+                order.push_back(object);
+
+                const auto children = object->get_children();
+                for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                    if (in_scene(it->get()))
+                        stack.push_back(it->get());
+                }
+            }
+        }
+
+        const auto record_of = [&](const scene_object &object) {
+            return record_of_slot[slot_handle::from_id(object.get_id()).index];
+        };
+
+        tables.objects.reserve(order.size());
+        for (const scene_object *object : order) {
+            format::object_record record{};
+
+            const glm::mat4 local = object->get_transform().is_null()
+                                        ? glm::mat4(1.0f)
+                                        : scene.transforms().get_local(object->get_transform());
+            std::memcpy(record.local_transform, &local, sizeof(local));
+
+            record.type = tables.add_type(*object);
+
+            const auto parent = object->get_parent();
+            record.parent     = parent && in_scene(parent.get()) ? record_of(*parent) : format::none;
+            record.name       = object->m_name.empty() ? format::none : tables.add_string(object->m_name);
+
+            record.state_offset = tables.data.size();
+            snapshot_writer writer(tables.data);
+            object->save_state(writer);
+            record.state_size = static_cast<uint32_t>(tables.data.size() - record.state_offset);
+
+            tables.objects.push_back(record);
+        }
+
+        for (const auto &phase : scene.m_phases.phases()) {
+            const uint32_t phase_name = tables.add_string(name_id::intern(phase->get_name()));
+            for (const auto &group : phase->update_groups()) {
+                const auto first = static_cast<uint32_t>(tables.members.size());
+                for (const auto &run : group->on_update.runs()) {
+                    for (const auto &object : run.objects) {
+                        if (in_scene(object.get()))
+                            tables.members.push_back(record_of(*object));
+                    }
+                }
+
+                tables.groups.push_back(format::group_record{
+                    .phase        = phase_name,
+                    .profile_name = tables.add_string(group->profile_name),
+                    .first_member = first,
+                    .member_count = static_cast<uint32_t>(tables.members.size()) - first,
+                    .chunk_size   = static_cast<uint32_t>(group->chunk_size),
+                    .parallel     = group->parallel,
+                    .independent  = group->independent,
+                    .reserved     = 0,
+                });
+            }
+        }
+
+        for (const auto &resource : scene.resources().list()) {
+            if (resource.persistent)
+                continue;
+            if (const auto *type = snapshot_types::get().find_resource_type(resource.type)) {
+                tables.resources.push_back(format::resource_record{
+                    .path = tables.add_string(resource.path),
+                    .type = tables.add_string(type->name),
+                });
+            }
+        }
+
+        // lay out the sections, then make the offsets into data absolute
+        format::file_header header{};
+        header.magic   = format::magic;
+        header.version = format::version;
+
+        uint64_t   end    = sizeof(format::file_header);
+        const auto layout = [&]<typename T>(const std::vector<T> &values) {
+            const format::section section{.offset = align_up(end), .count = values.size()};
+            end = section.offset + values.size() * sizeof(T);
+            return section;
+        };
+        header.strings   = layout(tables.strings);
+        header.types     = layout(tables.types);
+        header.objects   = layout(tables.objects);
+        header.groups    = layout(tables.groups);
+        header.members   = layout(tables.members);
+        header.resources = layout(tables.resources);
+        header.data      = layout(tables.data);
+        header.file_size = end;
+
+        for (auto &str : tables.strings) {
+            str.offset += header.data.offset;
+        }
+        for (auto &object : tables.objects) {
+            object.state_offset += header.data.offset;
+        }
+
+        std::vector<std::byte> out(header.file_size);
+        std::memcpy(out.data(), &header, sizeof(header));
+        const auto copy = [&]<typename T>(const format::section &section, const std::vector<T> &values) {
+            if (!values.empty())
+                std::memcpy(out.data() + section.offset, values.data(), values.size() * sizeof(T));
+        };
+        copy(header.strings, tables.strings);
+        copy(header.types, tables.types);
+        copy(header.objects, tables.objects);
+        copy(header.groups, tables.groups);
+        copy(header.members, tables.members);
+        copy(header.resources, tables.resources);
+        copy(header.data, tables.data);
+        return out;
+    }
+
+    void scene_snapshot::save(const scene &scene, const std::filesystem::path &path) {
+        const std::vector<std::byte> data = encode(scene);
+
+        if (path.has_parent_path()) {
+            std::filesystem::create_directories(path.parent_path());
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+        out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            throw std::runtime_error("Failed to write " + path.string());
+        }
+    }
+
+    void scene_snapshot::load(scene &scene, const std::span<const std::byte> data) {
+        const snapshot_view view(data);
+
+        // resolve every type, phase and resource type before creating anything, so that a snapshot this scene cannot
+        // load leaves it as it was
+        std::vector<const snapshot_types::object_type *> types;
+        types.reserve(view.types().size());
+        for (const auto &type : view.types()) {
+            const std::string_view name       = view.string(type.name);
+            const auto            *registered = snapshot_types::get().find_object_type(hashed_name(name));
+            if (!registered) {
+                throw std::runtime_error("Scene snapshot uses unregistered object type " + std::string(name));
+            }
+            types.push_back(registered);
+        }
+
+        std::vector<std::shared_ptr<phase>> phases;
+        phases.reserve(view.groups().size());
+        for (const auto &record : view.groups()) {
+            const std::string_view phase_name = view.string(record.phase);
+            auto                   phase      = scene.get_phase(phase_name);
+            if (!phase) {
+                throw std::runtime_error("Scene snapshot refers to unknown phase " + std::string(phase_name));
+            }
+            phases.push_back(std::move(phase));
+        }
+
+        std::vector<const snapshot_types::resource_type *> resource_types;
+        resource_types.reserve(view.resources().size());
+        for (const auto &record : view.resources()) {
+            const std::string_view type_name = view.string(record.type);
+            const auto            *type      = snapshot_types::get().find_resource_type(hashed_name(type_name));
+            if (!type) {
+                throw std::runtime_error("Scene snapshot uses unregistered resource type " + std::string(type_name));
+            }
+            resource_types.push_back(type);
+        }
+
+        {
+            std::vector<size_t> counts(types.size());
+            for (const auto &object : view.objects()) {
+                ++counts[object.type];
+            }
+            for (size_t i = 0; i < types.size(); ++i) {
+                types[i]->reserve(scene, counts[i]);
+            }
+            scene.m_objects.reserve(scene.m_objects.size() + view.objects().size());
+            scene.m_transforms.reserve(view.objects().size());
+        }
+
+        std::vector<std::shared_ptr<scene_object>> created;
+        std::vector<std::shared_ptr<scene_object>> displaced; // objects already in the scene whose names were taken
+        created.reserve(view.objects().size());
+        try {
+            for (const auto &record : view.objects()) {
+                const auto object = types[record.type]->create(scene);
+                created.push_back(object);
+
+                if (record.parent != format::none) {
+                    object->set_parent(created[record.parent]);
+                }
+
+                glm::mat4 local;
+                std::memcpy(&local, record.local_transform, sizeof(local));
+                scene.m_transforms.set_local(object->m_transform, local);
+
+                if (record.name != format::none) {
+                    const hashed_name name(view.string(record.name));
+                    if (auto previous = scene.get_scene_object(name))
+                        displaced.push_back(std::move(previous));
+                    scene.rename_object(object->get_id(), name);
+                }
+
+                snapshot_reader reader(view.state(record), view.types()[record.type].version);
+                object->load_state(reader);
+            }
+        } catch (...) {
+            // take out what was created so far and give back the names it took, so a failed load changes nothing
+            std::vector<uint64_t> ids;
+            ids.reserve(created.size());
+            for (const auto &object : created) {
+                ids.push_back(object->get_id());
+            }
+            scene.remove_objects(ids);
+            for (auto it = displaced.rbegin(); it != displaced.rend(); ++it) {
+                if (scene.has_scene_object((*it)->get_id()))
+                    scene.rename_object((*it)->get_id(), hashed_name((*it)->get_name()));
+            }
+            throw;
+        }
+
+        for (size_t i = 0; i < phases.size(); ++i) {
+            const auto &record  = view.groups()[i];
+            const auto  group   = phases[i]->push_end_new_update_group();
+            group->parallel     = record.parallel != 0;
+            group->independent  = record.independent != 0;
+            group->chunk_size   = std::max<uint32_t>(record.chunk_size, 1);
+            group->profile_name = name_id::intern(hashed_name(view.string(record.profile_name)));
+
+            for (const uint32_t member : view.members().subspan(record.first_member, record.member_count)) {
+                types[view.objects()[member].type]->insert_into_group(*group, created[member]);
+            }
+        }
+
+        for (size_t i = 0; i < resource_types.size(); ++i) {
+            resource_types[i]->load(scene, hashed_name(view.string(view.resources()[i].path)));
+        }
+    }
+
+    void scene_snapshot::load(scene &scene, const std::filesystem::path &path) {
+        const mapped_file file(path);
+        load(scene, file.bytes());
+    }
+} // namespace engine::scene
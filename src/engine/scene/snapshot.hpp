@@ -0,0 +1,262 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "scene.hpp"
+#include "snapshot_format.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace engine::scene {
+
+    /**
+     * Appends an object's state to a snapshot. Values are stored as raw bytes, so only trivially copyable types can be
+     * written directly.
+     */
+    class snapshot_writer {
+      public:
+        explicit snapshot_writer(std::vector<std::byte> &out) : m_out(out) {}
+
+        template <typename T>
+            requires std::is_trivially_copyable_v<T>
+        void write(const T &value) {
+            write_bytes(std::as_bytes(std::span(&value, 1)));
+        }
+
+        void write_bytes(const std::span<const std::byte> bytes) {
+            const size_t offset = m_out.size();
+            m_out.resize(offset + bytes.size());
+            if (!bytes.empty())
+                std::memcpy(m_out.data() + offset, bytes.data(), bytes.size());
+        }
+
+        void write_string(const std::string_view str) {
+            write(static_cast<uint32_t>(str.size()));
+            write_bytes(std::as_bytes(std::span(str)));
+        }
+
+      private:
+        std::vector<std::byte> &m_out;
+    };
+
+    /**
+     * Reads an object's state back, in the order it was written. Strings and byte ranges point into the snapshot
+     * itself, so they are only valid while it is. Reading past the end of the state throws std::runtime_error.
+     */
+    class snapshot_reader {
+      public:
+        snapshot_reader(const std::span<const std::byte> data, const uint32_t version) : m_data(data), m_version(version) {}
+
+        template <typename T>
+            requires std::is_trivially_copyable_v<T>
+        T read() {
+            T value;
+            std::memcpy(&value, read_bytes(sizeof(T)).data(), sizeof(T));
+            return value;
+        }
+
+        std::span<const std::byte> read_bytes(const size_t size) {
+            if (size > m_data.size() - m_position) {
+                throw std::runtime_error("Read past the end of an object's snapshot state");
+            }
+            const auto bytes = m_data.subspan(m_position, size);
+            m_position += size;
+            return bytes;
+        }
+
+        std::string_view read_string() {
+            const auto size  = read<uint32_t>();
+            const auto bytes = read_bytes(size);
+            return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+        }
+
+        /**
+         * @return The version the object's type was registered with when the snapshot was written.
+         */
+        [[nodiscard]] inline uint32_t version() const noexcept { return m_version; }
+
+        [[nodiscard]] inline size_t remaining() const noexcept { return m_data.size() - m_position; }
+
+      private:
+        std::span<const std::byte> m_data;
+        size_t                     m_position = 0;
+        uint32_t                   m_version;
+    };
+
+    /**
+     * Names the scene_object types and resource types that can be stored in snapshots. A snapshot refers to types by
+     * these names, so they must stay the same across builds; bump an object type's version when its state layout
+     * changes, and check snapshot_reader::version() in load_state.
+     */
+    class snapshot_types {
+      public:
+        struct object_type {
+            name_id         name;
+            uint32_t        version;
+            std::type_index type;
+
+            std::shared_ptr<scene_object> (*create)(scene &scene);
+            std::shared_ptr<scene_object> (*create_at)(scene &scene, uint64_t id); // the id's slot must be free
+            void (*reserve)(scene &scene, size_t count);
+            void (*insert_into_group)(update_group &group, const std::shared_ptr<scene_object> &object);
+        };
+
+        struct resource_type {
+            name_id         name;
+            std::type_index type;
+
+            void (*load)(scene &scene, hashed_name path);
+        };
+
+        static snapshot_types &get();
+
+        snapshot_types(const snapshot_types &other)                = delete;
+        snapshot_types(snapshot_types &&other) noexcept            = delete;
+        snapshot_types &operator=(const snapshot_types &other)     = delete;
+        snapshot_types &operator=(snapshot_types &&other) noexcept = delete;
+
+        /**
+         * Registers an object type. T must be constructible from (std::weak_ptr<scene>, uint64_t id) and should
+         * override save_state and load_state if it has state of its own. Registering a type again replaces it.
+         */
+        template <std::derived_from<scene_object> T>
+        void add_object_type(const hashed_name name, const uint32_t version = 1) {
+            _add_object_type(object_type{
+                .name    = name_id::intern(name),
+                .version = version,
+                .type    = typeid(T),
+                .create  = [](scene &scene) -> std::shared_ptr<scene_object> {
+                    return scene.emplace_object<T>().second;
+                },
+                .create_at = [](scene &scene, const uint64_t id) { return scene._emplace_object_at<T>(id); },
+                .reserve = [](scene &scene, const size_t count) { scene._object_pool<T>()->reserve(count); },
+                .insert_into_group =
+                    [](update_group &group, const std::shared_ptr<scene_object> &object) {
+                        group.insert(std::static_pointer_cast<T>(object));
+                    },
+            });
+        }
+
+        /**
+         * Registers a resource type, so the paths of resources of this type loaded from files are saved and requested
+         * again on load. Resources added from memory are not saved.
+         */
+        template <typename T>
+        void add_resource_type(const hashed_name name) {
+            _add_resource_type(resource_type{
+                .name = name_id::intern(name),
+                .type = typeid(T),
+                .load = [](scene &scene, const hashed_name path) { (void)scene.load_resource<T>(path); },
+            });
+        }
+
+        [[nodiscard]] const object_type *find_object_type(std::type_index type) const;
+        [[nodiscard]] const object_type *find_object_type(hashed_name name) const;
+
+        [[nodiscard]] const resource_type *find_resource_type(std::type_index type) const;
+        [[nodiscard]] const resource_type *find_resource_type(hashed_name name) const;
+
+      private:
+        mutable std::mutex m_mutex;
+
+        // deques, so pointers handed out stay valid as types are added
+        std::deque<object_type>                     m_object_types;
+        std::unordered_map<std::type_index, size_t> m_object_types_by_type;
+        flat_name_map<size_t>                       m_object_types_by_name;
+        std::deque<resource_type>                   m_resource_types;
+        std::unordered_map<std::type_index, size_t> m_resource_types_by_type;
+        flat_name_map<size_t>                       m_resource_types_by_name;
+
+        snapshot_types() = default;
+
+        void _add_object_type(object_type type);
+        void _add_resource_type(resource_type type);
+    };
+
+    /**
+     * A validated, read-only view of a snapshot in memory (usually a mapped file). Tables are used in place; nothing is
+     * copied. Throws std::runtime_error from the constructor if the data is not a snapshot this build can read, or
+     * if any table or reference lies outside the data.
+     */
+    class snapshot_view {
+      public:
+        explicit snapshot_view(std::span<const std::byte> data);
+
+        [[nodiscard]] inline const snapshot_format::file_header &header() const noexcept { return *m_header; }
+
+        [[nodiscard]] std::string_view string(uint32_t index) const;
+
+        [[nodiscard]] inline std::span<const snapshot_format::type_record> types() const noexcept { return m_types; }
+        [[nodiscard]] inline std::span<const snapshot_format::object_record> objects() const noexcept {
+            return m_objects;
+        }
+        [[nodiscard]] inline std::span<const snapshot_format::group_record> groups() const noexcept { return m_groups; }
+        [[nodiscard]] inline std::span<const uint32_t>                      members() const noexcept { return m_members; }
+        [[nodiscard]] inline std::span<const snapshot_format::resource_record> resources() const noexcept {
+            return m_resources;
+        }
+
+        [[nodiscard]] std::span<const std::byte> state(const snapshot_format::object_record &object) const noexcept {
+            return m_data.subspan(object.state_offset, object.state_size);
+        }
+
+      private:
+        std::span<const std::byte> m_data;
+
+        const snapshot_format::file_header                *m_header = nullptr;
+        std::span<const snapshot_format::string_record>   m_strings;
+        std::span<const snapshot_format::type_record>     m_types;
+        std::span<const snapshot_format::object_record>   m_objects;
+        std::span<const snapshot_format::group_record>    m_groups;
+        std::span<const uint32_t>                         m_members;
+        std::span<const snapshot_format::resource_record> m_resources;
+
+        template <typename T>
+        std::span<const T> _section(const snapshot_format::section &section) const;
+    };
+
+    /**
+     * Saves a scene's objects (with their names, parents, local transforms and state), its update groups and its
+     * file-backed resources to the format in snapshot_format.hpp, and loads them back.
+     *
+     * Loading adds to the scene: objects get new ids, update groups are appended to the phases of the same names, which
+     * must already exist, and resources are requested again. Component storage is not saved.
+     */
+    class scene_snapshot {
+      public:
+        /**
+         * @throws std::logic_error if an object's type was not registered with snapshot_types
+         */
+        [[nodiscard]] static std::vector<std::byte> encode(const scene &scene);
+
+        static void save(const scene &scene, const std::filesystem::path &path);
+
+        /**
+         * Types, phases and resource types are all resolved before anything is created, and objects created before a
+         * load_state throws are removed again, so a load that fails leaves the scene as it was.
+         *
+         * @throws std::runtime_error if the snapshot is invalid or refers to a type or phase this scene does not know
+         */
+        static void load(scene &scene, std::span<const std::byte> data);
+
+        /**
+         * Maps the file and loads from the mapping.
+         */
+        static void load(scene &scene, const std::filesystem::path &path);
+    };
+
+} // namespace engine::scene
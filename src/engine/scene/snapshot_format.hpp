@@ -0,0 +1,87 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Layout of scene snapshot files. Everything is little-endian and naturally aligned, so a snapshot can be mapped and its
+ * tables used in place; references between tables are indices, and references into the file are absolute offsets.
+ *
+ * A file is a file_header followed by its sections, each starting on a 16-byte boundary:
+ *
+ *   strings     string_record[]    text of object names, type names, phase names and resource paths
+ *   types       type_record[]      the registered scene_object types the objects use
+ *   objects     object_record[]    every object, parents before their children, children in their parent's order
+ *   groups      group_record[]     update groups, in phase order then group order
+ *   members     uint32_t[]         object indices, referenced by group_record ranges
+ *   resources   resource_record[]  resources requested from files, which are requested again on load
+ *   data        bytes              string text and object state, referenced by offset
+ */
+namespace engine::scene::snapshot_format {
+    inline constexpr std::array<char, 8> magic   = {'E', 'N', 'G', 'S', 'C', 'N', '\0', '\1'};
+    inline constexpr uint32_t            version = 1;
+
+    inline constexpr uint32_t none = UINT32_MAX;
+
+    struct section {
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct file_header {
+        std::array<char, 8> magic;
+        uint32_t            version;
+        uint32_t            reserved;
+        uint64_t            file_size;
+
+        section strings;
+        section types;
+        section objects;
+        section groups;
+        section members;
+        section resources;
+        section data;
+    };
+
+    struct string_record {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct type_record {
+        uint32_t name;    // string
+        uint32_t version; // the version the type was registered with when the snapshot was written
+    };
+
+    struct object_record {
+        float    local_transform[16]; // column-major
+        uint64_t state_offset;
+        uint32_t state_size;
+        uint32_t type;   // type index
+        uint32_t parent; // object index, or none
+        uint32_t name;   // string, or none
+    };
+
+    struct group_record {
+        uint32_t phase;        // string
+        uint32_t profile_name; // string
+        uint32_t first_member;
+        uint32_t member_count;
+        uint32_t chunk_size;
+        uint8_t  parallel;
+        uint8_t  independent;
+        uint16_t reserved;
+    };
+
+    struct resource_record {
+        uint32_t path; // string
+        uint32_t type; // string, the name the resource type was registered with
+    };
+
+    static_assert(sizeof(object_record) == 88);
+    static_assert(sizeof(group_record) == 24);
+} // namespace engine::scene::snapshot_format
@@ -0,0 +1,975 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "spatial.hpp"
+
+#include "engine/jobs.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace engine::scene {
+
+    // surface area, the cost of visiting a node in proportion to how likely a query is to enter it
+    static float area(const aabb &box) noexcept {
+        const glm::vec3 d = box.max - box.min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    // clips [t0, t1] to the part of the ray inside the box; false if nothing is left
+    static bool clip_ray(const ray &ray, const glm::vec3 &inverse, const aabb &box, float &t0, float &t1) noexcept {
+        for (int axis = 0; axis < 3; ++axis) {
+            float near = (box.min[axis] - ray.origin[axis]) * inverse[axis];
+            float far  = (box.max[axis] - ray.origin[axis]) * inverse[axis];
+            if (near > far)
+                std::swap(near, far);
+
+            // written so that NaNs (a ray along a face) leave the range alone
+            if (near > t0)
+                t0 = near;
+            if (far < t1)
+                t1 = far;
+        }
+        return t0 <= t1;
+    }
+
+    static bool ray_enters(const ray &ray, const glm::vec3 &inverse, const aabb &box, const float max_distance, float &t) {
+        float t0 = 0.0f;
+        float t1 = max_distance;
+        if (!clip_ray(ray, inverse, box, t0, t1))
+            return false;
+        t = t0;
+        return true;
+    }
+
+    static glm::vec3 inverse_direction(const ray &ray) noexcept {
+        return glm::vec3(1.0f) / ray.direction;
+    }
+
+    static void sort_hits(std::vector<ray_hit> &hits, const size_t first) {
+        std::sort(hits.begin() + static_cast<ptrdiff_t>(first), hits.end(), [](const ray_hit &a, const ray_hit &b) {
+            return a.distance < b.distance;
+        });
+    }
+
+    // scratch reused by every query a thread runs; queries never call back into user code, so they cannot nest
+    static std::vector<uint32_t> &scratch_stack() {
+        thread_local std::vector<uint32_t> stack;
+        stack.clear();
+        return stack;
+    }
+
+    using nearest_candidate = std::pair<float, uint64_t>; // squared distance, id or proxy
+
+    static std::vector<nearest_candidate> &scratch_nearest() {
+        thread_local std::vector<nearest_candidate> best;
+        best.clear();
+        return best;
+    }
+
+    // keeps the k nearest candidates as a max-heap, so the worst is at the front
+    static void offer_nearest(std::vector<nearest_candidate> &best, const size_t k, const nearest_candidate candidate) {
+        if (best.size() < k) {
+            best.push_back(candidate);
+            std::push_heap(best.begin(), best.end());
+        } else if (candidate.first < best.front().first) {
+            std::pop_heap(best.begin(), best.end());
+            best.back() = candidate;
+            std::push_heap(best.begin(), best.end());
+        }
+    }
+
+    aabb aabb::transformed(const glm::mat4 &transform) const noexcept {
+        const glm::vec3 center = (min + max) * 0.5f;
+        const glm::vec3 extent = (max - min) * 0.5f;
+
+        glm::vec3 world_center;
+        glm::vec3 world_extent;
+        for (int row = 0; row < 3; ++row) {
+            world_center[row] = transform[3][row] + transform[0][row] * center.x + transform[1][row] * center.y +
+                                transform[2][row] * center.z;
+            world_extent[row] = std::abs(transform[0][row]) * extent.x + std::abs(transform[1][row]) * extent.y +
+                                std::abs(transform[2][row]) * extent.z;
+        }
+        return {world_center - world_extent, world_center + world_extent};
+    }
+
+    aabb_tree::aabb_tree(const settings settings) : m_settings(settings) {}
+
+    spatial_index::proxy aabb_tree::insert(const uint64_t id, const aabb &bounds) {
+        if (bounds.empty()) {
+            throw std::invalid_argument("Cannot insert an empty box into a spatial index");
+        }
+
+        const uint32_t leaf  = _allocate();
+        m_nodes[leaf].box    = _enlarge(bounds, glm::vec3(0.0f));
+        m_nodes[leaf].height = 0;
+        m_leaves[leaf]       = {bounds, id};
+
+        _insert_leaf(leaf);
+        ++m_leaf_count;
+        return leaf;
+    }
+
+    void aabb_tree::move(const proxy proxy, const aabb &bounds) {
+        if (proxy >= m_nodes.size() || m_nodes[proxy].height != 0) {
+            throw std::out_of_range("Unknown spatial index proxy");
+        }
+        if (bounds.empty()) {
+            throw std::invalid_argument("Cannot move an object in a spatial index to an empty box");
+        }
+
+        leaf_data      &leaf         = m_leaves[proxy];
+        const glm::vec3 displacement = bounds.min - leaf.tight.min;
+        const aabb      enlarged     = _enlarge(bounds, displacement);
+        leaf.tight                   = bounds;
+
+        // still inside its leaf, and the leaf has not grown too loose around it (as after the object shrank or stopped)
+        const glm::vec3 loose(4.0f * m_settings.margin);
+        const aabb     &box = m_nodes[proxy].box;
+        if (box.contains(bounds) && aabb{enlarged.min - loose, enlarged.max + loose}.contains(box))
+            return;
+
+        m_nodes[proxy].box = enlarged;
+
+        // a node close above that still contains the new box keeps the tree's shape valid; only the nodes up to it
+        // need refitting, and none of them can grow past it
+        uint32_t ancestor = m_nodes[proxy].parent;
+        for (uint32_t level = 0; ancestor != null_node && level < m_settings.refit_levels; ++level) {
+            if (m_nodes[ancestor].box.contains(enlarged)) {
+                for (uint32_t index = m_nodes[proxy].parent;; index = m_nodes[index].parent) {
+                    node &n = m_nodes[index];
+                    n.box   = aabb::merge(m_nodes[n.child1].box, m_nodes[n.child2].box);
+                    if (index == ancestor)
+                        return;
+                }
+            }
+            ancestor = m_nodes[ancestor].parent;
+        }
+
+        _remove_leaf(proxy);
+        _insert_leaf(proxy);
+    }
+
+    void aabb_tree::remove(const proxy proxy) {
+        if (proxy >= m_nodes.size() || m_nodes[proxy].height != 0) {
+            throw std::out_of_range("Unknown spatial index proxy");
+        }
+
+        _remove_leaf(proxy);
+        _release(proxy);
+        --m_leaf_count;
+    }
+
+    int32_t aabb_tree::height() const noexcept {
+        return m_root == null_node ? 0 : m_nodes[m_root].height;
+    }
+
+    void aabb_tree::query_aabb(const aabb &box, std::vector<uint64_t> &out) const {
+        if (m_root == null_node)
+            return;
+
+        auto &stack = scratch_stack();
+        stack.push_back(m_root);
+        while (!stack.empty()) {
+            const uint32_t index = stack.back();
+            const node    &n     = m_nodes[index];
+            stack.pop_back();
+            if (!n.box.overlaps(box))
+                continue;
+
+            if (n.leaf()) {
+                const leaf_data &leaf = m_leaves[index];
+                if (leaf.tight.overlaps(box))
+                    out.push_back(leaf.id);
+            } else {
+                stack.push_back(n.child1);
+                stack.push_back(n.child2);
+            }
+        }
+    }
+
+    void aabb_tree::query_sphere(const glm::vec3 &center, const float radius, std::vector<uint64_t> &out) const {
+        if (m_root == null_node)
+            return;
+
+        const float radius2 = radius * radius;
+        auto       &stack   = scratch_stack();
+        stack.push_back(m_root);
+        while (!stack.empty()) {
+            const uint32_t index = stack.back();
+            const node    &n     = m_nodes[index];
+            stack.pop_back();
+            if (n.box.distance2(center) > radius2)
+                continue;
+
+            if (n.leaf()) {
+                if (m_leaves[index].tight.distance2(center) <= radius2)
+                    out.push_back(m_leaves[index].id);
+            } else {
+                stack.push_back(n.child1);
+                stack.push_back(n.child2);
+            }
+        }
+    }
+
+    void aabb_tree::query_ray(const ray &ray, const float max_distance, std::vector<ray_hit> &out) const {
+        if (m_root == null_node)
+            return;
+
+        const glm::vec3 inverse = inverse_direction(ray);
+        const size_t    first   = out.size();
+
+        auto &stack = scratch_stack();
+        stack.push_back(m_root);
+        while (!stack.empty()) {
+            const uint32_t index = stack.back();
+            const node    &n     = m_nodes[index];
+            stack.pop_back();
+
+            float t;
+            if (!ray_enters(ray, inverse, n.box, max_distance, t))
+                continue;
+
+            if (n.leaf()) {
+                if (ray_enters(ray, inverse, m_leaves[index].tight, max_distance, t))
+                    out.push_back({m_leaves[index].id, t});
+            } else {
+                stack.push_back(n.child1);
+                stack.push_back(n.child2);
+            }
+        }
+
+        sort_hits(out, first);
+    }
+
+    std::optional<ray_hit> aabb_tree::raycast(const ray &ray, const float max_distance) const {
+        if (m_root == null_node)
+            return std::nullopt;
+
+        const glm::vec3        inverse = inverse_direction(ray);
+        float                  best    = max_distance;
+        std::optional<ray_hit> hit;
+
+        auto &stack = scratch_stack();
+        stack.push_back(m_root);
+        while (!stack.empty()) {
+            const uint32_t index = stack.back();
+            const node    &n     = m_nodes[index];
+            stack.pop_back();
+
+            float t;
+            if (!ray_enters(ray, inverse, n.box, best, t))
+                continue;
+
+            if (n.leaf()) {
+                if (ray_enters(ray, inverse, m_leaves[index].tight, best, t) && (!hit || t < best)) {
+                    best = t;
+                    hit  = ray_hit{m_leaves[index].id, t};
+                }
+                continue;
+            }
+
+            // visit the nearer child first, so the far one is more likely to be cut off
+            float t1 = std::numeric_limits<float>::infinity();
+            float t2 = std::numeric_limits<float>::infinity();
+            const bool enters1 = ray_enters(ray, inverse, m_nodes[n.child1].box, best, t1);
+            const bool enters2 = ray_enters(ray, inverse, m_nodes[n.child2].box, best, t2);
+            if (enters1 && enters2) {
+                stack.push_back(t1 < t2 ? n.child2 : n.child1);
+                stack.push_back(t1 < t2 ? n.child1 : n.child2);
+            } else if (enters1) {
+                stack.push_back(n.child1);
+            } else if (enters2) {
+                stack.push_back(n.child2);
+            }
+        }
+
+        return hit;
+    }
+
+    void aabb_tree::query_nearest(const glm::vec3 &point, const size_t k, std::vector<uint64_t> &out) const {
+        if (m_root == null_node || k == 0)
+            return;
+
+        // nodes to open, nearest first (a min-heap on the distance to their box)
+        thread_local std::vector<std::pair<float, uint32_t>> open;
+        open.clear();
+        auto &best = scratch_nearest();
+
+        const auto nearer = [](const auto &a, const auto &b) { return a.first > b.first; };
+        open.emplace_back(m_nodes[m_root].box.distance2(point), m_root);
+        while (!open.empty()) {
+            std::pop_heap(open.begin(), open.end(), nearer);
+            const auto [distance, index] = open.back();
+            open.pop_back();
+            if (best.size() == k && distance >= best.front().first)
+                break;
+
+            const node &n = m_nodes[index];
+            if (n.leaf()) {
+                offer_nearest(best, k, {m_leaves[index].tight.distance2(point), m_leaves[index].id});
+                continue;
+            }
+
+            for (const uint32_t child : {n.child1, n.child2}) {
+                const float d = m_nodes[child].box.distance2(point);
+                if (best.size() < k || d < best.front().first) {
+                    open.emplace_back(d, child);
+                    std::push_heap(open.begin(), open.end(), nearer);
+                }
+            }
+        }
+
+        std::sort_heap(best.begin(), best.end());
+        for (const auto &[_, id] : best) {
+            out.push_back(id);
+        }
+    }
+
+    uint32_t aabb_tree::_allocate() {
+        if (m_free == null_node) {
+            m_nodes.emplace_back();
+            m_leaves.emplace_back();
+            return static_cast<uint32_t>(m_nodes.size() - 1);
+        }
+
+        const uint32_t index = m_free;
+        m_free               = m_nodes[index].parent;
+        m_nodes[index]       = node{};
+        return index;
+    }
+
+    void aabb_tree::_release(const uint32_t index) {
+        m_nodes[index]        = node{};
+        m_nodes[index].parent = m_free;
+        m_free                = index;
+    }
+
+    void aabb_tree::_insert_leaf(const uint32_t leaf) {
+        if (m_root == null_node) {
+            m_root                = leaf;
+            m_nodes[leaf].parent = null_node;
+            return;
+        }
+
+        // walk down to the sibling that makes the tree's total area grow least, counting the growth of every node on
+        // the way as the price of going deeper
+        const aabb box   = m_nodes[leaf].box;
+        uint32_t   index = m_root;
+        while (!m_nodes[index].leaf()) {
+            const node &n         = m_nodes[index];
+            const float combined  = area(aabb::merge(n.box, box));
+            const float here      = 2.0f * combined;
+            const float inherited = 2.0f * (combined - area(n.box));
+
+            const auto descend = [&](const uint32_t child) {
+                const node &c      = m_nodes[child];
+                const float merged = area(aabb::merge(c.box, box));
+                return (c.leaf() ? merged : merged - area(c.box)) + inherited;
+            };
+            const float cost1 = descend(n.child1);
+            const float cost2 = descend(n.child2);
+            if (here < cost1 && here < cost2)
+                break;
+
+            index = cost1 < cost2 ? n.child1 : n.child2;
+        }
+
+        const uint32_t sibling    = index;
+        const uint32_t old_parent = m_nodes[sibling].parent;
+        const uint32_t new_parent = _allocate();
+
+        node &p  = m_nodes[new_parent];
+        p.parent = old_parent;
+        p.box    = aabb::merge(box, m_nodes[sibling].box);
+        p.height = m_nodes[sibling].height + 1;
+        p.child1 = sibling;
+        p.child2 = leaf;
+
+        if (old_parent == null_node) {
+            m_root = new_parent;
+        } else if (m_nodes[old_parent].child1 == sibling) {
+            m_nodes[old_parent].child1 = new_parent;
+        } else {
+            m_nodes[old_parent].child2 = new_parent;
+        }
+        m_nodes[sibling].parent = new_parent;
+        m_nodes[leaf].parent    = new_parent;
+
+        _refit(old_parent);
+    }
+
+    void aabb_tree::_remove_leaf(const uint32_t leaf) {
+        if (leaf == m_root) {
+            m_root = null_node;
+            return;
+        }
+
+        const uint32_t parent      = m_nodes[leaf].parent;
+        const uint32_t grandparent = m_nodes[parent].parent;
+        const uint32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+        m_nodes[sibling].parent = grandparent;
+        m_nodes[leaf].parent    = null_node;
+        _release(parent);
+
+        if (grandparent == null_node) {
+            m_root = sibling;
+            return;
+        }
+
+        if (m_nodes[grandparent].child1 == parent) {
+            m_nodes[grandparent].child1 = sibling;
+        } else {
+            m_nodes[grandparent].child2 = sibling;
+        }
+        _refit(grandparent);
+    }
+
+    void aabb_tree::_refit(uint32_t index) {
+        while (index != null_node) {
+            index   = _balance(index);
+            node &n = m_nodes[index];
+
+            n.height = 1 + std::max(m_nodes[n.child1].height, m_nodes[n.child2].height);
+            n.box    = aabb::merge(m_nodes[n.child1].box, m_nodes[n.child2].box);
+            index    = n.parent;
+        }
+    }
+
+    uint32_t aabb_tree::_balance(const uint32_t index) {
+        node &a = m_nodes[index];
+        if (a.leaf() || a.height < 2)
+            return index;
+
+        const uint32_t ib      = a.child1;
+        const uint32_t ic      = a.child2;
+        node          &b       = m_nodes[ib];
+        node          &c       = m_nodes[ic];
+        const int32_t  balance = c.height - b.height;
+        if (balance >= -1 && balance <= 1)
+            return index;
+
+        // the taller child takes a's place, a takes the shorter of its children, and the taller one stays with it
+        const uint32_t iup    = balance > 1 ? ic : ib;
+        node          &up     = balance > 1 ? c : b;
+        node          &other  = balance > 1 ? b : c;
+        const uint32_t first  = up.child1;
+        const uint32_t second = up.child2;
+
+        up.child1 = index;
+        up.parent = a.parent;
+        a.parent  = iup;
+
+        if (up.parent == null_node) {
+            m_root = iup;
+        } else if (m_nodes[up.parent].child1 == index) {
+            m_nodes[up.parent].child1 = iup;
+        } else {
+            m_nodes[up.parent].child2 = iup;
+        }
+
+        const bool     first_taller = m_nodes[first].height > m_nodes[second].height;
+        const uint32_t keep         = first_taller ? first : second;
+        const uint32_t give         = first_taller ? second : first;
+
+        up.child2 = keep;
+        if (balance > 1) {
+            a.child2 = give;
+        } else {
+            a.child1 = give;
+        }
+        m_nodes[give].parent = index;
+
+        a.box     = aabb::merge(other.box, m_nodes[give].box);
+        a.height  = 1 + std::max(other.height, m_nodes[give].height);
+        up.box    = aabb::merge(a.box, m_nodes[keep].box);
+        up.height = 1 + std::max(a.height, m_nodes[keep].height);
+        return iup;
+    }
+
+    aabb aabb_tree::_enlarge(const aabb &bounds, const glm::vec3 &displacement) const noexcept {
+        const glm::vec3 margin(m_settings.margin);
+        const glm::vec3 ahead = displacement * m_settings.prediction;
+        return {
+            bounds.min - margin + glm::min(ahead, glm::vec3(0.0f)),
+            bounds.max + margin + glm::max(ahead, glm::vec3(0.0f)),
+        };
+    }
+
+    // keeps far-away coordinates from overflowing cell indices
+    static int32_t cell_index(const float v) noexcept {
+        return static_cast<int32_t>(std::clamp(std::floor(v), -1.0e9f, 1.0e9f));
+    }
+
+    hash_grid::hash_grid(const settings settings) : m_settings(settings) {
+        if (!(settings.cell_size > 0.0f)) {
+            throw std::invalid_argument("Hash grid cells must have a positive size");
+        }
+
+        m_inverse_cell_size = 1.0f / settings.cell_size;
+        m_buckets.resize(std::bit_ceil(std::max<uint32_t>(settings.bucket_count, 1)));
+    }
+
+    spatial_index::proxy hash_grid::insert(const uint64_t id, const aabb &bounds) {
+        if (bounds.empty()) {
+            throw std::invalid_argument("Cannot insert an empty box into a spatial index");
+        }
+
+        proxy proxy;
+        if (!m_free.empty()) {
+            proxy = m_free.back();
+            m_free.pop_back();
+        } else {
+            proxy = static_cast<spatial_index::proxy>(m_entries.size());
+            m_entries.emplace_back();
+        }
+
+        entry &e = m_entries[proxy];
+        e.box    = bounds;
+        e.id     = id;
+        e.live   = true;
+        _link(proxy);
+        ++m_size;
+        return proxy;
+    }
+
+    void hash_grid::move(const proxy proxy, const aabb &bounds) {
+        if (proxy >= m_entries.size() || !m_entries[proxy].live) {
+            throw std::out_of_range("Unknown spatial index proxy");
+        }
+        if (bounds.empty()) {
+            throw std::invalid_argument("Cannot move an object in a spatial index to an empty box");
+        }
+
+        entry &e = m_entries[proxy];
+        if (!e.oversized && _cell_of(bounds.min) == e.first && _cell_of(bounds.max) == e.last) {
+            e.box    = bounds;
+            m_extent = aabb::merge(m_extent, bounds);
+            return;
+        }
+
+        _unlink(proxy);
+        e.box = bounds;
+        _link(proxy);
+    }
+
+    void hash_grid::remove(const proxy proxy) {
+        if (proxy >= m_entries.size() || !m_entries[proxy].live) {
+            throw std::out_of_range("Unknown spatial index proxy");
+        }
+
+        _unlink(proxy);
+        m_entries[proxy] = entry{};
+        m_free.push_back(proxy);
+        --m_size;
+    }
+
+    void hash_grid::query_aabb(const aabb &box, std::vector<uint64_t> &out) const {
+        _for_each_overlapping(box, [&](const proxy proxy) { out.push_back(m_entries[proxy].id); });
+    }
+
+    void hash_grid::query_sphere(const glm::vec3 &center, const float radius, std::vector<uint64_t> &out) const {
+        const float radius2 = radius * radius;
+        const aabb  box{center - glm::vec3(radius), center + glm::vec3(radius)};
+        _for_each_overlapping(box, [&](const proxy proxy) {
+            const entry &e = m_entries[proxy];
+            if (e.box.distance2(center) <= radius2)
+                out.push_back(e.id);
+        });
+    }
+
+    void hash_grid::query_ray(const ray &ray, const float max_distance, std::vector<ray_hit> &out) const {
+        const glm::vec3 inverse = inverse_direction(ray);
+        const size_t    first   = out.size();
+
+        float t;
+        for (const proxy proxy : m_oversized) {
+            if (ray_enters(ray, inverse, m_entries[proxy].box, max_distance, t))
+                out.push_back({m_entries[proxy].id, t});
+        }
+
+        // objects spanning several cells are met more than once, so proxies stand in for ids until they are deduplicated
+        const size_t cells_first = out.size();
+        _walk_ray(ray, max_distance, [&](const std::span<const proxy> bucket, float) {
+            for (const proxy proxy : bucket) {
+                if (ray_enters(ray, inverse, m_entries[proxy].box, max_distance, t))
+                    out.push_back({proxy, t});
+            }
+            return true;
+        });
+
+        const auto cells = out.begin() + static_cast<ptrdiff_t>(cells_first);
+        std::sort(cells, out.end(), [](const ray_hit &a, const ray_hit &b) { return a.id < b.id; });
+        out.erase(std::unique(cells, out.end(), [](const ray_hit &a, const ray_hit &b) { return a.id == b.id; }), out.end());
+        for (auto it = cells; it != out.end(); ++it) {
+            it->id = m_entries[it->id].id;
+        }
+
+        sort_hits(out, first);
+    }
+
+    std::optional<ray_hit> hash_grid::raycast(const ray &ray, const float max_distance) const {
+        const glm::vec3        inverse = inverse_direction(ray);
+        float                  best    = max_distance;
+        std::optional<ray_hit> hit;
+
+        const auto test = [&](const proxy proxy) {
+            float t;
+            if (ray_enters(ray, inverse, m_entries[proxy].box, best, t) && (!hit || t < best)) {
+                best = t;
+                hit  = ray_hit{m_entries[proxy].id, t};
+            }
+        };
+
+        for (const proxy proxy : m_oversized) {
+            test(proxy);
+        }
+
+        // cells come in order along the ray, so once a hit lies within the cell just visited, no later cell can beat it
+        _walk_ray(ray, max_distance, [&](const std::span<const proxy> bucket, const float cell_exit) {
+            for (const proxy proxy : bucket) {
+                test(proxy);
+            }
+            return !hit || best > cell_exit;
+        });
+
+        return hit;
+    }
+
+    void hash_grid::query_nearest(const glm::vec3 &point, const size_t k, std::vector<uint64_t> &out) const {
+        if (m_size == 0 || k == 0)
+            return;
+
+        auto      &best  = scratch_nearest();
+        const auto offer = [&](const proxy proxy) {
+            const float d = m_entries[proxy].box.distance2(point);
+            if (best.size() == k && d >= best.front().first)
+                return;
+            // an object is listed in every cell it overlaps, and may be met again through another one
+            if (std::ranges::any_of(best, [proxy](const nearest_candidate &c) { return c.second == proxy; }))
+                return;
+            offer_nearest(best, k, {d, proxy});
+        };
+
+        for (const proxy proxy : m_oversized) {
+            offer(proxy);
+        }
+
+        // search shells of cells around the point's cell, outwards; an object not met after shell r - 1 lies wholly in
+        // shell r or beyond, which is at least (r - 1) cells away
+        const cell center = _cell_of(point);
+        const cell low    = _cell_of(m_extent.min);
+        const cell high   = _cell_of(m_extent.max);
+
+        const auto reach = [](const int32_t c, const int32_t lo, const int32_t hi) {
+            return std::max({lo - c, c - hi, hi - c, c - lo, 0});
+        };
+        const int32_t max_ring =
+            std::max({reach(center.x, low.x, high.x), reach(center.y, low.y, high.y), reach(center.z, low.z, high.z)});
+
+        const auto visit = [&](const int32_t x, const int32_t y, const int32_t z) {
+            if (x < low.x || x > high.x || y < low.y || y > high.y || z < low.z || z > high.z)
+                return;
+            for (const proxy proxy : m_buckets[_bucket_of({x, y, z})]) {
+                offer(proxy);
+            }
+        };
+
+        for (int32_t r = 0; r <= max_ring; ++r) {
+            if (r > 0 && best.size() == k) {
+                const float reached = static_cast<float>(r - 1) * m_settings.cell_size;
+                if (best.front().first <= reached * reached)
+                    break;
+            }
+
+            for (int32_t dz = -r; dz <= r; ++dz) {
+                for (int32_t dy = -r; dy <= r; ++dy) {
+                    if (std::abs(dz) == r || std::abs(dy) == r) {
+                        for (int32_t dx = -r; dx <= r; ++dx) {
+                            visit(center.x + dx, center.y + dy, center.z + dz);
+                        }
+                    } else {
+                        visit(center.x - r, center.y + dy, center.z + dz);
+                        visit(center.x + r, center.y + dy, center.z + dz);
+                    }
+                }
+            }
+        }
+
+        std::sort_heap(best.begin(), best.end());
+        for (const auto &[_, proxy] : best) {
+            out.push_back(m_entries[proxy].id);
+        }
+    }
+
+    hash_grid::cell hash_grid::_cell_of(const glm::vec3 &point) const noexcept {
+        return {
+            cell_index(point.x * m_inverse_cell_size),
+            cell_index(point.y * m_inverse_cell_size),
+            cell_index(point.z * m_inverse_cell_size),
+        };
+    }
+
+    size_t hash_grid::_bucket_of(const cell &cell) const noexcept {
+        uint32_t h = static_cast<uint32_t>(cell.x) * 73856093u ^ static_cast<uint32_t>(cell.y) * 19349663u ^
+                     static_cast<uint32_t>(cell.z) * 83492791u;
+        h ^= h >> 16;
+        h *= 0x45d9f3bu;
+        h ^= h >> 16;
+        return h & (m_buckets.size() - 1);
+    }
+
+    void hash_grid::_link(const proxy proxy) {
+        entry &e = m_entries[proxy];
+        e.first  = _cell_of(e.box.min);
+        e.last   = _cell_of(e.box.max);
+        m_extent = m_extent.empty() ? e.box : aabb::merge(m_extent, e.box);
+
+        const uint64_t cells = uint64_t(e.last.x - e.first.x + 1) * uint64_t(e.last.y - e.first.y + 1) *
+                               uint64_t(e.last.z - e.first.z + 1);
+        e.oversized = cells > m_settings.max_cells_per_object;
+        if (e.oversized) {
+            m_oversized.push_back(proxy);
+            return;
+        }
+
+        // cells of one object can share a bucket; it is listed there once
+        for (int32_t z = e.first.z; z <= e.last.z; ++z) {
+            for (int32_t y = e.first.y; y <= e.last.y; ++y) {
+                for (int32_t x = e.first.x; x <= e.last.x; ++x) {
+                    auto &bucket = m_buckets[_bucket_of({x, y, z})];
+                    if (std::ranges::find(bucket, proxy) == bucket.end())
+                        bucket.push_back(proxy);
+                }
+            }
+        }
+    }
+
+    void hash_grid::_unlink(const proxy proxy) {
+        const entry &e = m_entries[proxy];
+        if (e.oversized) {
+            std::erase(m_oversized, proxy);
+            return;
+        }
+
+        for (int32_t z = e.first.z; z <= e.last.z; ++z) {
+            for (int32_t y = e.first.y; y <= e.last.y; ++y) {
+                for (int32_t x = e.first.x; x <= e.last.x; ++x) {
+                    auto &bucket = m_buckets[_bucket_of({x, y, z})];
+                    if (const auto it = std::ranges::find(bucket, proxy); it != bucket.end()) {
+                        *it = bucket.back();
+                        bucket.pop_back();
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename F>
+    void hash_grid::_for_each_overlapping(const aabb &box, F &&f) const {
+        if (m_size == 0 || !box.overlaps(m_extent))
+            return;
+
+        for (const proxy proxy : m_oversized) {
+            if (m_entries[proxy].box.overlaps(box))
+                f(proxy);
+        }
+
+        const cell first = _cell_of(glm::max(box.min, m_extent.min));
+        const cell last  = _cell_of(glm::min(box.max, m_extent.max));
+
+        // a query covering more cells than there are buckets is cheaper as a scan of every object
+        const uint64_t cells =
+            uint64_t(last.x - first.x + 1) * uint64_t(last.y - first.y + 1) * uint64_t(last.z - first.z + 1);
+        if (cells > m_buckets.size()) {
+            for (proxy proxy = 0; proxy < m_entries.size(); ++proxy) {
+                const entry &e = m_entries[proxy];
+                if (e.live && !e.oversized && e.box.overlaps(box))
+                    f(proxy);
+            }
+            return;
+        }
+
+        // an object overlapping several of the cells is reported only from the cell holding the lowest corner of its
+        // overlap with the query, which is also how it is told apart from objects of other cells sharing the bucket
+        for (int32_t z = first.z; z <= last.z; ++z) {
+            for (int32_t y = first.y; y <= last.y; ++y) {
+                for (int32_t x = first.x; x <= last.x; ++x) {
+                    for (const proxy proxy : m_buckets[_bucket_of({x, y, z})]) {
+                        const entry &e = m_entries[proxy];
+                        if (e.box.overlaps(box) && _cell_of(glm::max(e.box.min, box.min)) == cell{x, y, z})
+                            f(proxy);
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename F>
+    void hash_grid::_walk_ray(const ray &ray, const float max_distance, F &&f) const {
+        if (m_size == 0)
+            return;
+
+        // only the part of the ray inside the grid's extent can meet anything
+        const glm::vec3 inverse = inverse_direction(ray);
+        float           t0      = 0.0f;
+        float           t1      = max_distance;
+        if (!clip_ray(ray, inverse, m_extent, t0, t1))
+            return;
+
+        const cell low   = _cell_of(m_extent.min);
+        const cell high  = _cell_of(m_extent.max);
+        cell       c     = _cell_of(ray.origin + ray.direction * t0);
+        int32_t   *at[3] = {&c.x, &c.y, &c.z};
+
+        // the classic voxel walk: for each axis, the t of the next cell boundary and the t between boundaries
+        int32_t step[3];
+        float   next[3];
+        float   delta[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            const int32_t lo = axis == 0 ? low.x : axis == 1 ? low.y : low.z;
+            const int32_t hi = axis == 0 ? high.x : axis == 1 ? high.y : high.z;
+            *at[axis]        = std::clamp(*at[axis], lo, hi);
+
+            const float d = ray.direction[axis];
+            if (d > 0.0f) {
+                step[axis]  = 1;
+                next[axis]  = (static_cast<float>(*at[axis] + 1) * m_settings.cell_size - ray.origin[axis]) / d;
+                delta[axis] = m_settings.cell_size / d;
+            } else if (d < 0.0f) {
+                step[axis]  = -1;
+                next[axis]  = (static_cast<float>(*at[axis]) * m_settings.cell_size - ray.origin[axis]) / d;
+                delta[axis] = -m_settings.cell_size / d;
+            } else {
+                step[axis]  = 0;
+                next[axis]  = std::numeric_limits<float>::infinity();
+                delta[axis] = std::numeric_limits<float>::infinity();
+            }
+        }
+
+        while (true) {
+            const int   axis = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+            const float exit = next[axis];
+
+            if (!f(std::span<const proxy>(m_buckets[_bucket_of(c)]), exit) || exit > t1)
+                return;
+
+            *at[axis] += step[axis];
+            next[axis] += delta[axis];
+            if (c.x < low.x || c.x > high.x || c.y < low.y || c.y > high.y || c.z < low.z || c.z > high.z)
+                return;
+        }
+    }
+
+    uint32_t spatial_query_batch::add_aabb(const aabb &box) {
+        m_queries.push_back({.kind = query_kind::aabb, .box = box});
+        return static_cast<uint32_t>(m_queries.size() - 1);
+    }
+
+    uint32_t spatial_query_batch::add_sphere(const glm::vec3 &center, const float radius) {
+        m_queries.push_back({.kind = query_kind::sphere, .point = center, .distance = radius});
+        return static_cast<uint32_t>(m_queries.size() - 1);
+    }
+
+    uint32_t spatial_query_batch::add_ray(const ray &ray, const float max_distance) {
+        m_queries.push_back({
+            .kind      = query_kind::ray,
+            .point     = ray.origin,
+            .direction = ray.direction,
+            .distance  = max_distance,
+        });
+        return static_cast<uint32_t>(m_queries.size() - 1);
+    }
+
+    uint32_t spatial_query_batch::add_nearest(const glm::vec3 &point, const size_t k) {
+        m_queries.push_back({.kind = query_kind::nearest, .point = point, .count = k});
+        return static_cast<uint32_t>(m_queries.size() - 1);
+    }
+
+    void spatial_query_batch::run(const spatial_index &index, job_system *jobs, size_t chunk_size) {
+        chunk_size         = std::max<size_t>(chunk_size, 1);
+        const size_t count = m_queries.size();
+        const size_t chunks = (count + chunk_size - 1) / chunk_size;
+
+        m_ranges.resize(count);
+        m_chunk_results.resize(std::max(m_chunk_results.size(), chunks));
+        for (auto &results : m_chunk_results) {
+            results.clear();
+        }
+
+        if (!jobs || chunks < 2) {
+            for (size_t chunk = 0; chunk < chunks; ++chunk) {
+                _run_chunk(index, chunk, chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size));
+            }
+            return;
+        }
+
+        job_counter counter;
+        for (size_t chunk = 1; chunk < chunks; ++chunk) {
+            jobs->submit(
+                [this, &index, chunk, chunk_size, count] {
+                    _run_chunk(index, chunk, chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size));
+                },
+                &counter
+            );
+        }
+        _run_chunk(index, 0, 0, std::min(count, chunk_size));
+        jobs->wait(counter);
+    }
+
+    std::span<const uint64_t> spatial_query_batch::results(const uint32_t query) const {
+        if (query >= m_ranges.size()) {
+            throw std::out_of_range("Spatial query has not been run");
+        }
+
+        const result_range &range = m_ranges[query];
+        return std::span(m_chunk_results[range.chunk]).subspan(range.offset, range.count);
+    }
+
+    void spatial_query_batch::clear() {
+        m_queries.clear();
+        m_ranges.clear();
+    }
+
+    void spatial_query_batch::_run_chunk(const spatial_index &index, const size_t chunk, const size_t begin, const size_t end) {
+        thread_local std::vector<ray_hit> hits;
+        auto                             &out = m_chunk_results[chunk];
+
+        for (size_t i = begin; i < end; ++i) {
+            const query &q      = m_queries[i];
+            const size_t offset = out.size();
+            switch (q.kind) {
+            case query_kind::aabb:
+                index.query_aabb(q.box, out);
+                break;
+            case query_kind::sphere:
+                index.query_sphere(q.point, q.distance, out);
+                break;
+            case query_kind::ray:
+                hits.clear();
+                index.query_ray(ray{q.point, q.direction}, q.distance, hits);
+                for (const ray_hit &hit : hits) {
+                    out.push_back(hit.id);
+                }
+                break;
+            case query_kind::nearest:
+                index.query_nearest(q.point, q.count, out);
+                break;
+            }
+
+            m_ranges[i] = {
+                static_cast<uint32_t>(chunk),
+                static_cast<uint32_t>(offset),
+                static_cast<uint32_t>(out.size() - offset),
+            };
+        }
+    }
+
+} // namespace engine::scene
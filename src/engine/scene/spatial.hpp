@@ -0,0 +1,317 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace engine {
+    class job_system;
+} // namespace engine
+
+namespace engine::scene {
+
+    struct aabb {
+        glm::vec3 min{0.0f};
+        glm::vec3 max{0.0f};
+
+        [[nodiscard]] inline bool empty() const noexcept { return max.x < min.x || max.y < min.y || max.z < min.z; }
+
+        [[nodiscard]] inline bool overlaps(const aabb &other) const noexcept {
+            return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y &&
+                   min.z <= other.max.z && other.min.z <= max.z;
+        }
+
+        [[nodiscard]] inline bool contains(const aabb &other) const noexcept {
+            return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z && other.max.x <= max.x &&
+                   other.max.y <= max.y && other.max.z <= max.z;
+        }
+
+        /**
+         * @return The squared distance from the point to the nearest point of the box, 0 inside it.
+         */
+        [[nodiscard]] inline float distance2(const glm::vec3 &point) const noexcept {
+            const glm::vec3 d = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+            return glm::dot(d, d);
+        }
+
+        [[nodiscard]] static inline aabb merge(const aabb &a, const aabb &b) noexcept {
+            return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+        }
+
+        /**
+         * @return The box around this one after transforming it by the matrix.
+         */
+        [[nodiscard]] aabb transformed(const glm::mat4 &transform) const noexcept;
+    };
+
+    struct ray {
+        glm::vec3 origin{0.0f};
+        glm::vec3 direction{0.0f, 0.0f, 1.0f}; // need not be normalized; distances are in multiples of its length
+    };
+
+    struct ray_hit {
+        uint64_t id       = 0;
+        float    distance = 0.0f; // where the ray enters the box, 0 if it starts inside
+    };
+
+    /**
+     * Finds objects by their bounding boxes. Objects are identified by an id (a scene object id when the index belongs to
+     * a scene) and are given a proxy when inserted, which is how they are moved and removed.
+     *
+     * Queries only read, so any number may run at once from different threads, but not while the index is changed.
+     */
+    class spatial_index {
+      public:
+        using proxy = uint32_t;
+
+        spatial_index()          = default;
+        virtual ~spatial_index() = default;
+
+        spatial_index(const spatial_index &other)                = delete;
+        spatial_index(spatial_index &&other) noexcept            = delete;
+        spatial_index &operator=(const spatial_index &other)     = delete;
+        spatial_index &operator=(spatial_index &&other) noexcept = delete;
+
+        [[nodiscard]] virtual proxy insert(uint64_t id, const aabb &bounds) = 0;
+        virtual void                move(proxy proxy, const aabb &bounds)  = 0;
+        virtual void                remove(proxy proxy)                    = 0;
+
+        [[nodiscard]] virtual size_t size() const noexcept = 0;
+
+        /**
+         * Appends the ids of every object whose box overlaps the query box.
+         */
+        virtual void query_aabb(const aabb &box, std::vector<uint64_t> &out) const = 0;
+
+        /**
+         * Appends the ids of every object whose box overlaps the sphere.
+         */
+        virtual void query_sphere(const glm::vec3 &center, float radius, std::vector<uint64_t> &out) const = 0;
+
+        /**
+         * Appends every object whose box the ray enters within max_distance, nearest first.
+         */
+        virtual void query_ray(const ray &ray, float max_distance, std::vector<ray_hit> &out) const = 0;
+
+        /**
+         * @return The first box the ray enters within max_distance
+         */
+        [[nodiscard]] virtual std::optional<ray_hit> raycast(const ray &ray, float max_distance) const = 0;
+
+        /**
+         * Appends the ids of the k objects whose boxes are nearest the point, nearest first. Ties are broken arbitrarily.
+         */
+        virtual void query_nearest(const glm::vec3 &point, size_t k, std::vector<uint64_t> &out) const = 0;
+    };
+
+    /**
+     * A bounding volume hierarchy that is kept balanced as objects come and go. Leaves hold boxes enlarged by a margin
+     * and stretched along the object's last move, so an object that keeps moving the same way stays in its leaf for a
+     * few moves and only its exact box is updated. One that leaves its enlarged box but stays within a node a few levels
+     * up has the nodes in between refitted; one that goes further is taken out and inserted again at the cheapest place
+     * by surface area, and the nodes above it are refitted and rotated to keep the tree shallow. A good default for
+     * scenes with objects of varied sizes.
+     */
+    class aabb_tree final : public spatial_index {
+      public:
+        struct settings {
+            // how far leaf boxes extend past the boxes they hold
+            float margin = 0.1f;
+            // how many moves ahead leaf boxes are stretched, extrapolating from the last one
+            float prediction = 4.0f;
+            // how many levels up an object that left its leaf box may look for a node still containing it, whose subtree
+            // is then refitted in place; past that it is reinserted
+            uint32_t refit_levels = 3;
+        };
+
+        explicit aabb_tree(settings settings);
+
+        [[nodiscard]] proxy insert(uint64_t id, const aabb &bounds) override;
+        void                move(proxy proxy, const aabb &bounds) override;
+        void                remove(proxy proxy) override;
+
+        [[nodiscard]] inline size_t size() const noexcept override { return m_leaf_count; }
+
+        void query_aabb(const aabb &box, std::vector<uint64_t> &out) const override;
+        void query_sphere(const glm::vec3 &center, float radius, std::vector<uint64_t> &out) const override;
+        void query_ray(const ray &ray, float max_distance, std::vector<ray_hit> &out) const override;
+        [[nodiscard]] std::optional<ray_hit> raycast(const ray &ray, float max_distance) const override;
+        void query_nearest(const glm::vec3 &point, size_t k, std::vector<uint64_t> &out) const override;
+
+        /**
+         * @return The number of levels below the root, 0 for a tree of one leaf
+         */
+        [[nodiscard]] int32_t height() const noexcept;
+
+      private:
+        static constexpr uint32_t null_node = UINT32_MAX;
+
+        struct node {
+            aabb     box;                // enlarged for leaves
+            uint32_t parent = null_node; // next free node while on the free list
+            uint32_t child1 = null_node;
+            uint32_t child2 = null_node;
+            int32_t  height = -1; // 0 for leaves, -1 while free
+
+            [[nodiscard]] inline bool leaf() const noexcept { return child1 == null_node; }
+        };
+
+        // kept apart from the nodes, so traversals only pull the boxes and links they walk into the cache
+        struct leaf_data {
+            aabb     tight;
+            uint64_t id = 0;
+        };
+
+        settings               m_settings;
+        std::vector<node>      m_nodes;
+        std::vector<leaf_data> m_leaves; // by node index, only meaningful for leaves
+        uint32_t               m_root       = null_node;
+        uint32_t               m_free       = null_node;
+        size_t                 m_leaf_count = 0;
+
+        uint32_t _allocate();
+        void     _release(uint32_t index);
+
+        void _insert_leaf(uint32_t leaf);
+        void _remove_leaf(uint32_t leaf);
+
+        // refits and rebalances from the node up to the root
+        void _refit(uint32_t index);
+
+        // rotates a grandchild up if the node is unbalanced; returns the node now in its place
+        uint32_t _balance(uint32_t index);
+
+        // adds the margin, and stretches the box further along the way the object last moved
+        [[nodiscard]] aabb _enlarge(const aabb &bounds, const glm::vec3 &displacement) const noexcept;
+    };
+
+    /**
+     * A uniform grid of cells hashed into a fixed table of buckets, with every object listed in each cell its box
+     * overlaps. Moving an object costs the same wherever it goes and nothing has to be rebalanced, which makes the grid
+     * the better choice for dense scenes where most objects move every frame and are about the size of a cell. Nearest
+     * queries search outwards cell by cell, so they slow down where objects are sparse. Objects much larger than a cell
+     * are kept in a separate list that every query checks.
+     */
+    class hash_grid final : public spatial_index {
+      public:
+        struct settings {
+            float    cell_size    = 4.0f;
+            uint32_t bucket_count = 1 << 16; // rounded up to a power of two
+            // objects overlapping more cells than this go in the oversized list
+            uint32_t max_cells_per_object = 64;
+        };
+
+        explicit hash_grid(settings settings);
+
+        [[nodiscard]] proxy insert(uint64_t id, const aabb &bounds) override;
+        void                move(proxy proxy, const aabb &bounds) override;
+        void                remove(proxy proxy) override;
+
+        [[nodiscard]] inline size_t size() const noexcept override { return m_size; }
+
+        void query_aabb(const aabb &box, std::vector<uint64_t> &out) const override;
+        void query_sphere(const glm::vec3 &center, float radius, std::vector<uint64_t> &out) const override;
+        void query_ray(const ray &ray, float max_distance, std::vector<ray_hit> &out) const override;
+        [[nodiscard]] std::optional<ray_hit> raycast(const ray &ray, float max_distance) const override;
+        void query_nearest(const glm::vec3 &point, size_t k, std::vector<uint64_t> &out) const override;
+
+      private:
+        struct cell {
+            int32_t x, y, z;
+
+            bool operator==(const cell &other) const = default;
+        };
+
+        struct entry {
+            aabb     box;
+            uint64_t id = 0;
+            cell     first{}; // range of cells the box overlaps, inclusive
+            cell     last{};
+            bool     live      = false;
+            bool     oversized = false;
+        };
+
+        settings m_settings;
+        float    m_inverse_cell_size;
+
+        std::vector<entry>              m_entries; // by proxy
+        std::vector<proxy>              m_free;
+        std::vector<std::vector<proxy>> m_buckets;
+        std::vector<proxy>              m_oversized;
+        size_t                          m_size = 0;
+        aabb                            m_extent{glm::vec3(0.0f), glm::vec3(-1.0f)}; // around every box; only grows
+
+        [[nodiscard]] cell   _cell_of(const glm::vec3 &point) const noexcept;
+        [[nodiscard]] size_t _bucket_of(const cell &cell) const noexcept;
+
+        void _link(proxy proxy);
+        void _unlink(proxy proxy);
+
+        // calls f(proxy) once for every object whose box overlaps the query box
+        template <typename F>
+        void _for_each_overlapping(const aabb &box, F &&f) const;
+
+        // walks the cells along the ray in order, calling f(proxy, t_enter) for each candidate; stops when f returns false
+        template <typename F>
+        void _walk_ray(const ray &ray, float max_distance, F &&f) const;
+    };
+
+    /**
+     * Queries collected up front and run together, split into chunks across the job system. Each chunk writes to its
+     * own buffer, so no locks are taken while the queries run.
+     */
+    class spatial_query_batch {
+      public:
+        uint32_t add_aabb(const aabb &box);
+        uint32_t add_sphere(const glm::vec3 &center, float radius);
+        uint32_t add_ray(const ray &ray, float max_distance); // every hit, nearest first
+        uint32_t add_nearest(const glm::vec3 &point, size_t k);
+
+        /**
+         * Runs every query against the index, in chunks of chunk_size queries spread across the job system (or on the
+         * calling thread without one), and waits for them.
+         */
+        void run(const spatial_index &index, job_system *jobs = nullptr, size_t chunk_size = 64);
+
+        /**
+         * @return The ids the query found in the last run
+         */
+        [[nodiscard]] std::span<const uint64_t> results(uint32_t query) const;
+
+        [[nodiscard]] inline size_t size() const noexcept { return m_queries.size(); }
+
+        void clear();
+
+      private:
+        enum class query_kind : uint8_t { aabb, sphere, ray, nearest };
+
+        struct query {
+            query_kind kind;
+            aabb       box;
+            glm::vec3  point{0.0f}; // sphere center, ray origin, or the point nearest objects are found for
+            glm::vec3  direction{0.0f};
+            float      distance = 0.0f; // sphere radius or ray length
+            size_t     count    = 0;
+        };
+
+        struct result_range {
+            uint32_t chunk;
+            uint32_t offset;
+            uint32_t count;
+        };
+
+        std::vector<query>                 m_queries;
+        std::vector<result_range>          m_ranges;
+        std::vector<std::vector<uint64_t>> m_chunk_results;
+
+        void _run_chunk(const spatial_index &index, size_t chunk, size_t begin, size_t end);
+    };
+
+} // namespace engine::scene
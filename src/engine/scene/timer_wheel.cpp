@@ -0,0 +1,61 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "timer_wheel.hpp"
+
+namespace engine::scene {
+
+    void timer_wheel::schedule(const timer &timer) {
+        ++m_size;
+        if (timer.deadline <= m_now) {
+            m_overdue.push_back(timer);
+        } else {
+            _place(timer);
+        }
+    }
+
+    std::span<const timer_wheel::timer> timer_wheel::advance() {
+        ++m_now;
+        m_due.clear();
+        m_due.swap(m_overdue);
+
+        // higher levels first, so what they move down can land in a slot the level below turns onto in the same tick
+        for (uint32_t level = level_count - 1; level > 0; --level) {
+            const uint32_t shift = slot_bits * level;
+            if ((m_now & ((uint64_t(1) << shift) - 1)) != 0)
+                continue;
+
+            std::vector<timer> &slot = m_slots[level * slot_count + ((m_now >> shift) & (slot_count - 1))];
+            m_cascade.swap(slot);
+            for (const timer &timer : m_cascade) {
+                _place(timer);
+            }
+            m_cascade.clear();
+        }
+
+        std::vector<timer> &slot = m_slots[m_now & (slot_count - 1)];
+        m_due.insert(m_due.end(), slot.begin(), slot.end());
+        slot.clear();
+
+        m_size -= m_due.size();
+        return m_due;
+    }
+
+    void timer_wheel::_place(const timer &timer) {
+        if (timer.deadline <= m_now) {
+            m_due.push_back(timer);
+            return;
+        }
+
+        const uint64_t delta    = timer.deadline - m_now;
+        const uint64_t deadline = delta < span ? timer.deadline : m_now + span - 1;
+
+        uint32_t level = 0;
+        while (level < level_count - 1 && (deadline - m_now) >> (slot_bits * (level + 1)) != 0) {
+            ++level;
+        }
+        m_slots[level * slot_count + ((deadline >> (slot_bits * level)) & (slot_count - 1))].push_back(timer);
+    }
+
+} // namespace engine::scene
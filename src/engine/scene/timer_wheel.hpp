@@ -0,0 +1,65 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine::scene {
+
+    /**
+     * A hierarchical timer wheel counting in ticks (the scene's updates). Each level has 64 slots, each slot of a level
+     * spanning all 64 slots of the level below it; a timer goes into the lowest level whose span reaches its deadline,
+     * and moves down a level whenever the wheel turns onto its slot. Scheduling is O(1), and a tick only touches the
+     * timers that are due or move down, however many are waiting.
+     *
+     * Timers cannot be cancelled; whoever schedules them tells stale ones apart when they fire (the scene compares a
+     * serial number).
+     */
+    class timer_wheel {
+      public:
+        struct timer {
+            uint64_t deadline; // the tick it fires on
+            uint64_t id;
+            uint32_t serial;
+        };
+
+        static constexpr uint32_t slot_bits   = 6;
+        static constexpr uint32_t slot_count  = 1u << slot_bits;
+        static constexpr uint32_t level_count = 4;
+
+        // timers further out than this are parked in the top level and placed again when it turns onto them
+        static constexpr uint64_t span = uint64_t(1) << (slot_bits * level_count);
+
+        /**
+         * A deadline that has already passed fires on the next advance().
+         */
+        void schedule(const timer &timer);
+
+        /**
+         * Moves on one tick.
+         *
+         * @return The timers due on the new tick (or earlier), valid until the next advance
+         */
+        std::span<const timer> advance();
+
+        [[nodiscard]] inline uint64_t now() const noexcept { return m_now; }
+        [[nodiscard]] inline size_t   size() const noexcept { return m_size; }
+
+      private:
+        std::array<std::vector<timer>, slot_count * level_count> m_slots;
+        std::vector<timer>                                       m_overdue; // scheduled for a tick already past
+        std::vector<timer>                                       m_due;
+        std::vector<timer>                                       m_cascade; // the slot being moved down a level
+        uint64_t                                                 m_now  = 0;
+        size_t                                                   m_size = 0;
+
+        void _place(const timer &timer);
+    };
+
+} // namespace engine::scene
@@ -0,0 +1,259 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#include "transform.hpp"
+
+#include "engine/jobs.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace engine::scene {
+    transform_handle transform_hierarchy::create(const transform_handle parent, const glm::mat4 &local) {
+        uint32_t depth = 0;
+        if (!parent.is_null()) {
+            depth = _info(parent).depth + 1;
+        }
+
+        const transform_handle node =
+            m_nodes.insert(node_info{.depth = 0, .index = 0, .parent = parent, .children = {}});
+        if (!parent.is_null()) {
+            _info(parent).children.push_back(node);
+        }
+
+        _place(node, depth, local);
+        return node;
+    }
+
+    void transform_hierarchy::reserve(const size_t count) {
+        m_nodes.reserve(m_nodes.size() + count);
+
+        if (m_levels.empty()) {
+            m_levels.resize(1);
+        }
+        level       &root = m_levels[0];
+        const size_t size = root.node.size() + count;
+        root.local.reserve(size);
+        root.world.reserve(size);
+        root.parent.reserve(size);
+        root.dirty.reserve(size);
+        root.changed.reserve(size);
+        root.node.reserve(size);
+    }
+
+    void transform_hierarchy::destroy(const transform_handle node) {
+        node_info &info = _info(node);
+
+        if (!info.parent.is_null()) {
+            std::erase(_info(info.parent).children, node);
+        }
+
+        const std::vector<transform_handle> children = std::move(info.children);
+        _remove_from_level(info);
+        m_nodes.erase(node);
+
+        for (const transform_handle child : children) {
+            _info(child).parent = {};
+            _move_subtree(child, 0);
+        }
+    }
+
+    void transform_hierarchy::set_parent(const transform_handle node, const transform_handle parent) {
+        node_info &info = _info(node);
+        if (info.parent == parent)
+            return;
+
+        uint32_t depth = 0;
+        if (!parent.is_null()) {
+            // walk up from the new parent to make sure the node is not one of its ancestors
+            for (transform_handle it = parent; !it.is_null(); it = _info(it).parent) {
+                if (it == node) {
+                    throw std::invalid_argument("Cannot parent a transform to one of its descendants");
+                }
+            }
+            depth = _info(parent).depth + 1;
+        }
+
+        if (!info.parent.is_null()) {
+            std::erase(_info(info.parent).children, node);
+        }
+        info.parent = parent;
+        if (!parent.is_null()) {
+            _info(parent).children.push_back(node);
+        }
+
+        _move_subtree(node, depth);
+    }
+
+    void transform_hierarchy::set_local(const transform_handle node, const glm::mat4 &local) {
+        const node_info &info = _info(node);
+        level           &l    = m_levels[info.depth];
+
+        l.local[info.index] = local;
+        l.dirty[info.index] = 1;
+        m_any_dirty.store(true, std::memory_order_relaxed);
+    }
+
+    const glm::mat4 &transform_hierarchy::get_local(const transform_handle node) const {
+        const node_info &info = _info(node);
+        return m_levels[info.depth].local[info.index];
+    }
+
+    const glm::mat4 &transform_hierarchy::get_world(const transform_handle node) const {
+        const node_info &info = _info(node);
+        return m_levels[info.depth].world[info.index];
+    }
+
+    bool transform_hierarchy::changed(const transform_handle node) const {
+        const node_info &info = _info(node);
+        return m_updated && m_levels[info.depth].changed[info.index];
+    }
+
+    void transform_hierarchy::update(job_system *jobs, const size_t parallel_threshold) {
+        m_updated = m_any_dirty;
+        if (!m_any_dirty)
+            return;
+
+        for (uint32_t depth = 0; depth < m_depth_count; ++depth) {
+            const size_t count = m_levels[depth].node.size();
+            if (jobs && count >= parallel_threshold) {
+                const size_t grain = std::max<size_t>(parallel_threshold / 4, 256);
+                jobs->parallel_for(count, grain, [this, depth](const size_t begin, const size_t end) {
+                    _update_range(depth, begin, end);
+                });
+            } else {
+                _update_range(depth, 0, count);
+            }
+        }
+
+        m_any_dirty = false;
+    }
+
+    void transform_hierarchy::_update_range(const uint32_t depth, const size_t begin, const size_t end) {
+        level &l = m_levels[depth];
+
+        if (depth == 0) {
+            for (size_t i = begin; i < end; ++i) {
+                l.changed[i] = l.dirty[i];
+                if (l.dirty[i]) {
+                    l.world[i] = l.local[i];
+                    l.dirty[i] = 0;
+                }
+            }
+            return;
+        }
+
+        const level &p = m_levels[depth - 1];
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t parent    = l.parent[i];
+            const uint8_t  recompute = l.dirty[i] | p.changed[parent];
+
+            l.changed[i] = recompute;
+            if (recompute) {
+                l.world[i] = p.world[parent] * l.local[i];
+                l.dirty[i] = 0;
+            }
+        }
+    }
+
+    transform_hierarchy::node_info &transform_hierarchy::_info(const transform_handle node) {
+        node_info *info = m_nodes.get(node);
+        if (!info) {
+            throw std::out_of_range("Transform handle is not valid");
+        }
+        return *info;
+    }
+
+    const transform_hierarchy::node_info &transform_hierarchy::_info(const transform_handle node) const {
+        const node_info *info = m_nodes.get(node);
+        if (!info) {
+            throw std::out_of_range("Transform handle is not valid");
+        }
+        return *info;
+    }
+
+    void transform_hierarchy::_place(const transform_handle node, const uint32_t depth, const glm::mat4 &local) {
+        if (m_depth_count <= depth) {
+            if (m_levels.size() <= depth) {
+                m_levels.resize(depth + 1);
+            }
+            m_depth_count = depth + 1;
+        }
+
+        node_info &info = _info(node);
+        level     &l    = m_levels[depth];
+
+        info.depth = depth;
+        info.index = static_cast<uint32_t>(l.node.size());
+
+        l.local.push_back(local);
+        l.world.push_back(local);
+        l.parent.push_back(info.parent.is_null() ? no_parent : _info(info.parent).index);
+        l.dirty.push_back(1);
+        l.changed.push_back(0);
+        l.node.push_back(node);
+
+        m_any_dirty = true;
+    }
+
+    void transform_hierarchy::_remove_from_level(node_info &info) {
+        level         &l    = m_levels[info.depth];
+        const uint32_t hole = info.index;
+        const uint32_t last = static_cast<uint32_t>(l.node.size() - 1);
+
+        if (hole != last) {
+            const transform_handle removed = l.node[hole];
+
+            l.local[hole]   = l.local[last];
+            l.world[hole]   = l.world[last];
+            l.parent[hole]  = l.parent[last];
+            l.dirty[hole]   = l.dirty[last];
+            l.changed[hole] = l.changed[last];
+            l.node[hole]    = l.node[last];
+
+            // the moved node's children refer to it by index. Children still waiting to be moved by _move_subtree may
+            // sit on another level; their parent index is rewritten when they are placed anyway. The removed node can
+            // be one of them (when _move_subtree has just placed its parent on this level), and its slot is the hole,
+            // which now belongs to the moved node.
+            node_info &moved = _info(l.node[hole]);
+            moved.index      = hole;
+            for (const transform_handle child : moved.children) {
+                if (child == removed)
+                    continue;
+                const node_info &child_info = _info(child);
+                m_levels[child_info.depth].parent[child_info.index] = hole;
+            }
+        }
+
+        l.local.pop_back();
+        l.world.pop_back();
+        l.parent.pop_back();
+        l.dirty.pop_back();
+        l.changed.pop_back();
+        l.node.pop_back();
+
+        // emptied levels keep their arrays, so a scene that despawns everything and spawns again does not regrow them
+        while (m_depth_count > 0 && m_levels[m_depth_count - 1].node.empty()) {
+            --m_depth_count;
+        }
+    }
+
+    void transform_hierarchy::_move_subtree(const transform_handle node, const uint32_t depth) {
+        // breadth first, so parents are always placed before their children and deep chains do not recurse
+        std::vector<std::pair<transform_handle, uint32_t>> queue{{node, depth}};
+        for (size_t i = 0; i < queue.size(); ++i) {
+            const auto [current, current_depth] = queue[i];
+
+            node_info      &info  = _info(current);
+            const glm::mat4 local = m_levels[info.depth].local[info.index];
+
+            _remove_from_level(info);
+            _place(current, current_depth, local);
+
+            for (const transform_handle child : info.children) {
+                queue.emplace_back(child, current_depth + 1);
+            }
+        }
+    }
+} // namespace engine::scene
@@ -0,0 +1,110 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include "engine/slot_map.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace engine {
+    class job_system;
+} // namespace engine
+
+namespace engine::scene {
+
+    using transform_handle = slot_handle;
+
+    /**
+     * Local and world matrices for a hierarchy of nodes. Nodes are stored by depth: each level keeps its matrices, parent
+     * indices and dirty flags in contiguous arrays, so a world-matrix update is a linear pass over one level after
+     * another, and every node of a level can be processed in parallel. Only nodes whose local matrix changed, or whose
+     * parent's world matrix changed, are recomputed.
+     */
+    class transform_hierarchy {
+      public:
+        static constexpr uint32_t no_parent = UINT32_MAX;
+
+        transform_handle create(transform_handle parent = {}, const glm::mat4 &local = glm::mat4(1.0f));
+
+        /**
+         * Destroys a node. Its children become roots and keep their local matrices.
+         */
+        void destroy(transform_handle node);
+
+        /**
+         * Moves a node (with its whole subtree) under a new parent, or to the root if parent is null.
+         */
+        void set_parent(transform_handle node, transform_handle parent);
+
+        /**
+         * Safe to call for different nodes from several threads at once, as long as nothing creates, destroys, reparents
+         * or updates nodes meanwhile: each node's matrix and dirty flag are its own, and the flag saying any is dirty is
+         * atomic.
+         */
+        void set_local(transform_handle node, const glm::mat4 &local);
+
+        [[nodiscard]] const glm::mat4 &get_local(transform_handle node) const;
+
+        /**
+         * @return The world matrix as of the last update().
+         */
+        [[nodiscard]] const glm::mat4 &get_world(transform_handle node) const;
+
+        /**
+         * @return Whether the last update() recomputed the node's world matrix.
+         */
+        [[nodiscard]] bool changed(transform_handle node) const;
+
+        [[nodiscard]] inline bool contains(const transform_handle node) const noexcept { return m_nodes.contains(node); }
+
+        /**
+         * Reserves room for count more nodes, placed at the root level.
+         */
+        void reserve(size_t count);
+
+        [[nodiscard]] inline size_t size() const noexcept { return m_nodes.size(); }
+        [[nodiscard]] inline size_t depth_count() const noexcept { return m_depth_count; }
+
+        /**
+         * Recomputes world matrices for dirty subtrees, one depth level at a time. Levels with at least
+         * parallel_threshold nodes are split across the job system when one is given.
+         */
+        void update(job_system *jobs = nullptr, size_t parallel_threshold = 4096);
+
+      private:
+        struct level {
+            std::vector<glm::mat4>        local;
+            std::vector<glm::mat4>        world;
+            std::vector<uint32_t>         parent; // index into the previous level
+            std::vector<uint8_t>          dirty;
+            std::vector<uint8_t>          changed; // world matrix changed during the current update
+            std::vector<transform_handle> node;
+        };
+
+        struct node_info {
+            uint32_t                      depth;
+            uint32_t                      index;
+            transform_handle              parent;
+            std::vector<transform_handle> children;
+        };
+
+        std::vector<level>  m_levels; // can hold emptied levels past m_depth_count, kept for their storage
+        slot_map<node_info> m_nodes;
+        size_t              m_depth_count = 0;
+        std::atomic<bool>   m_any_dirty   = false; // set_local may run on several threads
+        bool                m_updated     = false; // the last update() had work to do, so the changed flags are current
+
+        [[nodiscard]] node_info       &_info(transform_handle node);
+        [[nodiscard]] const node_info &_info(transform_handle node) const;
+
+        void _place(transform_handle node, uint32_t depth, const glm::mat4 &local);
+        void _remove_from_level(node_info &info);
+        void _move_subtree(transform_handle node, uint32_t depth);
+        void _update_range(uint32_t depth, size_t begin, size_t end);
+    };
+} // namespace engine::scene
@@ -0,0 +1,249 @@
+//
+// Created by andy on 10/17/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * A handle into a slot_map: a slot index plus the generation of the value that occupied it. Live handles always have
+     * a non-zero generation, so a default-constructed handle (and id 0) is null.
+     */
+    struct slot_handle {
+        uint32_t index      = 0;
+        uint32_t generation = 0;
+
+        [[nodiscard]] constexpr bool is_null() const noexcept { return generation == 0; }
+
+        /**
+         * Packs the handle into a single 64-bit id (generation in the high bits).
+         */
+        [[nodiscard]] constexpr uint64_t to_id() const noexcept {
+            return (static_cast<uint64_t>(generation) << 32) | index;
+        }
+
+        [[nodiscard]] static constexpr slot_handle from_id(const uint64_t id) noexcept {
+            return {.index = static_cast<uint32_t>(id), .generation = static_cast<uint32_t>(id >> 32)};
+        }
+
+        constexpr bool operator==(const slot_handle &other) const noexcept = default;
+    };
+
+    /**
+     * Stores values densely and hands out generational handles to them. Lookup is O(1), erasing swaps the last value into
+     * the hole, freed slots are reused (most recently freed first), and a handle to an erased value is detected because
+     * its generation no longer matches the slot.
+     */
+    template <typename T>
+    class slot_map {
+      public:
+        using handle = slot_handle;
+
+        template <typename... Args>
+        handle emplace(Args &&...args) {
+            const uint32_t dense = static_cast<uint32_t>(m_values.size());
+            m_values.emplace_back(std::forward<Args>(args)...);
+
+            uint32_t index;
+            if (!m_free.empty()) {
+                index = m_free.back();
+                m_free.pop_back();
+                m_free_low_water = std::min(m_free_low_water, m_free.size());
+            } else {
+                index = static_cast<uint32_t>(m_slots.size());
+                m_slots.push_back(slot{.dense_index = 0, .generation = 1});
+            }
+
+            m_slots[index].dense_index = dense;
+            m_dense_to_slot.push_back(index);
+            return {.index = index, .generation = m_slots[index].generation};
+        }
+
+        inline handle insert(T value) { return emplace(std::move(value)); }
+
+        /**
+         * Places a value at exactly the given handle, for rebuilding a map to a known state. The slot must not hold a
+         * value; it is taken off the free list, and slots are added up to it if the map has fewer. Slots added below it
+         * go on the free list, lowest on top.
+         *
+         * @throws std::logic_error if the handle is null or its slot is occupied
+         */
+        template <typename... Args>
+        handle emplace_at(const handle h, Args &&...args) {
+            if (h.is_null() || (h.index < m_slots.size() && occupied(h.index))) {
+                throw std::logic_error("Cannot place a value in an occupied or null slot");
+            }
+
+            if (h.index >= m_slots.size()) {
+                const auto old_size = static_cast<uint32_t>(m_slots.size());
+                m_slots.resize(h.index + 1, slot{.dense_index = invalid_index, .generation = 1});
+                for (uint32_t index = h.index; index > old_size; --index) {
+                    m_free.push_back(index - 1);
+                }
+            } else if (const auto it = std::find(m_free.rbegin(), m_free.rend(), h.index); it != m_free.rend()) {
+                const auto position = m_free.erase(std::next(it).base());
+                m_free_low_water    = std::min(m_free_low_water, static_cast<size_t>(position - m_free.begin()));
+            }
+
+            m_slots[h.index] = slot{.dense_index = static_cast<uint32_t>(m_values.size()), .generation = h.generation};
+            m_values.emplace_back(std::forward<Args>(args)...);
+            m_dense_to_slot.push_back(h.index);
+            return h;
+        }
+
+        /**
+         * @return The handle the next emplace or insert will return, for values that need to know their own id before
+         * they are inserted.
+         */
+        [[nodiscard]] handle next_handle() const noexcept {
+            if (!m_free.empty())
+                return {.index = m_free.back(), .generation = m_slots[m_free.back()].generation};
+            return {.index = static_cast<uint32_t>(m_slots.size()), .generation = 1};
+        }
+
+        bool erase(const handle h) {
+            if (!contains(h))
+                return false;
+
+            slot          &s    = m_slots[h.index];
+            const uint32_t hole = s.dense_index;
+            const uint32_t last = static_cast<uint32_t>(m_values.size() - 1);
+
+            if (hole != last) {
+                m_values[hole]                             = std::move(m_values[last]);
+                m_dense_to_slot[hole]                      = m_dense_to_slot[last];
+                m_slots[m_dense_to_slot[hole]].dense_index = hole;
+            }
+            m_values.pop_back();
+            m_dense_to_slot.pop_back();
+
+            if (++s.generation == 0)
+                s.generation = 1;
+            s.dense_index = invalid_index;
+            m_free.push_back(h.index);
+            return true;
+        }
+
+        [[nodiscard]] bool contains(const handle h) const noexcept {
+            return !h.is_null() && h.index < m_slots.size() && m_slots[h.index].generation == h.generation &&
+                   m_slots[h.index].dense_index < m_values.size() &&
+                   m_dense_to_slot[m_slots[h.index].dense_index] == h.index;
+        }
+
+        [[nodiscard]] bool occupied(const uint32_t index) const noexcept {
+            return index < m_slots.size() && m_slots[index].dense_index < m_values.size() &&
+                   m_dense_to_slot[m_slots[index].dense_index] == index;
+        }
+
+        [[nodiscard]] T *get(const handle h) noexcept {
+            return contains(h) ? &m_values[m_slots[h.index].dense_index] : nullptr;
+        }
+
+        [[nodiscard]] const T *get(const handle h) const noexcept {
+            return contains(h) ? &m_values[m_slots[h.index].dense_index] : nullptr;
+        }
+
+        /**
+         * @return The handle of the value at a dense position, e.g. while iterating values().
+         */
+        [[nodiscard]] handle handle_at(const size_t dense_index) const noexcept {
+            const uint32_t index = m_dense_to_slot[dense_index];
+            return {.index = index, .generation = m_slots[index].generation};
+        }
+
+        [[nodiscard]] inline std::span<T>       values() noexcept { return m_values; }
+        [[nodiscard]] inline std::span<const T> values() const noexcept { return m_values; }
+
+        [[nodiscard]] inline size_t size() const noexcept { return m_values.size(); }
+        [[nodiscard]] inline bool   empty() const noexcept { return m_values.empty(); }
+
+        inline auto begin() noexcept { return m_values.begin(); }
+        inline auto end() noexcept { return m_values.end(); }
+        inline auto begin() const noexcept { return m_values.begin(); }
+        inline auto end() const noexcept { return m_values.end(); }
+
+        [[nodiscard]] inline size_t slot_count() const noexcept { return m_slots.size(); }
+
+        /**
+         * @return The generation of a slot: its value's if it is occupied, otherwise the one its next value will get.
+         */
+        [[nodiscard]] inline uint32_t generation(const uint32_t index) const noexcept {
+            return m_slots[index].generation;
+        }
+
+        /**
+         * Sets the generation of a slot that holds no value.
+         */
+        void set_generation(const uint32_t index, const uint32_t generation) {
+            if (occupied(index) || generation == 0) {
+                throw std::logic_error("Cannot change the generation of an occupied slot");
+            }
+            m_slots[index].generation = generation;
+        }
+
+        /**
+         * @return The free slots; emplace reuses them from the back.
+         */
+        [[nodiscard]] inline std::span<const uint32_t> free_slots() const noexcept { return m_free; }
+
+        /**
+         * @return The shortest the free list has been since the last reset_free_low_water(). Entries below this position
+         * have not changed since then, so a copy of the free list can be brought up to date from here.
+         */
+        [[nodiscard]] inline size_t free_low_water() const noexcept { return m_free_low_water; }
+        inline void                 reset_free_low_water() noexcept { m_free_low_water = m_free.size(); }
+
+        /**
+         * Puts the slot array and free list back to a recorded state: the map gets slot_count slots, and the free list
+         * keeps its first keep entries followed by tail. Slots that are removed must not hold values.
+         */
+        void restore_free_slots(const size_t slot_count, const size_t keep, const std::span<const uint32_t> tail) {
+            for (size_t index = slot_count; index < m_slots.size(); ++index) {
+                if (occupied(static_cast<uint32_t>(index))) {
+                    throw std::logic_error("Cannot remove an occupied slot");
+                }
+            }
+            m_slots.resize(slot_count, slot{.dense_index = invalid_index, .generation = 1});
+
+            m_free.resize(std::min(keep, m_free.size()));
+            m_free.insert(m_free.end(), tail.begin(), tail.end());
+            m_free_low_water = std::min(m_free_low_water, keep);
+        }
+
+        void reserve(const size_t capacity) {
+            m_values.reserve(capacity);
+            m_dense_to_slot.reserve(capacity);
+            m_slots.reserve(capacity);
+        }
+
+        void clear() {
+            while (!m_values.empty()) {
+                erase(handle_at(m_values.size() - 1));
+            }
+        }
+
+      private:
+        static constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+
+        struct slot {
+            uint32_t dense_index; // invalid_index while the slot is unused
+            uint32_t generation;
+        };
+
+        std::vector<slot>     m_slots;
+        std::vector<T>        m_values;
+        std::vector<uint32_t> m_dense_to_slot;
+        std::vector<uint32_t> m_free; // a stack of unused slots
+        size_t                m_free_low_water = 0;
+    };
+
+} // namespace engine
@@ -1,5 +1,12 @@
+#include "engine/binary_log.hpp"
+#include "engine/frame_loop.hpp"
+#include "engine/logging.hpp"
+#include "engine/metrics.hpp"
 #include "engine/os.hpp"
+#include "engine/profiler.hpp"
+#include "engine/render/draw_list.hpp"
 #include "engine/render/render_device.hpp"
+#include "engine/render/render_thread.hpp"
 #include "engine/scene/scene.hpp"
 
 
@@ -9,35 +16,80 @@
 
 class test_object : public engine::scene::scene_object {
   public:
-    test_object(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id) : scene_object(scene, id) {}
+    test_object(
+        const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id, engine::event_logger logger
+    )
+        : scene_object(scene, id), m_logger(std::move(logger)) {}
 
-    void update(const double delta) override { spdlog::info("update {}", 1.0 / delta); }
+    void update(const double delta) override {
+        ENGINE_LOG(m_logger, spdlog::level::info, "update {}", 1.0 / delta);
+    }
+
+  private:
+    // from the installed factory, so logging every update does not block on the console (or format its message, when
+    // routed to a binary log)
+    engine::event_logger m_logger;
 };
 
 int main() {
+    {
+        const auto factory = std::make_shared<engine::routing_logger_factory>(
+            std::make_shared<engine::async_logger_factory>(engine::async_logger_factory::settings{})
+        );
+
+        // e.g. ENGINE_BINARY_LOGGERS=glfw,render,test_object
+        if (const char *binary_loggers = std::getenv("ENGINE_BINARY_LOGGERS")) {
+            factory->route_list(
+                binary_loggers,
+                std::make_shared<engine::binary_logger_factory>(engine::binary_logger_factory::settings{})
+            );
+        }
+        engine::set_logger_factory(factory);
+    }
+    ENGINE_PROFILE_THREAD("main");
+    const engine::metrics::file_exporter metrics_exporter(engine::metrics::file_exporter::settings{});
     engine::os_init();
     {
         const auto window = std::make_shared<engine::window>(
             engine::window::attributes{.title = "Hello!", .windowed_size = {800, 600}}
         );
-        const auto render_device = std::make_shared<engine::render_device>(window);
+        engine::render_device::settings device_settings{.window = window};
+        // e.g. ENGINE_GPU=llvmpipe
+        if (const char *gpu = std::getenv("ENGINE_GPU")) {
+            device_settings.device_override = gpu;
+        }
+        const auto render_device = std::make_shared<engine::render_device>(device_settings);
 
         const auto scene        = std::make_shared<engine::scene::scene>();
+        scene->set_job_system(std::make_shared<engine::job_system>(engine::job_system::settings{}));
         const auto update_group = scene->push_front_new_update_group();
+        const auto extraction   = engine::render_extraction::attach(scene);
 
-        const auto [_, _2] = scene->emplace_object_named_ug<test_object>("test_object", update_group);
+        const auto [_, _2] = scene->emplace_object_named_ug<test_object>(
+            "test_object", update_group, engine::event_logger(engine::create_logger("test_object"))
+        );
 
-        double this_frame = glfwGetTime();
-        double delta_time = 1.0 / 60.0;
-        double last_frame = this_frame - delta_time;
+        engine::frame_loop    loop(engine::frame_loop::settings{});
+        engine::render_thread renderer(
+            std::make_unique<engine::null_render_backend>(engine::null_render_backend::settings{}),
+            engine::render_thread::settings{}
+        );
 
         while (!window->should_close()) {
-            engine::os_poll();
-            scene->update(delta_time);
+            loop.set_idle(window->is_iconified());
+            loop.pace(engine::os_wait);
+            const auto frame = loop.advance([&](const double step) {
+                window->input().drain(loop.step_end());
+                scene->update(step);
+            });
 
-            last_frame = this_frame;
-            this_frame = glfwGetTime();
-            delta_time = this_frame - last_frame;
+            // the render thread draws this while the next frame is simulated
+            engine::frame_packet &packet = renderer.begin_frame();
+            packet.simulation_time       = frame.simulation_time;
+            packet.alpha                 = frame.alpha;
+            packet.assign(extraction->get_draw_list());
+            renderer.end_frame();
+            ENGINE_PROFILE_FRAME();
         }
     }
 
@@ -0,0 +1,222 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Logs from several threads to a binary log through binary_logger_factory, once as events (ENGINE_LOG, arguments
+// stored raw) and once as text (formatted by spdlog before it is written), then decodes each file with the reader
+// log_decode uses. Reports the p50, p90, p99 and p99.9 call latencies and the bytes written per message. Checks that
+// every message decodes to exactly what std::format gives for its format string and arguments, once each and in the
+// order its thread logged it, and that event_logger only skips formatting for loggers backed by a binary log.
+//
+//   binary_log_bench [--threads <count>] [--messages <per thread>] [--out <file>]
+
+#include "engine/binary_log.hpp"
+#include "engine/binary_log_reader.hpp"
+
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <latch>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint32_t              threads  = 4;
+        uint64_t              messages = 20'000;
+        std::filesystem::path out      = std::filesystem::temp_directory_path() / "engine_binary_log_bench.binlog";
+    };
+
+    // one argument of every kind an event stores, with format specs the decoder has to apply
+    constexpr std::string_view message_format = "{} thread {} message {}: {:.3f} ms, {} {:>6} {:#x}";
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    struct run_result {
+        std::vector<uint64_t> latencies; // nanoseconds per call, sorted
+        double                seconds = 0.0;
+        uint64_t              bytes   = 0;
+    };
+
+    [[nodiscard]] double percentile(const std::vector<uint64_t> &sorted, const double p) {
+        const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())));
+        return static_cast<double>(sorted[index]);
+    }
+
+    [[nodiscard]] std::string expected_text(const std::string &tag, const uint32_t t, const uint64_t n) {
+        return std::format(
+            message_format, tag, t, n, static_cast<double>(n) * 0.125, n % 3 == 0, -static_cast<int64_t>(n % 1000),
+            static_cast<uint32_t>(n * 2654435761u)
+        );
+    }
+
+    /**
+     * Decodes a run's file and checks that each thread's messages appear once each, in order, as std::format writes
+     * them.
+     */
+    void check_output(const options &options, const std::string &tag, const std::vector<uint32_t> &thread_ids) {
+        std::ifstream           file(options.out, std::ios::binary);
+        const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        std::unordered_map<uint32_t, uint32_t> thread_of;
+        for (uint32_t t = 0; t < options.threads; ++t) {
+            thread_of[thread_ids[t]] = t;
+        }
+        check(thread_of.size() == options.threads, "every thread has an id of its own");
+
+        std::vector<uint64_t>      next(options.threads, 0);
+        const std::string          logger = "binary_log_bench_" + tag;
+        engine::binary_log::reader in(data);
+        engine::binary_log::record record;
+        while (in.next(record)) {
+            check(record.logger == logger, "records name the logger that wrote them");
+            check(record.level == spdlog::level::info, "records keep their level");
+
+            const auto it = thread_of.find(record.thread);
+            check(it != thread_of.end(), "records name a thread that logged");
+            const uint32_t t = it->second;
+            check(next[t] < options.messages, "no message is written twice");
+            check(
+                record.text == expected_text(tag, t, next[t]),
+                "a message decodes to what std::format gives, in the order its thread logged it"
+            );
+            ++next[t];
+        }
+        check(std::ranges::all_of(next, [&](const uint64_t n) { return n == options.messages; }), "no message is lost");
+    }
+
+    run_result run(const options &options, const bool events) {
+        const std::string     tag = events ? "events" : "text";
+        run_result            result;
+        std::vector<uint32_t> thread_ids(options.threads);
+        {
+            engine::binary_logger_factory factory(engine::binary_logger_factory::settings{.path = options.out});
+            const engine::event_logger    logger(
+                factory.create_logger("binary_log_bench_" + tag, engine::logger_settings{.ephemeral_only = false})
+            );
+            check(
+                logger.binary_writer() == factory.writer().get(),
+                "loggers from a binary_logger_factory write events to its file"
+            );
+
+            std::vector<std::vector<uint64_t>> latencies(options.threads);
+            std::latch                         start_line(options.threads + 1);
+            std::vector<std::jthread>          threads;
+            for (uint32_t t = 0; t < options.threads; ++t) {
+                threads.emplace_back([&, t] {
+                    // as the writer and the sink record it
+                    thread_ids[t] = static_cast<uint32_t>(spdlog::details::os::thread_id());
+
+                    std::vector<uint64_t> &own = latencies[t];
+                    own.reserve(options.messages);
+                    start_line.arrive_and_wait();
+                    for (uint64_t n = 0; n < options.messages; ++n) {
+                        const double   ms     = static_cast<double>(n) * 0.125;
+                        const bool     third  = n % 3 == 0;
+                        const int64_t  offset = -static_cast<int64_t>(n % 1000);
+                        const uint32_t hash   = static_cast<uint32_t>(n * 2654435761u);
+
+                        const auto before = clock::now();
+                        if (events) {
+                            ENGINE_LOG(logger, spdlog::level::info, message_format, tag, t, n, ms, third, offset, hash);
+                        } else {
+                            logger->info(message_format, tag, t, n, ms, third, offset, hash);
+                        }
+                        own.push_back(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - before).count()
+                        );
+                    }
+                });
+            }
+
+            start_line.arrive_and_wait();
+            const auto start = clock::now();
+            threads.clear();
+            result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+            for (const auto &own : latencies) {
+                result.latencies.insert(result.latencies.end(), own.begin(), own.end());
+            }
+            std::ranges::sort(result.latencies);
+            spdlog::drop(logger->name());
+        }
+
+        // the writer trims the file to what it wrote when the last logger lets go of it
+        result.bytes = std::filesystem::file_size(options.out);
+        check_output(options, tag, thread_ids);
+        return result;
+    }
+
+    void print(const char *name, const run_result &r, const options &options) {
+        const double total = static_cast<double>(options.threads * options.messages);
+        std::printf(
+            "%-7s p50 %7.0f ns, p90 %7.0f ns, p99 %8.0f ns, p99.9 %8.0f ns, %6.2f M messages/s, %5.1f bytes/message\n",
+            name, percentile(r.latencies, 0.5), percentile(r.latencies, 0.9), percentile(r.latencies, 0.99),
+            percentile(r.latencies, 0.999), total / r.seconds / 1e6, static_cast<double>(r.bytes) / total
+        );
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: binary_log_bench [--threads <count>] [--messages <per thread>] [--out <file>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--threads") {
+            options.threads = std::max<uint32_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--messages") {
+            options.messages = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--out") {
+            options.out = argv[++i];
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        const engine::event_logger text(std::make_shared<spdlog::logger>(
+            "binary_log_bench_null", std::make_shared<spdlog::sinks::null_sink_mt>()
+        ));
+        check(!text.binary_writer(), "loggers that write text keep formatting it");
+
+        const run_result events    = run(options, true);
+        const run_result formatted = run(options, false);
+        std::filesystem::remove(options.out);
+        std::printf(
+            "round trip and ordering checks passed, %u threads logging %llu messages each\n", options.threads,
+            static_cast<unsigned long long>(options.messages)
+        );
+
+        print("events", events, options);
+        print("text", formatted, options);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
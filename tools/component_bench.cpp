@@ -0,0 +1,235 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Compares moving entities through component_storage with moving scene_objects through an update group, at 10k, 100k
+// and 1M entities. Each entity has a position and a velocity and does position += velocity * delta per update: as
+// members of a scene_object updated by an update group (with virtual calls, and with the typed per-run calls), and as
+// position and velocity columns iterated by a component_view. Checks that all three end up with the same positions,
+// and that components keep their values while entities move between archetypes.
+//
+//   component_bench [--updates <count>] [--max <entities>]
+
+#include "engine/scene/scene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t updates = 20;
+        uint64_t max     = 1'000'000;
+    };
+
+    struct position {
+        glm::vec3 value;
+    };
+
+    struct velocity {
+        glm::vec3 value;
+    };
+
+    struct tag {
+        uint32_t value;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    glm::vec3 start_position(const uint64_t i) {
+        return {static_cast<float>(i % 1000), static_cast<float>(i / 1000 % 1000), static_cast<float>(i % 7)};
+    }
+
+    glm::vec3 start_velocity(const uint64_t i) {
+        return {static_cast<float>(i % 3) - 1.0f, 0.5f, static_cast<float>(i % 5) * 0.25f};
+    }
+
+    class moving_object : public engine::scene::scene_object {
+      public:
+        moving_object(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id, const uint64_t index)
+            : scene_object(scene, id), m_position(start_position(index)), m_velocity(start_velocity(index)) {}
+
+        void update(const double delta) override { m_position += m_velocity * static_cast<float>(delta); }
+
+        [[nodiscard]] inline const glm::vec3 &get_position() const noexcept { return m_position; }
+
+      private:
+        glm::vec3 m_position;
+        glm::vec3 m_velocity;
+    };
+
+    constexpr double step = 1.0 / 60.0;
+
+    double sum(const glm::vec3 &v) {
+        return static_cast<double>(v.x) + static_cast<double>(v.y) + static_cast<double>(v.z);
+    }
+
+    struct run_result {
+        double seconds_per_update;
+        double checksum; // of every final position
+    };
+
+    run_result run_objects(const uint64_t count, const uint64_t updates, const bool typed) {
+        const auto scene = std::make_shared<engine::scene::scene>();
+        const auto group = scene->push_end_new_update_group();
+
+        std::vector<std::shared_ptr<engine::scene::scene_object>> objects;
+        objects.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            const auto object = scene->emplace_object<moving_object>(i).second;
+            if (typed) {
+                group->insert(std::static_pointer_cast<moving_object>(object));
+            } else {
+                group->insert(object);
+            }
+            objects.push_back(object);
+        }
+
+        const auto start = clock::now();
+        for (uint64_t i = 0; i < updates; ++i) {
+            group->update(step);
+        }
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        double checksum = 0.0;
+        for (const auto &object : objects) {
+            checksum += sum(static_cast<const moving_object &>(*object).get_position());
+        }
+        return {.seconds_per_update = seconds / static_cast<double>(updates), .checksum = checksum};
+    }
+
+    run_result run_components(const uint64_t count, const uint64_t updates) {
+        engine::scene::component_storage storage;
+        for (uint64_t i = 0; i < count; ++i) {
+            storage.create_entity(position{start_position(i)}, velocity{start_velocity(i)});
+        }
+
+        const auto start = clock::now();
+        for (uint64_t i = 0; i < updates; ++i) {
+            storage.view<position, velocity>().each([](position &p, const velocity &v) {
+                p.value += v.value * static_cast<float>(step);
+            });
+        }
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        double checksum = 0.0;
+        storage.view<position>().each([&](const position &p) { checksum += sum(p.value); });
+        return {.seconds_per_update = seconds / static_cast<double>(updates), .checksum = checksum};
+    }
+
+    /**
+     * Adds and removes components so entities move between archetypes, then checks every value against what was
+     * written and that destroyed entities are gone.
+     */
+    void check_storage() {
+        engine::scene::component_storage   storage;
+        std::vector<engine::scene::entity> entities;
+        for (uint32_t i = 0; i < 10'000; ++i) {
+            entities.push_back(storage.create_entity(position{start_position(i)}));
+        }
+        for (uint32_t i = 0; i < entities.size(); i += 2) {
+            storage.emplace_component<velocity>(entities[i], start_velocity(i));
+        }
+        for (uint32_t i = 0; i < entities.size(); i += 3) {
+            storage.emplace_component<tag>(entities[i], i);
+        }
+        for (uint32_t i = 0; i < entities.size(); i += 4) {
+            storage.remove_component<velocity>(entities[i]);
+        }
+        for (uint32_t i = 5; i < entities.size(); i += 10) {
+            storage.destroy_entity(entities[i]);
+        }
+
+        size_t alive = 0;
+        for (uint32_t i = 0; i < entities.size(); ++i) {
+            const engine::scene::entity e = entities[i];
+            if (i % 10 == 5) {
+                check(!storage.is_alive(e) && !storage.get_component<position>(e), "destroyed entities are gone");
+                continue;
+            }
+            ++alive;
+
+            const position *p = storage.get_component<position>(e);
+            check(p && p->value == start_position(i), "positions survive archetype moves");
+
+            const velocity *v = storage.get_component<velocity>(e);
+            check((v != nullptr) == (i % 2 == 0 && i % 4 != 0), "velocities are where they were added");
+            check(!v || v->value == start_velocity(i), "velocities survive archetype moves");
+
+            const tag *t = storage.get_component<tag>(e);
+            check((t != nullptr) == (i % 3 == 0) && (!t || t->value == i), "tags survive archetype moves");
+        }
+        check(storage.entity_count() == alive, "the entity count matches");
+        check(storage.view<position>().count() == alive, "a view sees every entity with its components");
+
+        size_t moving = 0;
+        storage.view<position, velocity>().each([&](const engine::scene::entity e, position &, velocity &) {
+            check(storage.is_alive(e), "a view only sees live entities");
+            ++moving;
+        });
+        check(moving == storage.view<position, velocity>().count(), "each visits what count counts");
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: component_bench [--updates <count>] [--max <entities>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--updates") {
+            options.updates = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--max") {
+            options.max = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        check_storage();
+        std::printf("component storage checks passed\n");
+
+        for (uint64_t count = std::min<uint64_t>(10'000, options.max); count <= options.max; count *= 10) {
+            const run_result virtual_calls = run_objects(count, options.updates, false);
+            const run_result typed_calls   = run_objects(count, options.updates, true);
+            const run_result components    = run_components(count, options.updates);
+            check(
+                virtual_calls.checksum == typed_calls.checksum && typed_calls.checksum == components.checksum,
+                "every path moves the entities the same way"
+            );
+
+            const auto print = [&](const char *label, const run_result &result) {
+                std::printf(
+                    "%8llu entities, %-22s %8.3f ms per update, %6.1f M entities/s\n",
+                    static_cast<unsigned long long>(count), label, result.seconds_per_update * 1e3,
+                    static_cast<double>(count) / result.seconds_per_update / 1e6
+                );
+            };
+            print("update_group (virtual)", virtual_calls);
+            print("update_group (typed)", typed_calls);
+            print("component_view", components);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,371 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures the draw list extraction stages on 1M boxes scattered around a camera: frustum culling (cull_bounds) against
+// testing each box's corners one at a time, radix_sort against std::sort on the sort keys of every box, and a whole
+// render_extraction::extract over 1M renderables, with and without a job system. Checks that culling keeps exactly the
+// boxes the corner test keeps (apart from boxes within rounding of a plane), that the radix sort orders entries as
+// std::stable_sort does, that sort keys order opaque and translucent draws as documented, and that an extracted draw
+// list holds every visible renderable, sorted, with its world matrix.
+//
+//   cull_bench [--bounds <count>] [--runs <count>] [--threads <count>] [--seed <value>]
+
+#include "engine/jobs.hpp"
+#include "engine/render/draw_list.hpp"
+#include "engine/scene/scene.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t bounds  = 1'000'000;
+        uint64_t runs    = 5;
+        uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        uint64_t seed    = 1;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    // boxes are scattered in [-world_extent, world_extent) on every axis, around a camera at the origin
+    constexpr float world_extent = 500.0f;
+
+    engine::camera_view make_camera() {
+        const glm::vec3 position(0.0f);
+        const glm::vec3 forward(0.0f, 0.0f, -1.0f);
+        constexpr float far_plane = 1000.0f;
+
+        engine::camera_view camera;
+        camera.view_projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, far_plane) *
+                                 glm::lookAt(position, position + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+        camera.position  = position;
+        camera.forward   = forward;
+        camera.far_plane = far_plane;
+        return camera;
+    }
+
+    std::vector<engine::scene::aabb> random_boxes(const uint64_t count, std::mt19937_64 &rng) {
+        std::uniform_real_distribution<float> place(-world_extent, world_extent);
+        std::uniform_real_distribution<float> size(0.5f, 4.0f);
+        std::vector<engine::scene::aabb>      boxes;
+        boxes.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            const glm::vec3 min(place(rng), place(rng), place(rng));
+            boxes.push_back({min, min + glm::vec3(size(rng), size(rng), size(rng))});
+        }
+        return boxes;
+    }
+
+    /**
+     * How far the box's corner furthest along each plane's normal is inside the frustum, at worst: at least 0 when
+     * some of the box is inside every plane.
+     */
+    double corner_margin(const engine::frustum &frustum, const engine::scene::aabb &box) {
+        double margin = std::numeric_limits<double>::max();
+        for (const glm::vec4 &plane : frustum.planes) {
+            const double x = plane.x >= 0.0f ? box.max.x : box.min.x;
+            const double y = plane.y >= 0.0f ? box.max.y : box.min.y;
+            const double z = plane.z >= 0.0f ? box.max.z : box.min.z;
+            margin         = std::min(margin, plane.x * x + plane.y * y + plane.z * z + static_cast<double>(plane.w));
+        }
+        return margin;
+    }
+
+    /**
+     * Checks the visible indices against the corner test. Boxes that touch a plane to within rounding may go either
+     * way, but there should be few of them.
+     */
+    void check_visible(
+        const engine::frustum &frustum, const std::vector<engine::scene::aabb> &boxes, const uint32_t *visible,
+        const size_t count
+    ) {
+        constexpr double tolerance = 1e-2;
+
+        check(std::is_sorted(visible, visible + count), "visible indices are in order");
+        size_t   next      = 0;
+        uint64_t uncertain = 0;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            const bool   kept   = next < count && visible[next] == i;
+            const double margin = corner_margin(frustum, boxes[i]);
+            if (std::abs(margin) < tolerance) {
+                ++uncertain;
+            } else {
+                check(kept == (margin > 0.0), "culling keeps exactly the boxes the corner test keeps");
+            }
+            next += kept;
+        }
+        check(next == count, "every visible index is a box");
+        check(uncertain <= boxes.size() / 1000, "few boxes lie within rounding of a plane");
+    }
+
+    void check_sort_keys() {
+        using engine::make_sort_key;
+
+        check(make_sort_key(1, 900, 0.9f, false) < make_sort_key(2, 0, 0.1f, false), "opaque draws group by pipeline");
+        check(make_sort_key(1, 1, 0.9f, false) < make_sort_key(1, 2, 0.1f, false), "then by material");
+        check(make_sort_key(1, 1, 0.1f, false) < make_sort_key(1, 1, 0.9f, false), "then front to back");
+        check(make_sort_key(0x7fff, 0xffffff, 1.0f, false) < make_sort_key(0, 0, 0.0f, true), "translucent come last");
+        check(make_sort_key(0, 0, 0.9f, true) < make_sort_key(0, 0, 0.1f, true), "translucent go back to front");
+        check(make_sort_key(9, 0, 0.5f, true) < make_sort_key(1, 0, 0.4f, true), "before pipeline");
+        check(
+            make_sort_key(3, 4, std::numeric_limits<float>::quiet_NaN(), false) == make_sort_key(3, 4, 0.0f, false),
+            "a NaN depth counts as 0"
+        );
+        check(make_sort_key(3, 4, 7.0f, false) == make_sort_key(3, 4, 1.0f, false), "depth is clamped to 1");
+    }
+
+    std::vector<engine::draw_sort_entry> random_entries(
+        const std::vector<engine::scene::aabb> &boxes, const engine::camera_view &camera, std::mt19937_64 &rng
+    ) {
+        std::vector<engine::draw_sort_entry> entries;
+        entries.reserve(boxes.size());
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            const glm::vec3 center = (boxes[i].min + boxes[i].max) * 0.5f;
+            const float     depth  = glm::dot(center - camera.position, camera.forward) / camera.far_plane;
+            const auto      bits   = rng();
+            entries.push_back({
+                engine::make_sort_key(bits & 0xf, (bits >> 4) & 0xff, depth, (bits >> 12) % 10 == 0),
+                static_cast<uint32_t>(i),
+            });
+        }
+        return entries;
+    }
+
+    void check_radix_sort(std::vector<engine::draw_sort_entry> entries) {
+        const auto by_key = [](const engine::draw_sort_entry &a, const engine::draw_sort_entry &b) {
+            return a.key < b.key;
+        };
+
+        // small lists take the 8-bit digit path, large ones the 16-bit one
+        for (const size_t count : {size_t(1), std::min<size_t>(1000, entries.size()), entries.size()}) {
+            std::vector<engine::draw_sort_entry> sorted(entries.begin(), entries.begin() + count);
+            std::vector<engine::draw_sort_entry> expected = sorted;
+            std::vector<engine::draw_sort_entry> scratch(count);
+            engine::radix_sort(sorted, scratch);
+            std::ranges::stable_sort(expected, by_key);
+            check(
+                std::ranges::equal(
+                    sorted, expected, [](const auto &a, const auto &b) { return a.key == b.key && a.index == b.index; }
+                ),
+                "radix_sort orders entries as std::stable_sort does"
+            );
+        }
+    }
+
+    struct renderable_scene {
+        std::shared_ptr<engine::scene::scene>        scene;
+        std::vector<engine::scene::transform_handle> transforms;
+        std::vector<engine::scene::aabb>             world_boxes; // what each renderable's box is culled as
+    };
+
+    /**
+     * Renderables on entities of their own, each with a unit box placed by its own transform node.
+     */
+    renderable_scene make_scene(const uint64_t count, std::mt19937_64 &rng) {
+        renderable_scene result{std::make_shared<engine::scene::scene>(), {}, {}};
+        auto            &transforms = result.scene->transforms();
+        transforms.reserve(count);
+
+        std::uniform_real_distribution<float> place(-world_extent, world_extent);
+        const engine::scene::aabb             unit_box{glm::vec3(-0.5f), glm::vec3(0.5f)};
+        for (uint64_t i = 0; i < count; ++i) {
+            const auto transform = transforms.create(
+                {}, glm::translate(glm::mat4(1.0f), glm::vec3(place(rng), place(rng), place(rng)))
+            );
+            const auto bits = rng();
+            result.scene->components().create_entity(engine::renderable{
+                .transform   = transform,
+                .bounds      = unit_box,
+                .mesh        = static_cast<uint32_t>(bits & 0x3f),
+                .material    = static_cast<uint32_t>((bits >> 6) & 0xff),
+                .pipeline    = static_cast<uint16_t>((bits >> 14) & 0xf),
+                .translucent = (bits >> 18) % 10 == 0,
+                .object      = i,
+            });
+            result.transforms.push_back(transform);
+        }
+
+        result.scene->update(0.0);
+        for (const auto transform : result.transforms) {
+            result.world_boxes.push_back(unit_box.transformed(transforms.get_world(transform)));
+        }
+        return result;
+    }
+
+    void check_draw_list(const renderable_scene &scene, const engine::frustum &frustum, const engine::draw_list &list) {
+        check(list.candidates == scene.transforms.size(), "every renderable is a candidate");
+        check(
+            std::ranges::is_sorted(list.draws, {}, &engine::draw_item::sort_key), "the draw list is sorted by sort key"
+        );
+
+        std::vector<uint8_t> drawn(scene.transforms.size(), 0);
+        for (const auto &draw : list.draws) {
+            check(draw.object < drawn.size() && !drawn[draw.object], "each renderable is drawn at most once");
+            drawn[draw.object] = 1;
+            check(
+                draw.world == scene.scene->transforms().get_world(scene.transforms[draw.object]),
+                "draws carry the world matrix"
+            );
+        }
+
+        std::vector<uint32_t> visible;
+        for (uint32_t i = 0; i < drawn.size(); ++i) {
+            if (drawn[i])
+                visible.push_back(i);
+        }
+        check_visible(frustum, scene.world_boxes, visible.data(), visible.size());
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: cull_bench [--bounds <count>] [--runs <count>] [--threads <count>] [--seed <value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--bounds") {
+            options.bounds = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--runs") {
+            options.runs = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--threads") {
+            options.threads = std::max(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), 1u);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::mt19937_64 rng(options.seed);
+        const auto      camera = make_camera();
+        const auto      view   = engine::frustum::from_matrix(camera.view_projection);
+        const auto      boxes  = random_boxes(options.bounds, rng);
+        const size_t    n      = boxes.size();
+
+        engine::frame_arena arena;
+        auto                bounds = engine::bounds_soa::allocate(arena, n);
+        for (size_t i = 0; i < n; ++i) {
+            bounds.set(i, boxes[i]);
+        }
+        std::vector<uint32_t> visible(n);
+
+        // split at an odd index, so the first range ends with boxes the four-at-a-time loop leaves over
+        const size_t split = std::min<size_t>(n, 1001);
+        size_t       kept  = engine::cull_bounds(view, bounds, 0, split, visible.data());
+        kept += engine::cull_bounds(view, bounds, split, n, visible.data() + kept);
+        check_visible(view, boxes, visible.data(), kept);
+        check_sort_keys();
+
+        auto entries = random_entries(boxes, camera, rng);
+        check_radix_sort(entries);
+
+        double cull_seconds   = std::numeric_limits<double>::max();
+        double corner_seconds = std::numeric_limits<double>::max();
+        double radix_seconds  = std::numeric_limits<double>::max();
+        double std_seconds    = std::numeric_limits<double>::max();
+        for (uint64_t run = 0; run < options.runs; ++run) {
+            auto start = clock::now();
+            check(engine::cull_bounds(view, bounds, 0, n, visible.data()) == kept, "culling is repeatable");
+            cull_seconds = std::min(cull_seconds, seconds_since(start));
+
+            start                 = clock::now();
+            size_t corner_visible = 0;
+            for (const auto &box : boxes) {
+                corner_visible += corner_margin(view, box) >= 0.0;
+            }
+            corner_seconds = std::min(corner_seconds, seconds_since(start));
+            check(corner_visible > 0, "some boxes are visible");
+
+            auto                                 sorted = entries;
+            std::vector<engine::draw_sort_entry> scratch(n);
+            start = clock::now();
+            engine::radix_sort(sorted, scratch);
+            radix_seconds = std::min(radix_seconds, seconds_since(start));
+
+            sorted = entries;
+            start  = clock::now();
+            std::ranges::sort(sorted, {}, &engine::draw_sort_entry::key);
+            std_seconds = std::min(std_seconds, seconds_since(start));
+        }
+
+        auto scene = make_scene(options.bounds, rng);
+        check_draw_list(scene, view, engine::render_extraction::extract(*scene.scene, camera, arena));
+        std::printf("culling, sort key, radix sort and extraction checks passed\n");
+
+        const auto jobs = std::make_shared<engine::job_system>(
+            engine::job_system::settings{.worker_count = std::max(options.threads, 2u) - 1}
+        );
+        double serial_seconds   = std::numeric_limits<double>::max();
+        double parallel_seconds = std::numeric_limits<double>::max();
+        size_t draws            = 0;
+        size_t arena_bytes      = 0;
+        for (uint64_t run = 0; run < options.runs; ++run) {
+            arena.reset();
+            auto start = clock::now();
+            draws          = engine::render_extraction::extract(*scene.scene, camera, arena).draws.size();
+            serial_seconds = std::min(serial_seconds, seconds_since(start));
+            arena_bytes    = arena.bytes_used();
+
+            arena.reset();
+            start = clock::now();
+            check(
+                engine::render_extraction::extract(*scene.scene, camera, arena, jobs.get()).draws.size() == draws,
+                "extracting with a job system draws the same"
+            );
+            parallel_seconds = std::min(parallel_seconds, seconds_since(start));
+        }
+
+        const double count = static_cast<double>(n);
+        std::printf(
+            "%llu boxes, %zu visible (%.1f%%), best of %llu runs\n", static_cast<unsigned long long>(n), kept,
+            static_cast<double>(kept) / count * 100.0, static_cast<unsigned long long>(options.runs)
+        );
+        std::printf(
+            "cull: cull_bounds %.2f ms (%.1f ns per box), corner test %.2f ms (%.1f ns per box)\n", cull_seconds * 1e3,
+            cull_seconds / count * 1e9, corner_seconds * 1e3, corner_seconds / count * 1e9
+        );
+        std::printf(
+            "sort %llu keys: radix_sort %.2f ms, std::sort %.2f ms (%.2fx)\n", static_cast<unsigned long long>(n),
+            radix_seconds * 1e3, std_seconds * 1e3, std_seconds / radix_seconds
+        );
+        std::printf(
+            "extract %llu renderables: %.2f ms serial, %.2f ms on %u job system threads; %zu draws, %.1f MB arena\n",
+            static_cast<unsigned long long>(n), serial_seconds * 1e3, parallel_seconds * 1e3, options.threads, draws,
+            static_cast<double>(arena_bytes) / 1e6
+        );
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
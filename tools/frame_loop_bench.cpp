@@ -0,0 +1,185 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Drives engine::frame_loop without a window at 60, 144 and 240 Hz: each frame advances the fixed-step simulation,
+// spins for a fixed time standing in for the frame's work, then paces with a null wait function standing in for
+// os_wait with no events pending. Reports the achieved frame rate, how late frames start against their deadlines
+// (mean and worst) and the share of a core the process used. Checks that the loop holds its target rate, that the wait
+// function is pumped once per frame without being asked to block, that the simulation keeps up with real time, that
+// frames start close to their deadlines on average, and that pacing sleeps instead of spinning through the frame.
+//
+//   frame_loop_bench [--seconds <per rate>] [--work <ms>] [--spin <ms>]
+
+#include "engine/frame_loop.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define ENGINE_HAS_RUSAGE 1
+#endif
+
+namespace {
+    using clock = engine::frame_loop::clock;
+
+    struct options {
+        double seconds = 2.0; // per rate
+        double work    = 1.0; // ms
+        double spin    = 2.0; // ms
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    /**
+     * User and system time used by every thread of the process so far, in seconds.
+     */
+    double process_cpu_seconds() {
+#ifdef ENGINE_HAS_RUSAGE
+        rusage usage{};
+        ::getrusage(RUSAGE_SELF, &usage);
+        const auto seconds = [](const timeval &t) { return static_cast<double>(t.tv_sec) + t.tv_usec / 1e6; };
+        return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+#else
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+    }
+
+    /**
+     * Stands in for the frame's work: keeps the thread busy, unlike pacing's sleep.
+     */
+    void busy_for(const double seconds) {
+        const auto start = clock::now();
+        while (seconds_since(start) < seconds) {
+        }
+    }
+
+    struct run_result {
+        double   rate;
+        uint64_t frames;
+        double   wall_seconds;
+        double   simulated_seconds;
+        double   dropped_seconds;
+        double   mean_lateness;
+        double   worst_lateness;
+        double   cpu_share; // of one core
+    };
+
+    run_result run(const double rate, const options &options) {
+        engine::frame_loop loop(engine::frame_loop::settings{
+            .fixed_step        = 1.0 / 60.0,
+            .target_frame_rate = rate,
+            .spin_threshold    = options.spin / 1e3,
+        });
+
+        // os_wait with no window: returns at once, as it does when no events are pending
+        uint64_t                                waits          = 0;
+        bool                                    asked_to_block = false;
+        const engine::frame_loop::wait_function null_wait      = [&](const double timeout) {
+            ++waits;
+            asked_to_block |= timeout != 0.0;
+        };
+
+        run_result result{.rate = rate};
+        double     total_lateness = 0.0;
+
+        loop.reset_clock();
+        const double cpu_start = process_cpu_seconds();
+        const auto   start     = clock::now();
+        while (seconds_since(start) < options.seconds) {
+            const engine::frame_loop::frame_info frame = loop.advance([](double) {});
+            result.dropped_seconds += frame.dropped;
+
+            busy_for(options.work / 1e3);
+            loop.pace(null_wait);
+
+            total_lateness += loop.lateness();
+            result.worst_lateness = std::max(result.worst_lateness, loop.lateness());
+            ++result.frames;
+        }
+        result.wall_seconds      = seconds_since(start);
+        result.cpu_share         = (process_cpu_seconds() - cpu_start) / result.wall_seconds;
+        result.simulated_seconds = loop.last_frame().simulation_time;
+        result.mean_lateness     = total_lateness / static_cast<double>(result.frames);
+
+        check(waits == result.frames, "pace pumps the wait function once every frame");
+        check(!asked_to_block, "and never asks it to block outside idle mode");
+        return result;
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: frame_loop_bench [--seconds <per rate>] [--work <ms>] [--spin <ms>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--seconds") {
+            options.seconds = std::max(std::strtod(argv[++i], nullptr), 0.25);
+        } else if (arg == "--work") {
+            options.work = std::max(std::strtod(argv[++i], nullptr), 0.0);
+        } else if (arg == "--spin") {
+            options.spin = std::max(std::strtod(argv[++i], nullptr), 0.0);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::vector<run_result> results;
+        for (const double rate : {60.0, 144.0, 240.0}) {
+            const run_result r = run(rate, options);
+            results.push_back(r);
+
+            const double period   = 1.0 / rate;
+            const double achieved = static_cast<double>(r.frames) / r.wall_seconds;
+            check(std::abs(achieved - rate) < rate * 0.05, "the loop holds its target rate within 5%");
+            check(
+                std::abs(r.simulated_seconds + r.dropped_seconds - r.wall_seconds) < 3.0 / 60.0,
+                "the simulation keeps up with real time"
+            );
+            check(r.mean_lateness < std::min(period / 4.0, 1e-3), "frames start close to their deadlines on average");
+            // the spin before each deadline and the work are the only busy parts of a frame
+            const double busy = std::min((options.spin + options.work) / 1e3 * rate, 1.0);
+            check(r.cpu_share < busy + 0.2 || busy >= 0.8, "pacing sleeps through the rest of the frame");
+        }
+        std::printf("rate, wait, simulation, lateness and CPU checks passed\n");
+
+        std::printf(
+            "%.1f ms of work per frame, spinning the last %.1f ms before each deadline\n", options.work, options.spin
+        );
+        for (const run_result &r : results) {
+            std::printf(
+                "%5.0f Hz: %6.1f frames/s, lateness mean %6.1f us, worst %7.1f us, process CPU %5.1f%% of a core\n",
+                r.rate, static_cast<double>(r.frames) / r.wall_seconds, r.mean_lateness * 1e6, r.worst_lateness * 1e6,
+                r.cpu_share * 100.0
+            );
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
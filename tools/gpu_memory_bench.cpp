@@ -0,0 +1,268 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures engine::gpu_allocator under churn against a fake device with no memory behind it: how fast allocations
+// and frees are, how much memory is reserved for what is in use, how scattered the free space gets, and how much
+// defragmentation gives back after most of the allocations are freed.
+//
+//   gpu_memory_bench [--steps <count>] [--live <MiB>] [--block <MiB>] [--seed <value>]
+//
+// The mix is mostly small buffers, then textures, then the odd render target large enough to get memory of its own;
+// a tenth of the buffers are uploads.
+
+#include "engine/render/gpu_memory.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    constexpr uint64_t mib = uint64_t(1) << 20;
+
+    struct options {
+        uint64_t steps = 1'000'000;
+        uint64_t live  = 1536; // MiB
+        uint64_t seed  = 1;
+        uint64_t block = 256; // MiB
+    };
+
+    /**
+     * A discrete GPU's memory: an 8 GiB device-local heap, 16 GiB of system memory, and a 256 MiB BAR heap that is
+     * both.
+     */
+    class fake_source final : public engine::gpu_memory_source {
+      public:
+        [[nodiscard]] std::span<const engine::memory_type_info> memory_types() const override { return m_types; }
+        [[nodiscard]] uint32_t heap_count() const override { return 3; }
+
+        [[nodiscard]] engine::heap_budget budget(const uint32_t heap) const override {
+            return {.usage = m_usage[heap], .budget = m_sizes[heap] / 10 * 8};
+        }
+
+        [[nodiscard]] block allocate(const uint32_t type, const uint64_t size) override {
+            const uint32_t heap = m_types[type].heap;
+            if (m_usage[heap] + size > m_sizes[heap])
+                return {};
+            m_usage[heap] += size;
+            m_sizes_by_memory.push_back(size);
+            ++allocate_calls;
+            return {.memory = m_sizes_by_memory.size(), .mapped = nullptr};
+        }
+
+        void free(const uint32_t type, const block block) override {
+            m_usage[m_types[type].heap] -= m_sizes_by_memory[block.memory - 1];
+        }
+
+        uint64_t allocate_calls = 0;
+
+      private:
+        std::vector<engine::memory_type_info> m_types = {
+            {.heap = 0, .device_local = true},
+            {.heap = 1, .host_visible = true, .host_coherent = true},
+            {.heap = 1, .host_visible = true, .host_coherent = true, .host_cached = true},
+            {.heap = 2, .device_local = true, .host_visible = true, .host_coherent = true},
+        };
+        uint64_t              m_sizes[3] = {8192 * mib, 16384 * mib, 256 * mib};
+        uint64_t              m_usage[3] = {};
+        std::vector<uint64_t> m_sizes_by_memory;
+    };
+
+    engine::memory_request random_request(std::mt19937_64 &rng, const uint64_t user) {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        const auto log_uniform = [&](const double low, const double high) {
+            return static_cast<uint64_t>(std::exp(std::log(low) + unit(rng) * (std::log(high) - std::log(low))));
+        };
+
+        const double kind = unit(rng);
+        if (kind < 0.70) {
+            return {
+                .size      = log_uniform(256, 1 << 20),
+                .alignment = 256,
+                .usage     = unit(rng) < 0.1 ? engine::memory_usage::upload : engine::memory_usage::device,
+                .linear    = true,
+                .user      = user,
+            };
+        }
+        if (kind < 0.99) {
+            const uint64_t size = log_uniform(64 << 10, 16 << 20);
+            return {.size = (size + 0xffff) & ~uint64_t(0xffff), .alignment = 64 << 10, .linear = false, .user = user};
+        }
+        return {.size = log_uniform(32 << 20, 128 << 20), .alignment = 64 << 10, .linear = false, .user = user};
+    }
+
+    struct operation {
+        bool                   allocate;
+        engine::memory_request request; // when allocating
+        size_t                 victim;  // the index in the live allocations to free otherwise
+    };
+
+    /**
+     * Drifts around the live target, so blocks fill up and drain again. Made up front so the timed loop only
+     * allocates and frees.
+     */
+    std::vector<operation> make_script(const options &options, std::mt19937_64 &rng) {
+        std::vector<operation> script;
+        script.reserve(options.steps);
+
+        std::vector<uint64_t> live_sizes;
+        uint64_t              live_bytes = 0;
+        const uint64_t        target     = options.live * mib;
+        for (uint64_t step = 0; step < options.steps; ++step) {
+            const bool allocate = live_sizes.empty() || rng() % 100 < (live_bytes < target ? 60 : 40);
+            if (allocate) {
+                script.push_back(operation{.allocate = true, .request = random_request(rng, step), .victim = 0});
+                live_sizes.push_back(script.back().request.size);
+                live_bytes += live_sizes.back();
+            } else {
+                const size_t victim = rng() % live_sizes.size();
+                script.push_back(operation{.allocate = false, .request = {}, .victim = victim});
+                live_bytes -= live_sizes[victim];
+                live_sizes[victim] = live_sizes.back();
+                live_sizes.pop_back();
+            }
+        }
+        return script;
+    }
+
+    void print_statistics(const char *label, const engine::gpu_allocator::statistics &stats) {
+        const double reserved = static_cast<double>(stats.reserved_bytes);
+        const double used     = static_cast<double>(stats.used_bytes);
+        std::printf(
+            "%-22s %3u blocks %3u dedicated %6u allocations  reserved %7.1f MiB  used %7.1f MiB (%5.1f%%)  "
+            "fragmentation %.2f\n",
+            label, stats.blocks, stats.dedicated_allocations, stats.allocations,
+            reserved / mib, used / mib, reserved > 0 ? 100.0 * used / reserved : 0.0, stats.fragmentation()
+        );
+    }
+
+    void run(const options &options) {
+        auto                  owned_source = std::make_unique<fake_source>();
+        const fake_source    &source       = *owned_source;
+        engine::gpu_allocator allocator(
+            std::move(owned_source), {.block_size = options.block * mib, .dedicated_threshold = 64 * mib}
+        );
+
+        std::mt19937_64              rng(options.seed);
+        const std::vector<operation> script = make_script(options, rng);
+
+        std::vector<engine::gpu_allocation> live;
+        double                              seconds          = 0.0;
+        double                              worst_used_share = 1.0;
+
+        constexpr uint64_t chunk = 10'000;
+        for (uint64_t first = 0; first < script.size(); first += chunk) {
+            const uint64_t last  = std::min<uint64_t>(first + chunk, script.size());
+            const auto     start = clock::now();
+            for (uint64_t step = first; step < last; ++step) {
+                const operation &op = script[step];
+                if (op.allocate) {
+                    live.push_back(allocator.allocate(op.request));
+                } else {
+                    allocator.free(live[op.victim]);
+                    live[op.victim] = live.back();
+                    live.pop_back();
+                }
+            }
+            seconds += std::chrono::duration<double>(clock::now() - start).count();
+
+            if (first >= script.size() / 10) {
+                const auto stats = allocator.get_statistics();
+                worst_used_share = std::min(
+                    worst_used_share, static_cast<double>(stats.used_bytes) / static_cast<double>(stats.reserved_bytes)
+                );
+            }
+        }
+
+        const auto allocations = std::ranges::count_if(script, &operation::allocate);
+        std::printf(
+            "%llu steps around %llu MiB live: %.1f ns per allocate or free, %lld allocations, %llu vkAllocateMemory "
+            "calls\n",
+            static_cast<unsigned long long>(options.steps), static_cast<unsigned long long>(options.live),
+            seconds * 1e9 / static_cast<double>(script.size()), static_cast<long long>(allocations),
+            static_cast<unsigned long long>(source.allocate_calls)
+        );
+        std::printf("worst used share of reserved memory after warm-up: %.1f%%\n", 100.0 * worst_used_share);
+        print_statistics("after churn", allocator.get_statistics());
+
+        // most of a level unloads, leaving a little in every block
+        for (size_t i = 0; i < live.size();) {
+            if (rng() % 100 < 75) {
+                allocator.free(live[i]);
+                live[i] = live.back();
+                live.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        print_statistics("after unloading 75%", allocator.get_statistics());
+
+        const auto                                                     start = clock::now();
+        const std::vector<engine::gpu_allocator::defragmentation_move> moves = allocator.begin_defragmentation();
+        const double plan_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        // the copies would happen here; the resources now live in the new allocations
+        std::unordered_map<uint64_t, size_t> index_of;
+        for (size_t i = 0; i < live.size(); ++i) {
+            index_of[live[i].user] = i;
+        }
+        uint64_t moved = 0;
+        for (const auto &move : moves) {
+            live[index_of.at(move.from.user)] = move.to;
+            moved += move.from.size;
+        }
+        allocator.end_defragmentation(moves);
+        std::printf(
+            "defragmentation: %zu moves, %.1f MiB moved, planned in %.2f ms\n", moves.size(),
+            static_cast<double>(moved) / mib, plan_seconds * 1e3
+        );
+        print_statistics("after defragmentation", allocator.get_statistics());
+
+        for (engine::gpu_allocation &allocation : live) {
+            allocator.free(allocation);
+        }
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: gpu_memory_bench [--steps <count>] [--live <MiB>] [--block <MiB>] [--seed <value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--steps") {
+            options.steps = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--live") {
+            options.live = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--block") {
+            options.block = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        run(options);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
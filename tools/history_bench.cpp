@@ -0,0 +1,270 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures the delta scene_history::capture produces for a frame, and how long it takes, at several change rates: the
+// fraction of objects whose state changes in a frame (half of which also move), against encoding a full snapshot of
+// the same scene every frame. Checks that restoring a frame brings back every object's state and transform as they
+// were when it was captured, that deltas recorded from an empty scene rebuild the same scene in another one, and that
+// a frame where nothing changed produces an almost empty delta.
+//
+//   history_bench [--objects <count>] [--frames <per rate>] [--seed <value>]
+
+#include "engine/scene/history.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t objects = 100'000;
+        uint64_t frames  = 20;
+        uint64_t seed    = 1;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    /**
+     * A position, a velocity and some counters: 32 bytes of state, of which a typical frame changes a few.
+     */
+    class mover final : public engine::scene::scene_object {
+      public:
+        mover(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id) : scene_object(scene, id) {}
+
+        float    position[3] = {};
+        float    velocity[3] = {1.0f, 0.0f, 0.5f};
+        uint32_t health      = 100;
+        uint32_t flags       = 0;
+
+        void save_state(engine::scene::snapshot_writer &out) const override {
+            out.write(position);
+            out.write(velocity);
+            out.write(health);
+            out.write(flags);
+        }
+
+        void load_state(engine::scene::snapshot_reader &in) override {
+            std::memcpy(position, in.read_bytes(sizeof(position)).data(), sizeof(position));
+            std::memcpy(velocity, in.read_bytes(sizeof(velocity)).data(), sizeof(velocity));
+            health = in.read<uint32_t>();
+            flags  = in.read<uint32_t>();
+        }
+
+        /**
+         * What a frame of gameplay might do to it: take damage, and every other time move as well.
+         */
+        void change(const bool move) {
+            --health;
+            if (move) {
+                for (int i = 0; i < 3; ++i) {
+                    position[i] += velocity[i];
+                }
+                set_local_transform(glm::translate(glm::mat4(1.0f), glm::vec3(position[0], position[1], position[2])));
+            }
+            mark_dirty();
+        }
+    };
+
+    std::shared_ptr<engine::scene::scene> make_scene() {
+        auto scene = std::make_shared<engine::scene::scene>();
+        static_cast<void>(scene->push_end_new_update_group());
+        return scene;
+    }
+
+    void add_movers(engine::scene::scene &scene, const uint64_t count) {
+        const auto group = scene.get_default_phase()->update_groups().front();
+        for (uint64_t i = 0; i < count; ++i) {
+            const auto object = scene.emplace_object<mover>().second;
+            group->insert(std::static_pointer_cast<mover>(object));
+            if (i % 50 == 0)
+                scene.rename_object(object->get_id(), "mover_" + std::to_string(i));
+        }
+    }
+
+    /**
+     * Every object's state, local transform and name, by id.
+     */
+    std::map<uint64_t, std::vector<std::byte>> digest(const engine::scene::scene &scene) {
+        std::map<uint64_t, std::vector<std::byte>> result;
+        for (const auto &object : scene.get_scene_objects()) {
+            std::vector<std::byte>         bytes;
+            engine::scene::snapshot_writer writer(bytes);
+            object->save_state(writer);
+            writer.write(object->get_local_transform());
+            writer.write_string(object->get_name());
+            result.emplace(object->get_id(), std::move(bytes));
+        }
+        return result;
+    }
+
+    /**
+     * Changes a random fraction of the objects, half of them moving.
+     */
+    void change_some(engine::scene::scene &scene, const double rate, std::mt19937_64 &rng) {
+        const auto     objects = scene.get_scene_objects();
+        const uint64_t changed = static_cast<uint64_t>(rate * static_cast<double>(objects.size()));
+        for (uint64_t i = 0; i < changed; ++i) {
+            static_cast<mover &>(*objects[rng() % objects.size()]).change(i % 2 == 0);
+        }
+    }
+
+    void check_history(std::mt19937_64 &rng) {
+        const auto                   scene = make_scene();
+        engine::scene::scene_history history(scene, {});
+
+        // every frame from an empty scene, so another empty scene can be rebuilt from the deltas
+        std::vector<engine::scene::scene_delta> deltas;
+        add_movers(*scene, 2000);
+        deltas.push_back(history.capture());
+
+        std::map<uint64_t, std::vector<std::byte>> at_frame_5;
+        for (uint64_t frame = 2; frame <= 10; ++frame) {
+            change_some(*scene, 0.05, rng);
+            if (frame == 4) {
+                // a few objects come and go as well
+                scene->remove_object(scene->get_scene_objects()[17]->get_id());
+                add_movers(*scene, 3);
+            }
+            deltas.push_back(history.capture());
+            if (frame == 5)
+                at_frame_5 = digest(*scene);
+        }
+
+        const auto replica = make_scene();
+        {
+            engine::scene::scene_history replica_history(replica, {});
+            for (const auto &delta : deltas) {
+                replica_history.apply(delta);
+            }
+        }
+        check(digest(*replica) == digest(*scene), "applying the deltas to an empty scene rebuilds the scene");
+
+        const auto at_frame_10 = digest(*scene);
+        const auto unchanged   = history.capture().changes.size();
+        check(unchanged < 64, "a frame where nothing changed has an almost empty delta");
+
+        history.restore(5);
+        check(history.frame() == 5, "restore goes back to the frame");
+        check(digest(*scene) == at_frame_5, "restoring brings back every object as it was");
+
+        // and changes since the last capture are undone too
+        change_some(*scene, 0.5, rng);
+        history.restore(5);
+        check(digest(*scene) == at_frame_5, "restoring undoes changes made since the last capture");
+        check(digest(*scene) != at_frame_10, "and the later frames are gone");
+    }
+
+    struct rate_result {
+        double capture_seconds;  // per frame
+        double delta_bytes;      // per frame
+        double snapshot_seconds; // per frame
+        double snapshot_bytes;
+    };
+
+    rate_result measure(const options &options, const double rate, std::mt19937_64 &rng) {
+        const auto scene = make_scene();
+        add_movers(*scene, options.objects);
+        engine::scene::scene_history history(scene, {.max_frames = options.frames});
+
+        rate_result result{};
+        for (uint64_t frame = 0; frame < options.frames; ++frame) {
+            change_some(*scene, rate, rng);
+
+            auto        start = clock::now();
+            const auto &delta = history.capture();
+            result.capture_seconds += seconds_since(start);
+            result.delta_bytes += static_cast<double>(delta.changes.size());
+
+            start               = clock::now();
+            const auto snapshot = engine::scene::scene_snapshot::encode(*scene);
+            result.snapshot_seconds += seconds_since(start);
+            result.snapshot_bytes = static_cast<double>(snapshot.size());
+        }
+
+        // the deltas still undo what they recorded
+        const auto last = digest(*scene);
+        history.restore(history.oldest_frame());
+        check(digest(*scene) != last || rate == 0.0, "restoring the oldest frame undoes the changes");
+
+        const double n = static_cast<double>(options.frames);
+        result.capture_seconds /= n;
+        result.delta_bytes /= n;
+        result.snapshot_seconds /= n;
+        return result;
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: history_bench [--objects <count>] [--frames <per rate>] [--seed <value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--objects") {
+            options.objects = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--frames") {
+            options.frames = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        engine::scene::snapshot_types::get().add_object_type<mover>("mover");
+
+        std::mt19937_64 rng(options.seed);
+        check_history(rng);
+        std::printf("restore, apply and empty frame checks passed\n");
+
+        std::printf(
+            "%llu objects, %llu frames per rate\n", static_cast<unsigned long long>(options.objects),
+            static_cast<unsigned long long>(options.frames)
+        );
+        double previous_bytes = -1.0;
+        for (const double rate : {0.0, 0.001, 0.01, 0.1, 0.5, 1.0}) {
+            const rate_result r = measure(options, rate, rng);
+            check(r.delta_bytes >= previous_bytes, "deltas grow with the change rate");
+            previous_bytes = r.delta_bytes;
+
+            std::printf(
+                "%5.1f%% changed: delta %10.0f bytes (%5.1f%% of a snapshot), capture %8.3f ms; full snapshot %.1f MB, "
+                "%8.3f ms\n",
+                rate * 100.0, r.delta_bytes, r.delta_bytes / r.snapshot_bytes * 100.0, r.capture_seconds * 1e3,
+                r.snapshot_bytes / 1e6, r.snapshot_seconds * 1e3
+            );
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
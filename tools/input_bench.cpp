@@ -0,0 +1,255 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Replays synthetic input through engine::input_queue the way the game loop drives it: events pushed in bursts at
+// each poll, drained once per fixed step up to the step's end time. Checks that every event comes out once, in order,
+// in the step it belongs to (or is dropped, oldest first, when the queue overflows), that the tracked state matches the
+// events, that an overflowing queue keeps held keys right, and that pushing and draining never allocate; then reports
+// the throughput.
+//
+//   input_bench [--events <count>] [--capacity <count>] [--seed <value>]
+
+#include "engine/input.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static std::atomic<uint64_t> allocations = 0;
+
+void *operator new(const std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+    using clock = engine::input_queue::clock;
+
+    struct options {
+        uint64_t events   = 2'000'000;
+        uint32_t capacity = 4096;
+        uint64_t seed     = 1;
+    };
+
+    constexpr clock::rep millisecond =
+        std::chrono::duration_cast<clock::duration>(std::chrono::milliseconds(1)).count();
+
+    /**
+     * A player on a high-rate mouse: cursor motion every eighth of a millisecond, with keys, buttons, scrolling and
+     * typing mixed in. Stamped in increasing order; code carries the event's index in the stream so the order can be
+     * checked on the way out (events whose code means something are checked through the state instead).
+     */
+    std::vector<engine::input_event> make_stream(const uint64_t count, std::mt19937_64 &rng) {
+        std::vector<engine::input_event> stream;
+        stream.reserve(count);
+
+        clock::rep time = millisecond;
+        for (uint64_t i = 0; i < count; ++i) {
+            time += millisecond / 8 + static_cast<clock::rep>(rng() % (millisecond / 16));
+
+            engine::input_event event{.timestamp = time, .code = static_cast<uint32_t>(i)};
+            const uint64_t      kind = rng() % 100;
+            if (kind < 85) {
+                event.type = engine::input_event_type::cursor_position;
+                event.x    = static_cast<float>(rng() % 1920);
+                event.y    = static_cast<float>(rng() % 1080);
+            } else if (kind < 95) {
+                event.type   = engine::input_event_type::key;
+                event.code   = 32 + static_cast<uint32_t>(rng() % 317);
+                event.action = rng() % 2 ? engine::input_action::press : engine::input_action::release;
+            } else if (kind < 98) {
+                event.type   = engine::input_event_type::mouse_button;
+                event.code   = static_cast<uint32_t>(rng() % 8);
+                event.action = rng() % 2 ? engine::input_action::press : engine::input_action::release;
+            } else if (kind < 99) {
+                event.type = engine::input_event_type::scroll;
+                event.y    = rng() % 2 ? 1.0f : -1.0f;
+            } else {
+                event.type = engine::input_event_type::character;
+            }
+            stream.push_back(event);
+        }
+        return stream;
+    }
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    bool same_state(const engine::input_state &a, const engine::input_state &b) {
+        return a.keys == b.keys && a.keys_pressed == b.keys_pressed && a.keys_released == b.keys_released &&
+               a.buttons == b.buttons && a.buttons_pressed == b.buttons_pressed &&
+               a.buttons_released == b.buttons_released && a.cursor.x == b.cursor.x && a.cursor.y == b.cursor.y &&
+               a.scroll.x == b.scroll.x && a.scroll.y == b.scroll.y;
+    }
+
+    bool same_event(const engine::input_event &a, const engine::input_event &b) {
+        return a.timestamp == b.timestamp && a.code == b.code && a.type == b.type && a.action == b.action &&
+               a.x == b.x && a.y == b.y;
+    }
+
+    struct replay_result {
+        double   seconds;
+        uint64_t steps;
+        uint64_t allocations;
+        uint64_t largest_batch;
+        uint64_t dropped; // counted when verifying
+    };
+
+    /**
+     * Polls at a jittery frame rate between 30 and 240 Hz and runs 60 Hz steps, each draining up to its end time, the
+     * way frame_loop and the main loop do. Checks every batch when verify is set.
+     */
+    replay_result replay(
+        const std::vector<engine::input_event> &stream, const uint32_t capacity, std::mt19937_64 &rng, const bool verify
+    ) {
+        engine::input_queue queue(engine::input_queue::settings{.capacity = capacity});
+        engine::input_state reference;
+
+        // made up front, so the timed loop only pushes and drains
+        constexpr clock::rep step_length = millisecond * 1000 / 60;
+        std::vector<clock::rep> polls;
+        for (clock::rep time = stream.front().timestamp; time <= stream.back().timestamp + step_length;) {
+            time += millisecond * 1000 / (30 + static_cast<clock::rep>(rng() % 211));
+            polls.push_back(time);
+        }
+
+        size_t        pushed    = 0;
+        size_t        drained   = 0; // or dropped
+        clock::rep    simulated = stream.front().timestamp;
+        replay_result result{};
+
+        const uint64_t allocations_before = allocations.load(std::memory_order_relaxed);
+        const auto     start              = std::chrono::steady_clock::now();
+        for (const clock::rep poll : polls) {
+            // os_poll: the callbacks push what arrived since the last poll
+            for (; pushed < stream.size() && stream[pushed].timestamp < poll; ++pushed) {
+                queue.push(stream[pushed]);
+            }
+
+            // frame_loop::advance: whole steps up to the poll time
+            for (; simulated + step_length <= poll; simulated += step_length) {
+                const std::span<const engine::input_event> batch =
+                    queue.drain(clock::time_point(clock::duration(simulated + step_length)));
+                ++result.steps;
+                result.largest_batch = std::max<uint64_t>(result.largest_batch, batch.size());
+                if (!verify)
+                    continue;
+
+                // the queue drops the oldest events when it overflows, after applying them to its state
+                for (; result.dropped < queue.dropped(); ++result.dropped) {
+                    reference.apply(stream[drained++]);
+                }
+
+                reference.begin_batch();
+                for (const engine::input_event &event : batch) {
+                    check(drained < stream.size() && same_event(event, stream[drained]), "events come out in order");
+                    check(event.timestamp < simulated + step_length, "no event from a later step");
+                    check(event.timestamp >= simulated, "no event left behind by an earlier step");
+                    reference.apply(event);
+                    ++drained;
+                }
+                check(same_state(queue.state(), reference), "the state matches the events");
+            }
+        }
+        result.seconds     = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.allocations = allocations.load(std::memory_order_relaxed) - allocations_before;
+
+        if (verify)
+            check(drained == stream.size() && result.dropped == queue.dropped(), "every event comes out or is dropped");
+        return result;
+    }
+
+    /**
+     * Pushes a burst ten times the capacity of a small queue, then checks that the keys and buttons held afterwards are
+     * the ones the whole burst leaves held.
+     */
+    void check_overflow(const std::vector<engine::input_event> &stream) {
+        engine::input_queue queue(engine::input_queue::settings{.capacity = 64});
+        engine::input_state reference;
+
+        const size_t count = std::min<size_t>(stream.size(), 640);
+        const size_t kept  = std::min<size_t>(count, 64);
+        for (size_t i = 0; i < count; ++i) {
+            queue.push(stream[i]);
+            reference.apply(stream[i]);
+        }
+        const std::span<const engine::input_event> batch = queue.drain(clock::time_point::max());
+
+        check(queue.dropped() == count - kept, "the oldest events are dropped");
+        check(batch.size() == kept && same_event(batch.front(), stream[count - kept]), "the newest events are kept");
+        check(queue.state().keys == reference.keys, "held keys survive dropped events");
+        check(queue.state().buttons == reference.buttons, "held buttons survive dropped events");
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: input_bench [--events <count>] [--capacity <count>] [--seed <value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--events") {
+            options.events = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--capacity") {
+            options.capacity = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::mt19937_64                        rng(options.seed);
+        const std::vector<engine::input_event> stream = make_stream(options.events, rng);
+
+        const uint64_t dropped = replay(stream, options.capacity, rng, true).dropped;
+        check_overflow(stream);
+        std::printf(
+            "ordering, step alignment, state and overflow checks passed (%llu events dropped)\n",
+            static_cast<unsigned long long>(dropped)
+        );
+
+        const replay_result result = replay(stream, options.capacity, rng, false);
+        std::printf(
+            "%llu events in %llu steps: %.1f ns per event pushed and drained, %.1f M events/s, largest batch %llu, "
+            "%llu allocations\n",
+            static_cast<unsigned long long>(stream.size()), static_cast<unsigned long long>(result.steps),
+            result.seconds * 1e9 / static_cast<double>(stream.size()),
+            static_cast<double>(stream.size()) / result.seconds / 1e6,
+            static_cast<unsigned long long>(result.largest_batch), static_cast<unsigned long long>(result.allocations)
+        );
+        check(result.allocations == 0, "pushing and draining do not allocate");
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Checks engine::job_system and parallel update groups, then measures how a scene update scales with the number of
+// threads. The checks: parallel_for runs every index once, main-thread jobs stay on the main thread, a throwing job
+// still counts as done and its exception comes out of wait(), and a parallel group updates each of its objects once
+// per update, after the group ordered before it. The scaling run updates a parallel group of objects doing a fixed
+// amount of arithmetic each, from 1 thread (no job system) up to --threads.
+//
+//   jobs_bench [--objects <count>] [--threads <count>] [--updates <count>]
+
+#include "engine/jobs.hpp"
+#include "engine/scene/scene.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t objects = 100'000;
+        uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        uint64_t updates = 100;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    /**
+     * Counts its updates, and checks that every object of the group before it had been updated as often when it was.
+     */
+    class counted_object : public engine::scene::scene_object {
+      public:
+        counted_object(
+            const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id, std::atomic<uint64_t> *own_updates,
+            const std::atomic<uint64_t> *earlier_updates, const uint64_t earlier_count
+        )
+            : scene_object(scene, id), m_own_updates(own_updates), m_earlier_updates(earlier_updates),
+              m_earlier_count(earlier_count) {}
+
+        void update(const double) override {
+            ++m_updates;
+            if (m_earlier_updates && m_earlier_updates->load(std::memory_order_relaxed) < m_updates * m_earlier_count)
+                m_out_of_order = true;
+            m_own_updates->fetch_add(1, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] inline uint64_t updates() const noexcept { return m_updates; }
+        [[nodiscard]] inline bool     out_of_order() const noexcept { return m_out_of_order; }
+
+      private:
+        std::atomic<uint64_t>       *m_own_updates;
+        const std::atomic<uint64_t> *m_earlier_updates;
+        uint64_t                     m_earlier_count;
+        uint64_t                     m_updates      = 0;
+        bool                         m_out_of_order = false;
+    };
+
+    /**
+     * A few hundred nanoseconds of arithmetic per update, touching only its own state.
+     */
+    class busy_object : public engine::scene::scene_object {
+      public:
+        busy_object(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id)
+            : scene_object(scene, id), m_state(static_cast<double>(id % 1000) * 1e-3) {}
+
+        void update(const double delta) override {
+            for (int i = 0; i < 64; ++i) {
+                m_state = m_state * 0.999 + delta * (m_state * m_state - 0.5);
+            }
+        }
+
+        [[nodiscard]] inline double state() const noexcept { return m_state; }
+
+      private:
+        double m_state;
+    };
+
+    void check_parallel_for(engine::job_system &jobs) {
+        for (const size_t grain : {size_t(1), size_t(7), size_t(1000), size_t(100'000)}) {
+            std::vector<std::atomic<uint32_t>> hits(10'000);
+            jobs.parallel_for(hits.size(), grain, [&](const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    hits[i].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+            const bool once = std::ranges::all_of(hits, [](const auto &hit) { return hit.load() == 1; });
+            check(once, "parallel_for runs every index once");
+        }
+    }
+
+    void check_main_thread_jobs(engine::job_system &jobs) {
+        engine::job_counter   counter;
+        std::atomic<uint32_t> off_main = 0;
+        for (int i = 0; i < 64; ++i) {
+            jobs.submit_main_thread([&] { off_main += jobs.is_main_thread() ? 0 : 1; }, &counter);
+        }
+        jobs.wait(counter);
+        check(off_main == 0, "main-thread jobs run on the main thread");
+    }
+
+    void check_exceptions(engine::job_system &jobs) {
+        {
+            engine::job_counter   counter;
+            std::atomic<uint32_t> ran = 0;
+            for (int i = 0; i < 100; ++i) {
+                jobs.submit(
+                    [&ran, i] {
+                        ++ran;
+                        if (i % 10 == 3)
+                            throw std::runtime_error("job failed");
+                    },
+                    &counter
+                );
+            }
+
+            bool thrown = false;
+            try {
+                jobs.wait(counter);
+            } catch (const std::runtime_error &) {
+                thrown = true;
+            }
+            check(thrown, "wait rethrows a job's exception");
+            check(counter.is_done() && ran == 100, "a throwing job still counts as done");
+        }
+
+        for (const size_t failing : {size_t(0), size_t(5000)}) {
+            // the first chunk runs on the calling thread, the rest as jobs
+            std::atomic<size_t> covered = 0;
+            bool                thrown  = false;
+            try {
+                jobs.parallel_for(10'000, 100, [&](const size_t begin, const size_t end) {
+                    covered += end - begin;
+                    if (begin <= failing && failing < end)
+                        throw std::runtime_error("chunk failed");
+                });
+            } catch (const std::runtime_error &) {
+                thrown = true;
+            }
+            check(thrown && covered == 10'000, "parallel_for rethrows once every chunk has run");
+        }
+    }
+
+    void check_update_groups(const std::shared_ptr<engine::job_system> &jobs) {
+        const auto scene = std::make_shared<engine::scene::scene>();
+        scene->set_job_system(jobs);
+
+        constexpr uint64_t    count   = 4096;
+        constexpr uint64_t    updates = 10;
+        std::atomic<uint64_t> first_updates  = 0;
+        std::atomic<uint64_t> second_updates = 0;
+
+        const auto first  = scene->push_end_new_update_group();
+        const auto second = scene->push_new_update_group_after(first);
+        first->parallel   = true;
+        second->parallel  = true;
+        first->chunk_size = second->chunk_size = 64;
+
+        const auto earlier = scene->emplace_objects_ug<counted_object>(count, first, &first_updates, nullptr, 0);
+        const auto later =
+            scene->emplace_objects_ug<counted_object>(count, second, &second_updates, &first_updates, count);
+        for (uint64_t i = 0; i < updates; ++i) {
+            scene->update(1.0 / 60.0);
+        }
+
+        for (const auto &objects : {earlier, later}) {
+            for (const auto &[_, object] : objects) {
+                const auto &counted = static_cast<const counted_object &>(*object);
+                check(counted.updates() == updates, "a parallel group updates each object once per update");
+                check(!counted.out_of_order(), "a group runs after the group it was pushed after");
+            }
+        }
+    }
+
+    double time_updates(const uint32_t threads, const uint64_t objects, const uint64_t updates) {
+        const auto scene = std::make_shared<engine::scene::scene>();
+        if (threads > 1) {
+            scene->set_job_system(
+                std::make_shared<engine::job_system>(engine::job_system::settings{.worker_count = threads - 1})
+            );
+        }
+
+        const auto group = scene->push_end_new_update_group();
+        group->parallel  = true;
+        scene->emplace_objects_ug<busy_object>(objects, group);
+        scene->update(1.0 / 60.0);
+
+        const auto start = clock::now();
+        for (uint64_t i = 0; i < updates; ++i) {
+            scene->update(1.0 / 60.0);
+        }
+        return std::chrono::duration<double>(clock::now() - start).count() / static_cast<double>(updates);
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: jobs_bench [--objects <count>] [--threads <count>] [--updates <count>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--objects") {
+            options.objects = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--threads") {
+            options.threads = std::max<uint32_t>(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), 1);
+        } else if (arg == "--updates") {
+            options.updates = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        const auto jobs = std::make_shared<engine::job_system>(
+            engine::job_system::settings{.worker_count = std::max<uint32_t>(options.threads, 4) - 1}
+        );
+        check_parallel_for(*jobs);
+        check_main_thread_jobs(*jobs);
+        check_exceptions(*jobs);
+        check_update_groups(jobs);
+        std::printf("parallel_for, main-thread, exception and update group checks passed\n");
+
+        double single = 0.0;
+        for (uint32_t threads = 1; threads <= options.threads; ++threads) {
+            const double seconds = time_updates(threads, options.objects, options.updates);
+            if (threads == 1)
+                single = seconds;
+            std::printf(
+                "%2u threads: %8.3f ms per update of %llu objects, %.2fx\n", threads, seconds * 1e3,
+                static_cast<unsigned long long>(options.objects), single / seconds
+            );
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
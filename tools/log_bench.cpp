@@ -0,0 +1,226 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures how long a log call takes on the calling thread while several threads log at once, through the default
+// factory (a synchronous, mutex-guarded console logger) and through async_logger_factory with each overflow policy.
+// Reports the p50, p90, p99 and p99.9 call latencies. Checks that every message a run logged was written exactly once
+// and in order per thread, or, for the policies that discard, that what was written and what was counted as dropped
+// add up to what was logged.
+//
+//   log_bench [--threads <count>] [--messages <per thread>] [--out <file>]
+//
+// The console is redirected to the out file (under the system temp directory by default) so that the runs write what
+// a terminal would be sent and the checks can read it back; the results are printed to stderr.
+
+#include "engine/logging.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <latch>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint32_t              threads  = 8;
+        uint64_t              messages = 10'000;
+        std::filesystem::path out      = std::filesystem::temp_directory_path() / "engine_log_bench.out";
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    struct run_result {
+        std::vector<uint64_t> latencies; // nanoseconds per call, sorted
+        double                seconds = 0.0;
+        uint64_t              written = 0;
+        uint64_t              dropped = 0;
+    };
+
+    [[nodiscard]] double percentile(const std::vector<uint64_t> &sorted, const double p) {
+        const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())));
+        return static_cast<double>(sorted[index]);
+    }
+
+    /**
+     * Logs from every thread at once, timing each call.
+     */
+    void log_from_threads(spdlog::logger &logger, const options &options, const std::string &tag, run_result &result) {
+        std::vector<std::vector<uint64_t>> latencies(options.threads);
+        std::latch                         start_line(options.threads + 1);
+        std::vector<std::jthread>          threads;
+        for (uint32_t t = 0; t < options.threads; ++t) {
+            threads.emplace_back([&, t] {
+                std::vector<uint64_t> &own = latencies[t];
+                own.reserve(options.messages);
+                start_line.arrive_and_wait();
+                for (uint64_t n = 0; n < options.messages; ++n) {
+                    const auto before = clock::now();
+                    logger.info("{} thread {} message {} of {}", tag, t, n, options.messages);
+                    own.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - before).count());
+                }
+            });
+        }
+
+        start_line.arrive_and_wait();
+        const auto start = clock::now();
+        threads.clear();
+        logger.flush();
+        std::fflush(stdout);
+        result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        for (const auto &own : latencies) {
+            result.latencies.insert(result.latencies.end(), own.begin(), own.end());
+        }
+        std::ranges::sort(result.latencies);
+    }
+
+    /**
+     * Reads back what a run wrote and checks that each thread's messages appear once each, in order, with no gaps
+     * unless the run was allowed to discard them.
+     */
+    uint64_t check_output(const options &options, const std::string &tag, const bool may_drop) {
+        std::ifstream        in(options.out);
+        std::vector<int64_t> last(options.threads, -1);
+        uint64_t             written = 0;
+        const std::string    prefix  = tag + " thread ";
+        std::string          line;
+        while (std::getline(in, line)) {
+            const size_t at = line.find(prefix);
+            if (at == std::string::npos)
+                continue;
+
+            unsigned  thread  = 0;
+            long long message = 0;
+            check(
+                std::sscanf(line.c_str() + at + prefix.size(), "%u message %lld", &thread, &message) == 2,
+                "a written message reads back"
+            );
+            check(thread < options.threads, "the thread index is one that logged");
+            check(message > last[thread], "a thread's messages are written once each, in the order it logged them");
+            check(may_drop || message == last[thread] + 1, "no message is lost");
+            last[thread] = message;
+            ++written;
+        }
+        return written;
+    }
+
+    void redirect_console(const options &options) {
+        check(std::freopen(options.out.string().c_str(), "w", stdout) != nullptr, "the console can be redirected");
+    }
+
+    run_result run_default(const options &options) {
+        redirect_console(options);
+        run_result result;
+        {
+            const auto logger = engine::default_logger_factory().create_logger(
+                "log_bench_default", engine::logger_settings{.ephemeral_only = true}
+            );
+            log_from_threads(*logger, options, "default", result);
+            spdlog::drop(logger->name());
+        }
+        result.written = check_output(options, "default", false);
+        check(result.written == options.threads * options.messages, "the default logger writes every message");
+        return result;
+    }
+
+    run_result run_async(const options &options, const engine::log_overflow_policy policy, const std::string &tag) {
+        engine::async_logger_factory::settings settings;
+        settings.overflow      = policy;
+        settings.log_directory = options.out.parent_path();
+        // the default capacity holds a frame's worth of messages; a smaller ring makes the discarding policies discard
+        if (policy != engine::log_overflow_policy::block)
+            settings.queue_capacity = 256;
+
+        redirect_console(options);
+        run_result result;
+        {
+            engine::async_logger_factory factory(settings);
+            const auto                   logger =
+                factory.create_logger("log_bench_" + tag, engine::logger_settings{.ephemeral_only = true});
+            log_from_threads(*logger, options, tag, result);
+            result.dropped = factory.dropped_messages();
+            spdlog::drop(logger->name());
+        }
+        std::fflush(stdout);
+
+        const bool may_drop = policy != engine::log_overflow_policy::block;
+        result.written      = check_output(options, tag, may_drop);
+        check(
+            result.written + result.dropped == options.threads * options.messages,
+            "every message is either written or counted as dropped"
+        );
+        check(may_drop || result.dropped == 0, "blocking never drops");
+        return result;
+    }
+
+    void print(const char *name, const run_result &r, const options &options) {
+        const double total = static_cast<double>(options.threads * options.messages);
+        std::fprintf(
+            stderr,
+            "%-18s p50 %8.0f ns, p90 %8.0f ns, p99 %9.0f ns, p99.9 %9.0f ns, %6.2f M messages/s, %llu written, "
+            "%llu dropped\n",
+            name, percentile(r.latencies, 0.5), percentile(r.latencies, 0.9), percentile(r.latencies, 0.99),
+            percentile(r.latencies, 0.999), total / r.seconds / 1e6, static_cast<unsigned long long>(r.written),
+            static_cast<unsigned long long>(r.dropped)
+        );
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: log_bench [--threads <count>] [--messages <per thread>] [--out <file>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--threads") {
+            options.threads = std::max<uint32_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--messages") {
+            options.messages = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--out") {
+            options.out = argv[++i];
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        const run_result sync      = run_default(options);
+        const run_result block     = run_async(options, engine::log_overflow_policy::block, "block");
+        const run_result drop      = run_async(options, engine::log_overflow_policy::drop, "drop");
+        const run_result overwrite = run_async(options, engine::log_overflow_policy::overwrite, "overwrite");
+        std::filesystem::remove(options.out);
+        std::fprintf(
+            stderr, "delivery and ordering checks passed, %u threads logging %llu messages each\n", options.threads,
+            static_cast<unsigned long long>(options.messages)
+        );
+
+        print("default (sync)", sync, options);
+        print("async, block", block, options);
+        print("async, drop", drop, options);
+        print("async, overwrite", overwrite, options);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Decodes a binary log written by engine::binary_logger_factory back into text.
+//
+//   log_decode <file.binlog>
+
+#include "engine/binary_log_reader.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace {
+    constexpr std::string_view level_names[] = {"trace", "debug", "info", "warning", "error", "critical", "off"};
+
+    int decode(const std::vector<char> &data) {
+        engine::binary_log::reader in(data);
+        engine::binary_log::record record;
+        while (in.next(record)) {
+            const std::string_view level_name = record.level < std::size(level_names) ? level_names[record.level] : "?";
+            std::cout << std::format(
+                "[{}] [{}] [{}] [{}] {}\n", in.format_time(record.ticks), record.logger, level_name, record.thread,
+                record.text
+            );
+        }
+
+        return EXIT_SUCCESS;
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    if (argc != 2) {
+        std::cerr << "usage: log_decode <file.binlog>\n";
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << argv[1] << '\n';
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    try {
+        return decode(data);
+    } catch (const std::exception &e) {
+        std::cout.flush();
+        std::cerr << "Stopped decoding: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,271 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures the cost of publishing a metric: counter increments, histogram records, gauge sets and adds on one thread,
+// and counter increments from several threads at once against a single std::atomic that every thread adds to (which is
+// what the per-thread shards avoid). Checks that snapshots sum every thread's increments, including those of threads
+// that have exited, that histograms count and sum what they record, that quantiles land in the right bucket, that the
+// bucket layout is consistent, and that a name cannot be reused for a different kind of metric.
+//
+//   metrics_bench [--increments <count>] [--threads <count>]
+
+#include "engine/metrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <latch>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t increments = 50'000'000;
+        uint32_t threads    = 8;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    template <typename T>
+    const T *find(const std::vector<T> &values, const std::string_view name) {
+        const auto it = std::ranges::find_if(values, [&](const T &v) { return v.name.str() == name; });
+        return it == values.end() ? nullptr : &*it;
+    }
+
+    int64_t counter_value(const std::string_view name) {
+        const engine::metrics::snapshot snapshot = engine::metrics::registry::get().take_snapshot();
+        const auto                     *value    = find(snapshot.counters, name);
+        return value ? value->value : 0;
+    }
+
+    void check_bucket_layout() {
+        using engine::metrics::histogram;
+        for (uint32_t bucket = 0; bucket + 1 < histogram::bucket_count; ++bucket) {
+            const uint64_t lower = histogram::bucket_lower_bound(bucket);
+            check(histogram::bucket_of(lower) == bucket, "a bucket's lower bound falls in it");
+            check(lower + histogram::bucket_width(bucket) == histogram::bucket_lower_bound(bucket + 1), "buckets tile");
+            check(histogram::bucket_width(bucket) * 8 <= std::max<uint64_t>(lower, 8), "a bucket is at most 1/8 wide");
+        }
+        check(
+            histogram::bucket_of(UINT64_MAX) == histogram::bucket_count - 1, "the last bucket holds the largest value"
+        );
+    }
+
+    void check_registry(const uint32_t threads) {
+        auto &registry = engine::metrics::registry::get();
+
+        // threads that have exited by the time of the snapshot, and this one
+        const engine::metrics::counter counter = registry.get_counter("metrics_bench_check");
+        {
+            std::vector<std::jthread> workers;
+            for (uint32_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&registry, t] {
+                    const engine::metrics::counter same = registry.get_counter("metrics_bench_check");
+                    for (uint32_t i = 0; i <= t; ++i) {
+                        same.add(1000);
+                    }
+                });
+            }
+        }
+        counter.increment();
+        check(
+            counter_value("metrics_bench_check") == 1000 * threads * (threads + 1) / 2 + 1,
+            "a snapshot sums every thread's shard, including those of exited threads"
+        );
+
+        const engine::metrics::counter live = registry.get_up_down_counter("metrics_bench_live");
+        live.add(5);
+        live.decrement();
+        const auto  snapshot = registry.take_snapshot();
+        const auto *as_gauge = find(snapshot.gauges, "metrics_bench_live");
+        check(as_gauge && as_gauge->value == 4, "an up/down counter is listed with the gauges");
+        check(!find(snapshot.counters, "metrics_bench_live"), "and not with the counters");
+
+        const engine::metrics::gauge gauge = registry.get_gauge("metrics_bench_gauge");
+        gauge.set(10);
+        gauge.add(-3);
+        check(find(registry.take_snapshot().gauges, "metrics_bench_gauge")->value == 7, "a gauge keeps its last value");
+
+        const engine::metrics::histogram histogram = registry.get_histogram("metrics_bench_histogram");
+        uint64_t                         sum       = 0;
+        for (uint64_t value = 1; value <= 1000; ++value) {
+            histogram.record(value);
+            sum += value;
+        }
+        const engine::metrics::snapshot with_histogram = registry.take_snapshot();
+        const auto                     *h              = find(with_histogram.histograms, "metrics_bench_histogram");
+        check(h && h->count == 1000 && h->sum == sum, "a histogram counts and sums what it records");
+        for (const double q : {0.5, 0.9, 0.99}) {
+            const uint64_t exact  = static_cast<uint64_t>(q * 1000);
+            const uint64_t middle = h->quantile(q);
+            check(middle + middle / 8 >= exact && middle <= exact + exact / 8, "a quantile is within a bucket of it");
+        }
+
+        bool threw = false;
+        try {
+            static_cast<void>(registry.get_gauge("metrics_bench_check"));
+        } catch (const std::logic_error &) {
+            threw = true;
+        }
+        check(threw, "a counter's name cannot be reused for a gauge");
+        const int64_t counted = counter_value("metrics_bench_check");
+        registry.get_counter("metrics_bench_check").increment();
+        check(counter_value("metrics_bench_check") == counted + 1, "looking a name up again gives the same counter");
+    }
+
+    struct rates {
+        double counter;
+        double histogram;
+        double gauge_set;
+        double gauge_add;
+    };
+
+    rates time_single_thread(const uint64_t increments) {
+        auto &registry = engine::metrics::registry::get();
+
+        const engine::metrics::counter counter = registry.get_counter("metrics_bench_counter");
+        const int64_t                  before  = counter_value("metrics_bench_counter");
+        auto                           start   = clock::now();
+        for (uint64_t i = 0; i < increments; ++i) {
+            counter.increment();
+        }
+        const double counter_seconds = seconds_since(start);
+        check(
+            counter_value("metrics_bench_counter") - before == static_cast<int64_t>(increments),
+            "every increment is counted"
+        );
+
+        const engine::metrics::histogram histogram = registry.get_histogram("metrics_bench_record");
+        start                                      = clock::now();
+        for (uint64_t i = 0; i < increments; ++i) {
+            histogram.record(i & 0xffff);
+        }
+        const double                    histogram_seconds = seconds_since(start);
+        const engine::metrics::snapshot snapshot          = registry.take_snapshot();
+        const auto                     *h                 = find(snapshot.histograms, "metrics_bench_record");
+        check(h && h->count == increments, "every record is counted");
+
+        const engine::metrics::gauge gauge = registry.get_gauge("metrics_bench_set");
+        start                              = clock::now();
+        for (uint64_t i = 0; i < increments; ++i) {
+            gauge.set(static_cast<int64_t>(i));
+        }
+        const double gauge_set_seconds = seconds_since(start);
+        start                          = clock::now();
+        for (uint64_t i = 0; i < increments; ++i) {
+            gauge.add(1);
+        }
+        const double gauge_add_seconds = seconds_since(start);
+        check(
+            find(registry.take_snapshot().gauges, "metrics_bench_set")->value ==
+                static_cast<int64_t>(2 * increments - 1),
+            "the gauge holds the last value set plus every add"
+        );
+
+        const double n = static_cast<double>(increments);
+        return {
+            .counter   = counter_seconds / n,
+            .histogram = histogram_seconds / n,
+            .gauge_set = gauge_set_seconds / n,
+            .gauge_add = gauge_add_seconds / n,
+        };
+    }
+
+    /**
+     * @return The wall time per increment with every thread incrementing at once, so that on a machine with fewer cores
+     * than threads the time a thread spends descheduled is not counted.
+     */
+    template <typename F>
+    double time_threads(const uint64_t increments, const uint32_t threads, F &&increment) {
+        const uint64_t            per_thread = increments / threads;
+        std::latch                start_line(threads + 1);
+        std::vector<std::jthread> workers;
+        for (uint32_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                start_line.arrive_and_wait();
+                for (uint64_t i = 0; i < per_thread; ++i) {
+                    increment();
+                }
+            });
+        }
+
+        start_line.arrive_and_wait();
+        const auto start = clock::now();
+        workers.clear();
+        return seconds_since(start) / static_cast<double>(per_thread * threads);
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: metrics_bench [--increments <count>] [--threads <count>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--increments") {
+            options.increments = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--threads") {
+            options.threads = std::max<uint32_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        check_bucket_layout();
+        check_registry(options.threads);
+        std::printf("bucket layout, snapshot sum, histogram, gauge and name kind checks passed\n");
+
+        const rates single = time_single_thread(options.increments);
+
+        const engine::metrics::counter sharded = engine::metrics::registry::get().get_counter("metrics_bench_sharded");
+        const int64_t                  before  = counter_value("metrics_bench_sharded");
+        const double sharded_seconds = time_threads(options.increments, options.threads, [&] { sharded.increment(); });
+        const uint64_t counted       = options.increments / options.threads * options.threads;
+        check(
+            counter_value("metrics_bench_sharded") - before == static_cast<int64_t>(counted),
+            "every thread's increments are counted"
+        );
+
+        std::atomic<int64_t> shared         = 0;
+        const double         shared_seconds = time_threads(options.increments, options.threads, [&] {
+            shared.fetch_add(1, std::memory_order_relaxed);
+        });
+        check(shared.load() == static_cast<int64_t>(counted), "the shared atomic counts every increment");
+
+        std::printf(
+            "counter increment  %6.2f ns\n"
+            "histogram record   %6.2f ns\n"
+            "gauge set          %6.2f ns\n"
+            "gauge add          %6.2f ns\n"
+            "%u threads: sharded counter %6.2f ns per increment, shared std::atomic %6.2f ns (%.2fx)\n",
+            single.counter * 1e9, single.histogram * 1e9, single.gauge_set * 1e9, single.gauge_add * 1e9,
+            options.threads, sharded_seconds * 1e9, shared_seconds * 1e9, shared_seconds / sharded_seconds
+        );
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures name lookups at 1k and 100k named scene objects: through the std::map<std::string, ...> the scene used to
+// keep names in (a std::string built from the query for every lookup, as get_scene_object(const std::string &) did),
+// through scene::get_scene_object with the hash computed per lookup, and through the flat name map with hashes
+// computed up front, as for "name"_hn literals. Checks that literal and run-time hashes agree, that a name built from a
+// character buffer stops at its NUL, that interning is unique, and that flat_name_map agrees with std::unordered_map
+// under random inserts and erases.
+//
+//   name_bench [--lookups <count>] [--seed <value>]
+
+#include "engine/names.hpp"
+#include "engine/scene/scene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace engine::literals;
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t lookups = 2'000'000;
+        uint64_t seed    = 1;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    // computed by the compiler, or this would not compile
+    static_assert("player"_hn.hash == engine::hash_name("player"));
+    static_assert(engine::hashed_name("player").str.size() == 6);
+
+    void check_hashed_names() {
+        char buffer[32] = {};
+        std::snprintf(buffer, sizeof(buffer), "object_%d", 42);
+        const engine::hashed_name from_buffer = buffer;
+        check(from_buffer.str == "object_42", "a name from a buffer ends at its NUL");
+        check(from_buffer.hash == engine::hash_name("object_42"), "and hashes like the literal");
+
+        const char unterminated[3] = {'a', 'b', 'c'};
+        check(engine::hashed_name(unterminated).str == "abc", "a buffer without a NUL is used whole");
+
+        const std::string string = "object_42";
+        check(engine::hashed_name(string).hash == "object_42"_hn.hash, "strings and literals hash alike");
+
+        const char *pointer = string.c_str();
+        check(engine::hashed_name(pointer).str == "object_42", "a C string ends at its NUL");
+        check(engine::hashed_name(pointer).hash == "object_42"_hn.hash, "and hashes like the literal");
+
+        const engine::name_id first = engine::name_id::intern("name_bench_check"_hn);
+        const std::string     copy  = "name_bench_check";
+        check(engine::name_id::intern(copy) == first, "interning the same string again gives the same name_id");
+        check(first.str() == "name_bench_check", "an interned name keeps its string");
+        check(engine::name_id::find("name_bench_never_interned"_hn).empty(), "find never interns");
+    }
+
+    void check_against_unordered_map(std::mt19937_64 &rng) {
+        engine::flat_name_map<uint64_t>           map;
+        std::unordered_map<std::string, uint64_t> reference;
+        std::vector<std::string>                  names;
+        for (int i = 0; i < 2000; ++i) {
+            names.push_back("check_" + std::to_string(i));
+        }
+
+        for (uint64_t step = 0; step < 100'000; ++step) {
+            const std::string &name = names[rng() % names.size()];
+            if (rng() % 3 != 0) {
+                map.insert_or_assign(engine::name_id::intern(name), step);
+                reference.insert_or_assign(name, step);
+            } else {
+                check(map.erase(name) == (reference.erase(name) == 1), "erase agrees");
+            }
+
+            if (step % 5000 == 0) {
+                check(map.size() == reference.size(), "the size matches");
+                for (const std::string &other : names) {
+                    const uint64_t *found = map.find(other);
+                    const auto      it    = reference.find(other);
+                    check((found != nullptr) == (it != reference.end()), "find agrees");
+                    check(!found || *found == it->second, "and finds the same value");
+                }
+            }
+        }
+    }
+
+    class named_object final : public engine::scene::scene_object {
+      public:
+        named_object(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id) : scene_object(scene, id) {}
+    };
+
+    void check_scene_names() {
+        const auto scene = std::make_shared<engine::scene::scene>();
+        char       buffer[32];
+        for (int i = 0; i < 1000; ++i) {
+            std::snprintf(buffer, sizeof(buffer), "named_%d", i);
+            scene->emplace_object_named<named_object>(buffer);
+        }
+        check(scene->has_scene_object("named_999"_hn) && !scene->has_scene_object("named_1000"), "names are indexed");
+
+        // names known only at run time, as a pointer rather than an array
+        const std::string runtime_name = "named_runtime";
+        const char       *runtime_ptr  = runtime_name.c_str();
+        const uint64_t    runtime_id   = scene->emplace_object_named<named_object>(runtime_ptr).first;
+        check(scene->get_scene_object(runtime_ptr)->get_id() == runtime_id, "a C string names an object");
+        scene->remove_object(runtime_id);
+
+        const auto object = scene->get_scene_object("named_10");
+        scene->rename_object(object->get_id(), "renamed");
+        check(!scene->has_scene_object("named_10") && scene->get_scene_object("renamed") == object, "rename moves it");
+        scene->remove_object(object->get_id());
+        check(!scene->has_scene_object("renamed"), "removing an object removes its name");
+    }
+
+    struct rates {
+        double string_map;
+        double scene;
+        double prehashed;
+    };
+
+    rates measure(const uint64_t count, const uint64_t lookups, std::mt19937_64 &rng) {
+        const auto scene = std::make_shared<engine::scene::scene>();
+
+        std::map<std::string, std::shared_ptr<engine::scene::scene_object>> string_map;
+        engine::flat_name_map<std::shared_ptr<engine::scene::scene_object>> flat_map;
+        std::vector<std::string>                                            names;
+        for (uint64_t i = 0; i < count; ++i) {
+            names.push_back("object_" + std::to_string(i * 7919 % (count * 10)));
+            const auto object = scene->emplace_object_named<named_object>(names.back()).second;
+            string_map.emplace(names.back(), object);
+            flat_map.insert_or_assign(engine::name_id::intern(names.back()), object);
+        }
+
+        // the same random queries for every container, as C strings the way names come from code and data
+        std::vector<const char *>        queries;
+        std::vector<engine::hashed_name> hashed;
+        queries.reserve(lookups);
+        hashed.reserve(lookups);
+        for (uint64_t i = 0; i < lookups; ++i) {
+            queries.push_back(names[rng() % count].c_str());
+            hashed.emplace_back(std::string_view(queries.back()));
+        }
+
+        uint64_t found = 0;
+        auto     start = clock::now();
+        for (const char *query : queries) {
+            found += string_map.find(std::string(query)) != string_map.end();
+        }
+        const double string_map_seconds = seconds_since(start);
+
+        start = clock::now();
+        for (const char *query : queries) {
+            found += scene->get_scene_object(std::string_view(query)) != nullptr;
+        }
+        const double scene_seconds = seconds_since(start);
+
+        start = clock::now();
+        for (const engine::hashed_name &query : hashed) {
+            found += flat_map.find(query) != nullptr;
+        }
+        const double prehashed_seconds = seconds_since(start);
+        check(found == 3 * lookups, "every lookup finds its object");
+
+        const double n = static_cast<double>(lookups);
+        return {.string_map = n / string_map_seconds, .scene = n / scene_seconds, .prehashed = n / prehashed_seconds};
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: name_bench [--lookups <count>] [--seed <value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--lookups") {
+            options.lookups = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::mt19937_64 rng(options.seed);
+        check_hashed_names();
+        check_against_unordered_map(rng);
+        check_scene_names();
+        std::printf("hashed name, interning, flat_name_map and scene name checks passed\n");
+
+        for (const uint64_t count : {uint64_t(1000), uint64_t(100'000)}) {
+            const rates r = measure(count, options.lookups, rng);
+            std::printf(
+                "%7llu names: std::map<std::string> %6.1f M lookups/s, get_scene_object %6.1f M lookups/s (%.2fx), "
+                "prehashed flat_name_map %6.1f M lookups/s (%.2fx)\n",
+                static_cast<unsigned long long>(count), r.string_map / 1e6, r.scene / 1e6, r.scene / r.string_map,
+                r.prehashed / 1e6, r.prehashed / r.string_map
+            );
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,273 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures what a profiler zone costs: the same loop with no zone (which is what ENGINE_PROFILING=0 compiles it to),
+// with a zone while the profiler is disabled at run time, with a zone while it records, with two nested zones, and with
+// several threads recording at once. Zones are collected with frame_mark every few thousand zones, as a frame would,
+// and what that costs is reported separately. Checks that every zone is counted in the rolling statistics, that nested
+// zones nest, that a capture exports one trace event per zone, that a disabled profiler records nothing and that a
+// full buffer counts what it drops.
+//
+//   profile_bench [--zones <count>] [--threads <count>]
+
+#include "engine/profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <latch>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t zones   = 2'000'000;
+        uint32_t threads = 4;
+    };
+
+    // well below the per-thread buffer, so nothing is dropped between frame marks
+    constexpr uint64_t zones_per_frame = 4096;
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    // what the zones wrap; volatile so the loop is not folded away
+    volatile uint64_t g_sink = 0;
+
+    const engine::profiler::zone_stats *find_stats(const std::vector<engine::profiler::zone_stats> &stats,
+                                                   const std::string_view                           name) {
+        const auto it = std::ranges::find(stats, name, &engine::profiler::zone_stats::name);
+        return it == stats.end() ? nullptr : &*it;
+    }
+
+    void check_recording() {
+        engine::profiler &profiler = engine::profiler::get();
+        profiler.set_enabled(true);
+        profiler.frame_mark();
+
+        profiler.begin_capture();
+        for (uint64_t i = 0; i < 100; ++i) {
+            ENGINE_PROFILE_ZONE("check_outer");
+            for (uint64_t j = 0; j < 3; ++j) {
+                ENGINE_PROFILE_ZONE("check_inner");
+                g_sink = g_sink + j;
+            }
+        }
+        profiler.end_capture();
+
+        const auto                          stats = profiler.stats();
+        const engine::profiler::zone_stats *outer = find_stats(stats, "check_outer");
+        const engine::profiler::zone_stats *inner = find_stats(stats, "check_inner");
+        check(outer && outer->samples == 100, "every outer zone is collected");
+        check(inner && inner->samples == 300, "every inner zone is collected");
+        check(inner->max <= outer->max && inner->min <= outer->min, "an inner zone takes no longer than its outer one");
+        check(profiler.dropped_zones() == 0, "nothing is dropped while collected every frame");
+
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "engine_profile_bench.json";
+        profiler.write_chrome_trace(path);
+        std::ifstream     in(path);
+        const std::string trace{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+        in.close();
+        std::filesystem::remove(path);
+
+        auto count = [&](const std::string_view text) {
+            uint64_t n = 0;
+            for (size_t at = trace.find(text); at != std::string::npos; at = trace.find(text, at + 1)) {
+                ++n;
+            }
+            return n;
+        };
+        check(trace.starts_with("{") && trace.ends_with("]}\n"), "the trace is a JSON object");
+        check(count(R"("name":"check_outer")") == 100, "the trace has one event per outer zone");
+        check(count(R"("name":"check_inner")") == 300, "and one per inner zone");
+
+        profiler.set_enabled(false);
+        for (uint64_t i = 0; i < 100; ++i) {
+            ENGINE_PROFILE_ZONE("check_disabled");
+        }
+        profiler.frame_mark();
+        check(!find_stats(profiler.stats(), "check_disabled"), "a disabled profiler records nothing");
+        profiler.set_enabled(true);
+
+        // fill this thread's buffer without collecting
+        const uint64_t dropped_before = profiler.dropped_zones();
+        const auto     name           = engine::name_id::intern("check_overflow");
+        const auto     now            = engine::profiler::clock::now();
+        for (uint64_t i = 0; i < 20'000; ++i) {
+            profiler.record(name, now, now);
+        }
+        const uint64_t dropped = profiler.dropped_zones() - dropped_before;
+        profiler.frame_mark();
+        check(dropped > 0 && dropped < 20'000, "a full buffer drops zones");
+        const auto *kept = find_stats(profiler.stats(), "check_overflow");
+        check(kept && kept->samples > 0, "and keeps the rest");
+    }
+
+    struct zone_times {
+        double loop;       // seconds for the zones, with frame marks excluded
+        double frame_mark; // seconds spent in frame_mark
+    };
+
+    enum class mode { none, zone, nested };
+
+    zone_times time_zones(const uint64_t zones, const mode mode) {
+        engine::profiler &profiler = engine::profiler::get();
+        profiler.frame_mark();
+
+        zone_times times{};
+        for (uint64_t done = 0; done < zones; done += zones_per_frame) {
+            const uint64_t batch = std::min(zones_per_frame, zones - done);
+            const auto     start = clock::now();
+            switch (mode) {
+            case mode::none:
+                for (uint64_t i = 0; i < batch; ++i) {
+                    g_sink = g_sink + i;
+                }
+                break;
+            case mode::zone:
+                for (uint64_t i = 0; i < batch; ++i) {
+                    ENGINE_PROFILE_ZONE("bench_zone");
+                    g_sink = g_sink + i;
+                }
+                break;
+            case mode::nested:
+                // two zones per iteration, so the same number of zones as mode::zone
+                for (uint64_t i = 0; i < batch; i += 2) {
+                    ENGINE_PROFILE_ZONE("bench_outer");
+                    g_sink = g_sink + i;
+                    ENGINE_PROFILE_ZONE("bench_inner");
+                    g_sink = g_sink + i;
+                }
+                break;
+            }
+            times.loop += seconds_since(start);
+
+            const auto mark_start = clock::now();
+            profiler.frame_mark();
+            times.frame_mark += seconds_since(mark_start);
+        }
+        return times;
+    }
+
+    /**
+     * @return The mean seconds per zone with threads recording at once, collected by this thread as it would be by the
+     * main thread.
+     */
+    double time_threads(const uint64_t zones, const uint32_t threads) {
+        engine::profiler &profiler   = engine::profiler::get();
+        const uint64_t    per_thread = zones / threads;
+        const uint64_t    dropped    = profiler.dropped_zones();
+
+        std::vector<double>       seconds(threads);
+        std::latch                start_line(threads + 1);
+        std::atomic<uint32_t>     finished = 0;
+        std::vector<std::jthread> workers;
+        for (uint32_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                start_line.arrive_and_wait();
+                for (uint64_t done = 0; done < per_thread; done += zones_per_frame) {
+                    const uint64_t batch = std::min(zones_per_frame, per_thread - done);
+                    const auto     start = clock::now();
+                    for (uint64_t i = 0; i < batch; ++i) {
+                        ENGINE_PROFILE_ZONE("bench_thread_zone");
+                        g_sink = g_sink + i;
+                    }
+                    seconds[t] += seconds_since(start);
+                    // leave the collector room, as a frame boundary would
+                    std::this_thread::yield();
+                }
+                finished.fetch_add(1, std::memory_order_release);
+            });
+        }
+
+        start_line.arrive_and_wait();
+        while (finished.load(std::memory_order_acquire) < threads) {
+            profiler.frame_mark();
+            std::this_thread::yield();
+        }
+        workers.clear();
+        profiler.frame_mark();
+
+        check(profiler.dropped_zones() == dropped, "threads recording at once drop nothing while collected");
+        double total = 0.0;
+        for (const double s : seconds) {
+            total += s;
+        }
+        return total / static_cast<double>(per_thread * threads);
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: profile_bench [--zones <count>] [--threads <count>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--zones") {
+            options.zones = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), zones_per_frame);
+        } else if (arg == "--threads") {
+            options.threads = std::max<uint32_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        check_recording();
+        std::printf("zone collection, nesting, trace export, disable and overflow checks passed\n");
+
+        engine::profiler &profiler = engine::profiler::get();
+        const zone_times  none     = time_zones(options.zones, mode::none);
+        profiler.set_enabled(false);
+        const zone_times disabled = time_zones(options.zones, mode::zone);
+        profiler.set_enabled(true);
+        const zone_times zone   = time_zones(options.zones, mode::zone);
+        const zone_times nested = time_zones(options.zones, mode::nested);
+        const auto *recorded = find_stats(profiler.stats(), "bench_zone");
+        check(recorded && recorded->samples > 0, "the benchmark's zones were recorded");
+
+        const double n         = static_cast<double>(options.zones);
+        auto         overhead  = [&](const zone_times &t) { return (t.loop - none.loop) / n * 1e9; };
+        const double threaded  = time_threads(options.zones, options.threads);
+        const double per_frame = zone.frame_mark / std::ceil(n / static_cast<double>(zones_per_frame));
+        std::printf(
+            "no zone (compiled out) %6.2f ns per iteration\n"
+            "disabled at run time   %+6.2f ns per zone\n"
+            "recording              %+6.2f ns per zone\n"
+            "recording, nested      %+6.2f ns per zone\n"
+            "recording, %u threads   %6.2f ns per iteration, each thread\n"
+            "frame_mark collecting %llu zones: %.1f us (%.2f ns per zone)\n",
+            none.loop / n * 1e9, overhead(disabled), overhead(zone), overhead(nested), options.threads,
+            threaded * 1e9, static_cast<unsigned long long>(zones_per_frame), per_frame * 1e6,
+            per_frame / static_cast<double>(zones_per_frame) * 1e9
+        );
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
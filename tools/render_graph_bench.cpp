@@ -0,0 +1,820 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Compiles render graphs without a GPU and checks every decision the compiler makes against a replay of the frame:
+// which passes are kept, that resources sharing memory are never alive at the same time, and that every access is in
+// the right layout and waits for what it has to (and that no barrier is there for nothing). Runs a deferred 1080p
+// frame, a post-processing chain, a set of buffers that only fit together if placements stay aligned, and a batch of
+// random graphs, reporting how much memory aliasing saves on each, then times compiling against reusing the last
+// result.
+//
+//   render_graph_bench [--graphs <count>] [--runs <count>] [--seed <value>]
+
+#include "engine/render/render_graph.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    using engine::render_graph;
+    using engine::resource_usage;
+
+    struct options {
+        uint64_t graphs = 3000;
+        uint64_t runs   = 10'000;
+        uint64_t seed   = 1;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    uint64_t align_up(const uint64_t value, const uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    /**
+     * Stands in for vkGetDeviceImageMemoryRequirements: tightly packed texels, 64 KiB aligned (4 KiB for images
+     * of format 2), and render targets (format 1) restricted to one memory type.
+     */
+    engine::memory_requirements image_requirements(const engine::image_desc &desc) {
+        const uint64_t texels = uint64_t(desc.width) * desc.height * desc.depth * desc.layers * desc.samples;
+        const uint64_t alignment = desc.format == 2 ? 4096 : 65536;
+        return {
+            .size      = align_up(texels * desc.bytes_per_texel, alignment),
+            .alignment = alignment,
+            .type_bits = desc.format == 1 ? 0b01u : 0b11u,
+        };
+    }
+
+    /**
+     * Buffers are sized in steps of 256 bytes, but some (standing in for ones used as descriptor or acceleration
+     * structure storage) need 64 KiB alignment.
+     */
+    engine::memory_requirements buffer_requirements(const engine::buffer_desc &desc) {
+        const uint64_t alignment = desc.size % 3 == 0 ? 65536 : 256;
+        return {.size = align_up(desc.size, 256), .alignment = alignment, .type_bits = 0b111u};
+    }
+
+    render_graph::settings memory_model() {
+        return {.image_requirements = image_requirements, .buffer_requirements = buffer_requirements};
+    }
+
+    /**
+     * Declares a graph and remembers the declaration, so what the graph compiled to can be checked against it.
+     */
+    class declaration {
+      public:
+        struct resource {
+            bool                        image    = false;
+            bool                        imported = false;
+            resource_usage              initial  = resource_usage::sampled;
+            resource_usage              final    = resource_usage::sampled;
+            engine::memory_requirements requirements;
+        };
+
+        explicit declaration(render_graph &graph) : m_graph(graph) { m_graph.reset(); }
+
+        engine::resource_handle image(std::string name, const engine::image_desc &desc) {
+            m_resources.push_back({.image = true, .requirements = image_requirements(desc)});
+            return m_graph.create_image(std::move(name), desc);
+        }
+
+        engine::resource_handle buffer(std::string name, const engine::buffer_desc &desc) {
+            m_resources.push_back({.requirements = buffer_requirements(desc)});
+            return m_graph.create_buffer(std::move(name), desc);
+        }
+
+        engine::resource_handle import_image(
+            std::string name, const engine::image_desc &desc, const resource_usage initial, const resource_usage final
+        ) {
+            m_resources.push_back({.image = true, .imported = true, .initial = initial, .final = final});
+            return m_graph.import_image(std::move(name), desc, initial, final);
+        }
+
+        engine::resource_handle import_buffer(
+            std::string name, const engine::buffer_desc &desc, const resource_usage initial, const resource_usage final
+        ) {
+            m_resources.push_back({.imported = true, .initial = initial, .final = final});
+            return m_graph.import_buffer(std::move(name), desc, initial, final);
+        }
+
+        void pass(
+            std::string name, std::vector<engine::resource_access> reads, std::vector<engine::resource_access> writes,
+            const bool side_effects = false
+        ) {
+            engine::render_pass_desc desc{std::move(name), std::move(reads), std::move(writes), side_effects, {}};
+            m_passes.push_back(desc);
+            m_graph.add_pass(std::move(desc));
+        }
+
+        [[nodiscard]] const std::vector<resource> &resources() const noexcept { return m_resources; }
+        [[nodiscard]] const std::vector<engine::render_pass_desc> &passes() const noexcept { return m_passes; }
+
+      private:
+        render_graph                         &m_graph;
+        std::vector<resource>                 m_resources;
+        std::vector<engine::render_pass_desc> m_passes;
+    };
+
+    engine::resource_access read(const engine::resource_handle resource, const resource_usage usage) {
+        return {resource, usage};
+    }
+
+    engine::resource_access write(
+        const engine::resource_handle resource, const resource_usage usage, const bool discard = false
+    ) {
+        return {resource, usage, discard};
+    }
+
+    /**
+     * The passes a graph has to keep, worked out backwards: a pass is needed if it has side effects, writes an
+     * imported resource, or writes something a needed pass after it reads (or writes without discarding).
+     */
+    std::vector<uint32_t> needed_passes(const declaration &declared) {
+        const auto           &passes = declared.passes();
+        std::vector<uint8_t>  wanted(declared.resources().size(), 0);
+        std::vector<uint32_t> needed;
+        for (uint32_t p = static_cast<uint32_t>(passes.size()); p-- > 0;) {
+            bool keep = passes[p].side_effects;
+            for (const auto &access : passes[p].writes) {
+                keep |= declared.resources()[access.resource.index].imported || wanted[access.resource.index];
+            }
+            if (!keep)
+                continue;
+
+            needed.push_back(p);
+            for (const auto &access : passes[p].writes) {
+                wanted[access.resource.index] = 0;
+            }
+            for (const auto &access : passes[p].reads) {
+                wanted[access.resource.index] = 1;
+            }
+            for (const auto &access : passes[p].writes) {
+                wanted[access.resource.index] |= !access.discard;
+            }
+        }
+        std::ranges::reverse(needed);
+        return needed;
+    }
+
+    void check_memory(const declaration &declared, const render_graph::compiled_graph &compiled) {
+        const auto &resources = declared.resources();
+
+        uint64_t requested = 0;
+        for (uint32_t r = 0; r < resources.size(); ++r) {
+            const auto &placement = compiled.placements[r];
+            const auto &life      = compiled.lifetimes[r];
+            if (resources[r].imported || life.first > life.last) {
+                check(placement.block == render_graph::placement::no_block, "only used transients get memory");
+                continue;
+            }
+
+            const auto &need = resources[r].requirements;
+            check(placement.block < compiled.blocks.size(), "every used transient has a block");
+            const auto &block = compiled.blocks[placement.block];
+            requested += need.size;
+            check(block.images == resources[r].image, "images and buffers live in separate blocks");
+            check(placement.offset % need.alignment == 0, "placements are aligned");
+            check(placement.offset + need.size <= block.size, "placements fit in their block");
+            check(
+                block.type_bits != 0 && (block.type_bits & need.type_bits) == block.type_bits,
+                "a block's memory type suits everything in it"
+            );
+
+            for (uint32_t other = 0; other < r; ++other) {
+                const auto &other_placement = compiled.placements[other];
+                const auto &other_life      = compiled.lifetimes[other];
+                if (other_placement.block != placement.block)
+                    continue;
+                const bool same_time = life.first <= other_life.last && other_life.first <= life.last;
+                const bool same_memory =
+                    placement.offset < other_placement.offset + resources[other].requirements.size &&
+                    other_placement.offset < placement.offset + need.size;
+                check(!(same_time && same_memory), "resources alive at the same time never share memory");
+            }
+        }
+
+        uint64_t allocated = 0;
+        for (const auto &block : compiled.blocks) {
+            allocated += block.size;
+        }
+        check(compiled.requested_bytes == requested, "requested bytes add up the used transients");
+        check(compiled.allocated_bytes == allocated, "allocated bytes add up the blocks");
+        check(allocated <= requested, "aliasing never takes more memory than not aliasing");
+    }
+
+    /**
+     * Replays the compiled frame, tracking for each resource its layout, its last write and the reads since, and what
+     * barriers have made safe. Every access has to be in its layout and be made safe from the accesses before it, and
+     * every barrier has to change a layout, hand over aliased memory or resolve a hazard.
+     */
+    void check_barriers(const declaration &declared, const render_graph::compiled_graph &compiled) {
+        using engine::image_layout;
+        using engine::layout_of;
+        using engine::mask_of;
+
+        // whatever wrote an imported resource before the frame, made visible to its initial usage only
+        constexpr engine::usage_mask external_write = engine::usage_mask(1) << 31;
+
+        const auto &resources = declared.resources();
+        struct state {
+            image_layout       layout     = image_layout::undefined;
+            engine::usage_mask last_write = 0;
+            engine::usage_mask readers    = 0; // since the last write
+            engine::usage_mask safe_reads = 0; // usages a barrier has let go after the last write
+            engine::usage_mask safe_write = 0; // usages a barrier has let go after the last write and reads since
+            bool               aliased    = false;
+        };
+        std::vector<state> states(resources.size());
+        for (uint32_t r = 0; r < resources.size(); ++r) {
+            if (!resources[r].imported)
+                continue;
+            states[r].layout = resources[r].image ? layout_of(resources[r].initial) : image_layout::undefined;
+            if (engine::is_write(resources[r].initial)) {
+                states[r].last_write = mask_of(resources[r].initial);
+            } else {
+                states[r].last_write = external_write;
+                states[r].readers    = mask_of(resources[r].initial);
+                states[r].safe_reads = mask_of(resources[r].initial);
+            }
+        }
+
+        // transients that take over memory something else used earlier in the frame
+        for (uint32_t r = 0; r < resources.size(); ++r) {
+            const auto &placement = compiled.placements[r];
+            for (uint32_t other = 0; other < resources.size() && placement.block != render_graph::placement::no_block;
+                 ++other) {
+                const auto &other_placement = compiled.placements[other];
+                if (other == r || other_placement.block != placement.block ||
+                    compiled.lifetimes[other].last >= compiled.lifetimes[r].first)
+                    continue;
+                states[r].aliased |=
+                    placement.offset < other_placement.offset + resources[other].requirements.size &&
+                    other_placement.offset < placement.offset + resources[r].requirements.size;
+            }
+        }
+
+        // reads and writes are the usages the barrier is placed for, by the pass after it or as the final usage
+        const auto apply = [&](const render_graph::barrier &barrier, const bool discards,
+                               const engine::usage_mask reads, const engine::usage_mask writes) {
+            state     &s      = states[barrier.resource.index];
+            const bool hazard = (writes != 0 && (s.readers != 0 || s.last_write != 0)) ||
+                                (reads != 0 && s.last_write != 0 && (reads & ~s.safe_reads) != 0);
+            if (resources[barrier.resource.index].image) {
+                check(
+                    barrier.old_layout == s.layout || (barrier.old_layout == image_layout::undefined && discards),
+                    "barriers start from the layout the image is in, unless its contents are discarded"
+                );
+                s.layout = barrier.new_layout;
+            }
+
+            // waiting for the reads since the last write also waits for that write, which they waited for
+            if (s.readers != 0 && (barrier.before & s.readers) == s.readers) {
+                s.safe_write |= barrier.after;
+                s.safe_reads |= barrier.after;
+            } else if (s.last_write != 0 && (barrier.before & s.last_write) == s.last_write) {
+                s.safe_reads |= barrier.after;
+                s.safe_write |= s.readers == 0 ? barrier.after : 0;
+            }
+            check(
+                barrier.old_layout != barrier.new_layout || barrier.aliasing || hazard,
+                "every barrier changes a layout, hands over memory or resolves a hazard"
+            );
+            if (barrier.aliasing) {
+                check(s.aliased && barrier.before != 0, "aliasing barriers wait for the memory's previous users");
+                s.aliased = false;
+            }
+        };
+
+        const auto &passes = declared.passes();
+        for (const auto &kept : compiled.passes) {
+            const auto &pass = passes[kept.pass];
+
+            std::vector<uint32_t> seen;
+            for (const auto &barrier : compiled.barriers_before(kept)) {
+                check(
+                    std::ranges::find(seen, barrier.resource.index) == seen.end(),
+                    "a pass has at most one barrier per resource"
+                );
+                seen.push_back(barrier.resource.index);
+
+                bool discards = states[barrier.resource.index].last_write == 0 &&
+                                states[barrier.resource.index].readers == 0 &&
+                                !resources[barrier.resource.index].imported;
+                engine::usage_mask reads  = 0;
+                engine::usage_mask writes = 0;
+                for (const auto &access : pass.writes) {
+                    if (access.resource == barrier.resource) {
+                        discards |= access.discard;
+                        writes |= mask_of(access.usage);
+                    }
+                }
+                for (const auto &access : pass.reads) {
+                    if (access.resource == barrier.resource) {
+                        discards = false;
+                        reads |= mask_of(access.usage);
+                    }
+                }
+                apply(barrier, discards, reads, writes);
+            }
+
+            for (const auto *list : {&pass.reads, &pass.writes}) {
+                for (const auto &access : *list) {
+                    const state &s = states[access.resource.index];
+                    check(!s.aliased, "memory taken over from another resource is waited for first");
+                    if (resources[access.resource.index].image)
+                        check(s.layout == layout_of(access.usage), "images are in the layout each access needs");
+
+                    const engine::usage_mask usage = mask_of(access.usage);
+                    if (list == &pass.reads) {
+                        check(s.last_write == 0 || (s.safe_reads & usage), "reads wait for the last write");
+                    } else if (s.readers != 0 || s.last_write != 0) {
+                        check((s.safe_write & usage) != 0, "writes wait for the last write and the reads since");
+                    }
+                }
+            }
+
+            for (const auto &access : pass.reads) {
+                states[access.resource.index].readers |= mask_of(access.usage);
+            }
+            std::vector<engine::usage_mask> written(resources.size(), 0);
+            for (const auto &access : pass.writes) {
+                written[access.resource.index] |= mask_of(access.usage);
+            }
+            for (uint32_t r = 0; r < resources.size(); ++r) {
+                if (!written[r])
+                    continue;
+                // the graph counts everything the pass did to the resource as the write later passes wait for
+                engine::usage_mask all = written[r];
+                for (const auto &access : pass.reads) {
+                    if (access.resource.index == r)
+                        all |= mask_of(access.usage);
+                }
+                states[r] = state{.layout = states[r].layout, .last_write = all};
+            }
+        }
+
+        for (const auto &barrier : compiled.final_barriers) {
+            const auto &resource = resources[barrier.resource.index];
+            check(resource.imported, "final barriers are for imported resources");
+            const engine::usage_mask usage = mask_of(resource.final);
+            const bool               writes = engine::is_write(resource.final);
+            apply(barrier, false, writes ? 0 : usage, writes ? usage : 0);
+        }
+        for (uint32_t r = 0; r < resources.size(); ++r) {
+            if (!resources[r].imported)
+                continue;
+            const state &s = states[r];
+            if (resources[r].image)
+                check(s.layout == layout_of(resources[r].final), "imported images end in their final layout");
+
+            const engine::usage_mask usage = mask_of(resources[r].final);
+            if (engine::is_write(resources[r].final)) {
+                check((s.readers == 0 && s.last_write == 0) || (s.safe_write & usage), "the final usage waits");
+            } else {
+                check(s.last_write == 0 || (s.safe_reads & usage), "the final usage waits for the last write");
+            }
+        }
+    }
+
+    void check_compiled(const declaration &declared, const render_graph::compiled_graph &compiled) {
+        const std::vector<uint32_t> needed = needed_passes(declared);
+        check(compiled.passes.size() == needed.size(), "the graph keeps exactly the passes that are needed");
+        for (size_t i = 0; i < needed.size(); ++i) {
+            check(compiled.passes[i].pass == needed[i], "the graph keeps exactly the passes that are needed");
+        }
+
+        for (uint32_t r = 0; r < declared.resources().size(); ++r) {
+            uint32_t first = UINT32_MAX;
+            uint32_t last  = 0;
+            for (uint32_t i = 0; i < compiled.passes.size(); ++i) {
+                const auto &pass = declared.passes()[compiled.passes[i].pass];
+                for (const auto *list : {&pass.reads, &pass.writes}) {
+                    for (const auto &access : *list) {
+                        if (access.resource.index == r) {
+                            first = std::min(first, i);
+                            last  = std::max(last, i);
+                        }
+                    }
+                }
+            }
+            check(
+                compiled.lifetimes[r].first == first && (first == UINT32_MAX || compiled.lifetimes[r].last == last),
+                "lifetimes span the first and last kept passes using a resource"
+            );
+        }
+
+        check_memory(declared, compiled);
+        check_barriers(declared, compiled);
+    }
+
+    /**
+     * A deferred renderer's frame at 1080p: depth prepass, G-buffer, SSAO, shadows, lighting, sky, transparency,
+     * bloom, tonemapping and UI, then a blit to the swapchain. A debug view nothing reads is declared too.
+     */
+    void declare_deferred(declaration &d, const uint32_t width, const uint32_t height) {
+        const auto target = [&](const uint32_t bytes, const uint32_t divisor = 1) {
+            return engine::image_desc{
+                .width = width / divisor, .height = height / divisor, .format = 1, .bytes_per_texel = bytes
+            };
+        };
+
+        const auto swapchain = d.import_image(
+            "swapchain", target(4), resource_usage::present, resource_usage::present
+        );
+        const auto depth    = d.image("depth", target(4));
+        const auto albedo   = d.image("albedo", target(4));
+        const auto normal   = d.image("normal", target(8));
+        const auto material = d.image("material", target(4));
+        const auto ssao_raw = d.image("ssao_raw", target(1, 2));
+        const auto ssao     = d.image("ssao", target(1, 2));
+        const auto shadows  = d.image(
+            "shadows", engine::image_desc{.width = 2048, .height = 2048, .layers = 4, .format = 1}
+        );
+        const auto hdr       = d.image("hdr", target(8));
+        const auto luminance = d.buffer("luminance", {.size = 256 * 4});
+        const auto bloom_a   = d.image("bloom_a", target(8, 2));
+        const auto bloom_b   = d.image("bloom_b", target(8, 2));
+        const auto ldr       = d.image("ldr", target(4));
+        const auto debug     = d.image("debug", target(4));
+
+        using u = resource_usage;
+        d.pass("depth_prepass", {}, {write(depth, u::depth_attachment, true)});
+        d.pass(
+            "gbuffer", {},
+            {write(depth, u::depth_attachment), write(albedo, u::color_attachment, true),
+             write(normal, u::color_attachment, true), write(material, u::color_attachment, true)}
+        );
+        d.pass("ssao", {read(depth, u::sampled), read(normal, u::sampled)}, {write(ssao_raw, u::storage_write, true)});
+        d.pass("ssao_blur", {read(ssao_raw, u::storage_read)}, {write(ssao, u::storage_write, true)});
+        d.pass("shadows", {}, {write(shadows, u::depth_attachment, true)});
+        d.pass(
+            "lighting",
+            {read(albedo, u::sampled), read(normal, u::sampled), read(material, u::sampled), read(depth, u::sampled),
+             read(ssao, u::sampled), read(shadows, u::sampled)},
+            {write(hdr, u::color_attachment, true)}
+        );
+        d.pass("sky", {read(depth, u::depth_read)}, {write(hdr, u::color_attachment)});
+        d.pass(
+            "transparent", {read(depth, u::depth_read), read(shadows, u::sampled)}, {write(hdr, u::color_attachment)}
+        );
+        d.pass("luminance", {read(hdr, u::sampled)}, {write(luminance, u::storage_write, true)});
+        d.pass("bloom_down", {read(hdr, u::sampled)}, {write(bloom_a, u::storage_write, true)});
+        d.pass("bloom_up", {read(bloom_a, u::storage_read)}, {write(bloom_b, u::storage_write, true)});
+        d.pass(
+            "tonemap", {read(hdr, u::sampled), read(bloom_b, u::sampled), read(luminance, u::storage_read)},
+            {write(ldr, u::color_attachment, true)}
+        );
+        d.pass("debug_view", {read(normal, u::sampled), read(depth, u::sampled)}, {write(debug, u::color_attachment)});
+        d.pass("ui", {}, {write(ldr, u::color_attachment)});
+        d.pass("present", {read(ldr, u::transfer_src)}, {write(swapchain, u::transfer_dst, true)});
+    }
+
+    /**
+     * A chain of full-screen effects, each reading the one before, ending in the swapchain.
+     */
+    void declare_post_chain(declaration &d, const uint32_t effects) {
+        const engine::image_desc target{.width = 1920, .height = 1080, .format = 1, .bytes_per_texel = 8};
+        const auto scene = d.import_image("scene", target, resource_usage::sampled, resource_usage::sampled);
+        const auto swapchain =
+            d.import_image("swapchain", target, resource_usage::present, resource_usage::present);
+
+        auto previous = scene;
+        for (uint32_t i = 0; i < effects; ++i) {
+            const auto next = d.image("effect_" + std::to_string(i), target);
+            d.pass(
+                "effect_" + std::to_string(i), {read(previous, resource_usage::sampled)},
+                {write(next, resource_usage::color_attachment, true)}
+            );
+            previous = next;
+        }
+        d.pass(
+            "present", {read(previous, resource_usage::transfer_src)},
+            {write(swapchain, resource_usage::transfer_dst, true)}
+        );
+    }
+
+    /**
+     * Buffers laid out so that the last one (64 KiB aligned, see buffer_requirements) fits in the gap a short-lived
+     * buffer leaves between two others only if its offset is not aligned. It has to go after them instead.
+     */
+    void declare_tight_gap(declaration &d) {
+        using u                = resource_usage;
+        const auto block       = d.buffer("block", {.size = 1 << 20});
+        const auto first       = d.buffer("first", {.size = 262144});
+        const auto second      = d.buffer("second", {.size = 131584});
+        const auto short_lived = d.buffer("short_lived", {.size = 66304});
+        const auto third       = d.buffer("third", {.size = 65792});
+        const auto aligned     = d.buffer("aligned", {.size = 65280});
+
+        d.pass("sizes_the_block", {}, {write(block, u::storage_write)}, true);
+        d.pass(
+            "fills_the_block", {},
+            {write(first, u::storage_write), write(second, u::storage_write), write(short_lived, u::storage_write),
+             write(third, u::storage_write)},
+            true
+        );
+        d.pass(
+            "leaves_a_gap",
+            {read(first, u::storage_read), read(second, u::storage_read), read(third, u::storage_read)},
+            {write(aligned, u::storage_write)}, true
+        );
+    }
+
+    /**
+     * A graph of random passes over random images and buffers. Passes only read what an earlier pass wrote (or an
+     * imported resource), and never use one image in two layouts.
+     */
+    void declare_random(declaration &d, std::mt19937_64 &rng) {
+        using u = resource_usage;
+        static constexpr u image_reads[]   = {u::sampled, u::storage_read, u::depth_read, u::transfer_src};
+        static constexpr u image_writes[]  = {u::color_attachment, u::depth_attachment, u::storage_write,
+                                              u::transfer_dst};
+        static constexpr u buffer_reads[]  = {u::vertex_buffer, u::index_buffer, u::indirect_buffer, u::uniform_buffer,
+                                              u::storage_read, u::transfer_src};
+        static constexpr u buffer_writes[] = {u::storage_write, u::transfer_dst};
+
+        const auto pick = [&](const auto &values) { return values[rng() % std::size(values)]; };
+
+        std::vector<engine::resource_handle> resources;
+        std::vector<uint8_t>                 images;
+        std::vector<uint8_t>                 readable;
+        const uint32_t                       resource_count = 4 + rng() % 24;
+        for (uint32_t r = 0; r < resource_count; ++r) {
+            const bool image = rng() % 3 != 0;
+            const bool imported = rng() % 8 == 0;
+            if (image) {
+                const engine::image_desc desc{
+                    .width           = 64u << rng() % 6,
+                    .height          = 64u << rng() % 6,
+                    .layers          = 1 + static_cast<uint32_t>(rng() % 2),
+                    .format          = static_cast<uint32_t>(rng() % 3),
+                    .bytes_per_texel = 1u << rng() % 4,
+                };
+                resources.push_back(
+                    imported ? d.import_image("image", desc, pick(image_reads), pick(image_reads))
+                             : d.image("image", desc)
+                );
+            } else {
+                const engine::buffer_desc desc{.size = 1 + rng() % (4 << 20)};
+                const resource_usage      final = rng() % 2 ? pick(buffer_reads) : pick(buffer_writes);
+                resources.push_back(
+                    imported ? d.import_buffer("buffer", desc, pick(buffer_reads), final) : d.buffer("buffer", desc)
+                );
+            }
+            images.push_back(image);
+            readable.push_back(imported);
+        }
+
+        const uint32_t pass_count = 2 + rng() % 30;
+        for (uint32_t p = 0; p < pass_count; ++p) {
+            std::vector<engine::resource_access> reads;
+            std::vector<engine::resource_access> writes;
+            std::vector<uint8_t>                 used(resources.size(), 0);
+            for (uint64_t n = rng() % 4; n-- > 0;) {
+                const uint32_t r = rng() % resources.size();
+                if (!readable[r] || used[r])
+                    continue;
+                used[r] = 1;
+                reads.push_back(read(resources[r], images[r] ? pick(image_reads) : pick(buffer_reads)));
+            }
+            for (uint64_t n = 1 + rng() % 2; n-- > 0;) {
+                const uint32_t r = rng() % resources.size();
+                if (used[r])
+                    continue;
+                used[r] = 1;
+                writes.push_back(write(resources[r], images[r] ? pick(image_writes) : pick(buffer_writes), rng() % 2));
+            }
+            for (const auto &access : writes) {
+                readable[access.resource.index] = 1;
+            }
+            d.pass("pass", std::move(reads), std::move(writes), rng() % 6 == 0);
+        }
+    }
+
+    void check_errors() {
+        render_graph graph(memory_model());
+        declaration  d(graph);
+        const auto   image  = d.image("image", {});
+        const auto   buffer = d.buffer("buffer", {.size = 64});
+
+        const auto throws = [&](auto &&f) {
+            try {
+                f();
+            } catch (const std::invalid_argument &) {
+                return true;
+            }
+            return false;
+        };
+        check(
+            throws([&] { d.pass("p", {read(image, resource_usage::color_attachment)}, {}); }),
+            "a write usage listed as a read is rejected"
+        );
+        check(
+            throws([&] { d.pass("p", {read(buffer, resource_usage::sampled)}, {}); }),
+            "an image usage of a buffer is rejected"
+        );
+        check(
+            throws([&] {
+                d.pass("p", {read(image, resource_usage::sampled)}, {write(image, resource_usage::color_attachment)});
+            }),
+            "an image in two layouts in one pass is rejected"
+        );
+        check(
+            throws([&] { d.pass("p", {read({99}, resource_usage::sampled)}, {}); }), "an unknown resource is rejected"
+        );
+
+        d.pass(
+            "reads_first", {read(image, resource_usage::sampled)}, {write(buffer, resource_usage::storage_write)}, true
+        );
+        bool logic_error = false;
+        try {
+            static_cast<void>(graph.compile());
+        } catch (const std::logic_error &) {
+            logic_error = true;
+        }
+        check(logic_error, "reading a transient nothing wrote is an error");
+    }
+
+    struct memory_result {
+        size_t   passes;
+        size_t   kept;
+        size_t   barriers;
+        uint64_t requested;
+        uint64_t allocated;
+    };
+
+    memory_result summarize(const declaration &d, const render_graph::compiled_graph &compiled) {
+        return {
+            d.passes().size(),
+            compiled.passes.size(),
+            compiled.barriers.size() + compiled.final_barriers.size(),
+            compiled.requested_bytes,
+            compiled.allocated_bytes,
+        };
+    }
+
+    void print_memory(const char *name, const memory_result &r) {
+        std::printf(
+            "%-22s %2zu of %2zu passes kept, %2zu barriers, %7.1f MiB requested, %7.1f MiB allocated (%4.1f%% saved)\n",
+            name, r.kept, r.passes, r.barriers, static_cast<double>(r.requested) / (1 << 20),
+            static_cast<double>(r.allocated) / (1 << 20),
+            100.0 - static_cast<double>(r.allocated) / static_cast<double>(r.requested) * 100.0
+        );
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: render_graph_bench [--graphs <count>] [--runs <count>] [--seed <value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--graphs") {
+            options.graphs = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--runs") {
+            options.runs = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        check_errors();
+
+        render_graph deferred_graph(memory_model());
+        memory_result deferred;
+        {
+            declaration d(deferred_graph);
+            declare_deferred(d, 1920, 1080);
+            const auto &compiled = deferred_graph.compile();
+            check_compiled(d, compiled);
+            for (const auto &pass : compiled.passes) {
+                check(deferred_graph.pass_name(pass.pass) != "debug_view", "the unused debug view is culled");
+            }
+            deferred = summarize(d, compiled);
+        }
+
+        memory_result post;
+        {
+            constexpr uint32_t effects = 10;
+            render_graph       graph(memory_model());
+            declaration        d(graph);
+            declare_post_chain(d, effects);
+            const auto &compiled = graph.compile();
+            check_compiled(d, compiled);
+            check(
+                compiled.requested_bytes == effects * d.resources()[2].requirements.size, "every effect is requested"
+            );
+            check(
+                compiled.allocated_bytes == 2 * d.resources()[2].requirements.size,
+                "a chain only needs two effects' worth of memory"
+            );
+            post = summarize(d, compiled);
+        }
+
+        {
+            render_graph graph(memory_model());
+            declaration  d(graph);
+            declare_tight_gap(d);
+            const auto &compiled = graph.compile();
+            check_compiled(d, compiled);
+            check(compiled.blocks.size() == 1, "the buffers share one block");
+        }
+
+        std::mt19937_64 rng(options.seed);
+        uint64_t        random_requested = 0;
+        uint64_t        random_allocated = 0;
+        for (uint64_t g = 0; g < options.graphs; ++g) {
+            render_graph graph(memory_model());
+            declaration  d(graph);
+            declare_random(d, rng);
+            const auto &compiled = graph.compile();
+            check_compiled(d, compiled);
+            random_requested += compiled.requested_bytes;
+            random_allocated += compiled.allocated_bytes;
+        }
+
+        // the same declaration is reused, anything compiling looks at changing is not
+        {
+            declaration d(deferred_graph);
+            declare_deferred(d, 1920, 1080);
+            static_cast<void>(deferred_graph.compile());
+            check(
+                deferred_graph.compile_count() == 1 && deferred_graph.reuse_count() == 1,
+                "an unchanged graph is reused"
+            );
+        }
+        {
+            declaration d(deferred_graph);
+            declare_deferred(d, 2560, 1440);
+            check_compiled(d, deferred_graph.compile());
+            check(deferred_graph.compile_count() == 2, "a changed graph is compiled again");
+        }
+        std::printf("culling, lifetime, memory, barrier, caching and error checks passed\n");
+
+        double compile_seconds = 0.0;
+        double reuse_seconds   = 0.0;
+        for (uint64_t run = 0; run < options.runs; ++run) {
+            auto start = clock::now();
+            {
+                declaration d(deferred_graph);
+                declare_deferred(d, run % 2 == 0 ? 1920 : 2560, run % 2 == 0 ? 1080 : 1440);
+                static_cast<void>(deferred_graph.compile());
+            }
+            compile_seconds += seconds_since(start);
+        }
+        for (uint64_t run = 0; run < options.runs; ++run) {
+            const auto start = clock::now();
+            {
+                declaration d(deferred_graph);
+                declare_deferred(d, 2560, 1440);
+                static_cast<void>(deferred_graph.compile());
+            }
+            reuse_seconds += seconds_since(start);
+        }
+
+        print_memory("deferred 1080p frame:", deferred);
+        print_memory("post chain of 10:", post);
+        const double requested = static_cast<double>(random_requested);
+        const double allocated = static_cast<double>(random_allocated);
+        std::printf(
+            "%-22s %42.1f MiB requested, %7.1f MiB allocated (%4.1f%% saved)\n",
+            (std::to_string(options.graphs) + " random graphs:").c_str(), requested / (1 << 20),
+            allocated / (1 << 20), requested > 0.0 ? 100.0 - allocated / requested * 100.0 : 0.0
+        );
+        const double runs = static_cast<double>(options.runs);
+        std::printf(
+            "deferred frame: declare and compile %.2f us, declare and reuse %.2f us\n", compile_seconds / runs * 1e6,
+            reuse_seconds / runs * 1e6
+        );
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
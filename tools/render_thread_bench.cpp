@@ -0,0 +1,343 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures how much pipelining the render thread buys without a GPU. Each frame updates a scene of renderables with a
+// render extraction, then spins for a fixed time standing in for the rest of the simulation; a null_render_backend
+// walks the draws and sleeps for a fixed time standing in for the GPU. Frames are run serially on the main thread, then
+// through a render_thread with 1 to 3 frames in flight, reporting frame time and the latency from filling a frame's
+// packet to the frame being drawn. Checks that the render thread draws exactly the packets handed to it, in order,
+// that the main thread never gets more than frames_in_flight frames ahead, that the destructor draws every packet
+// handed over, and that a backend failure is rethrown from begin_frame() without deadlocking.
+//
+//   render_thread_bench [--renderables <count>] [--frames <count>] [--simulate <ms>] [--render <ms>] [--seed <value>]
+
+#include "engine/metrics.hpp"
+#include "engine/render/draw_list.hpp"
+#include "engine/render/render_thread.hpp"
+#include "engine/scene/scene.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t renderables = 50'000;
+        uint64_t frames      = 200;
+        double   simulate    = 4.0; // ms
+        double   render      = 4.0; // ms
+        uint64_t seed        = 1;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    /**
+     * Stands in for simulation work: keeps the main thread busy, unlike the backend's sleep.
+     */
+    void spin(const double seconds) {
+        const auto start = clock::now();
+        while (seconds_since(start) < seconds) {
+        }
+    }
+
+    /**
+     * Counts the frames it draws into a counter that outlives it, and throws on one of them if asked to.
+     */
+    class counting_backend final : public engine::render_backend {
+      public:
+        counting_backend(std::atomic<uint64_t> *drawn, const double frame_time, const uint64_t fail_at = UINT64_MAX)
+            : m_drawn(drawn), m_frame_time(frame_time), m_fail_at(fail_at) {}
+
+        void render(const engine::frame_packet &packet) override {
+            std::this_thread::sleep_for(std::chrono::duration<double>(m_frame_time));
+            if (packet.index == m_fail_at)
+                throw std::runtime_error("backend failed");
+            m_drawn->fetch_add(1, std::memory_order_relaxed);
+        }
+
+      private:
+        std::atomic<uint64_t> *m_drawn;
+        double                 m_frame_time;
+        uint64_t               m_fail_at;
+    };
+
+    void check_shutdown_and_failure() {
+        std::atomic<uint64_t> drawn = 0;
+        {
+            engine::render_thread renderer(
+                std::make_unique<counting_backend>(&drawn, 0.002),
+                engine::render_thread::settings{.frames_in_flight = 3}
+            );
+            for (int i = 0; i < 3; ++i) {
+                static_cast<void>(renderer.begin_frame());
+                renderer.end_frame();
+            }
+        }
+        check(drawn == 3, "the destructor draws every packet handed over");
+
+        drawn = 0;
+        engine::render_thread renderer(
+            std::make_unique<counting_backend>(&drawn, 0.0, 2), engine::render_thread::settings{.frames_in_flight = 2}
+        );
+        // the failing frame is the last one handed over, so none of these begin_frame calls can see it yet
+        for (int i = 0; i < 3; ++i) {
+            static_cast<void>(renderer.begin_frame());
+            renderer.end_frame();
+        }
+        renderer.wait_idle();
+        check(renderer.frames_rendered() == 3 && drawn == 2, "a failed frame still counts as rendered");
+
+        bool rethrown = false;
+        try {
+            static_cast<void>(renderer.begin_frame());
+        } catch (const std::runtime_error &) {
+            rethrown = true;
+        }
+        check(rethrown, "begin_frame rethrows the backend's exception");
+
+        bool rejected = false;
+        try {
+            engine::render_thread invalid(
+                std::make_unique<counting_backend>(&drawn, 0.0), engine::render_thread::settings{.frames_in_flight = 0}
+            );
+        } catch (const std::invalid_argument &) {
+            rejected = true;
+        }
+        check(rejected, "frames_in_flight of 0 is rejected");
+    }
+
+    struct world {
+        std::shared_ptr<engine::scene::scene>      scene;
+        std::shared_ptr<engine::render_extraction> extraction;
+    };
+
+    world make_world(const uint64_t count, const uint64_t seed) {
+        world world{std::make_shared<engine::scene::scene>(), nullptr};
+        world.extraction = engine::render_extraction::attach(world.scene);
+
+        std::mt19937_64                       rng(seed);
+        std::uniform_real_distribution<float> place(-200.0f, 200.0f);
+        auto                                 &transforms = world.scene->transforms();
+        for (uint64_t i = 0; i < count; ++i) {
+            const auto bits = rng();
+            world.scene->components().create_entity(engine::renderable{
+                .transform = transforms.create(
+                    {}, glm::translate(glm::mat4(1.0f), glm::vec3(place(rng), place(rng), place(rng)))
+                ),
+                .bounds   = {glm::vec3(-0.5f), glm::vec3(0.5f)},
+                .mesh     = static_cast<uint32_t>(bits & 0x3f),
+                .material = static_cast<uint32_t>((bits >> 6) & 0xff),
+                .pipeline = static_cast<uint16_t>((bits >> 14) & 0xf),
+                .object   = i,
+            });
+        }
+        return world;
+    }
+
+    /**
+     * A camera flying through the scene, so every frame draws something different.
+     */
+    engine::camera_view camera_at(const uint64_t frame) {
+        const glm::vec3 position(0.0f, 0.0f, 200.0f - static_cast<float>(frame % 400));
+        const glm::vec3 forward(0.0f, 0.0f, -1.0f);
+
+        engine::camera_view camera;
+        camera.view_projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f) *
+                                 glm::lookAt(position, position + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+        camera.position  = position;
+        camera.forward   = forward;
+        camera.far_plane = 500.0f;
+        return camera;
+    }
+
+    void simulate(const world &world, const options &options, const uint64_t frame) {
+        constexpr double step = 1.0 / 60.0;
+
+        world.extraction->set_camera(camera_at(frame));
+        world.scene->update(step);
+        spin(options.simulate / 1e3);
+    }
+
+    /**
+     * Fills the packet with what the last update extracted, as the main loop does.
+     */
+    void fill(const world &world, const uint64_t frame, engine::frame_packet &packet) {
+        packet.assign(world.extraction->get_draw_list());
+        packet.camera          = camera_at(frame);
+        packet.simulation_time = world.scene->get_time();
+    }
+
+    engine::metrics::snapshot::histogram_value latency_histogram() {
+        const auto snapshot = engine::metrics::registry::get().take_snapshot();
+        for (const auto &histogram : snapshot.histograms) {
+            if (histogram.name.str() == "render_latency_microseconds")
+                return histogram;
+        }
+        return {};
+    }
+
+    struct run_result {
+        double   frame_seconds;
+        double   mean_latency; // seconds
+        uint64_t p99_latency;  // microseconds
+        uint64_t draws;
+    };
+
+    run_result run_serial(const options &options) {
+        const world                 world = make_world(options.renderables, options.seed);
+        engine::null_render_backend backend({.frame_time = options.render / 1e3});
+        engine::frame_packet        packet;
+
+        double     latency = 0.0;
+        const auto start   = clock::now();
+        for (uint64_t frame = 0; frame < options.frames; ++frame) {
+            simulate(world, options, frame);
+
+            // measured from the same point as render_thread's latency, when the packet starts being filled
+            const auto begun = clock::now();
+            packet.index     = frame;
+            fill(world, frame, packet);
+            backend.render(packet);
+            latency += seconds_since(begun);
+        }
+        const double seconds = seconds_since(start);
+
+        const double frames = static_cast<double>(options.frames);
+        return {seconds / frames, latency / frames, 0, backend.draws()};
+    }
+
+    run_result run_pipelined(const options &options, const uint32_t frames_in_flight) {
+        const world                 world = make_world(options.renderables, options.seed);
+        engine::null_render_backend expected({});
+        const auto                  before = latency_histogram();
+
+        auto                         backend = std::make_unique<engine::null_render_backend>(
+            engine::null_render_backend::settings{.frame_time = options.render / 1e3}
+        );
+        engine::null_render_backend &drawn = *backend;
+        engine::render_thread        renderer(std::move(backend), {.frames_in_flight = frames_in_flight});
+
+        const auto start = clock::now();
+        for (uint64_t frame = 0; frame < options.frames; ++frame) {
+            // the render thread draws the previous frame meanwhile
+            simulate(world, options, frame);
+
+            engine::frame_packet &packet = renderer.begin_frame();
+            check(
+                renderer.frames_submitted() - renderer.frames_rendered() < frames_in_flight,
+                "the main thread is never more than frames_in_flight frames ahead"
+            );
+            check(packet.index == frame, "packets are handed out in frame order");
+            fill(world, frame, packet);
+            expected.render(packet);
+            renderer.end_frame();
+        }
+        renderer.wait_idle();
+        const double seconds = seconds_since(start);
+
+        check(renderer.frames_rendered() == options.frames, "every frame handed over is drawn");
+        check(drawn.frames() == options.frames && drawn.draws() == expected.draws(), "and nothing else");
+        check(drawn.checksum() == expected.checksum(), "the render thread draws the packets as filled, in order");
+        check(renderer.last_latency() >= options.render / 1e3, "latency includes the backend's frame time");
+
+        // the latency recorded by this run alone
+        auto latency = latency_histogram();
+        latency.count -= before.count;
+        latency.sum -= before.sum;
+        for (size_t i = 0; i < before.buckets.size(); ++i) {
+            latency.buckets[i] -= before.buckets[i];
+        }
+        check(latency.count == options.frames, "a latency is recorded for every frame");
+
+        return {
+            seconds / static_cast<double>(options.frames),
+            static_cast<double>(latency.sum) / static_cast<double>(latency.count) / 1e6,
+            latency.quantile(0.99),
+            drawn.draws(),
+        };
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: render_thread_bench [--renderables <count>] [--frames <count>] [--simulate <ms>] "
+                         "[--render <ms>] [--seed <value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--renderables") {
+            options.renderables = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--frames") {
+            options.frames = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--simulate") {
+            options.simulate = std::max(std::strtod(argv[++i], nullptr), 0.0);
+        } else if (arg == "--render") {
+            options.render = std::max(std::strtod(argv[++i], nullptr), 0.0);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        check_shutdown_and_failure();
+
+        const run_result        serial = run_serial(options);
+        std::vector<run_result> pipelined;
+        for (uint32_t frames_in_flight = 1; frames_in_flight <= 3; ++frames_in_flight) {
+            pipelined.push_back(run_pipelined(options, frames_in_flight));
+            check(pipelined.back().draws == serial.draws, "pipelined runs draw what the serial run draws");
+        }
+        std::printf("ordering, checksum, shutdown and failure checks passed\n");
+
+        std::printf(
+            "%llu renderables, %llu frames, %.1f ms simulated, %.1f ms render frame\n",
+            static_cast<unsigned long long>(options.renderables), static_cast<unsigned long long>(options.frames),
+            options.simulate, options.render
+        );
+        std::printf(
+            "serial:             %6.2f ms per frame, latency %6.2f ms\n", serial.frame_seconds * 1e3,
+            serial.mean_latency * 1e3
+        );
+        for (size_t i = 0; i < pipelined.size(); ++i) {
+            const run_result &r = pipelined[i];
+            std::printf(
+                "%zu frame(s) in flight: %6.2f ms per frame, latency %6.2f ms (p99 %.2f ms), %.2fx the serial rate\n",
+                i + 1, r.frame_seconds * 1e3, r.mean_latency * 1e3, static_cast<double>(r.p99_latency) / 1e3,
+                serial.frame_seconds / r.frame_seconds
+            );
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Streams thousands of synthetic assets through engine::resource_manager from a temporary directory, and reports load
+// throughput, the manager's peak resident bytes and the process's peak memory. Assets are streamed in a sliding window:
+// a fixed number are requested ahead and held, and each is dropped once used, so the budget is what bounds residency.
+// Checks first that requests for one path share a load, that a wrong type or a missing file is reported, that
+// dropping the last handle evicts at once when over budget (also when the evicted value holds handles of its own), that
+// eviction goes in least-recently-requested order, and that every asset loads with the bytes it was written with.
+//
+//   resource_bench [--assets <count>] [--size <max KiB>] [--budget <MiB>] [--window <count>] [--threads <count>]
+
+#include "engine/jobs.hpp"
+#include "engine/resources.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#define ENGINE_HAS_RUSAGE 1
+#endif
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t assets  = 4000;
+        uint64_t size    = 64; // KiB
+        uint64_t budget  = 32; // MiB
+        uint64_t window  = 64;
+        uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    uint64_t checksum(const std::span<const std::byte> bytes) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (const std::byte b : bytes) {
+            hash ^= static_cast<uint8_t>(b);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    /**
+     * A loaded asset: its bytes, which are what it is charged for.
+     */
+    struct blob {
+        std::vector<std::byte> data;
+
+        [[nodiscard]] size_t resident_bytes() const noexcept { return data.size(); }
+    };
+
+    /**
+     * An asset that refers to another, the way a material holds its textures.
+     */
+    struct bundle {
+        engine::resource_handle<blob> part;
+    };
+
+    /**
+     * A directory of synthetic assets that is removed again on destruction.
+     */
+    class asset_directory {
+      public:
+        asset_directory(const uint64_t count, const uint64_t max_size, std::mt19937_64 &rng) {
+#ifdef ENGINE_HAS_RUSAGE
+            const auto pid = static_cast<long long>(::getpid());
+#else
+            const auto pid = static_cast<long long>(rng() % 1'000'000);
+#endif
+            m_root = std::filesystem::temp_directory_path() / ("resource_bench_" + std::to_string(pid));
+            std::filesystem::create_directories(m_root);
+
+            std::vector<std::byte> data;
+            for (uint64_t i = 0; i < count; ++i) {
+                data.resize(256 + rng() % std::max<uint64_t>(max_size - 256, 1));
+                for (auto &b : data) {
+                    b = static_cast<std::byte>(rng());
+                }
+
+                std::ofstream file(m_root / name(i), std::ios::binary);
+                file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+                if (!file)
+                    throw std::runtime_error("Failed to write " + (m_root / name(i)).string());
+
+                m_checksums.push_back(checksum(data));
+                m_total_bytes += data.size();
+            }
+        }
+
+        ~asset_directory() {
+            std::error_code ignored;
+            std::filesystem::remove_all(m_root, ignored);
+        }
+
+        asset_directory(const asset_directory &other)            = delete;
+        asset_directory &operator=(const asset_directory &other) = delete;
+
+        [[nodiscard]] static std::string name(const uint64_t i) { return "asset_" + std::to_string(i) + ".bin"; }
+
+        [[nodiscard]] inline const std::filesystem::path &root() const noexcept { return m_root; }
+        [[nodiscard]] inline uint64_t checksum_of(const uint64_t i) const noexcept { return m_checksums[i]; }
+        [[nodiscard]] inline uint64_t count() const noexcept { return m_checksums.size(); }
+        [[nodiscard]] inline uint64_t total_bytes() const noexcept { return m_total_bytes; }
+
+      private:
+        std::filesystem::path m_root;
+        std::vector<uint64_t> m_checksums;
+        uint64_t              m_total_bytes = 0;
+    };
+
+    std::unique_ptr<engine::resource_manager> make_manager(const asset_directory &assets, const size_t budget) {
+        auto manager = std::make_unique<engine::resource_manager>(
+            engine::resource_manager::settings{.root = assets.root(), .budget_bytes = budget}
+        );
+        manager->set_loader<blob>([](const std::span<const std::byte> data) {
+            return std::make_shared<blob>(blob{.data = {data.begin(), data.end()}});
+        });
+        return manager;
+    }
+
+    void check_sharing_and_errors(const asset_directory &assets, const std::shared_ptr<engine::job_system> &jobs) {
+        const auto manager = make_manager(assets, SIZE_MAX);
+        manager->set_job_system(jobs);
+
+        const auto first  = manager->load<blob>(asset_directory::name(0));
+        const auto second = manager->load<blob>(asset_directory::name(0));
+        check(first.wait() && first.get() == second.wait(), "requests for one path share one resource");
+        check(manager->stats().loads_started == 1, "and one load");
+        check(checksum(first->data) == assets.checksum_of(0), "the resource holds the file's bytes");
+
+        bool thrown = false;
+        try {
+            (void)manager->load<bundle>(asset_directory::name(0));
+        } catch (const std::invalid_argument &) {
+            thrown = true;
+        }
+        check(thrown, "requesting a path as another type throws");
+
+        const auto missing = manager->load<blob>("no_such_asset.bin");
+        check(!missing.wait() && missing.state() == engine::resource_state::failed, "a missing file fails to load");
+        check(!missing.error().empty(), "with an error");
+    }
+
+    void check_eviction(const asset_directory &assets) {
+        const auto manager = make_manager(assets, 0);
+        manager->set_loader<bundle>([&manager](std::span<const std::byte>) {
+            return std::make_shared<bundle>(bundle{.part = manager->load<blob>(asset_directory::name(1))});
+        });
+
+        {
+            const auto held = manager->load<blob>(asset_directory::name(0));
+            check(held.ready(), "a held resource stays loaded over budget");
+            check(manager->stats().resident_count == 1, "and resident");
+        }
+        check(manager->stats().resident_count == 0, "dropping the last handle over budget evicts it at once");
+        check(manager->stats().evictions == 1, "once");
+
+        {
+            // the bundle is evicted first, and releasing its part from inside eviction evicts the part too
+            const auto held = manager->load<bundle>(asset_directory::name(2));
+            check(held.ready() && held->part.ready(), "a bundle loads its part");
+        }
+        check(manager->stats().resident_count == 0, "evicting a value that holds handles releases them");
+
+        // the least recently requested goes first
+        manager->set_budget(SIZE_MAX);
+        std::vector<engine::resource_handle<blob>> kept;
+        for (uint64_t i = 3; i < 6; ++i) {
+            kept.push_back(manager->load<blob>(asset_directory::name(i)));
+        }
+        const size_t resident = manager->stats().resident_bytes;
+        kept.clear();
+        (void)manager->load<blob>(asset_directory::name(3)); // 3 becomes the most recent
+
+        const size_t evictions = manager->stats().evictions;
+        manager->set_budget(resident - 1);
+        check(manager->stats().evictions == evictions + 1, "going just over budget evicts one resource");
+        check(!manager->find<blob>(asset_directory::name(4)).ready(), "the least recently requested one");
+        check(manager->find<blob>(asset_directory::name(3)).ready(), "and not one requested since");
+    }
+
+    uint64_t peak_process_bytes() {
+#ifdef ENGINE_HAS_RUSAGE
+        rusage usage{};
+        ::getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    struct stream_result {
+        double                               seconds;
+        engine::resource_manager::statistics stats;
+    };
+
+    /**
+     * Requests every asset in order, holding window of them at once, and checks each one's bytes as it is dropped.
+     */
+    stream_result stream(
+        const asset_directory &assets, const size_t budget, const uint64_t window,
+        const std::shared_ptr<engine::job_system> &jobs
+    ) {
+        const auto manager = make_manager(assets, budget);
+        manager->set_job_system(jobs);
+
+        std::deque<std::pair<uint64_t, engine::resource_handle<blob>>> in_flight;
+
+        const auto use_oldest = [&] {
+            const auto &[index, handle] = in_flight.front();
+            const blob *loaded          = handle.wait();
+            check(loaded && checksum(loaded->data) == assets.checksum_of(index), "every asset streams intact");
+            in_flight.pop_front();
+        };
+
+        const auto start = clock::now();
+        for (uint64_t i = 0; i < assets.count(); ++i) {
+            if (in_flight.size() >= window)
+                use_oldest();
+            in_flight.emplace_back(i, manager->load<blob>(asset_directory::name(i)));
+        }
+        while (!in_flight.empty()) {
+            use_oldest();
+        }
+        manager->wait_idle();
+        return {.seconds = seconds_since(start), .stats = manager->stats()};
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: resource_bench [--assets <count>] [--size <max KiB>] [--budget <MiB>] [--window "
+                         "<count>] [--threads <count>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--assets") {
+            options.assets = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 8);
+        } else if (arg == "--size") {
+            options.size = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--budget") {
+            options.budget = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--window") {
+            options.window = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--threads") {
+            options.threads = std::max<uint32_t>(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), 1);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::mt19937_64       rng(1);
+        const asset_directory assets(options.assets, options.size * 1024, rng);
+        const auto            jobs = std::make_shared<engine::job_system>(
+            engine::job_system::settings{.worker_count = std::max<uint32_t>(options.threads, 2) - 1}
+        );
+
+        check_sharing_and_errors(assets, jobs);
+        check_eviction(assets);
+        std::printf("sharing, error, eviction and LRU checks passed\n");
+
+        const size_t budget = options.budget << 20;
+        std::printf(
+            "%llu assets, %.1f MiB in %s\n", static_cast<unsigned long long>(assets.count()),
+            static_cast<double>(assets.total_bytes()) / (1 << 20), assets.root().string().c_str()
+        );
+        for (const bool threaded : {false, true}) {
+            const stream_result result = stream(assets, budget, options.window, threaded ? jobs : nullptr);
+            const size_t        bound  = budget + options.window * options.size * 1024;
+            check(result.stats.peak_resident_bytes <= bound, "residency stays within the budget plus held assets");
+            check(result.stats.loads_completed == assets.count(), "every asset is loaded once");
+
+            std::printf(
+                "%-10s %8.0f assets/s, %7.1f MiB/s, peak resident %6.1f MiB (budget %llu MiB), %llu evictions, peak "
+                "process memory %6.1f MiB\n",
+                threaded ? "job system" : "one thread", static_cast<double>(assets.count()) / result.seconds,
+                static_cast<double>(assets.total_bytes()) / (1 << 20) / result.seconds,
+                static_cast<double>(result.stats.peak_resident_bytes) / (1 << 20),
+                static_cast<unsigned long long>(options.budget),
+                static_cast<unsigned long long>(result.stats.evictions),
+                static_cast<double>(peak_process_bytes()) / (1 << 20)
+            );
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
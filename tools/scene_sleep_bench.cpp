@@ -0,0 +1,225 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures what a scene of mostly idle objects costs per update, with and without sleeping. Each object works for a
+// few updates, then idles for long enough that only a small fraction works at any time. Idle objects either sleep
+// (scene_object::sleep_for_frames) or stay in their update group and return early, as they had to before objects
+// could sleep. The last run keeps the same number of working objects in a scene a tenth of the size, and checks that
+// the cost follows the working objects rather than the total: the full scene may take at most 1.6 times as long per
+// update, which leaves room for its working objects being spread over ten times the memory.
+//
+//   scene_sleep_bench [--objects <count>] [--active <percent>] [--updates <count>]
+
+#include "engine/scene/scene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t objects = 1'000'000;
+        double   active  = 1.0; // percent
+        uint64_t updates = 600;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    struct schedule {
+        uint64_t work_updates = 10; // in a row, before idling again
+        uint64_t mean_idle    = 990;
+        uint64_t frame        = 0; // the current update, for objects that check it themselves
+    };
+
+    class worker : public engine::scene::scene_object {
+      public:
+        worker(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id, const schedule *schedule,
+               const bool sleeps)
+            : scene_object(scene, id), m_schedule(schedule), m_random(id * 0x9e3779b97f4a7c15ull + 1),
+              m_sleeps(sleeps) {
+            // starting part of the way through a cycle, so the scene starts out as idle as it stays
+            const uint64_t cycle = schedule->work_updates + schedule->mean_idle;
+            const uint64_t phase = _next() % cycle;
+            if (phase < schedule->work_updates) {
+                m_work_left = schedule->work_updates - phase;
+            } else {
+                m_work_left  = 0;
+                m_first_idle = cycle - phase;
+            }
+        }
+
+        void update(const double delta) override {
+            if (!m_sleeps && m_schedule->frame < m_idle_until)
+                return;
+
+            if (m_work_left == 0) {
+                _idle(m_first_idle);
+                return;
+            }
+            m_value = m_value * 0.999 + delta;
+            ++m_worked;
+            if (--m_work_left == 0)
+                _idle(m_schedule->mean_idle / 2 + _next() % (m_schedule->mean_idle + 1));
+        }
+
+        [[nodiscard]] inline double   value() const noexcept { return m_value; }
+        [[nodiscard]] inline uint64_t worked() const noexcept { return m_worked; }
+
+      private:
+        const schedule *m_schedule;
+        uint64_t        m_random;
+        uint64_t        m_idle_until = 0;
+        uint64_t        m_work_left  = 0;
+        uint64_t        m_first_idle = 0;
+        double          m_value      = 0.0;
+        uint64_t        m_worked     = 0; // updates it did its work in
+        bool            m_sleeps;
+
+        uint64_t _next() noexcept {
+            m_random ^= m_random << 13;
+            m_random ^= m_random >> 7;
+            m_random ^= m_random << 17;
+            return m_random;
+        }
+
+        void _idle(const uint64_t updates) {
+            m_work_left = m_schedule->work_updates;
+            if (m_sleeps) {
+                sleep_for_frames(updates);
+            } else {
+                m_idle_until = m_schedule->frame + updates + 1;
+            }
+        }
+    };
+
+    struct run_result {
+        double seconds_per_update;
+        double   awake;  // updated per update, on average
+        uint64_t worked; // updates objects did their work in, over the whole run
+    };
+
+    run_result run(const uint64_t objects, const double active, const uint64_t updates, const bool sleeps) {
+        schedule schedule;
+        schedule.mean_idle = static_cast<uint64_t>(
+            static_cast<double>(schedule.work_updates) * (100.0 - active) / active + 0.5
+        );
+
+        const auto scene = std::make_shared<engine::scene::scene>();
+        const auto group = scene->push_end_new_update_group();
+        scene->emplace_objects_ug<worker>(objects, group, &schedule, sleeps);
+
+        // long enough for the objects that start out idle to have gone to sleep
+        constexpr double   step   = 1.0 / 60.0;
+        constexpr uint64_t warmup = 2;
+        for (uint64_t i = 0; i < warmup; ++i) {
+            ++schedule.frame;
+            scene->update(step);
+        }
+
+        double   seconds = 0.0;
+        uint64_t awake   = 0;
+        for (uint64_t i = 0; i < updates; ++i) {
+            ++schedule.frame;
+            awake += group->awake_size();
+
+            const auto start = clock::now();
+            scene->update(step);
+            seconds += std::chrono::duration<double>(clock::now() - start).count();
+        }
+
+        uint64_t worked = 0;
+        for (const auto &type_run : group->on_update.runs()) {
+            for (const auto &object : type_run.objects) {
+                worked += static_cast<const worker &>(*object).worked();
+            }
+        }
+
+        return {
+            .seconds_per_update = seconds / static_cast<double>(updates),
+            .awake              = static_cast<double>(awake) / static_cast<double>(updates),
+            .worked             = worked,
+        };
+    }
+
+    void print(const char *label, const uint64_t objects, const run_result &result) {
+        std::printf(
+            "%-9s %8llu objects, %9.0f updated per update: %7.3f ms per update\n", label,
+            static_cast<unsigned long long>(objects), result.awake, result.seconds_per_update * 1e3
+        );
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: scene_sleep_bench [--objects <count>] [--active <percent>] [--updates <count>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--objects") {
+            options.objects = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--active") {
+            options.active = std::clamp(std::strtod(argv[++i], nullptr), 0.01, 100.0);
+        } else if (arg == "--updates") {
+            options.updates = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        const run_result polling = run(options.objects, options.active, options.updates, false);
+
+        // the same number of working objects in a tenth of the scene. Each sleeping scene keeps its fastest of a few
+        // runs, so a stall from elsewhere on the machine does not decide the check
+        const uint64_t smaller = std::max<uint64_t>(options.objects / 10, 1);
+        run_result     sleeping{.seconds_per_update = HUGE_VAL};
+        run_result     small{.seconds_per_update = HUGE_VAL};
+        const auto     faster = [](const run_result &a, const run_result &b) {
+            return a.seconds_per_update < b.seconds_per_update ? a : b;
+        };
+        for (int i = 0; i < 3; ++i) {
+            sleeping = faster(sleeping, run(options.objects, options.active, options.updates, true));
+            small    = faster(small, run(smaller, std::min(options.active * 10.0, 100.0), options.updates, true));
+        }
+
+        check(sleeping.worked == polling.worked, "sleeping objects work on the same updates as polling ones");
+        // too few working objects to time apart from the update's fixed costs
+        if (small.awake >= 1000.0) {
+            check(
+                std::abs(sleeping.awake - small.awake) <= small.awake * 0.1,
+                "the smaller scene updates as many objects per update"
+            );
+            check(
+                sleeping.seconds_per_update < small.seconds_per_update * 1.6,
+                "an update costs about as much as in a scene with as many awake objects and a tenth of the total"
+            );
+        }
+        std::printf("work and scale checks passed\n");
+
+        print("polling", options.objects, polling);
+        print("sleeping", options.objects, sleeping);
+        print("sleeping", smaller, small);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
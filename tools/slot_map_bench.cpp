@@ -0,0 +1,280 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Checks engine::slot_map against a std::map under random inserts and erases, checks that scene::emplace_object
+// returns the object it created even when that object's on_attach_to_scene adds and removes objects, then compares
+// insert, lookup and erase rates of the slot map with the std::map<uint64_t, ...> the scene used to keep its objects in.
+//
+//   slot_map_bench [--count <values>] [--seed <value>]
+
+#include "engine/scene/scene.hpp"
+#include "engine/slot_map.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t count = 1'000'000;
+        uint64_t seed  = 1;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    /**
+     * Random inserts and erases, with every live handle checked against a std::map after each step, and every erased
+     * handle checked to stay dead even once its slot is reused.
+     */
+    void check_against_map(std::mt19937_64 &rng) {
+        engine::slot_map<uint64_t>       map;
+        std::map<uint64_t, uint64_t>     reference; // by id
+        std::vector<engine::slot_handle> erased;
+
+        for (uint64_t step = 0; step < 200'000; ++step) {
+            if (reference.empty() || rng() % 3 != 0) {
+                const engine::slot_handle expected = map.next_handle();
+                const engine::slot_handle handle   = map.insert(step);
+                check(handle == expected, "next_handle predicts the handle insert returns");
+                check(!reference.contains(handle.to_id()), "a live handle is never handed out twice");
+                reference.emplace(handle.to_id(), step);
+            } else {
+                auto it = reference.begin();
+                std::advance(it, static_cast<ptrdiff_t>(rng() % std::min<size_t>(reference.size(), 64)));
+                const engine::slot_handle handle = engine::slot_handle::from_id(it->first);
+                check(map.erase(handle), "erasing a live handle succeeds");
+                check(!map.erase(handle), "erasing twice fails");
+                erased.push_back(handle);
+                reference.erase(it);
+            }
+
+            if (step % 1000 == 0) {
+                check(map.size() == reference.size(), "the size matches");
+                for (const auto &[id, value] : reference) {
+                    const uint64_t *found = map.get(engine::slot_handle::from_id(id));
+                    check(found && *found == value, "every live handle finds its value");
+                }
+                for (const engine::slot_handle &handle : erased) {
+                    check(!map.contains(handle) && !map.get(handle), "an erased handle stays dead");
+                }
+                erased.clear();
+
+                for (size_t i = 0; i < map.size(); ++i) {
+                    check(*map.get(map.handle_at(i)) == map.values()[i], "handle_at matches the dense values");
+                }
+            }
+        }
+    }
+
+    /**
+     * Placing a value past the end of the map adds the slots below it; they are handed out again before new ones.
+     */
+    void check_emplace_at() {
+        engine::slot_map<uint64_t> map;
+        map.emplace_at({.index = 5, .generation = 3}, 5);
+        map.emplace_at({.index = 2, .generation = 1}, 2);
+        check(map.free_slots().size() == 4, "emplace_at frees the slots it adds below the handle");
+
+        for (const uint32_t index : {0u, 1u, 3u, 4u}) {
+            check(map.next_handle().index == index, "the added slots are reused lowest first");
+            check(map.insert(index).index == index, "insert takes the slot next_handle predicts");
+        }
+        check(map.slot_count() == 6 && map.free_slots().empty(), "no slot is left behind");
+        check(map.next_handle().index == 6, "and only then does the map grow");
+    }
+
+    /**
+     * Adds and removes other objects from on_attach_to_scene, so the scene's object storage reallocates and swaps
+     * values while the object is being created.
+     */
+    class spawning_object : public engine::scene::scene_object {
+      public:
+        spawning_object(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id, const int children)
+            : scene_object(scene, id), m_children(children) {}
+
+        [[nodiscard]] inline int children() const noexcept { return m_children; }
+
+      protected:
+        void on_attach_to_scene() override {
+            const auto scene = get_scene().lock();
+            std::vector<uint64_t> spawned;
+            for (int i = 0; i < m_children; ++i) {
+                spawned.push_back(scene->emplace_object<spawning_object>(0).first);
+            }
+            // removing every other one swaps later objects into the holes
+            for (size_t i = 0; i < spawned.size(); i += 2) {
+                scene->remove_object(spawned[i]);
+            }
+        }
+
+      private:
+        int m_children;
+    };
+
+    void check_scene_spawning() {
+        const auto scene = std::make_shared<engine::scene::scene>();
+        for (int i = 0; i < 100; ++i) {
+            scene->emplace_object<spawning_object>(0);
+        }
+
+        for (const int children : {1, 10, 1000}) {
+            const auto [id, object] = scene->emplace_object<spawning_object>(children);
+            check(object && object->get_id() == id, "emplace_object returns the object it created");
+            check(static_cast<const spawning_object &>(*object).children() == children, "and not another one");
+            check(scene->get_scene_object(id) == object, "the object is in the scene under its id");
+
+            const auto [named_id, named] = scene->emplace_object_named<spawning_object>("spawner", children);
+            check(named && named->get_id() == named_id, "emplace_object_named returns the object it created");
+            check(scene->get_scene_object("spawner") == named, "the name finds the object it created");
+        }
+    }
+
+    struct rates {
+        double insert;
+        double lookup;
+        double erase;
+    };
+
+    /**
+     * Values are made up front so only the containers are timed; lookups and erases go in a random order.
+     */
+    rates measure_slot_map(const uint64_t count, std::mt19937_64 &rng) {
+        std::vector<std::shared_ptr<uint64_t>> values;
+        values.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            values.push_back(std::make_shared<uint64_t>(i));
+        }
+
+        engine::slot_map<std::shared_ptr<uint64_t>> map;
+        std::vector<uint64_t>                       ids;
+        ids.reserve(count);
+
+        auto start = clock::now();
+        for (auto &value : values) {
+            ids.push_back(map.insert(std::move(value)).to_id());
+        }
+        const double insert = seconds_since(start);
+
+        std::shuffle(ids.begin(), ids.end(), rng);
+        uint64_t sum = 0;
+        start        = clock::now();
+        for (const uint64_t id : ids) {
+            sum += **map.get(engine::slot_handle::from_id(id));
+        }
+        const double lookup = seconds_since(start);
+        check(sum == count * (count - 1) / 2, "slot_map lookups find every value");
+
+        start = clock::now();
+        for (const uint64_t id : ids) {
+            map.erase(engine::slot_handle::from_id(id));
+        }
+        const double erase = seconds_since(start);
+        check(map.empty(), "slot_map erases every value");
+
+        const double n = static_cast<double>(count);
+        return {.insert = n / insert, .lookup = n / lookup, .erase = n / erase};
+    }
+
+    rates measure_std_map(const uint64_t count, std::mt19937_64 &rng) {
+        std::vector<std::shared_ptr<uint64_t>> values;
+        values.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            values.push_back(std::make_shared<uint64_t>(i));
+        }
+
+        // as the scene did: ids from a counter, never reused
+        std::map<uint64_t, std::shared_ptr<uint64_t>> map;
+        std::vector<uint64_t>                         ids;
+        ids.reserve(count);
+        uint64_t last_id = 0;
+
+        auto start = clock::now();
+        for (auto &value : values) {
+            map.emplace(++last_id, std::move(value));
+            ids.push_back(last_id);
+        }
+        const double insert = seconds_since(start);
+
+        std::shuffle(ids.begin(), ids.end(), rng);
+        uint64_t sum = 0;
+        start        = clock::now();
+        for (const uint64_t id : ids) {
+            sum += *map.find(id)->second;
+        }
+        const double lookup = seconds_since(start);
+        check(sum == count * (count - 1) / 2, "std::map lookups find every value");
+
+        start = clock::now();
+        for (const uint64_t id : ids) {
+            map.erase(id);
+        }
+        const double erase = seconds_since(start);
+
+        const double n = static_cast<double>(count);
+        return {.insert = n / insert, .lookup = n / lookup, .erase = n / erase};
+    }
+
+    void print(const char *label, const uint64_t count, const rates &rates) {
+        std::printf(
+            "%-9s %9llu values: %7.1f M inserts/s, %7.1f M lookups/s, %7.1f M erases/s\n", label,
+            static_cast<unsigned long long>(count), rates.insert / 1e6, rates.lookup / 1e6, rates.erase / 1e6
+        );
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: slot_map_bench [--count <values>] [--seed <value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--count") {
+            options.count = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::mt19937_64 rng(options.seed);
+        check_against_map(rng);
+        check_emplace_at();
+        check_scene_spawning();
+        std::printf("slot_map and scene object creation checks passed\n");
+
+        for (const uint64_t count : {std::min<uint64_t>(options.count, 10'000), options.count}) {
+            print("slot_map", count, measure_slot_map(count, rng));
+            print("std::map", count, measure_std_map(count, rng));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,415 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Compares loading a large scene from a binary snapshot (validated and read in place from a memory mapping) with a
+// naive loader that reads the same scene field by field from an std::ifstream and creates each object as it goes. The
+// scene has named objects, a hierarchy, local transforms, per-object state and two update groups in two phases.
+// Checks that a saved and loaded scene matches the original (state, names, parents, transforms and group membership)
+// and that a snapshot which names a missing phase, or whose load_state throws, leaves the scene it was loaded into as
+// it was.
+//
+//   snapshot_bench [--objects <count>] [--dir <directory>]
+
+#include "engine/scene/snapshot.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t              objects = 1'000'000;
+        std::filesystem::path dir     = std::filesystem::temp_directory_path() / "engine_snapshot_bench";
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    // every phase the benchmark's scenes have, in order
+    constexpr std::string_view phase_names[] = {"update", "late"};
+
+    // the key to load_state throwing, so a load can be made to fail part way through
+    uint64_t g_failing_key = UINT64_MAX;
+
+    /**
+     * Saves a key that identifies it across a save and a load, and a little state besides.
+     */
+    class keyed_object final : public engine::scene::scene_object {
+      public:
+        keyed_object(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id) : scene_object(scene, id) {}
+
+        uint64_t key    = 0;
+        float    health = 0.0f;
+
+        void save_state(engine::scene::snapshot_writer &out) const override {
+            out.write(key);
+            out.write(health);
+        }
+
+        void load_state(engine::scene::snapshot_reader &in) override {
+            key    = in.read<uint64_t>();
+            health = in.read<float>();
+            if (key == g_failing_key)
+                throw std::runtime_error("load_state failed");
+        }
+    };
+
+    glm::mat4 local_of(const uint64_t key) {
+        const auto x = static_cast<float>(key % 101);
+        return glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.5f, -static_cast<float>(key)));
+    }
+
+    std::string name_of(const uint64_t key) {
+        return "object_" + std::to_string(key);
+    }
+
+    /**
+     * count objects, each tenth a root and the rest children of the object before them, every hundredth named. Even
+     * keys update in the default phase, odd keys in a "late" phase, when one is given.
+     */
+    std::shared_ptr<engine::scene::scene> make_scene(const uint64_t count, const bool late_phase) {
+        auto scene = std::make_shared<engine::scene::scene>();
+
+        const auto early = scene->push_end_new_update_group();
+        std::shared_ptr<engine::scene::update_group> late;
+        if (late_phase) {
+            late = scene->add_phase(engine::scene::phase_desc{.name = "late", .after = {"update"}})
+                       ->push_end_new_update_group();
+            late->parallel = true;
+        }
+
+        std::shared_ptr<keyed_object> previous;
+        for (uint64_t key = 0; key < count; ++key) {
+            const auto object = std::static_pointer_cast<keyed_object>(scene->emplace_object<keyed_object>().second);
+            object->key       = key;
+            object->health    = static_cast<float>(key) * 0.25f;
+            object->set_local_transform(local_of(key));
+            if (key % 10 != 0)
+                object->set_parent(previous);
+            if (key % 100 == 0)
+                scene->rename_object(object->get_id(), name_of(key));
+
+            if (key % 2 == 0 || !late) {
+                early->insert(object);
+            } else {
+                late->insert(object);
+            }
+            previous = object;
+        }
+        return scene;
+    }
+
+    size_t group_count(const engine::scene::scene &scene) {
+        size_t count = 0;
+        for (const std::string_view name : phase_names) {
+            if (const auto phase = scene.get_phase(name))
+                count += phase->update_groups().size();
+        }
+        return count;
+    }
+
+    /**
+     * Checks that loaded holds exactly what original does, matching objects by key.
+     */
+    void check_same(const engine::scene::scene &original, const engine::scene::scene &loaded) {
+        check(loaded.get_scene_objects().size() == original.get_scene_objects().size(), "every object is loaded");
+
+        std::unordered_map<uint64_t, const keyed_object *> by_key;
+        for (const auto &object : loaded.get_scene_objects()) {
+            const auto &keyed = static_cast<const keyed_object &>(*object);
+            check(by_key.emplace(keyed.key, &keyed).second, "keys are loaded once each");
+        }
+
+        for (const auto &object : original.get_scene_objects()) {
+            const auto &expected = static_cast<const keyed_object &>(*object);
+            const auto  it       = by_key.find(expected.key);
+            check(it != by_key.end(), "each object is loaded");
+            const keyed_object &actual = *it->second;
+
+            check(actual.health == expected.health, "state round-trips");
+            check(actual.get_name() == expected.get_name(), "names round-trip");
+            const glm::mat4 a = actual.get_local_transform(), b = expected.get_local_transform();
+            check(std::memcmp(&a, &b, sizeof(a)) == 0, "local transforms round-trip");
+
+            const auto parent          = actual.get_parent();
+            const auto expected_parent = expected.get_parent();
+            check((parent == nullptr) == (expected_parent == nullptr), "roots stay roots");
+            check(
+                !parent || static_cast<const keyed_object &>(*parent).key ==
+                               static_cast<const keyed_object &>(*expected_parent).key,
+                "parents round-trip"
+            );
+        }
+
+        for (const std::string_view name : phase_names) {
+            const auto phase = original.get_phase(name);
+            if (!phase)
+                continue;
+            const auto &expected = phase->update_groups();
+            const auto &actual   = loaded.get_phase(name)->update_groups();
+            check(actual.size() == expected.size(), "each phase gets its groups");
+            for (auto a = actual.begin(), e = expected.begin(); a != actual.end(); ++a, ++e) {
+                check((*a)->size() == (*e)->size(), "groups keep their members");
+                check((*a)->parallel == (*e)->parallel, "and their settings");
+            }
+        }
+
+        for (uint64_t key = 0; key < original.get_scene_objects().size(); key += 100) {
+            const auto named = loaded.get_scene_object(name_of(key));
+            check(named && static_cast<const keyed_object &>(*named).key == key, "names are indexed after loading");
+        }
+    }
+
+    void check_round_trip(const std::filesystem::path &dir) {
+        const auto original = make_scene(5000, true);
+        const auto path     = dir / "round_trip.snapshot";
+        engine::scene::scene_snapshot::save(*original, path);
+
+        const auto loaded = std::make_shared<engine::scene::scene>();
+        loaded->add_phase(engine::scene::phase_desc{.name = "late", .after = {"update"}});
+        engine::scene::scene_snapshot::load(*loaded, path);
+        check_same(*original, *loaded);
+
+        // and again, from the loaded scene
+        const auto again = std::make_shared<engine::scene::scene>();
+        again->add_phase(engine::scene::phase_desc{.name = "late", .after = {"update"}});
+        engine::scene::scene_snapshot::load(*again, engine::scene::scene_snapshot::encode(*loaded));
+        check_same(*original, *again);
+    }
+
+    void check_failed_loads() {
+        const auto source = make_scene(1000, true);
+        const auto data   = engine::scene::scene_snapshot::encode(*source);
+
+        // a scene with something in it already, which a failed load must leave alone
+        const auto target           = make_scene(10, false);
+        const auto objects          = target->get_scene_objects().size();
+        const auto groups           = group_count(*target);
+        const auto first            = target->get_scene_object(name_of(0)); // a name the snapshot uses too
+        const auto expect_unchanged = [&](const char *what) {
+            check(target->get_scene_objects().size() == objects, what);
+            check(group_count(*target) == groups, "and no update group is added");
+            check(target->get_scene_object(name_of(0)) == first, "and a name the load took is given back");
+            check(!target->has_scene_object(name_of(500)), "and none of the snapshot's names are left");
+        };
+
+        bool threw = false;
+        try {
+            engine::scene::scene_snapshot::load(*target, data);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        check(threw, "a snapshot naming a missing phase does not load");
+        expect_unchanged("a snapshot naming a missing phase adds no objects");
+
+        target->add_phase(engine::scene::phase_desc{.name = "late", .after = {"update"}});
+        g_failing_key = 777;
+        threw         = false;
+        try {
+            engine::scene::scene_snapshot::load(*target, data);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        g_failing_key = UINT64_MAX;
+        check(threw, "a throwing load_state fails the load");
+        expect_unchanged("a load whose load_state throws removes what it created");
+
+        engine::scene::scene_snapshot::load(*target, data);
+        check(target->get_scene_objects().size() == objects + 1000, "the same snapshot loads once the cause is gone");
+    }
+
+    /**
+     * How a scene might be saved without a snapshot format: each object's fields written one at a time to a stream.
+     */
+    void save_naive(const engine::scene::scene &scene, const std::filesystem::path &path) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        const auto    write = [&]<typename T>(const T &value) {
+            out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        };
+        const auto write_string = [&](const std::string_view str) {
+            write(static_cast<uint32_t>(str.size()));
+            out.write(str.data(), static_cast<std::streamsize>(str.size()));
+        };
+
+        const auto objects = scene.get_scene_objects();
+        std::unordered_map<const engine::scene::scene_object *, uint32_t> index_of;
+        write(static_cast<uint64_t>(objects.size()));
+        for (const auto &object : objects) {
+            index_of.emplace(object.get(), static_cast<uint32_t>(index_of.size()));
+            const auto parent = object->get_parent();
+            write(parent ? index_of.at(parent.get()) : UINT32_MAX);
+            write(object->get_local_transform());
+            write_string(object->get_name());
+
+            std::vector<std::byte> state;
+            engine::scene::snapshot_writer writer(state);
+            object->save_state(writer);
+            write(static_cast<uint32_t>(state.size()));
+            out.write(reinterpret_cast<const char *>(state.data()), static_cast<std::streamsize>(state.size()));
+        }
+
+        for (const std::string_view name : phase_names) {
+            const auto phase = scene.get_phase(name);
+            if (!phase)
+                continue;
+            for (const auto &group : phase->update_groups()) {
+                write_string(name);
+                write(group->parallel);
+                write(static_cast<uint64_t>(group->size()));
+                for (const auto &run : group->on_update.runs()) {
+                    for (const auto &object : run.objects) {
+                        write(index_of.at(object.get()));
+                    }
+                }
+            }
+        }
+        check(static_cast<bool>(out), "the naive save is written");
+    }
+
+    void load_naive(engine::scene::scene &scene, const std::filesystem::path &path) {
+        std::ifstream in(path, std::ios::binary);
+        const auto    read = [&]<typename T>(T &value) { in.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+        const auto    read_string = [&] {
+            uint32_t size = 0;
+            read(size);
+            std::string str(size, '\0');
+            in.read(str.data(), size);
+            return str;
+        };
+
+        uint64_t count = 0;
+        read(count);
+        std::vector<std::shared_ptr<keyed_object>> created;
+        std::vector<std::byte>                     state;
+        for (uint64_t i = 0; i < count; ++i) {
+            const auto object = std::static_pointer_cast<keyed_object>(scene.emplace_object<keyed_object>().second);
+
+            uint32_t parent = 0;
+            read(parent);
+            if (parent != UINT32_MAX)
+                object->set_parent(created.at(parent));
+
+            glm::mat4 local;
+            read(local);
+            object->set_local_transform(local);
+
+            if (const std::string name = read_string(); !name.empty())
+                scene.rename_object(object->get_id(), name);
+
+            uint32_t size = 0;
+            read(size);
+            state.resize(size);
+            in.read(reinterpret_cast<char *>(state.data()), size);
+            engine::scene::snapshot_reader reader(state, 1);
+            object->load_state(reader);
+
+            created.push_back(object);
+        }
+
+        for (std::string phase_name = read_string(); in; phase_name = read_string()) {
+            const auto group = scene.get_phase(phase_name)->push_end_new_update_group();
+            read(group->parallel);
+            uint64_t members = 0;
+            read(members);
+            for (uint64_t i = 0; i < members; ++i) {
+                uint32_t member = 0;
+                read(member);
+                group->insert(created.at(member));
+            }
+        }
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: snapshot_bench [--objects <count>] [--dir <directory>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--objects") {
+            options.objects = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--dir") {
+            options.dir = argv[++i];
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::filesystem::create_directories(options.dir);
+        engine::scene::snapshot_types::get().add_object_type<keyed_object>("keyed_object");
+
+        check_round_trip(options.dir);
+        check_failed_loads();
+        std::printf("round trip and failed load checks passed\n");
+
+        const auto original = make_scene(options.objects, true);
+
+        const auto snapshot_path = options.dir / "bench.snapshot";
+        auto       start         = clock::now();
+        engine::scene::scene_snapshot::save(*original, snapshot_path);
+        const double save_seconds = seconds_since(start);
+
+        const auto naive_path = options.dir / "bench.naive";
+        start                 = clock::now();
+        save_naive(*original, naive_path);
+        const double naive_save_seconds = seconds_since(start);
+
+        const auto loaded = std::make_shared<engine::scene::scene>();
+        loaded->add_phase(engine::scene::phase_desc{.name = "late", .after = {"update"}});
+        start = clock::now();
+        engine::scene::scene_snapshot::load(*loaded, snapshot_path);
+        const double load_seconds = seconds_since(start);
+        check_same(*original, *loaded);
+
+        const auto naive = std::make_shared<engine::scene::scene>();
+        naive->add_phase(engine::scene::phase_desc{.name = "late", .after = {"update"}});
+        start = clock::now();
+        load_naive(*naive, naive_path);
+        const double naive_load_seconds = seconds_since(start);
+        check_same(*original, *naive);
+
+        const auto snapshot_size = std::filesystem::file_size(snapshot_path);
+        const auto naive_size    = std::filesystem::file_size(naive_path);
+        std::filesystem::remove_all(options.dir);
+
+        std::printf(
+            "%llu objects: snapshot %.1f MB, save %7.1f ms, load %7.1f ms; naive stream %.1f MB, save %7.1f ms, "
+            "load %7.1f ms (%.2fx the snapshot's load time)\n",
+            static_cast<unsigned long long>(options.objects), static_cast<double>(snapshot_size) / 1e6,
+            save_seconds * 1e3, load_seconds * 1e3, static_cast<double>(naive_size) / 1e6, naive_save_seconds * 1e3,
+            naive_load_seconds * 1e3, naive_load_seconds / load_seconds
+        );
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,282 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures a scene's spatial index with 100k objects that all move every update: inserting their bounds, the cost the
+// index adds to an update (the same scene updated without bounds is subtracted), and box queries against a brute force
+// scan of every object. Checks that queries find exactly the objects a scan finds after the objects have moved, and
+// that bounds set from a parallel update group are recorded and applied at the sync point rather than while the group
+// runs.
+//
+//   spatial_bench [--objects <count>] [--updates <count>] [--queries <count>] [--threads <count>] [--seed <value>]
+
+#include "engine/jobs.hpp"
+#include "engine/scene/scene.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t objects = 100'000;
+        uint64_t updates = 60;
+        uint64_t queries = 2000;
+        uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        uint64_t seed    = 1;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    constexpr double          step = 1.0 / 60.0;
+    const engine::scene::aabb unit_box{glm::vec3(-0.5f), glm::vec3(0.5f)};
+
+    /**
+     * Drifts at a constant velocity, a few units a second.
+     */
+    class mover final : public engine::scene::scene_object {
+      public:
+        mover(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id) : scene_object(scene, id) {}
+
+        glm::vec3 position{0.0f};
+        glm::vec3 velocity{0.0f};
+
+        void update(const double delta) override {
+            position += velocity * static_cast<float>(delta);
+            set_local_transform(glm::translate(glm::mat4(1.0f), position));
+        }
+    };
+
+    /**
+     * Sets its own bounds from its update, which runs in a parallel group.
+     */
+    class grower final : public engine::scene::scene_object {
+      public:
+        grower(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id, const engine::scene::aabb *box,
+               std::atomic<uint64_t> *seen_early)
+            : scene_object(scene, id), m_box(box), m_seen_early(seen_early) {}
+
+        void update(double) override {
+            set_bounds(*m_box);
+
+            // the index is only read here, which any number of threads may do at once
+            std::vector<uint64_t> found;
+            if (const auto s = get_scene().lock())
+                s->spatial().query_aabb(*m_box, found);
+            if (std::ranges::find(found, get_id()) != found.end())
+                m_seen_early->fetch_add(1, std::memory_order_relaxed);
+        }
+
+      private:
+        const engine::scene::aabb *m_box;
+        std::atomic<uint64_t>     *m_seen_early;
+    };
+
+    struct world {
+        std::shared_ptr<engine::scene::scene> scene;
+        std::vector<uint64_t>                 ids;
+        float                                 extent; // objects start in [0, extent) on every axis
+    };
+
+    world make_world(const uint64_t count, const uint64_t seed) {
+        world world{std::make_shared<engine::scene::scene>(), {}, 4.0f * std::cbrt(static_cast<float>(count))};
+        const auto group = world.scene->push_end_new_update_group();
+
+        std::mt19937_64                       rng(seed);
+        std::uniform_real_distribution<float> place(0.0f, world.extent);
+        std::uniform_real_distribution<float> speed(-5.0f, 5.0f);
+        for (const auto &[id, object] : world.scene->emplace_objects_ug<mover>(count, group)) {
+            auto &m    = static_cast<mover &>(*object);
+            m.position = glm::vec3(place(rng), place(rng), place(rng));
+            m.velocity = glm::vec3(speed(rng), speed(rng), speed(rng));
+            m.set_local_transform(glm::translate(glm::mat4(1.0f), m.position));
+            world.ids.push_back(id);
+        }
+        // world transforms, so bounds are inserted where the objects are
+        world.scene->update(0.0);
+        return world;
+    }
+
+    std::vector<engine::scene::aabb> random_boxes(const world &world, const uint64_t count, std::mt19937_64 &rng) {
+        std::uniform_real_distribution<float> place(0.0f, world.extent);
+        std::uniform_real_distribution<float> size(1.0f, 8.0f);
+        std::vector<engine::scene::aabb>      boxes;
+        boxes.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            const glm::vec3 min(place(rng), place(rng), place(rng));
+            boxes.push_back({min, min + glm::vec3(size(rng), size(rng), size(rng))});
+        }
+        return boxes;
+    }
+
+    /**
+     * The ids of every object whose world box overlaps the query box, by looking at each of them.
+     */
+    void scan(const world &world, const engine::scene::aabb &box, std::vector<uint64_t> &out) {
+        for (const uint64_t id : world.ids) {
+            const auto object = world.scene->get_scene_object(id);
+            if (unit_box.transformed(object->get_world_transform()).overlaps(box))
+                out.push_back(id);
+        }
+    }
+
+    void check_queries(const world &world, std::mt19937_64 &rng) {
+        std::vector<uint64_t> found;
+        std::vector<uint64_t> expected;
+        uint64_t              hits = 0;
+        for (const auto &box : random_boxes(world, 50, rng)) {
+            found.clear();
+            expected.clear();
+            world.scene->spatial().query_aabb(box, found);
+            scan(world, box, expected);
+            std::ranges::sort(found);
+            std::ranges::sort(expected);
+            check(found == expected, "queries find exactly the objects a scan finds");
+            hits += found.size();
+        }
+        check(hits > 0, "some queries find objects");
+    }
+
+    void check_parallel_bounds(const uint32_t threads) {
+        constexpr uint64_t count = 4000;
+
+        const auto scene = std::make_shared<engine::scene::scene>();
+        scene->set_job_system(std::make_shared<engine::job_system>(
+            engine::job_system::settings{.worker_count = std::max(threads, 2u) - 1}
+        ));
+        const auto group  = scene->push_end_new_update_group();
+        group->parallel   = true;
+        group->chunk_size = 64;
+
+        const engine::scene::aabb box{glm::vec3(1000.0f), glm::vec3(1001.0f)};
+        std::atomic<uint64_t>     seen_early = 0;
+        scene->emplace_objects_ug<grower>(count, group, &box, &seen_early);
+
+        scene->update(step);
+        check(seen_early == 0, "bounds set from a parallel group are not applied while it runs");
+        check(scene->spatial().size() == count, "bounds set from a parallel group are applied at the sync point");
+
+        std::vector<uint64_t> found;
+        scene->spatial().query_aabb(box, found);
+        check(found.size() == count, "and are placed where the objects are");
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: spatial_bench [--objects <count>] [--updates <count>] [--queries <count>] "
+                         "[--threads <count>] [--seed <value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--objects") {
+            options.objects = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--updates") {
+            options.updates = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--queries") {
+            options.queries = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--threads") {
+            options.threads = std::max(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), 1u);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::mt19937_64 rng(options.seed);
+        check_parallel_bounds(options.threads);
+
+        const world bounded   = make_world(options.objects, options.seed);
+        const world unbounded = make_world(options.objects, options.seed);
+
+        auto start = clock::now();
+        for (const uint64_t id : bounded.ids) {
+            bounded.scene->set_object_bounds(id, unit_box);
+        }
+        const double insert_seconds = seconds_since(start);
+        check(bounded.scene->spatial().size() == options.objects, "every object is in the index");
+        check_queries(bounded, rng);
+
+        double with_bounds    = 0.0;
+        double without_bounds = 0.0;
+        for (uint64_t i = 0; i < options.updates; ++i) {
+            start = clock::now();
+            bounded.scene->update(step);
+            with_bounds += seconds_since(start);
+
+            start = clock::now();
+            unbounded.scene->update(step);
+            without_bounds += seconds_since(start);
+        }
+        check_queries(bounded, rng);
+        std::printf("query and parallel bounds checks passed\n");
+
+        const auto            boxes = random_boxes(bounded, options.queries, rng);
+        std::vector<uint64_t> found;
+        uint64_t              hits = 0;
+        start                      = clock::now();
+        for (const auto &box : boxes) {
+            found.clear();
+            bounded.scene->spatial().query_aabb(box, found);
+            hits += found.size();
+        }
+        const double query_seconds = seconds_since(start);
+
+        // a scan is slow enough that a few queries give its cost
+        const uint64_t scans = std::min<uint64_t>(options.queries, 20);
+        start                = clock::now();
+        for (uint64_t i = 0; i < scans; ++i) {
+            found.clear();
+            scan(bounded, boxes[i], found);
+        }
+        const double scan_seconds = seconds_since(start);
+
+        const double n = static_cast<double>(options.objects);
+        const double u = static_cast<double>(options.updates);
+        const double q = static_cast<double>(options.queries);
+        std::printf(
+            "%llu moving objects: insert %.1f ms (%.0f ns each); update %.3f ms with bounds, %.3f ms without, index "
+            "%.3f ms (%.0f ns per object)\n",
+            static_cast<unsigned long long>(options.objects), insert_seconds * 1e3, insert_seconds / n * 1e9,
+            with_bounds / u * 1e3, without_bounds / u * 1e3, (with_bounds - without_bounds) / u * 1e3,
+            (with_bounds - without_bounds) / u / n * 1e9
+        );
+        std::printf(
+            "box query: %.2f us, %.1f objects found on average; scan of every object %.2f ms\n",
+            query_seconds / q * 1e6, static_cast<double>(hits) / q, scan_seconds / static_cast<double>(scans) * 1e3
+        );
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,424 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures scene object spawning and despawning through the per-type pools, against allocating each object the way
+// scene_object::create did before (std::shared_ptr<T>(new T), an object and a control block per call). Heap
+// allocations are counted by replacing the global operator new. Reports spawn and despawn rates and heap allocations
+// per object for the allocation alone, then through the scene one at a time and in bulk (which adds its slot map,
+// transforms, names and update groups), then heap allocations per frame for a scene that spawns and despawns a batch
+// of objects every frame while its objects use the frame arena. Checks that pools hand freed blocks back out, that
+// bulk spawn and despawn create and destroy every object, that every thread's frame arena is emptied by every update,
+// and that the churning scene allocates nothing once it has grown.
+//
+//   spawn_bench [--count <objects>] [--frames <count>] [--churn <objects per frame>]
+
+#include "engine/memory.hpp"
+#include "engine/scene/scene.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::atomic<uint64_t> heap_allocations = 0;
+
+    void *counted_allocate(const size_t size, const size_t alignment) noexcept {
+        heap_allocations.fetch_add(1, std::memory_order_relaxed);
+        if (alignment <= alignof(std::max_align_t))
+            return std::malloc(std::max<size_t>(size, 1));
+        return std::aligned_alloc(alignment, (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment);
+    }
+
+    void *counted_allocate_or_throw(const size_t size, const size_t alignment) {
+        if (void *ptr = counted_allocate(size, alignment))
+            return ptr;
+        throw std::bad_alloc();
+    }
+} // namespace
+
+// every form is replaced, so each allocation is counted and every pointer is released by the matching free
+void *operator new(const size_t size) { return counted_allocate_or_throw(size, alignof(std::max_align_t)); }
+void *operator new[](const size_t size) { return counted_allocate_or_throw(size, alignof(std::max_align_t)); }
+void *operator new(const size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+void *operator new[](const size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+void *operator new(const size_t size, const std::align_val_t alignment) {
+    return counted_allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+void *operator new[](const size_t size, const std::align_val_t alignment) {
+    return counted_allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+void *operator new(const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, static_cast<size_t>(alignment));
+}
+void *operator new[](const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t count  = 100'000;
+        uint64_t frames = 200;
+        uint64_t churn  = 1000;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    std::atomic<int64_t> live_objects = 0;
+
+    /**
+     * Counts live instances, and takes a little scratch space from the frame arena on every update.
+     */
+    class particle final : public engine::scene::scene_object {
+      public:
+        particle(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id)
+            : scene_object(scene, id), m_seed(static_cast<float>(id % 1000)) {
+            ++live_objects;
+        }
+
+        ~particle() override { --live_objects; }
+
+        void update(const double delta) override {
+            float *scratch = get_scene().lock()->get_frame_arena().allocate_array<float>(4);
+            for (int i = 0; i < 4; ++i) {
+                scratch[i] = m_seed * static_cast<float>(delta) + static_cast<float>(i);
+            }
+            m_seed = scratch[3];
+        }
+
+      private:
+        float m_seed;
+    };
+
+    void check_pool_resource() {
+        engine::pool_resource pool(64);
+        std::vector<void *>   blocks;
+        for (int i = 0; i < 1000; ++i) {
+            blocks.push_back(pool.allocate(48, 8));
+        }
+        check(pool.live_blocks() == 1000, "the pool counts live blocks");
+
+        const size_t chunks = pool.chunk_allocations();
+        for (void *block : blocks) {
+            pool.deallocate(block, 48, 8);
+        }
+        check(pool.live_blocks() == 0, "freed blocks are returned");
+
+        for (auto &block : blocks) {
+            block = pool.allocate(48, 8);
+        }
+        check(pool.chunk_allocations() == chunks, "freed blocks are handed out again before new chunks");
+        for (void *block : blocks) {
+            pool.deallocate(block, 48, 8);
+        }
+    }
+
+    void check_bulk_spawn() {
+        const auto scene = std::make_shared<engine::scene::scene>();
+        const auto group = scene->push_end_new_update_group();
+
+        std::vector<uint64_t> ids;
+        {
+            const auto objects = scene->emplace_objects_ug<particle>(10'000, group);
+            check(objects.size() == 10'000 && live_objects == 10'000, "emplace_objects spawns count objects");
+            for (const auto &[id, object] : objects) {
+                check(object && object->get_id() == id, "each pair holds the object created under its id");
+                check(scene->get_scene_object(id) == object, "each object is in the scene");
+                ids.push_back(id);
+            }
+            std::ranges::sort(ids);
+            check(std::ranges::adjacent_find(ids) == ids.end(), "every object gets its own id");
+        }
+
+        // the arena is reset as each update starts, so it only ever holds one frame's scratch space
+        scene->update(1.0 / 60.0);
+        const size_t frame_bytes = scene->get_frame_arena().bytes_used();
+        check(frame_bytes >= 10'000 * 4 * sizeof(float), "updates allocate from the frame arena");
+        for (int frame = 0; frame < 3; ++frame) {
+            scene->update(1.0 / 60.0);
+            check(scene->get_frame_arena().bytes_used() == frame_bytes, "the frame arena is emptied by every update");
+        }
+        check(scene->get_frame_arena().peak_bytes_used() == frame_bytes, "and never holds two frames at once");
+
+        // objects updated on other threads get arenas of their own, which every update empties as well
+        engine::frame_arena *worker_arena = nullptr;
+        std::thread([&] {
+            worker_arena = &scene->get_frame_arena();
+            static_cast<void>(worker_arena->allocate_array<float>(16));
+        }).join();
+        check(worker_arena != &scene->get_frame_arena(), "each thread gets its own frame arena");
+        scene->update(1.0 / 60.0);
+        check(worker_arena->bytes_used() == 0, "and every update empties every thread's arena");
+
+        check(scene->remove_objects(ids) == ids.size(), "remove_objects removes every object");
+        check(live_objects == 0, "despawned objects are destroyed");
+        check(group->size() == 0, "and leave their update groups");
+        check(scene->remove_objects(ids) == 0, "removing them again does nothing");
+    }
+
+    struct spawn_result {
+        double spawn_rate;
+        double despawn_rate;
+        double spawn_allocations; // per object
+    };
+
+    /**
+     * Objects as scene_object::create used to make them, held in a vector as the scene held them in a map.
+     */
+    spawn_result measure_heap(const uint64_t count) {
+        std::vector<std::shared_ptr<engine::scene::scene_object>> objects;
+        objects.reserve(count);
+
+        const uint64_t allocations = heap_allocations.load();
+        auto           start       = clock::now();
+        for (uint64_t i = 0; i < count; ++i) {
+            objects.push_back(std::shared_ptr<particle>(new particle({}, i)));
+        }
+        const double   spawn           = seconds_since(start);
+        const uint64_t spawned_objects = heap_allocations.load() - allocations;
+
+        start = clock::now();
+        objects.clear();
+        const double despawn = seconds_since(start);
+        check(live_objects == 0, "heap objects are destroyed");
+
+        const double n = static_cast<double>(count);
+        return {.spawn_rate = n / spawn, .despawn_rate = n / despawn, .spawn_allocations = spawned_objects / n};
+    }
+
+    /**
+     * The same objects from a pool as scene_object::create makes them, without a scene: what measure_heap measures, so
+     * the two compare the allocation alone. The second round is reported, as in measure_scene.
+     */
+    spawn_result measure_pooled(const uint64_t count) {
+        const auto                                pool = std::make_shared<engine::pool_resource>();
+        const engine::pool_allocator<particle>    allocator(pool);
+        const std::weak_ptr<engine::scene::scene> no_scene;
+        spawn_result                              result{};
+
+        std::vector<std::shared_ptr<engine::scene::scene_object>> objects;
+        objects.reserve(count);
+        for (int round = 0; round < 2; ++round) {
+            const uint64_t allocations = heap_allocations.load();
+            auto           start       = clock::now();
+            for (uint64_t i = 0; i < count; ++i) {
+                objects.push_back(std::allocate_shared<particle>(allocator, no_scene, i));
+            }
+            const double   spawn           = seconds_since(start);
+            const uint64_t spawned_objects = heap_allocations.load() - allocations;
+
+            start = clock::now();
+            objects.clear();
+            const double despawn = seconds_since(start);
+            check(live_objects == 0 && pool->live_blocks() == 0, "pooled objects are destroyed and their blocks freed");
+
+            const double n = static_cast<double>(count);
+            result = {.spawn_rate = n / spawn, .despawn_rate = n / despawn, .spawn_allocations = spawned_objects / n};
+        }
+        return result;
+    }
+
+    /**
+     * Spawns and despawns count objects twice in the same scene; the second round is what a game spawning waves of
+     * objects sees once the pool has grown.
+     */
+    spawn_result measure_scene(const uint64_t count, const bool bulk) {
+        const auto   scene = std::make_shared<engine::scene::scene>();
+        spawn_result result{};
+
+        for (int round = 0; round < 2; ++round) {
+            std::vector<uint64_t> ids;
+            ids.reserve(count);
+
+            const uint64_t allocations = heap_allocations.load();
+            auto           start       = clock::now();
+            if (bulk) {
+                for (const auto &[id, _] : scene->emplace_objects<particle>(count)) {
+                    ids.push_back(id);
+                }
+            } else {
+                for (uint64_t i = 0; i < count; ++i) {
+                    ids.push_back(scene->emplace_object<particle>().first);
+                }
+            }
+            const double   spawn           = seconds_since(start);
+            const uint64_t spawned_objects = heap_allocations.load() - allocations;
+            check(live_objects == static_cast<int64_t>(count), "every object is spawned");
+
+            start = clock::now();
+            if (bulk) {
+                scene->remove_objects(ids);
+            } else {
+                for (const uint64_t id : ids) {
+                    scene->remove_object(id);
+                }
+            }
+            const double despawn = seconds_since(start);
+            check(live_objects == 0, "every object is despawned");
+
+            const double n = static_cast<double>(count);
+            result = {.spawn_rate = n / spawn, .despawn_rate = n / despawn, .spawn_allocations = spawned_objects / n};
+        }
+        return result;
+    }
+
+    struct frame_result {
+        // heap allocations per frame
+        double spawn;
+        double despawn;
+        double update;
+    };
+
+    /**
+     * A scene of count updated objects that spawns churn objects into its update group and despawns its churn oldest
+     * every frame. Allocations are counted after the first few frames; spawning includes joining the group. Objects are
+     * spawned one at a time, as emplace_objects returns a newly allocated vector.
+     */
+    frame_result measure_frames(const uint64_t count, const uint64_t churn, const uint64_t frames) {
+        const auto scene = std::make_shared<engine::scene::scene>();
+        const auto group = scene->push_end_new_update_group();
+
+        std::vector<uint64_t> ids;
+        for (const auto &[id, _] : scene->emplace_objects_ug<particle>(count, group)) {
+            ids.push_back(id);
+        }
+
+        uint64_t spawn   = 0;
+        uint64_t despawn = 0;
+        uint64_t update  = 0;
+        size_t   oldest  = 0;
+        for (uint64_t frame = 0; frame < frames + 10; ++frame) {
+            if (frame == 10)
+                spawn = despawn = update = 0;
+
+            // keeps the id list from growing without bound, outside the counted scene work
+            if (oldest > ids.size() / 2) {
+                ids.erase(ids.begin(), ids.begin() + static_cast<ptrdiff_t>(oldest));
+                oldest = 0;
+            }
+            ids.reserve(ids.size() + churn);
+
+            uint64_t     before  = heap_allocations.load();
+            const size_t removed = std::min<size_t>(churn, ids.size() - oldest);
+            scene->remove_objects(std::span(ids).subspan(oldest, removed));
+            oldest += removed;
+            despawn += heap_allocations.load() - before;
+
+            before = heap_allocations.load();
+            for (uint64_t i = 0; i < churn; ++i) {
+                ids.push_back(scene->emplace_object_ug<particle>(group).first);
+            }
+            spawn += heap_allocations.load() - before;
+
+            before = heap_allocations.load();
+            scene->update(1.0 / 60.0);
+            update += heap_allocations.load() - before;
+        }
+        check(live_objects == static_cast<int64_t>(count), "churn keeps the object count steady");
+
+        const double n = static_cast<double>(frames);
+        return {.spawn = spawn / n, .despawn = despawn / n, .update = update / n};
+    }
+
+    void print(const char *label, const uint64_t count, const spawn_result &result) {
+        std::printf(
+            "%-24s %8llu objects: %6.2f M spawns/s, %6.2f M despawns/s, %5.2f heap allocations per spawn\n", label,
+            static_cast<unsigned long long>(count), result.spawn_rate / 1e6, result.despawn_rate / 1e6,
+            result.spawn_allocations
+        );
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: spawn_bench [--count <objects>] [--frames <count>] [--churn <objects per frame>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--count") {
+            options.count = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--frames") {
+            options.frames = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--churn") {
+            options.churn = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        check_pool_resource();
+        check_bulk_spawn();
+        std::printf("pool, bulk spawn and frame arena checks passed\n");
+
+        const spawn_result heap   = measure_heap(options.count);
+        const spawn_result pooled = measure_pooled(options.count);
+        const spawn_result single = measure_scene(options.count, false);
+        const spawn_result bulk   = measure_scene(options.count, true);
+        print("shared_ptr(new T)", options.count, heap);
+        print("create, pooled", options.count, pooled);
+        print("emplace_object, pooled", options.count, single);
+        print("emplace_objects, pooled", options.count, bulk);
+        check(heap.spawn_allocations >= 2.0, "shared_ptr(new T) allocates the object and its control block apart");
+        check(pooled.spawn_allocations < 1.0, "a grown pool creates objects without allocating them");
+        check(bulk.spawn_allocations < 1.0, "a grown pool spawns objects without allocating them");
+
+        const frame_result frame = measure_frames(options.count, options.churn, options.frames);
+        std::printf(
+            "%llu objects, %llu spawned and despawned per frame: heap allocations per frame: %.1f spawning (%.1f with "
+            "shared_ptr(new T)), %.1f despawning, %.1f updating\n",
+            static_cast<unsigned long long>(options.count), static_cast<unsigned long long>(options.churn), frame.spawn,
+            heap.spawn_allocations * static_cast<double>(options.churn), frame.despawn, frame.update
+        );
+        // pools, the scene's reused scratch and the frame arena keep a steady churn off the heap entirely
+        check(frame.spawn == 0.0, "spawning into a grown pool and update group allocates nothing");
+        check(frame.despawn == 0.0, "despawning allocates nothing");
+        check(frame.update == 0.0, "updates allocate nothing");
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,244 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures how long the renderer takes to start, first with an empty pipeline cache and then with the one the first run
+// saved: instance and device creation, loading the cache, compiling a set of compute pipelines through it, and saving
+// it again. The device is headless, so this runs on a software driver such as lavapipe.
+//
+//   startup_bench [--pipelines <count>] [--device <name>] [--cache <directory>]
+//
+// The cache directory is emptied first, so by default it is a directory of its own under the system temp directory.
+
+#include "engine/logging.hpp"
+#include "engine/render/render_device.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint32_t              pipelines = 200;
+        std::string           device;
+        std::filesystem::path cache = std::filesystem::temp_directory_path() / "engine_startup_bench";
+    };
+
+    struct run_times {
+        engine::render_device::startup_times device;
+        double                               pipelines = 0.0;
+        double                               save      = 0.0;
+        double                               total     = 0.0;
+    };
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    /**
+     * Assembles the SPIR-V for
+     *
+     *   layout(local_size_x = 64) in;
+     *   layout(constant_id = 0) const uint variant = 0;
+     *   layout(binding = 0) buffer data { uint values[]; };
+     *   void main() { uint i = gl_GlobalInvocationID.x; values[i] = values[i] * variant + i; }
+     *
+     * so the benchmark needs no shader compiler. Each value of the specialization constant is a separate pipeline as
+     * far as the cache is concerned.
+     */
+    std::vector<uint32_t> compute_shader() {
+        enum : uint32_t {
+            t_void = 1,
+            t_function,
+            t_uint,
+            t_uint3,
+            t_input_uint3,
+            t_input_uint,
+            t_array,
+            t_block,
+            t_uniform_block,
+            t_uniform_uint,
+            t_int,
+            global_id,
+            variant,
+            buffer,
+            int_0,
+            uint_0,
+            main_function,
+            entry,
+            x_pointer,
+            x,
+            value_pointer,
+            value,
+            product,
+            sum,
+            bound,
+        };
+
+        std::vector<uint32_t> code = {0x07230203, 0x00010000, 0, bound, 0};
+        const auto op              = [&](const uint32_t opcode, const std::initializer_list<uint32_t> operands) {
+            code.push_back(static_cast<uint32_t>(operands.size() + 1) << 16 | opcode);
+            code.insert(code.end(), operands);
+        };
+
+        op(17, {1});                                          // OpCapability Shader
+        op(14, {0, 1});                                       // OpMemoryModel Logical GLSL450
+        op(15, {5, main_function, 0x6e69616d, 0, global_id}); // OpEntryPoint GLCompute "main"
+        op(16, {main_function, 17, 64, 1, 1});                // OpExecutionMode LocalSize 64 1 1
+        op(71, {global_id, 11, 28});                          // OpDecorate BuiltIn GlobalInvocationId
+        op(71, {variant, 1, 0});                              // OpDecorate SpecId 0
+        op(71, {t_array, 6, 4});                              // OpDecorate ArrayStride 4
+        op(72, {t_block, 0, 35, 0});                          // OpMemberDecorate Offset 0
+        op(71, {t_block, 3});                                 // OpDecorate BufferBlock
+        op(71, {buffer, 34, 0});                              // OpDecorate DescriptorSet 0
+        op(71, {buffer, 33, 0});                              // OpDecorate Binding 0
+
+        op(19, {t_void});                      // OpTypeVoid
+        op(33, {t_function, t_void});          // OpTypeFunction
+        op(21, {t_uint, 32, 0});               // OpTypeInt 32 unsigned
+        op(23, {t_uint3, t_uint, 3});          // OpTypeVector
+        op(32, {t_input_uint3, 1, t_uint3});   // OpTypePointer Input
+        op(32, {t_input_uint, 1, t_uint});     // OpTypePointer Input
+        op(59, {t_input_uint3, global_id, 1}); // OpVariable Input
+        op(50, {t_uint, variant, 0});          // OpSpecConstant
+        op(29, {t_array, t_uint});             // OpTypeRuntimeArray
+        op(30, {t_block, t_array});            // OpTypeStruct
+        op(32, {t_uniform_block, 2, t_block}); // OpTypePointer Uniform
+        op(32, {t_uniform_uint, 2, t_uint});   // OpTypePointer Uniform
+        op(59, {t_uniform_block, buffer, 2});  // OpVariable Uniform
+        op(21, {t_int, 32, 1});                // OpTypeInt 32 signed
+        op(43, {t_int, int_0, 0});             // OpConstant
+        op(43, {t_uint, uint_0, 0});           // OpConstant
+
+        op(54, {t_void, main_function, 0, t_function});            // OpFunction
+        op(248, {entry});                                          // OpLabel
+        op(65, {t_input_uint, x_pointer, global_id, uint_0});      // OpAccessChain
+        op(61, {t_uint, x, x_pointer});                            // OpLoad
+        op(65, {t_uniform_uint, value_pointer, buffer, int_0, x}); // OpAccessChain
+        op(61, {t_uint, value, value_pointer});                    // OpLoad
+        op(132, {t_uint, product, value, variant});                // OpIMul
+        op(128, {t_uint, sum, product, x});                        // OpIAdd
+        op(62, {value_pointer, sum});                              // OpStore
+        op(253, {});                                               // OpReturn
+        op(56, {});                                                // OpFunctionEnd
+        return code;
+    }
+
+    run_times run(const options &options) {
+        run_times  times;
+        const auto start = clock::now();
+
+        const engine::render_device device(engine::render_device::settings{
+            .window                   = nullptr,
+            .device_override          = options.device,
+            .pipeline_cache_directory = options.cache,
+        });
+        times.device = device.get_startup_times();
+
+        const vk::raii::Device &vk_device = device.device();
+
+        const std::vector<uint32_t>  code = compute_shader();
+        const vk::raii::ShaderModule shader(vk_device, vk::ShaderModuleCreateInfo{}.setCode(code));
+
+        const vk::DescriptorSetLayoutBinding binding(
+            0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute
+        );
+        const vk::raii::DescriptorSetLayout set_layout(
+            vk_device, vk::DescriptorSetLayoutCreateInfo{}.setBindings(binding)
+        );
+        const vk::DescriptorSetLayout  set_layouts[] = {*set_layout};
+        const vk::raii::PipelineLayout layout(vk_device, vk::PipelineLayoutCreateInfo{}.setSetLayouts(set_layouts));
+
+        const vk::SpecializationMapEntry entry(0, 0, sizeof(uint32_t));
+        std::vector<vk::raii::Pipeline>  pipelines;
+        pipelines.reserve(options.pipelines);
+
+        auto step = clock::now();
+        for (uint32_t variant = 0; variant < options.pipelines; ++variant) {
+            vk::SpecializationInfo specialization{};
+            specialization.setMapEntries(entry);
+            specialization.setDataSize(sizeof(variant));
+            specialization.setPData(&variant);
+
+            vk::PipelineShaderStageCreateInfo stage{};
+            stage.setStage(vk::ShaderStageFlagBits::eCompute);
+            stage.setModule(*shader);
+            stage.setPName("main");
+            stage.setPSpecializationInfo(&specialization);
+
+            vk::ComputePipelineCreateInfo pipeline_create_info{};
+            pipeline_create_info.setStage(stage);
+            pipeline_create_info.setLayout(*layout);
+            pipelines.emplace_back(vk_device, device.pipeline_cache(), pipeline_create_info);
+        }
+        times.pipelines = seconds_since(step);
+
+        step = clock::now();
+        device.save_pipeline_cache();
+        times.save  = seconds_since(step);
+        times.total = seconds_since(start);
+        return times;
+    }
+
+    void print_row(const std::string_view label, const run_times &times) {
+        std::printf(
+            "%-6s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", label.data(), times.device.instance * 1e3,
+            times.device.device * 1e3, times.device.pipeline_cache * 1e3, times.pipelines * 1e3, times.save * 1e3,
+            times.total * 1e3
+        );
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: startup_bench [--pipelines <count>] [--device <name>] [--cache <directory>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--pipelines") {
+            options.pipelines = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--device") {
+            options.device = argv[++i];
+        } else if (arg == "--cache") {
+            options.cache = argv[++i];
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+#ifndef _WIN32
+    // Mesa keeps a shader cache of its own on disk, which would make the cold run warm
+    setenv("MESA_SHADER_CACHE_DISABLE", "true", 0);
+#endif
+
+    try {
+        std::filesystem::remove_all(options.cache);
+
+        std::printf("%u pipelines, times in ms\n", options.pipelines);
+        std::printf(
+            "%-6s %10s %10s %10s %10s %10s %10s\n", "", "instance", "device", "cache", "pipelines", "save", "total"
+        );
+        print_row("cold", run(options));
+        // each device creates a logger of the same name
+        spdlog::drop("render");
+        print_row("warm", run(options));
+        spdlog::drop("render");
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,380 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Measures transform_hierarchy updates on 100k-node hierarchies of three shapes: deep (chains 1000 levels deep), wide
+// (one root with every other node as its child) and a tree with four children per node. For each, times a full update
+// with every node dirty, updates with a few random nodes changed and with one subtree reparented, and an update with
+// nothing changed, with and without a job system. The full update is compared with a pointer tree of individually
+// allocated nodes updated depth first, the shape scene objects' parent and child links have. Before timing, random
+// edits are checked against world matrices recomputed from scratch, and changed() is checked to flag exactly the
+// subtrees under edited nodes.
+//
+//   transform_bench [--nodes <count>] [--threads <count>] [--updates <count>] [--seed <value>]
+
+#include "engine/jobs.hpp"
+#include "engine/scene/transform.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t nodes   = 100'000;
+        uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        uint64_t updates = 20;
+        uint64_t seed    = 1;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    double seconds_since(const clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    glm::mat4 offset(const uint64_t i) {
+        return glm::translate(
+            glm::mat4(1.0f), glm::vec3(static_cast<float>(i % 7) * 0.5f, 1.0f, static_cast<float>(i % 3) - 1.0f)
+        );
+    }
+
+    enum class shape { deep, wide, tree };
+
+    const char *shape_name(const shape shape) {
+        switch (shape) {
+        case shape::deep:
+            return "deep";
+        case shape::wide:
+            return "wide";
+        default:
+            return "tree";
+        }
+    }
+
+    /**
+     * @return The parent of each node, by index, or -1 for a root. Parents always come before their children.
+     */
+    std::vector<int64_t> make_parents(const shape shape, const uint64_t count) {
+        std::vector<int64_t> parents(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            switch (shape) {
+            case shape::deep:
+                parents[i] = i % 1000 == 0 ? -1 : static_cast<int64_t>(i) - 1;
+                break;
+            case shape::wide:
+                parents[i] = i == 0 ? -1 : 0;
+                break;
+            case shape::tree:
+                parents[i] = i == 0 ? -1 : static_cast<int64_t>((i - 1) / 4);
+                break;
+            }
+        }
+        return parents;
+    }
+
+    /**
+     * The same hierarchy kept as plain parent links and local matrices, with world matrices computed from scratch.
+     */
+    struct reference {
+        std::vector<int64_t>   parent;
+        std::vector<glm::mat4> local;
+        std::vector<bool>      alive;
+        std::vector<bool>      touched; // edited since the last update, so its whole subtree must be recomputed
+
+        [[nodiscard]] bool is_ancestor(int64_t ancestor, int64_t node) const {
+            for (; node >= 0; node = parent[node]) {
+                if (node == ancestor)
+                    return true;
+            }
+            return false;
+        }
+
+        [[nodiscard]] std::vector<glm::mat4> world() const {
+            std::vector<glm::mat4> world(parent.size());
+            std::vector<bool>      done(parent.size());
+            std::vector<int64_t>   chain;
+            for (size_t i = 0; i < parent.size(); ++i) {
+                for (int64_t node = static_cast<int64_t>(i); node >= 0 && !done[node]; node = parent[node]) {
+                    chain.push_back(node);
+                }
+                // parents first, with the same multiplication the hierarchy does
+                for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                    const int64_t p = parent[*it];
+                    world[*it]      = p < 0 ? local[*it] : world[p] * local[*it];
+                    done[*it]       = true;
+                }
+                chain.clear();
+            }
+            return world;
+        }
+
+        [[nodiscard]] bool expect_changed(int64_t node) const {
+            for (; node >= 0; node = parent[node]) {
+                if (touched[node])
+                    return true;
+            }
+            return false;
+        }
+    };
+
+    engine::scene::transform_handle
+    parent_handle(const std::vector<engine::scene::transform_handle> &handles, const int64_t parent) {
+        return parent < 0 ? engine::scene::transform_handle{} : handles[parent];
+    }
+
+    void verify(
+        const engine::scene::transform_hierarchy           &hierarchy,
+        const std::vector<engine::scene::transform_handle> &handles,
+        const reference                                    &ref
+    ) {
+        const std::vector<glm::mat4> world = ref.world();
+        for (size_t i = 0; i < handles.size(); ++i) {
+            if (!ref.alive[i])
+                continue;
+            check(hierarchy.get_world(handles[i]) == world[i], "world matrices match a full recomputation");
+            check(hierarchy.changed(handles[i]) == ref.expect_changed(static_cast<int64_t>(i)), "changed flags edits");
+        }
+    }
+
+    /**
+     * Random local edits, reparenting (including to the root) and destruction, with every world matrix and changed
+     * flag checked after each update.
+     */
+    void check_edits(const shape shape, std::mt19937_64 &rng, engine::job_system *jobs) {
+        constexpr uint64_t count = 5000;
+
+        engine::scene::transform_hierarchy           hierarchy;
+        std::vector<engine::scene::transform_handle> handles;
+        reference                                    ref;
+        ref.parent  = make_parents(shape, count);
+        ref.alive   = std::vector<bool>(count, true);
+        ref.touched = std::vector<bool>(count, true);
+        for (uint64_t i = 0; i < count; ++i) {
+            ref.local.push_back(offset(i));
+            handles.push_back(hierarchy.create(parent_handle(handles, ref.parent[i]), offset(i)));
+        }
+
+        for (int round = 0; round < 20; ++round) {
+            // threshold 1 puts every level through the job system
+            hierarchy.update(jobs, 1);
+            verify(hierarchy, handles, ref);
+            std::fill(ref.touched.begin(), ref.touched.end(), false);
+
+            hierarchy.update(jobs, 1);
+            verify(hierarchy, handles, ref);
+
+            for (int edit = 0; edit < 50; ++edit) {
+                const auto node = static_cast<int64_t>(rng() % count);
+                if (!ref.alive[node])
+                    continue;
+
+                switch (rng() % 8) {
+                case 0: {
+                    const auto parent = static_cast<int64_t>(rng() % (count + 1)) - 1;
+                    // setting the same parent again is a no-op that dirties nothing
+                    if (parent == ref.parent[node])
+                        break;
+                    if (parent >= 0 && (!ref.alive[parent] || ref.is_ancestor(node, parent)))
+                        break;
+                    hierarchy.set_parent(handles[node], parent_handle(handles, parent));
+                    ref.parent[node]  = parent;
+                    ref.touched[node] = true;
+                    break;
+                }
+                case 1:
+                    if (round % 4 != 3)
+                        break;
+                    hierarchy.destroy(handles[node]);
+                    ref.alive[node] = false;
+                    for (size_t child = 0; child < count; ++child) {
+                        if (ref.parent[child] == node) {
+                            ref.parent[child]  = -1;
+                            ref.touched[child] = true;
+                        }
+                    }
+                    ref.parent[node] = -1;
+                    break;
+                default:
+                    ref.local[node]   = offset(rng());
+                    ref.touched[node] = true;
+                    hierarchy.set_local(handles[node], ref.local[node]);
+                    break;
+                }
+            }
+        }
+    }
+
+    /**
+     * Individually allocated nodes linked by pointers, updated depth first from each root.
+     */
+    struct pointer_node {
+        glm::mat4                  local;
+        glm::mat4                  world;
+        std::vector<pointer_node *> children;
+    };
+
+    double time_pointer_tree(const std::vector<int64_t> &parents, const uint64_t updates) {
+        std::vector<std::unique_ptr<pointer_node>> nodes;
+        std::vector<pointer_node *>                roots;
+        for (size_t i = 0; i < parents.size(); ++i) {
+            nodes.push_back(std::make_unique<pointer_node>(pointer_node{offset(i), glm::mat4(1.0f), {}}));
+            if (parents[i] < 0) {
+                roots.push_back(nodes.back().get());
+            } else {
+                nodes[parents[i]]->children.push_back(nodes.back().get());
+            }
+        }
+
+        std::vector<std::pair<pointer_node *, const glm::mat4 *>> stack;
+        const glm::mat4                                           identity(1.0f);
+        const auto                                                start = clock::now();
+        for (uint64_t u = 0; u < updates; ++u) {
+            for (pointer_node *root : roots) {
+                stack.emplace_back(root, &identity);
+                while (!stack.empty()) {
+                    const auto [node, parent_world] = stack.back();
+                    stack.pop_back();
+                    node->world = *parent_world * node->local;
+                    for (pointer_node *child : node->children) {
+                        stack.emplace_back(child, &node->world);
+                    }
+                }
+            }
+        }
+        return seconds_since(start) / static_cast<double>(updates);
+    }
+
+    struct timings {
+        double build;
+        double full;
+        double sparse;   // 0.1% of nodes with a new local matrix
+        double reparent; // one subtree moved under another parent
+        double clean;
+        size_t depth;
+    };
+
+    timings time_hierarchy(
+        const std::vector<int64_t> &parents, const uint64_t updates, engine::job_system *jobs, std::mt19937_64 &rng
+    ) {
+        timings                                      result{};
+        engine::scene::transform_hierarchy           hierarchy;
+        std::vector<engine::scene::transform_handle> handles;
+        handles.reserve(parents.size());
+
+        auto start = clock::now();
+        for (size_t i = 0; i < parents.size(); ++i) {
+            handles.push_back(hierarchy.create(parent_handle(handles, parents[i]), offset(i)));
+        }
+        result.build = seconds_since(start);
+        result.depth = hierarchy.depth_count();
+
+        hierarchy.update(jobs);
+        const auto dirty_all = [&] {
+            for (size_t i = 0; i < handles.size(); ++i) {
+                hierarchy.set_local(handles[i], offset(i + 1));
+            }
+        };
+        const auto timed = [&](const auto &edit) {
+            double total = 0.0;
+            for (uint64_t u = 0; u < updates; ++u) {
+                edit();
+                const auto begin = clock::now();
+                hierarchy.update(jobs);
+                total += seconds_since(begin);
+            }
+            return total / static_cast<double>(updates);
+        };
+
+        result.full   = timed(dirty_all);
+        result.sparse = timed([&] {
+            for (size_t i = 0; i < handles.size() / 1000; ++i) {
+                const size_t node = rng() % handles.size();
+                hierarchy.set_local(handles[node], offset(node + rng() % 5));
+            }
+        });
+        // the last node is a leaf in every shape; it alternates between the first two nodes
+        uint64_t flip   = 0;
+        result.reparent = timed([&] { hierarchy.set_parent(handles.back(), handles[flip++ % 2]); });
+        result.clean = timed([] {});
+        return result;
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: transform_bench [--nodes <count>] [--threads <count>] [--updates <count>] [--seed "
+                         "<value>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--nodes") {
+            options.nodes = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 3);
+        } else if (arg == "--threads") {
+            options.threads = std::max<uint32_t>(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)), 1);
+        } else if (arg == "--updates") {
+            options.updates = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::mt19937_64 rng(options.seed);
+        const auto      jobs = std::make_shared<engine::job_system>(
+            engine::job_system::settings{.worker_count = std::max<uint32_t>(options.threads, 2) - 1}
+        );
+
+        for (const shape shape : {shape::deep, shape::wide, shape::tree}) {
+            check_edits(shape, rng, nullptr);
+            check_edits(shape, rng, jobs.get());
+        }
+        std::printf("world matrix and changed flag checks passed\n");
+
+        for (const shape shape : {shape::deep, shape::wide, shape::tree}) {
+            const std::vector<int64_t> parents = make_parents(shape, options.nodes);
+            const double               pointer = time_pointer_tree(parents, options.updates);
+            std::printf(
+                "%s, %llu nodes: pointer tree full update %8.3f ms\n", shape_name(shape),
+                static_cast<unsigned long long>(options.nodes), pointer * 1e3
+            );
+
+            for (const bool threaded : {false, true}) {
+                const timings t = time_hierarchy(parents, options.updates, threaded ? jobs.get() : nullptr, rng);
+                std::printf(
+                    "  %-10s %5zu levels: build %7.3f ms, full %7.3f ms (%.2fx), 0.1%% dirty %7.3f ms, reparent "
+                    "%7.3f ms, clean %7.4f ms\n",
+                    threaded ? "job system" : "one thread", t.depth, t.build * 1e3, t.full * 1e3, pointer / t.full,
+                    t.sparse * 1e3, t.reparent * 1e3, t.clean * 1e3
+                );
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,267 @@
+//
+// Created by andy on 10/17/26.
+//
+
+// Compares update_phase with the unordered_set of shared_ptrs it replaced, which updated each object through a
+// pointer to the virtual scene_object::update. Three object types are inserted interleaved; the set is walked in hash
+// order, update_phase walks one dense run per type, either with virtual calls (untyped insert) or with one call of the
+// type's batch function per run (typed insert). Checks that the update order is insertion order within each type,
+// the same on every run, that erasing keeps it, and that every object is updated once per update.
+//
+//   update_phase_bench [--updates <count>] [--max <objects>]
+
+#include "engine/scene/scene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct options {
+        uint64_t updates = 20;
+        uint64_t max     = 1'000'000;
+    };
+
+    void check(const bool condition, const char *what) {
+        if (!condition)
+            throw std::runtime_error(std::string("check failed: ") + what);
+    }
+
+    /**
+     * Appends its id to a log when updated, if given one, and adds up the deltas it was updated with.
+     */
+    class counted_object : public engine::scene::scene_object {
+      public:
+        counted_object(const std::weak_ptr<engine::scene::scene> &scene, const uint64_t id, std::vector<uint64_t> *log)
+            : scene_object(scene, id), m_log(log) {}
+
+        [[nodiscard]] inline double total() const noexcept { return m_total; }
+
+      protected:
+        inline void count(const double delta) {
+            if (m_log)
+                m_log->push_back(get_id());
+            m_total += delta;
+        }
+
+      private:
+        std::vector<uint64_t> *m_log;
+        double                 m_total = 0.0;
+    };
+
+    // three otherwise identical types, so an update group has three runs
+    template <int N>
+    class counter_object final : public counted_object {
+      public:
+        using counted_object::counted_object;
+
+        void update(const double delta) override { count(delta); }
+    };
+
+    /**
+     * How update groups kept their objects before: an unordered_set, updated through a member function pointer.
+     */
+    class set_phase {
+      public:
+        using update_func = void (engine::scene::scene_object::*)(double);
+
+        explicit set_phase(const update_func f) : m_update_function(f) {}
+
+        void insert(const std::shared_ptr<engine::scene::scene_object> &object) { m_objects.insert(object); }
+
+        void run_updates(const double delta) {
+            for (const auto &object : m_objects) {
+                std::invoke(m_update_function, object, delta);
+            }
+        }
+
+      private:
+        std::unordered_set<std::shared_ptr<engine::scene::scene_object>> m_objects;
+        update_func                                                      m_update_function;
+    };
+
+    enum class mode { set, untyped, typed };
+
+    struct scene_setup {
+        std::shared_ptr<engine::scene::scene>                     scene;
+        std::vector<std::shared_ptr<engine::scene::scene_object>> objects; // in insertion order
+    };
+
+    /**
+     * count objects of three types, inserted round-robin.
+     */
+    scene_setup make_objects(const uint64_t count, std::vector<uint64_t> *log) {
+        scene_setup setup{.scene = std::make_shared<engine::scene::scene>()};
+        setup.objects.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            switch (i % 3) {
+            case 0:
+                setup.objects.push_back(setup.scene->emplace_object<counter_object<0>>(log).second);
+                break;
+            case 1:
+                setup.objects.push_back(setup.scene->emplace_object<counter_object<1>>(log).second);
+                break;
+            default:
+                setup.objects.push_back(setup.scene->emplace_object<counter_object<2>>(log).second);
+                break;
+            }
+        }
+        return setup;
+    }
+
+    void insert_typed(engine::scene::update_group &group, const std::shared_ptr<engine::scene::scene_object> &object) {
+        if (const auto zero = std::dynamic_pointer_cast<counter_object<0>>(object)) {
+            group.insert(zero);
+        } else if (const auto one = std::dynamic_pointer_cast<counter_object<1>>(object)) {
+            group.insert(one);
+        } else {
+            group.insert(std::static_pointer_cast<counter_object<2>>(object));
+        }
+    }
+
+    /**
+     * @return The order objects should be updated in: by type, in order of the type's first insertion, then by
+     * insertion.
+     */
+    std::vector<uint64_t> expected_order(const std::vector<std::shared_ptr<engine::scene::scene_object>> &objects) {
+        std::vector<uint64_t> order;
+        for (size_t type = 0; type < 3; ++type) {
+            for (size_t i = type; i < objects.size(); i += 3) {
+                order.push_back(objects[i]->get_id());
+            }
+        }
+        return order;
+    }
+
+    void check_order() {
+        for (const bool typed : {false, true}) {
+            std::vector<uint64_t>       log;
+            const scene_setup           setup = make_objects(3000, &log);
+            engine::scene::update_group group;
+            for (const auto &object : setup.objects) {
+                if (typed) {
+                    insert_typed(group, object);
+                } else {
+                    group.insert(object);
+                }
+            }
+
+            group.update(1.0);
+            std::vector<uint64_t> expected = expected_order(setup.objects);
+            check(log == expected, "objects are updated by type, in insertion order");
+
+            log.clear();
+            group.update(1.0);
+            check(log == expected, "the order is the same on every update");
+
+            // erase every fifth object
+            std::vector<std::shared_ptr<engine::scene::scene_object>> kept;
+            for (size_t i = 0; i < setup.objects.size(); ++i) {
+                if (i % 5 == 0) {
+                    check(group.erase(setup.objects[i]), "erasing a member succeeds");
+                } else {
+                    kept.push_back(setup.objects[i]);
+                }
+            }
+            std::erase_if(expected, [&](const uint64_t id) {
+                return std::ranges::none_of(kept, [id](const auto &object) { return object->get_id() == id; });
+            });
+
+            log.clear();
+            group.update(1.0);
+            check(log == expected, "erasing keeps the order of the rest");
+            check(group.size() == kept.size(), "the group holds what was not erased");
+        }
+    }
+
+    double time_updates(const uint64_t count, const uint64_t updates, const mode mode) {
+        const scene_setup setup = make_objects(count, nullptr);
+
+        set_phase                   set(&engine::scene::scene_object::update);
+        engine::scene::update_group group;
+        for (const auto &object : setup.objects) {
+            switch (mode) {
+            case mode::set:
+                set.insert(object);
+                break;
+            case mode::untyped:
+                group.insert(object);
+                break;
+            case mode::typed:
+                insert_typed(group, object);
+                break;
+            }
+        }
+
+        const auto start = clock::now();
+        for (uint64_t i = 0; i < updates; ++i) {
+            if (mode == mode::set) {
+                set.run_updates(1.0 / 60.0);
+            } else {
+                group.update(1.0 / 60.0);
+            }
+        }
+        const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        const double expected = static_cast<double>(updates) / 60.0;
+        for (const auto &object : setup.objects) {
+            const double total = static_cast<const counted_object &>(*object).total();
+            check(std::abs(total - expected) < 1e-9, "every object is updated once per update");
+        }
+        return seconds / static_cast<double>(updates);
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "usage: update_phase_bench [--updates <count>] [--max <objects>]\n";
+            return EXIT_FAILURE;
+        }
+        if (arg == "--updates") {
+            options.updates = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (arg == "--max") {
+            options.max = std::max<uint64_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        check_order();
+        std::printf("update order and erase checks passed\n");
+
+        for (uint64_t count = std::min<uint64_t>(10'000, options.max); count <= options.max; count *= 10) {
+            const double set     = time_updates(count, options.updates, mode::set);
+            const double untyped = time_updates(count, options.updates, mode::untyped);
+            const double typed   = time_updates(count, options.updates, mode::typed);
+            std::printf(
+                "%8llu objects: unordered_set %8.3f ms, untyped runs %8.3f ms (%.2fx), typed runs %8.3f ms (%.2fx) "
+                "per update\n",
+                static_cast<unsigned long long>(count), set * 1e3, untyped * 1e3, set / untyped, typed * 1e3,
+                set / typed
+            );
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Failed: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}